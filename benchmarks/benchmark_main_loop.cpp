@@ -0,0 +1,170 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/glib_main_loop.h"
+#include "mir/epoll_main_loop.h"
+#include "mir/time/steady_clock.h"
+#include "mir/fd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+namespace
+{
+/*
+ * Each "client" is a pipe with an fd handler on the main loop, as the
+ * frontend and input sources are. A writer thread sends timestamps round
+ * the clients (and occasionally enqueues a server action) keeping a bounded
+ * number in flight; we record how long each took to be dispatched.
+ */
+struct Client
+{
+    Client()
+    {
+        int pipefds[2];
+        if (pipe(pipefds) < 0)
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to create pipe"};
+        }
+
+        read_fd = mir::Fd{pipefds[0]};
+        write_fd = mir::Fd{pipefds[1]};
+    }
+
+    mir::Fd read_fd;
+    mir::Fd write_fd;
+};
+
+int64_t now_ns()
+{
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+microseconds cpu_time()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return seconds{usage.ru_utime.tv_sec + usage.ru_stime.tv_sec} +
+           microseconds{usage.ru_utime.tv_usec + usage.ru_stime.tv_usec};
+}
+
+void print_percentile(char const* label, std::vector<int64_t> const& sorted, double percentile)
+{
+    auto const index = std::min(sorted.size() - 1, static_cast<size_t>(percentile / 100.0 * sorted.size()));
+    std::cout << " " << label << "=" << sorted[index] / 1000.0 << "us";
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 4 || (strcmp(argv[1], "glib") && strcmp(argv[1], "epoll")))
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <glib|epoll> [number of clients] [number of messages]"<<std::endl;
+        exit(1);
+    }
+
+    size_t const client_count = argc > 2 ? std::atoll(argv[2]) : 256;
+    size_t const message_count = argc > 3 ? std::atoll(argv[3]) : 200000;
+    size_t const max_in_flight = 64;
+    size_t const action_interval = 8;
+
+    auto const clock = std::make_shared<mir::time::SteadyClock>();
+    std::shared_ptr<mir::MainLoop> const main_loop = strcmp(argv[1], "glib") ?
+        std::shared_ptr<mir::MainLoop>{std::make_shared<mir::EpollMainLoop>(clock)} :
+        std::shared_ptr<mir::MainLoop>{std::make_shared<mir::GLibMainLoop>(clock)};
+
+    std::vector<Client> clients(client_count);
+    std::vector<int64_t> latencies;
+    latencies.reserve(message_count);
+    std::atomic<size_t> handled{0};
+
+    auto const record = [&](int64_t sent)
+        {
+            latencies.push_back(now_ns() - sent);
+            if (++handled == message_count)
+                main_loop->stop();
+        };
+
+    for (auto const& client : clients)
+    {
+        main_loop->register_fd_handler(
+            {client.read_fd},
+            &client,
+            [&](int fd)
+            {
+                int64_t sent;
+                if (read(fd, &sent, sizeof sent) == sizeof sent)
+                    record(sent);
+            });
+    }
+
+    std::thread writer{
+        [&]
+        {
+            for (size_t i = 0; i != message_count; ++i)
+            {
+                while (i - handled >= max_in_flight)
+                    std::this_thread::yield();
+
+                auto const sent = now_ns();
+                if (i % action_interval == 0)
+                {
+                    main_loop->enqueue(&clients, [&record, sent] { record(sent); });
+                }
+                else if (write(clients[i % client_count].write_fd, &sent, sizeof sent) != sizeof sent)
+                {
+                    throw std::system_error{errno, std::system_category(), "Failed to write to pipe"};
+                }
+            }
+        }};
+
+    auto const start_cpu = cpu_time();
+    auto const start = steady_clock::now();
+
+    main_loop->run();
+
+    auto const wall = duration_cast<microseconds>(steady_clock::now() - start);
+    auto const cpu = cpu_time() - start_cpu;
+
+    writer.join();
+
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << argv[1] << ": " << message_count << " messages over " << client_count << " clients"
+              << " took " << wall.count() << "us (cpu " << cpu.count() << "us);"
+              << " dispatch latency";
+    print_percentile("p50", latencies, 50);
+    print_percentile("p90", latencies, 90);
+    print_percentile("p99", latencies, 99);
+    std::cout << " max=" << latencies.back() / 1000.0 << "us" << std::endl;
+
+    for (auto const& client : clients)
+        main_loop->unregister_fd_handler(&client);
+
+    exit(0);
+}
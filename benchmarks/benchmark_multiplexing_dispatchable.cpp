@@ -18,6 +18,7 @@
 
 #include "mir/dispatch/multiplexing_dispatchable.h"
 
+#include <atomic>
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -31,8 +32,8 @@ namespace md = mir::dispatch;
 class TestDispatchable : public md::Dispatchable
 {
 public:
-    TestDispatchable(uint64_t limit)
-        : dispatch_limit{limit}
+    TestDispatchable(std::atomic<int64_t>& remaining)
+        : remaining{remaining}
     {
         int pipefds[2];
         if (pipe(pipefds) < 0)
@@ -56,8 +57,9 @@ public:
     }
     bool dispatch(md::FdEvents) override
     {
-        ++dispatch_count;
-        return (dispatch_count < dispatch_limit);
+        // Once the budget is spent each source removes itself, leaving the
+        // dispatcher unreadable.
+        return --remaining > 0;
     }
     md::FdEvents relevant_events() const override
     {
@@ -65,13 +67,10 @@ public:
     }
 
 private:
-    static thread_local uint64_t dispatch_count;
-    uint64_t const dispatch_limit;
+    std::atomic<int64_t>& remaining;
     mir::Fd read_fd, write_fd;
 };
 
-thread_local uint64_t TestDispatchable::dispatch_count = 0;
-
 bool fd_is_readable(int fd)
 {
     struct pollfd poller {
@@ -82,19 +81,15 @@ bool fd_is_readable(int fd)
     return poll(&poller, 1, 0);
 }
 
-int main(int argc, char** argv)
+void run(int thread_count, int64_t dispatch_count, int source_count)
 {
-    if (argc != 3)
-    {
-        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <dispatch count>"<<std::endl;
-        exit(1);
-    }
-
-    int const thread_count = std::atoi(argv[1]);
-    uint64_t const dispatch_count = std::atoll(argv[2]);
+    std::atomic<int64_t> remaining{dispatch_count};
 
     auto dispatcher = std::make_shared<md::MultiplexingDispatchable>();
-    dispatcher->add_watch(std::make_shared<TestDispatchable>(dispatch_count / thread_count), md::DispatchReentrancy::reentrant);
+    for (int i = 0; i != source_count; ++i)
+    {
+        dispatcher->add_watch(std::make_shared<TestDispatchable>(remaining), md::DispatchReentrancy::reentrant);
+    }
 
     auto start = std::chrono::steady_clock::now();
 
@@ -116,6 +111,28 @@ int main(int argc, char** argv)
     }
 
     auto duration = std::chrono::steady_clock::now() - start;
-    std::cout<<"Dispatching "<<dispatch_count<<" times took "<<std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()<<"ns"<<std::endl;
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    auto const dispatched = dispatch_count - remaining;
+
+    std::cout<<"Dispatching "<<dispatched<<" times over "<<source_count<<" sources took "<<ns<<"ns"
+             <<" ("<<dispatched * 1000000000 / ns<<" dispatches/s)"<<std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <dispatch count>"<<std::endl;
+        exit(1);
+    }
+
+    int const thread_count = std::atoi(argv[1]);
+    int64_t const dispatch_count = std::atoll(argv[2]);
+
+    for (auto source_count : {1, 16, 256})
+    {
+        run(thread_count, dispatch_count, source_count);
+    }
+
     exit(0);
 }
@@ -0,0 +1,159 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/basic_observers.h"
+#include "mir/observer_multiplexer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+struct Observer
+{
+    virtual ~Observer() = default;
+    virtual void frame_posted(int frames) = 0;
+};
+
+struct CountingObserver : Observer
+{
+    void frame_posted(int frames) override { count += frames; }
+    int count{0};
+};
+
+// As scene::SurfaceObservers does for BasicSurface
+struct Observers : Observer, mir::BasicObservers<Observer>
+{
+    using mir::BasicObservers<Observer>::add;
+    using mir::BasicObservers<Observer>::remove;
+
+    void frame_posted(int frames) override
+    {
+        for_each([frames](std::shared_ptr<Observer> const& observer) { observer->frame_posted(frames); });
+    }
+};
+
+struct ImmediateExecutor : mir::Executor
+{
+    void spawn(std::function<void()>&& work) override { work(); }
+};
+
+struct Multiplexer : mir::ObserverMultiplexer<Observer>
+{
+    Multiplexer(mir::Executor& executor) : mir::ObserverMultiplexer<Observer>{executor} {}
+
+    void frame_posted(int frames) override
+    {
+        for_each_observer(&Observer::frame_posted, frames);
+    }
+};
+
+/*
+ * Notifier threads (compositors, IPC threads) notify as fast as they can while
+ * another thread adds and removes an observer, as surfaces come and go.
+ */
+template<typename Add, typename Remove>
+int64_t notifications_per_second(
+    Observer& subject, int notifier_count, duration<double> run_time, Add const& add, Remove const& remove)
+{
+    std::atomic<bool> running{true};
+    std::atomic<int64_t> notifications{0};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i != notifier_count; ++i)
+    {
+        threads.emplace_back([&]
+            {
+                int64_t count{0};
+                while (running)
+                {
+                    subject.frame_posted(1);
+                    ++count;
+                }
+                notifications += count;
+            });
+    }
+
+    threads.emplace_back([&]
+        {
+            while (running)
+            {
+                auto const transient = std::make_shared<CountingObserver>();
+                add(transient);
+                std::this_thread::sleep_for(milliseconds{1});
+                remove(transient);
+            }
+        });
+
+    std::this_thread::sleep_for(run_time);
+    running = false;
+
+    for (auto& thread : threads)
+        thread.join();
+
+    return static_cast<int64_t>(notifications / run_time.count());
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 3)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" [number of notifying threads] [seconds per run]"<<std::endl;
+        exit(1);
+    }
+
+    int const notifier_count = argc > 1 ? std::atoi(argv[1]) : 4;
+    auto const run_time = duration<double>{argc > 2 ? std::atof(argv[2]) : 1.0};
+
+    std::cout << notifier_count << " notifying threads:" << std::endl;
+
+    for (int const observer_count : {1, 10, 100})
+    {
+        std::vector<std::shared_ptr<CountingObserver>> observers;
+        for (int i = 0; i != observer_count; ++i)
+            observers.push_back(std::make_shared<CountingObserver>());
+
+        Observers basic_observers;
+        for (auto const& observer : observers)
+            basic_observers.add(observer);
+
+        auto const basic_rate = notifications_per_second(basic_observers, notifier_count, run_time,
+            [&](std::shared_ptr<Observer> const& observer) { basic_observers.add(observer); },
+            [&](std::shared_ptr<Observer> const& observer) { basic_observers.remove(observer); });
+
+        ImmediateExecutor executor;
+        Multiplexer multiplexer{executor};
+        for (auto const& observer : observers)
+            multiplexer.register_interest(observer);
+
+        auto const multiplexer_rate = notifications_per_second(multiplexer, notifier_count, run_time,
+            [&](std::shared_ptr<Observer> const& observer) { multiplexer.register_interest(observer); },
+            [&](std::shared_ptr<Observer> const& observer) { multiplexer.unregister_interest(*observer); });
+
+        std::cout << "  " << observer_count << " observers: BasicObservers " << basic_rate << " notifies/s,"
+                  << " ObserverMultiplexer " << multiplexer_rate << " notifies/s" << std::endl;
+    }
+
+    exit(0);
+}
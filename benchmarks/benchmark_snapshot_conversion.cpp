@@ -0,0 +1,129 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/pixel_conversion.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+namespace ms = mir::scene;
+
+using namespace std::chrono;
+
+namespace
+{
+/*
+ * The CPU side of a snapshot: GL reads back bottom-up (and maybe as RGBA),
+ * and snapshots want top-down ARGB. The GPU transfer itself can't be timed
+ * without a GL implementation, so this measures only what follows it.
+ */
+uint32_t abgr_to_argb(uint32_t p)
+{
+    return ((p << 16) & 0x00ff0000) | (p & 0x0000ff00) | ((p >> 16) & 0x000000ff) | (p & 0xff000000);
+}
+
+// What GLPixelBuffer::as_argb_8888() did before: swap rows in place, a pixel at a time
+void in_place_flip(std::vector<char>& pixels, uint32_t width, uint32_t height, bool convert)
+{
+    auto const stride = width * 4;
+    std::vector<char> tmp(stride);
+
+    auto const copy_line = [&](char* src, char* dst)
+        {
+            if (convert)
+            {
+                auto const from = reinterpret_cast<uint32_t*>(src);
+                auto const to = reinterpret_cast<uint32_t*>(dst);
+                for (uint32_t n = 0; n < width; n++)
+                    to[n] = abgr_to_argb(from[n]);
+            }
+            else if (src != dst)
+            {
+                std::copy(src, src + stride, dst);
+            }
+        };
+
+    for (uint32_t i = 0; i < height / 2; i++)
+    {
+        tmp.assign(&pixels[i * stride], &pixels[(i + 1) * stride]);
+        copy_line(&pixels[(height - i - 1) * stride], &pixels[i * stride]);
+        copy_line(tmp.data(), &pixels[(height - i - 1) * stride]);
+    }
+
+    if (height % 2 == 1)
+        copy_line(&pixels[(height / 2) * stride], &pixels[(height / 2) * stride]);
+}
+
+void time(char const* name, int iterations, uint32_t width, uint32_t height, std::function<void()> const& convert)
+{
+    convert();
+
+    auto const start = steady_clock::now();
+    for (int i = 0; i != iterations; ++i)
+        convert();
+    auto const elapsed = duration_cast<duration<double>>(steady_clock::now() - start);
+
+    auto const bytes = double(width) * height * 4 * iterations;
+    std::cout << "  " << name << ": " << elapsed.count() * 1000 / iterations << "ms/frame, "
+              << iterations / elapsed.count() << " frames/s, "
+              << bytes / elapsed.count() / (1024 * 1024 * 1024) << "GiB/s" << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" [width] [height] [iterations]"<<std::endl;
+        exit(1);
+    }
+
+    uint32_t const width = argc > 1 ? std::atoi(argv[1]) : 3840;
+    uint32_t const height = argc > 2 ? std::atoi(argv[2]) : 2160;
+    int const iterations = argc > 3 ? std::atoi(argv[3]) : 100;
+
+    std::vector<char> readback(width * height * 4);
+    for (size_t i = 0; i != readback.size(); ++i)
+        readback[i] = static_cast<char>(i * 7);
+
+    // Flipping and swapping red and blue are their own inverses, so in place works on the same data each time
+    std::vector<char> pixels{readback};
+
+    std::cout << width << "x" << height << " snapshot conversion:" << std::endl;
+
+    // Without pixel buffer objects GL reads straight into the snapshot, which is flipped in place
+    time("BGRA in place (before)", iterations, width, height,
+        [&] { in_place_flip(pixels, width, height, false); });
+    time("BGRA in place, flip()", iterations, width, height,
+        [&] { ms::flip(pixels.data(), width, height); });
+    time("RGBA in place (before)", iterations, width, height,
+        [&] { in_place_flip(pixels, width, height, true); });
+    time("RGBA in place, flip_abgr_to_argb()", iterations, width, height,
+        [&] { ms::flip_abgr_to_argb(pixels.data(), width, height); });
+
+    // With them the (read only) mapping is copied into the snapshot
+    time("BGRA from mapping, copy_flipped()", iterations, width, height,
+        [&] { ms::copy_flipped(readback.data(), pixels.data(), width, height); });
+    time("RGBA from mapping, copy_flipped_abgr_to_argb()", iterations, width, height,
+        [&] { ms::copy_flipped_abgr_to_argb(readback.data(), pixels.data(), width, height); });
+
+    exit(0);
+}
@@ -0,0 +1,214 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/surface_stack.h"
+#include "mir/scene/scene_report.h"
+#include "mir/compositor/scene_element.h"
+#include "mir/graphics/renderable.h"
+#include "mir/test/doubles/stub_scene_surface.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace ms = mir::scene;
+namespace mi = mir::input;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace std::chrono;
+
+namespace
+{
+struct NullSceneReport : ms::SceneReport
+{
+    void surface_created(BasicSurfaceId, std::string const&) override {}
+    void surface_added(BasicSurfaceId, std::string const&) override {}
+    void surface_removed(BasicSurfaceId, std::string const&) override {}
+    void surface_deleted(BasicSurfaceId, std::string const&) override {}
+};
+
+struct BenchmarkRenderable : mg::Renderable
+{
+    BenchmarkRenderable(geom::Rectangle const& position) : position{position} {}
+
+    ID id() const override { return this; }
+    std::shared_ptr<mg::Buffer> buffer() const override { return {}; }
+    geom::Rectangle screen_position() const override { return position; }
+    float alpha() const override { return 1.0f; }
+    glm::mat4 transformation() const override { return glm::mat4(1); }
+    bool shaped() const override { return false; }
+    unsigned int swap_interval() const override { return 1; }
+
+    geom::Rectangle const position;
+};
+
+struct BenchmarkSurface : mtd::StubSceneSurface
+{
+    BenchmarkSurface(geom::Rectangle const& position) : renderable{std::make_shared<BenchmarkRenderable>(position)} {}
+
+    mg::RenderableList generate_renderables(mc::CompositorID) const override
+    {
+        return {renderable};
+    }
+
+    bool could_appear_in(geom::Rectangle const& area) const override
+    {
+        return area.overlaps(renderable->position);
+    }
+
+    std::shared_ptr<BenchmarkRenderable> const renderable;
+};
+
+// Outputs are side by side, and the surfaces spread evenly over them
+geom::Rectangle output_area(int output)
+{
+    return {{output * 1920, 0}, {1920, 1080}};
+}
+
+geom::Rectangle surface_position(int surface, int output_count)
+{
+    return {output_area(surface % output_count).top_left + geom::Displacement{surface % 7 * 100, 0}, {640, 480}};
+}
+
+struct Latencies
+{
+    std::vector<int64_t> samples;
+
+    void print(char const* name, duration<double> run_time)
+    {
+        std::sort(samples.begin(), samples.end());
+        auto const at = [this](double percentile)
+            {
+                return samples[std::min(samples.size() - 1, static_cast<size_t>(percentile / 100.0 * samples.size()))] / 1000.0;
+            };
+
+        std::cout << "  " << name << ": " << static_cast<int64_t>(samples.size() / run_time.count()) << "/s"
+                  << " p50=" << at(50) << "us p99=" << at(99) << "us max=" << samples.back() / 1000.0 << "us"
+                  << std::endl;
+    }
+};
+
+template<typename Operation>
+void time_each(std::atomic<bool> const& running, Latencies& latencies, Operation const& operation)
+{
+    while (running)
+    {
+        auto const start = steady_clock::now();
+        operation();
+        latencies.samples.push_back(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" [number of outputs] [number of surfaces] [seconds]"<<std::endl;
+        exit(1);
+    }
+
+    int const output_count = argc > 1 ? std::atoi(argv[1]) : 8;
+    int const surface_count = argc > 2 ? std::atoi(argv[2]) : 64;
+    auto const run_time = seconds{argc > 3 ? std::atoi(argv[3]) : 2};
+
+    ms::SurfaceStack stack{std::make_shared<NullSceneReport>()};
+
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+    for (int i = 0; i != surface_count; ++i)
+    {
+        surfaces.push_back(std::make_shared<BenchmarkSurface>(surface_position(i, output_count)));
+        stack.add_surface(surfaces.back(), mi::InputReceptionMode::normal);
+    }
+
+    std::atomic<bool> running{true};
+
+    // One compositor per output, each composing as fast as it can
+    std::vector<Latencies> compositor_latencies(output_count);
+    std::vector<std::thread> threads;
+    for (int i = 0; i != output_count; ++i)
+    {
+        stack.register_compositor(&compositor_latencies[i]);
+        stack.set_view_area(&compositor_latencies[i], output_area(i));
+
+        threads.emplace_back([&, i]
+            {
+                mc::CompositorID const id{&compositor_latencies[i]};
+                time_each(running, compositor_latencies[i], [&]
+                    {
+                        for (auto const& element : stack.scene_elements_for(id))
+                            element->rendered();
+                    });
+            });
+    }
+
+    // The input dispatcher hit-testing pointer motion
+    Latencies input_latencies;
+    threads.emplace_back([&]
+        {
+            time_each(running, input_latencies, [&] { stack.surface_at({320, 240}); });
+        });
+
+    // A window manager restacking, and occasionally replacing, surfaces
+    Latencies shell_latencies;
+    threads.emplace_back([&]
+        {
+            unsigned int next{0};
+            time_each(running, shell_latencies, [&]
+                {
+                    auto const index = next++ % surfaces.size();
+                    auto& surface = surfaces[index];
+                    if (next % 64 == 0)
+                    {
+                        stack.remove_surface(surface);
+                        surface = std::make_shared<BenchmarkSurface>(surface_position(index, output_count));
+                        stack.add_surface(surface, mi::InputReceptionMode::normal);
+                    }
+                    else
+                    {
+                        stack.raise(surface);
+                    }
+                });
+        });
+
+    std::this_thread::sleep_for(run_time);
+    running = false;
+
+    for (auto& thread : threads)
+        thread.join();
+
+    std::cout << output_count << " outputs, " << surface_count << " surfaces:" << std::endl;
+    for (int i = 0; i != output_count; ++i)
+    {
+        auto const name = "output " + std::to_string(i) + " scene_elements_for";
+        compositor_latencies[i].print(name.c_str(), run_time);
+    }
+    input_latencies.print("surface_at", run_time);
+    shell_latencies.print("restack", run_time);
+
+    for (int i = 0; i != output_count; ++i)
+        stack.unregister_compositor(&compositor_latencies[i]);
+
+    exit(0);
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/time/timer_wheel_alarm_factory.h"
+#include "mir/time/steady_clock.h"
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdlib>
+#include <poll.h>
+
+namespace md = mir::dispatch;
+namespace mt = mir::time;
+
+namespace
+{
+bool fd_becomes_readable(int fd, int timeout_ms)
+{
+    struct pollfd poller {
+        fd,
+        POLLIN,
+        0
+    };
+    return poll(&poller, 1, timeout_ms) > 0;
+}
+
+template<typename Step>
+void time_step(char const* name, size_t alarm_count, Step const& step)
+{
+    auto const start = std::chrono::steady_clock::now();
+    step();
+    auto const duration = std::chrono::steady_clock::now() - start;
+
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    std::cout << name << " " << alarm_count << " alarms took " << ns << "ns"
+              << " (" << ns / alarm_count << "ns per alarm)" << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 2)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" [number of alarms]"<<std::endl;
+        exit(1);
+    }
+
+    size_t const alarm_count = argc == 2 ? std::atoll(argv[1]) : 10000;
+
+    mt::TimerWheelAlarmFactory factory{std::make_shared<mt::SteadyClock>()};
+
+    size_t fired{0};
+    std::vector<std::unique_ptr<mt::Alarm>> alarms;
+    alarms.reserve(alarm_count);
+
+    time_step("Creating", alarm_count, [&]
+        {
+            for (size_t i = 0; i != alarm_count; ++i)
+                alarms.push_back(factory.create_alarm([&fired] { ++fired; }));
+        });
+
+    // Spread the alarms over a minute, like a busy server's key repeats and pings
+    time_step("Scheduling", alarm_count, [&]
+        {
+            for (size_t i = 0; i != alarm_count; ++i)
+                alarms[i]->reschedule_in(std::chrono::milliseconds{1000 + (i * 7919) % 60000});
+        });
+
+    time_step("Rescheduling", alarm_count, [&]
+        {
+            for (size_t i = 0; i != alarm_count; ++i)
+                alarms[i]->reschedule_in(std::chrono::milliseconds{1000 + (i * 104729) % 60000});
+        });
+
+    time_step("Cancelling", alarm_count, [&]
+        {
+            for (auto const& alarm : alarms)
+                alarm->cancel();
+        });
+
+    // Everything due at once, as after a stall of the main loop
+    for (auto const& alarm : alarms)
+        alarm->reschedule_in(std::chrono::milliseconds{0});
+
+    time_step("Firing", alarm_count, [&]
+        {
+            while (fired < alarm_count)
+            {
+                if (fd_becomes_readable(factory.watch_fd(), 1000))
+                    factory.dispatch(md::FdEvent::readable);
+            }
+        });
+
+    time_step("Destroying", alarm_count, [&] { alarms.clear(); });
+
+    exit(0);
+}
@@ -22,10 +22,13 @@
 #include "mir/dispatch/dispatchable.h"
 #include "mir/posix_rw_mutex.h"
 
+#include <deque>
 #include <functional>
 #include <initializer_list>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <string>
 
 #include <pthread.h>
 
@@ -48,6 +51,12 @@ enum class DispatchReentrancy
 
 /**
  * \brief An adaptor that combines multiple Dispatchables into a single Dispatchable
+ *
+ * Ready dispatchees are taken from the kernel in batches and queued, so one
+ * call to dispatch() may handle several of them, each at most once, in the
+ * order they became ready. Other threads dispatching the same instance take
+ * work from the queue rather than waiting behind a slow dispatchee.
+ *
  * \note Instances are fully thread-safe.
  */
 class MultiplexingDispatchable final : public Dispatchable
@@ -94,11 +103,26 @@ public:
      * \param [in] fd   File descriptor of watch to remove.
      */
     void remove_watch(Fd const& fd);
+
+    /**
+     * \brief How long the dispatchee watching \p fd waits to be dispatched once ready
+     * \returns A one-line summary of the delays, or an empty string if \p fd is not watched
+     */
+    std::string queueing_delay(Fd const& fd);
 private:
+    struct Watch;
+
+    std::shared_ptr<Watch> wait_for_ready();
+    std::shared_ptr<Watch> take_ready(Watch* const* dispatched, int dispatched_count);
+
     PosixRWMutex lifetime_mutex;
-    std::list<std::pair<std::shared_ptr<Dispatchable>, bool>> dispatchee_holder;
+    std::list<std::shared_ptr<Watch>> watches;
+
+    std::mutex ready_mutex;
+    std::deque<std::shared_ptr<Watch>> ready;
 
     Fd epoll_fd;
+    Fd ready_fd;
 };
 }
 }
@@ -19,6 +19,7 @@
 #ifndef MIR_DISPATCH_SIMPLE_DISPATCH_THREAD_H_
 #define MIR_DISPATCH_SIMPLE_DISPATCH_THREAD_H_
 
+#include <chrono>
 #include <string>
 #include <memory>
 #include <thread>
@@ -47,16 +48,46 @@ public:
     void add_thread();
     void remove_thread();
 
+    /**
+     * \brief Let the number of threads follow the load
+     *
+     * Whenever a thread starts dispatching while every other thread is in
+     * the dispatchee too another thread is started, up to \p max_threads, so
+     * a dispatchee blocked or busy in dispatch() doesn't hold up the rest.
+     * Threads that haven't dispatched anything for \p idle_timeout exit,
+     * down to \p min_threads. (Threads already waiting for work when this
+     * is first called only start timing out once they next wake.)
+     *
+     * A MultiplexingDispatchable dispatchee keeps each of its sequential
+     * sources in order and shares its ready sources between the threads.
+     *
+     * Until this is called the dispatchee is dispatched directly, with no
+     * load monitoring. Don't call it from within the dispatchee.
+     */
+    void set_thread_limits(unsigned int min_threads,
+                           unsigned int max_threads,
+                           std::chrono::milliseconds idle_timeout = std::chrono::seconds{5});
+
+    /// The number of threads currently running
+    unsigned int thread_count();
+
     class ThreadShutdownRequestHandler;
+    class ThreadLoadMonitor;
 private:
+    void start_thread();
+    void add_thread_if_below_limit();
+    void join_retired_threads();
 
     std::string const name_base;
 
     std::shared_ptr<ThreadShutdownRequestHandler> thread_exiter;
+    std::shared_ptr<ThreadLoadMonitor> load_monitor;
     std::shared_ptr<MultiplexingDispatchable> dispatcher;
+    std::shared_ptr<Dispatchable> const dispatchee;
 
     std::mutex thread_pool_mutex;
     std::vector<std::thread> threadpool;
+    bool load_monitored;
 
     std::function<void()> const exception_handler;
 };
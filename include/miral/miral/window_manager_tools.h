@@ -70,6 +70,10 @@ public:
  *  @{ */
 
     /** count the applications
+     *
+     * \note Like active_window() and active_output(), this may also be called
+     * from a thread that doesn't hold the lock: it then doesn't wait for the
+     * lock, and reflects the model when the lock was last released.
      *
      * @return number of applications
      */
@@ -110,6 +114,29 @@ public:
      */
     auto info_for(Window const& window) const -> WindowInfo&;
 
+    /** retrieve a read only copy of the metadata for an application
+     *
+     * \note Unlike info_for(), this may also be called from a thread that
+     * doesn't hold the lock. It then doesn't wait for the lock (except on the
+     * first such call, to take the copies), and reflects the model when the
+     * lock was last released.
+     *
+     * @param application   the application
+     * @return              a copy of the metadata
+     * @throw               std::out_of_range if the application isn't known
+     */
+    auto info_snapshot_for(Application const& application) const -> std::shared_ptr<ApplicationInfo const>;
+
+    /** retrieve a read only copy of the metadata for a window
+     *
+     * \note May be called without holding the lock (see info_snapshot_for(Application const&))
+     *
+     * @param window    the window
+     * @return          a copy of the metadata
+     * @throw           std::out_of_range if the window isn't known
+     */
+    auto info_snapshot_for(Window const& window) const -> std::shared_ptr<WindowInfo const>;
+
     /** retrieve metadata for a persistent surface id
      *
      * @param id        the persistent surface id
@@ -133,6 +160,7 @@ public:
     void force_close(Window const& window);
 
     /// retrieve the active window
+    /// \note May be called without holding the lock (see count_applications())
     auto active_window() const -> Window;
 
     /** select a new active window based on the hint
@@ -161,6 +189,7 @@ public:
     auto window_at(mir::geometry::Point cursor) const -> Window;
 
     /// Find the active output area
+    /// \note May be called without holding the lock (see count_applications())
     auto active_output() -> mir::geometry::Rectangle const;
 
     /// Raise window and all its children
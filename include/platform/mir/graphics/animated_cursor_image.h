@@ -0,0 +1,51 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_ANIMATED_CURSOR_IMAGE_H_
+#define MIR_GRAPHICS_ANIMATED_CURSOR_IMAGE_H_
+
+#include "mir/graphics/cursor_image.h"
+
+#include <chrono>
+#include <cstddef>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * A cursor image that cycles through a sequence of frames.
+ *
+ * As a plain CursorImage it describes the first frame, so cursors that
+ * cannot animate still show something sensible.
+ */
+class AnimatedCursorImage : public CursorImage
+{
+public:
+    virtual std::size_t frame_count() const = 0;
+    virtual CursorImage const& frame(std::size_t index) const = 0;
+
+    /// How long frame \a index is shown before moving on to the next
+    virtual std::chrono::milliseconds frame_delay(std::size_t index) const = 0;
+
+protected:
+    AnimatedCursorImage() = default;
+};
+}
+}
+
+
+#endif /* MIR_GRAPHICS_ANIMATED_CURSOR_IMAGE_H_ */
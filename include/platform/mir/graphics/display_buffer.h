@@ -68,6 +68,18 @@ public:
     **/
     virtual bool overlay(RenderableList const& renderlist) = 0;
 
+    /** Show the top-most renderables of renderlist directly in hardware,
+     *  e.g. on overlay planes, if overlay() could not take the whole list.
+     *  \param [in] renderlist
+     *      The renderables that should appear on the screen.
+     *  \returns
+     *      The number of renderables, counted from the back (top) of
+     *      renderlist, that the hardware will show on top of the next frame.
+     *      The caller should composite only the renderables before them.
+     *      The default, for hardware without overlay planes, is none.
+    **/
+    virtual std::size_t overlay_topmost(RenderableList const& /*renderlist*/) { return 0; }
+
     /**
      * Returns a transformation that the renderer must apply to all rendering.
      * There is usually no transformation required (just the identity matrix)
@@ -135,6 +135,11 @@ struct DisplayConfigurationOutput
 
     mir::optional_value<geometry::Size> custom_logical_size;
 
+    /** Whether the output can vary its refresh rate to follow the frames shown (adaptive sync) */
+    bool adaptive_sync_supported{false};
+    /** Whether to refresh the output as frames arrive, rather than at the mode's fixed rate */
+    bool adaptive_sync{false};
+
     /** The logical rectangle occupied by the output, based on its position,
         current mode and orientation (rotation) */
     geometry::Rectangle extents() const;
@@ -178,6 +183,8 @@ struct UserDisplayConfigurationOutput
     MirOutputGammaSupported const& gamma_supported;
     std::vector<uint8_t const> const& edid;
     mir::optional_value<geometry::Size>& custom_logical_size;
+    bool const& adaptive_sync_supported;
+    bool& adaptive_sync;
 
     UserDisplayConfigurationOutput(DisplayConfigurationOutput& master);
     geometry::Rectangle extents() const;
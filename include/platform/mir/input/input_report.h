@@ -41,6 +41,9 @@ public:
     virtual void opened_input_device(char const* device_name, char const* input_platform) = 0;
     virtual void failed_to_open_input_device(char const* device_name, char const* input_platform) = 0;
 
+    /// An input event passed the event filter chain and is being delivered to a surface
+    virtual void dispatched_event(int64_t /*event_time*/) {}
+
 protected:
     InputReport() = default;
     InputReport(InputReport const&) = delete;
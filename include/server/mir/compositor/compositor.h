@@ -32,6 +32,17 @@ public:
     virtual void start() = 0;
     virtual void stop() = 0;
 
+    /**
+     * Stop compositing while the display is paused (e.g. on a VT switch),
+     * keeping rendering resources for the unchanged display buffers.
+     * Does not return while a frame is being posted.
+     *
+     * The default just stop()s.
+     */
+    virtual void pause() { stop(); }
+    /// Resume compositing after pause() to the same display buffers; the default just start()s
+    virtual void resume() { start(); }
+
 protected:
     Compositor() = default;
     Compositor(Compositor const&) = delete;
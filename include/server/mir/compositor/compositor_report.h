@@ -21,6 +21,8 @@
 
 #include "mir/graphics/renderable.h"
 
+#include <chrono>
+
 namespace mir
 {
 namespace compositor
@@ -35,6 +37,10 @@ public:
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
     virtual void finished_frame(SubCompositorId id) = 0;
+    /// A scheduled frame was not rendered or posted as nothing had changed
+    virtual void skipped_frame(SubCompositorId /*id*/) {}
+    /// The first frame after Compositor::resume() was posted, \a time_to_first_frame after resuming
+    virtual void resumed_frame(SubCompositorId /*id*/, std::chrono::nanoseconds /*time_to_first_frame*/) {}
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
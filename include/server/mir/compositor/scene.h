@@ -20,6 +20,7 @@
 #define MIR_COMPOSITOR_SCENE_H_
 
 #include "compositor_id.h"
+#include "mir/geometry/rectangle.h"
 
 #include <memory>
 #include <vector>
@@ -68,6 +69,15 @@ public:
     virtual void register_compositor(CompositorID id) = 0;
     virtual void unregister_compositor(CompositorID id) = 0;
 
+    /**
+     * Tell the scene which part of it a registered compositor displays.
+     * Surfaces that cannot appear within view_area are culled from
+     * scene_elements_for(id) (and treated as occluded there) without their
+     * content being snapshot. Compositors that never set a view area are
+     * given every element, as are all compositors by scenes that don't cull.
+     */
+    virtual void set_view_area(CompositorID /*id*/, geometry::Rectangle const& /*view_area*/) {}
+
     virtual void add_observer(std::shared_ptr<scene::Observer> const& observer) = 0;
     virtual void remove_observer(std::weak_ptr<scene::Observer> const& observer) = 0;
 
@@ -19,6 +19,7 @@
 #ifndef MIR_GRAPHICS_DISPLAY_CONFIGURATION_OBSERVER_
 #define MIR_GRAPHICS_DISPLAY_CONFIGURATION_OBSERVER_
 
+#include <chrono>
 #include <exception>
 #include <memory>
 
@@ -54,6 +55,19 @@ public:
      */
     virtual void configuration_applied(std::shared_ptr<DisplayConfiguration const> const& config) = 0;
 
+    /**
+     * Notification of how long the last successful display configuration took.
+     *
+     * This is called after configuration_applied().
+     *
+     * \param [in] duration     Time from starting to apply the configuration until
+     *                          every output was compositing again.
+     * \param [in] incremental  true if the configuration was applied without stopping
+     *                          compositing; false if compositing was stopped on every
+     *                          output while the display buffers were recreated.
+     */
+    virtual void configuration_timing(std::chrono::nanoseconds /*duration*/, bool /*incremental*/) {}
+
     /**
      * Notification after updating base display configuration.
      *
@@ -59,6 +59,18 @@ public:
     virtual void register_session(frontend::Session const* session, std::function<void()> const& pinger) = 0;
     virtual void unregister_session(frontend::Session const* session) = 0;
     virtual void pong_received(frontend::Session const* received_for) = 0;
+    /**
+     * A function for the frontend to call on each message the session sends;
+     * any message shows the client is responding.
+     *
+     * \note It is called for every message, so must not need any locks in
+     *       the common case. Calls after the session is unregistered are
+     *       ignored.
+     */
+    virtual std::function<void()> activity_notifier(frontend::Session const* /*session*/)
+    {
+        return []{};
+    }
 
     virtual void register_observer(std::shared_ptr<Observer> const& observer) = 0;
     virtual void unregister_observer(std::shared_ptr<Observer> const& observer) = 0;
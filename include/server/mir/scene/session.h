@@ -40,6 +40,14 @@ public:
     virtual pid_t process_id() const = 0;
 
     virtual void take_snapshot(SnapshotCallback const& snapshot_taken) = 0;
+    /**
+     * Like take_snapshot(), but scaled to size; unchanged content is not re-read.
+     * The default doesn't scale, it just takes a snapshot.
+     */
+    virtual void take_thumbnail(geometry::Size const& /*size*/, SnapshotCallback const& thumbnail_taken)
+    {
+        take_snapshot(thumbnail_taken);
+    }
     virtual std::shared_ptr<Surface> default_surface() const = 0;
     virtual void set_lifecycle_state(MirLifecycleState state) = 0;
 
@@ -64,6 +64,10 @@ public:
     virtual geometry::Size size() const = 0;
 
     virtual graphics::RenderableList generate_renderables(compositor::CompositorID id) const = 0; 
+    /// Whether any of the surface's streams could appear within area; by default, assume so
+    virtual bool could_appear_in(geometry::Rectangle const& /*area*/) const { return true; }
+    /// The area covered by the surface and its streams (which may be displaced beyond it)
+    virtual geometry::Rectangle stream_extents() const { return {top_left(), size()}; }
     virtual int buffers_ready_for_compositor(void const* compositor_id) const = 0;
 
     virtual MirWindowType type() const = 0;
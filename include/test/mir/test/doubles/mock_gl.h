@@ -53,6 +53,8 @@ public:
     MOCK_METHOD4(glClearColor, void(GLclampf, GLclampf, GLclampf, GLclampf));
     MOCK_METHOD4(glColorMask, void(GLboolean, GLboolean, GLboolean, GLboolean));
     MOCK_METHOD1(glCompileShader, void(GLuint));
+    MOCK_METHOD8(glCopyTexSubImage2D,
+                 void(GLenum, GLint, GLint, GLint, GLint, GLint, GLsizei, GLsizei));
     MOCK_METHOD0(glCreateProgram, GLuint());
     MOCK_METHOD1(glCreateShader, GLuint(GLenum));
     MOCK_METHOD2(glDeleteBuffers, void(GLsizei, const GLuint *));
@@ -67,6 +69,7 @@ public:
     MOCK_METHOD1(glEnable, void(GLenum));
     MOCK_METHOD1(glEnableVertexAttribArray, void(GLuint));
     MOCK_METHOD0(glFinish, void());
+    MOCK_METHOD0(glFlush, void());
     MOCK_METHOD4(glFramebufferRenderbuffer,
                  void(GLenum, GLenum, GLenum, GLuint));
     MOCK_METHOD5(glFramebufferTexture2D,
@@ -109,6 +112,7 @@ public:
                  void(GLuint, GLint, GLenum, GLboolean, GLsizei,
                       const GLvoid *));
     MOCK_METHOD4(glViewport, void(GLint, GLint, GLsizei, GLsizei));
+    MOCK_METHOD4(glScissor, void(GLint, GLint, GLsizei, GLsizei));
     MOCK_METHOD1(glGenerateMipmap, void(GLenum target));
     MOCK_METHOD4(glDrawElements, void(GLenum, GLsizei, GLenum, const GLvoid*));
 };
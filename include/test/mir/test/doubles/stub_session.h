@@ -41,6 +41,8 @@ struct StubSession : scene::Session
 
     void take_snapshot(scene::SnapshotCallback const& snapshot_taken) override;
 
+    void take_thumbnail(geometry::Size const& size, scene::SnapshotCallback const& thumbnail_taken) override;
+
     std::shared_ptr<scene::Surface> default_surface() const override;
 
     void set_lifecycle_state(MirLifecycleState state) override;
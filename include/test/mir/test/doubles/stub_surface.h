@@ -49,6 +49,7 @@ struct StubSurface : scene::Surface
     void set_transformation(glm::mat4 const&) override;
     bool visible() const override;
     graphics::RenderableList generate_renderables(compositor::CompositorID id) const override;
+    bool could_appear_in(geometry::Rectangle const& area) const override;
     int buffers_ready_for_compositor(void const* compositor_id) const override;
     MirWindowType type() const override;
     MirWindowState state() const override;
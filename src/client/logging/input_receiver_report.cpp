@@ -33,13 +33,24 @@ namespace mcll = mir::client::logging;
 namespace
 {
 std::string const component{"input-receiver"};
+auto const latency_summary_interval = std::chrono::seconds(10);
 }
 
 mcll::InputReceiverReport::InputReceiverReport(std::shared_ptr<ml::Logger> const& logger)
-    : logger{logger}
+    : logger{logger},
+      last_summary{std::chrono::steady_clock::now()}
 {
 }
 
+mcll::InputReceiverReport::~InputReceiverReport()
+{
+    // Summaries are only logged as input arrives, so the last period is
+    // still pending if input stopped
+    std::lock_guard<std::mutex> lock{summary_mutex};
+    if (receipt_latency.count() > 0)
+        flush_latency_summary();
+}
+
 void mcll::InputReceiverReport::received_event(
     MirEvent const& event)
 {
@@ -48,4 +59,34 @@ void mcll::InputReceiverReport::received_event(
     ss << "Received event:" << event << std::endl;
 
     logger->log(ml::Severity::debug, ss.str(), component);
+
+    if (mir_event_get_type(&event) == mir_event_type_input)
+    {
+        // Input event times are CLOCK_MONOTONIC, as is steady_clock
+        auto const now = std::chrono::steady_clock::now();
+        auto const event_time = mir_input_event_get_event_time(mir_event_get_input_event(&event));
+        receipt_latency.record(now.time_since_epoch() - std::chrono::nanoseconds(event_time));
+
+        log_latency_summary(now);
+    }
+}
+
+void mcll::InputReceiverReport::log_latency_summary(std::chrono::steady_clock::time_point now)
+{
+    std::unique_lock<std::mutex> lock{summary_mutex, std::try_to_lock};
+    if (!lock.owns_lock() || now - last_summary < latency_summary_interval)
+        return;
+
+    last_summary = now;
+    flush_latency_summary();
+}
+
+void mcll::InputReceiverReport::flush_latency_summary()
+{
+    logger->log(
+        ml::Severity::informational,
+        "Latency summary stage=receipt " + receipt_latency.summary(),
+        component);
+
+    receipt_latency.reset();
 }
@@ -20,8 +20,11 @@
 #define MIR_CLIENT_LOGGING_INPUT_RECEIVER_REPORT_H_
 
 #include "mir/input/input_receiver_report.h"
+#include "mir/logging/latency_histogram.h"
 
+#include <chrono>
 #include <memory>
+#include <mutex>
 
 namespace mir
 {
@@ -40,11 +43,21 @@ class InputReceiverReport : public input::receiver::InputReceiverReport
 {
 public:
     InputReceiverReport(std::shared_ptr<mir::logging::Logger> const& logger);
+    ~InputReceiverReport();
 
     void received_event(MirEvent const& event) override;
 
 private:
+    void log_latency_summary(std::chrono::steady_clock::time_point now);
+    void flush_latency_summary();
+
     std::shared_ptr<mir::logging::Logger> const logger;
+
+    // Latency from the event timestamp to receipt by the client
+    mir::logging::LatencyHistogram receipt_latency;
+
+    std::mutex summary_mutex; // Protects the following...
+    std::chrono::steady_clock::time_point last_summary;
 };
 
 }
@@ -20,11 +20,16 @@
 #include "utils.h"
 #include "mir/raii.h"
 #include "mir/posix_rw_mutex.h"
+#include "mir/logging/latency_histogram.h"
 
 #include <boost/throw_exception.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <shared_mutex>
 
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <poll.h>
 #include <limits.h>
 #include <unistd.h>
@@ -36,6 +41,10 @@ namespace md = mir::dispatch;
 
 namespace
 {
+// The most ready sources taken from epoll at once, and the most one call to
+// dispatch() will handle.
+int const max_events_per_dispatch{16};
+
 class DispatchableAdaptor : public md::Dispatchable
 {
 public:
@@ -71,9 +80,32 @@ private:
 
 }
 
+struct md::MultiplexingDispatchable::Watch : std::enable_shared_from_this<Watch>
+{
+    Watch(std::shared_ptr<Dispatchable> const& dispatchee, bool rearm)
+        : dispatchee{dispatchee},
+          rearm{rearm}
+    {
+    }
+
+    std::shared_ptr<Dispatchable> const dispatchee;
+    bool const rearm;
+    // Set before the watch is dropped, so that a source already taken from
+    // epoll can tell its dispatchee has gone.
+    std::atomic<bool> removed{false};
+
+    // Guarded by ready_mutex
+    bool queued{false};
+    uint32_t ready_events{0};
+    std::chrono::steady_clock::time_point ready_since;
+
+    mir::logging::LatencyHistogram queueing_delay;
+};
+
 md::MultiplexingDispatchable::MultiplexingDispatchable()
     : lifetime_mutex{PosixRWMutex::Type::PreferWriterNonRecursive},
-      epoll_fd{mir::Fd{::epoll_create1(EPOLL_CLOEXEC)}}
+      epoll_fd{mir::Fd{::epoll_create1(EPOLL_CLOEXEC)}},
+      ready_fd{mir::Fd{::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)}}
 {
     if (epoll_fd == mir::Fd::invalid)
     {
@@ -81,6 +113,25 @@ md::MultiplexingDispatchable::MultiplexingDispatchable()
                                                  std::system_category(),
                                                  "Failed to create epoll monitor"}));
     }
+    if (ready_fd == mir::Fd::invalid)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno,
+                                                 std::system_category(),
+                                                 "Failed to create ready queue notifier"}));
+    }
+
+    // Keeps our fd readable while there are sources queued for dispatch, so
+    // that idle threads share the work of a batch taken by a busy one.
+    epoll_event e;
+    ::memset(&e, 0, sizeof(e));
+    e.events = EPOLLIN;
+    e.data.ptr = nullptr;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, ready_fd, &e) < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno,
+                                                 std::system_category(),
+                                                 "Failed to monitor ready queue notifier"}));
+    }
 }
 
 md::MultiplexingDispatchable::~MultiplexingDispatchable() noexcept
@@ -108,14 +159,64 @@ bool md::MultiplexingDispatchable::dispatch(md::FdEvents events)
         return false;
     }
 
-    std::shared_ptr<md::Dispatchable> source;
-    bool rearm_source{false};
-    epoll_event event;
+    std::array<Watch*, max_events_per_dispatch> dispatched{};
+    int dispatched_count{0};
+
+    auto source = take_ready(dispatched.data(), dispatched_count);
+    if (!source)
+    {
+        source = wait_for_ready();
+    }
+
+    if (!source)
+    {
+        // Some other thread must have stolen the event we were woken for;
+        // that's ok, just return.
+        return true;
+    }
+
+    SourceDispatchObserver::notify_source_taken();
+
+    do
+    {
+        dispatched[dispatched_count++] = source.get();
+
+        epoll_event event;
+        ::memset(&event, 0, sizeof(event));
+        auto const now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<decltype(ready_mutex)> lock{ready_mutex};
+            event.events = source->ready_events;
+            source->queueing_delay.record(now - source->ready_since);
+        }
+
+        if (!source->dispatchee->dispatch(epoll_to_fd_event(event)))
+        {
+            remove_watch(source->dispatchee);
+        }
+        else if (source->rearm && !source->removed)
+        {
+            event.events = fd_event_to_epoll(source->dispatchee->relevant_events()) | EPOLLONESHOT;
+            event.data.ptr = static_cast<void*>(source.get());
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->dispatchee->watch_fd(), &event);
+        }
+    }
+    while (dispatched_count != max_events_per_dispatch &&
+           (source = take_ready(dispatched.data(), dispatched_count)));
+
+    return true;
+}
+
+auto md::MultiplexingDispatchable::wait_for_ready() -> std::shared_ptr<Watch>
+{
+    std::array<epoll_event, max_events_per_dispatch> events_ready;
+    std::array<std::shared_ptr<Watch>, max_events_per_dispatch> sources;
+    int source_count{0};
 
     {
         std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
 
-        auto result = epoll_wait(epoll_fd, &event, 1, 0);
+        auto const result = epoll_wait(epoll_fd, events_ready.data(), max_events_per_dispatch, 0);
 
         if (result < 0)
         {
@@ -124,30 +225,101 @@ bool md::MultiplexingDispatchable::dispatch(md::FdEvents events)
                                                      "Failed to wait on fds"}));
         }
 
-        if (result == 0)
+        for (int i = 0; i != result; ++i)
         {
-            // Some other thread must have stolen the event we were woken for;
-            // that's ok, just return.
-            return true;
+            // The ready queue notifier; whatever is queued we'll pick up in dispatch()
+            if (!events_ready[i].data.ptr)
+                continue;
+
+            auto const source = static_cast<Watch*>(events_ready[i].data.ptr);
+            sources[source_count] = source->shared_from_this();
+            events_ready[source_count] = events_ready[i];
+            ++source_count;
         }
+    }
+
+    if (source_count == 0)
+    {
+        return {};
+    }
 
-        auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(event.data.ptr);
+    auto const now = std::chrono::steady_clock::now();
+    std::lock_guard<decltype(ready_mutex)> lock{ready_mutex};
 
-        source = event_source->first;
-        rearm_source = event_source->second;
+    // We dispatch the first source; the rest join the ready queue for us or
+    // any other thread to take. (A level-triggered reentrant source may
+    // already be there, in which case it needs no second entry.)
+    if (sources[0]->queued)
+    {
+        sources[0]->ready_events |= events_ready[0].events;
+    }
+    else
+    {
+        sources[0]->ready_events = events_ready[0].events;
+        sources[0]->ready_since = now;
     }
 
-    if (!source->dispatch(epoll_to_fd_event(event)))
+    auto const was_empty = ready.empty();
+    for (int i = 1; i != source_count; ++i)
     {
-        remove_watch(source);
+        auto& source = sources[i];
+        if (source->removed)
+            continue;
+
+        if (source->queued)
+        {
+            source->ready_events |= events_ready[i].events;
+        }
+        else
+        {
+            source->queued = true;
+            source->ready_events = events_ready[i].events;
+            source->ready_since = now;
+            ready.push_back(std::move(source));
+        }
     }
-    else if (rearm_source)
+
+    if (was_empty && !ready.empty())
     {
-        event.events = fd_event_to_epoll(source->relevant_events()) | EPOLLONESHOT;
-        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->watch_fd(), &event);
+        eventfd_write(ready_fd, 1);
     }
 
-    return true;
+    return std::move(sources[0]);
+}
+
+auto md::MultiplexingDispatchable::take_ready(Watch* const* dispatched, int dispatched_count)
+    -> std::shared_ptr<Watch>
+{
+    std::lock_guard<decltype(ready_mutex)> lock{ready_mutex};
+
+    while (!ready.empty())
+    {
+        // Each call to dispatch() handles a source at most once, as callers
+        // such as ThreadedDispatcher expect; a source already handled in this
+        // call is left for the next one.
+        if (std::find(dispatched, dispatched + dispatched_count, ready.front().get()) !=
+            dispatched + dispatched_count)
+        {
+            return {};
+        }
+
+        auto source = std::move(ready.front());
+        ready.pop_front();
+        source->queued = false;
+
+        if (ready.empty())
+        {
+            eventfd_t dummy;
+            eventfd_read(ready_fd, &dummy);
+        }
+
+        if (!source->removed)
+        {
+            return source;
+        }
+    }
+
+    return {};
 }
 
 md::FdEvents md::MultiplexingDispatchable::relevant_events() const
@@ -163,12 +335,11 @@ void md::MultiplexingDispatchable::add_watch(std::shared_ptr<md::Dispatchable> c
 void md::MultiplexingDispatchable::add_watch(std::shared_ptr<md::Dispatchable> const& dispatchee,
                                              DispatchReentrancy reentrancy)
 {
-    decltype(dispatchee_holder)::iterator new_holder;
+    decltype(watches)::iterator new_watch;
     {
         std::unique_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
-        new_holder = dispatchee_holder.emplace(dispatchee_holder.begin(),
-                                               dispatchee,
-                                               reentrancy == DispatchReentrancy::sequential);
+        new_watch = watches.emplace(watches.begin(),
+                                    std::make_shared<Watch>(dispatchee, reentrancy == DispatchReentrancy::sequential));
     }
 
     epoll_event e;
@@ -179,11 +350,11 @@ void md::MultiplexingDispatchable::add_watch(std::shared_ptr<md::Dispatchable> c
     {
         e.events |= EPOLLONESHOT;
     }
-    e.data.ptr = static_cast<void*>(&(*new_holder));
+    e.data.ptr = static_cast<void*>(new_watch->get());
     if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, dispatchee->watch_fd(), &e) < 0)
     {
         std::unique_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
-        dispatchee_holder.erase(new_holder);
+        watches.erase(new_watch);
         if (errno == EEXIST)
         {
             BOOST_THROW_EXCEPTION((std::logic_error{"Attempted to monitor the same fd twice"}));
@@ -222,9 +393,45 @@ void md::MultiplexingDispatchable::remove_watch(Fd const& fd)
                                                  "Failed to remove fd monitor"}));
     }
 
-    std::unique_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
-    dispatchee_holder.remove_if([&fd](std::pair<std::shared_ptr<Dispatchable>,bool> const& candidate)
     {
-        return candidate.first->watch_fd() == fd;
-    });
+        std::unique_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
+        watches.remove_if([&fd](std::shared_ptr<Watch> const& candidate)
+        {
+            if (candidate->dispatchee->watch_fd() == fd)
+            {
+                candidate->removed = true;
+                return true;
+            }
+            return false;
+        });
+    }
+
+    // Don't keep the dispatchee alive in the ready queue
+    std::lock_guard<decltype(ready_mutex)> lock{ready_mutex};
+    auto const removed = std::remove_if(ready.begin(), ready.end(),
+        [](std::shared_ptr<Watch> const& candidate) { return candidate->removed.load(); });
+    if (removed != ready.end())
+    {
+        ready.erase(removed, ready.end());
+        if (ready.empty())
+        {
+            eventfd_t dummy;
+            eventfd_read(ready_fd, &dummy);
+        }
+    }
+}
+
+std::string md::MultiplexingDispatchable::queueing_delay(Fd const& fd)
+{
+    std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
+
+    for (auto const& watch : watches)
+    {
+        if (watch->dispatchee->watch_fd() == fd)
+        {
+            return watch->queueing_delay.summary();
+        }
+    }
+
+    return {};
 }
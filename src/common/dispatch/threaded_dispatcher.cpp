@@ -18,6 +18,7 @@
 
 #include "mir/dispatch/threaded_dispatcher.h"
 #include "mir/dispatch/dispatchable.h"
+#include "utils.h"
 #include "mir/signal_blocker.h"
 #include "mir/thread_name.h"
 
@@ -27,10 +28,13 @@
 #include <fcntl.h>
 #include <poll.h>
 #include <unistd.h>
+#include <atomic>
+#include <stdexcept>
 #include <system_error>
 #include <signal.h>
 #include <boost/exception/all.hpp>
 #include <algorithm>
+#include <chrono>
 #include <unordered_map>
 #include <sys/eventfd.h>
 
@@ -141,6 +145,30 @@ public:
         }
     }
 
+    /**
+     * Lets an idle thread leave, unless that would take us below \p min_threads
+     * \returns true if the calling thread should exit
+     */
+    bool retire_thread(unsigned int min_threads)
+    {
+        std::lock_guard<decltype(running_flag_guard)> lock{running_flag_guard};
+
+        if (shutting_down || running_flags.size() <= min_threads)
+        {
+            return false;
+        }
+
+        running_flags.erase(std::this_thread::get_id());
+        retired_threads.push_back(std::this_thread::get_id());
+        return true;
+    }
+
+    std::vector<std::thread::id> take_retired_threads()
+    {
+        std::lock_guard<decltype(running_flag_guard)> lock{running_flag_guard};
+        return std::move(retired_threads);
+    }
+
     void unregister_thread()
     {
         {
@@ -167,13 +195,247 @@ private:
 
     std::mutex running_flag_guard;
     std::unordered_map<std::thread::id, bool*> running_flags;
+    std::vector<std::thread::id> retired_threads;
     bool shutting_down;
 };
 
 namespace
 {
+using IdleClock = std::chrono::steady_clock;
+
+// When the dispatch thread running on this thread last did any work
+thread_local IdleClock::time_point last_work_on_this_thread;
+}
+
+class md::ThreadedDispatcher::ThreadLoadMonitor
+{
+public:
+    ThreadLoadMonitor(std::function<void()> const& add_thread)
+        : add_thread{add_thread},
+          adaptive{false},
+          min_threads{1},
+          max_threads{1},
+          idle_timeout_ms{-1},
+          threads{0},
+          busy_threads{0},
+          peak_busy_threads{0},
+          needed_threads{1}
+    {
+    }
+
+    void set_limits(unsigned int min, unsigned int max, std::chrono::milliseconds idle_timeout)
+    {
+        {
+            std::lock_guard<std::mutex> lock{window_mutex};
+            window_start = IdleClock::now();
+            needed_threads = max;
+        }
+        min_threads = min;
+        max_threads = max;
+        idle_timeout_ms = idle_timeout.count();
+        adaptive = true;
+    }
+
+    /**
+     * How long the calling thread may wait for work before it has been idle
+     * for too long; -1 for ever
+     */
+    int wait_timeout() const
+    {
+        if (!adaptive)
+        {
+            return -1;
+        }
+
+        auto const idle = std::chrono::duration_cast<std::chrono::milliseconds>(
+            IdleClock::now() - last_work_on_this_thread);
+        return std::max<int>(idle_timeout_ms - idle.count(), 0);
+    }
+
+    unsigned int minimum_threads() const
+    {
+        return min_threads;
+    }
+
+    unsigned int maximum_threads() const
+    {
+        return max_threads;
+    }
+
+    /// Counted from when it's created, so work arriving meanwhile doesn't add another
+    void thread_created()
+    {
+        ++threads;
+    }
+
+    void thread_started()
+    {
+        last_work_on_this_thread = IdleClock::now();
+    }
+
+    void thread_stopped()
+    {
+        --threads;
+    }
+
+    /// The calling thread stays, so starts a fresh idle period
+    void thread_kept()
+    {
+        last_work_on_this_thread = IdleClock::now();
+    }
+
+    /**
+     * How many threads the pool needs, if fewer than it has: one more than
+     * were ever busy at once over the last idle timeout. Otherwise 0.
+     *
+     * Whichever thread wakes first takes the work, so under light traffic
+     * every thread does a little of it and none is ever idle for long. The
+     * surplus can only be seen across the pool.
+     */
+    unsigned int threads_needed_if_surplus()
+    {
+        if (!adaptive)
+        {
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock{window_mutex};
+        auto const now = IdleClock::now();
+        if (now - window_start >= std::chrono::milliseconds{idle_timeout_ms})
+        {
+            needed_threads = std::max<unsigned int>(min_threads, peak_busy_threads + 1);
+            peak_busy_threads = busy_threads.load();
+            window_start = now;
+        }
+
+        return threads > needed_threads ? needed_threads : 0;
+    }
+
+    // Called around the dispatchee's dispatch(). Waking up only to find another
+    // thread has taken the work doesn't count; every thread polls the same fd.
+    void work_starting()
+    {
+        // Once this thread is busy nobody may be left to pick up new work
+        auto const busy = ++busy_threads;
+
+        auto peak = peak_busy_threads.load();
+        while (busy > peak && !peak_busy_threads.compare_exchange_weak(peak, busy))
+        {
+        }
+
+        if (adaptive && busy >= threads && threads < max_threads)
+        {
+            add_thread();
+        }
+    }
+
+    void work_finished()
+    {
+        --busy_threads;
+        last_work_on_this_thread = IdleClock::now();
+    }
+
+private:
+    std::function<void()> const add_thread;
+
+    std::atomic<bool> adaptive;
+    std::atomic<unsigned int> min_threads;
+    std::atomic<unsigned int> max_threads;
+    std::atomic<int> idle_timeout_ms;
+
+    std::atomic<unsigned int> threads;
+    std::atomic<unsigned int> busy_threads;
+    std::atomic<unsigned int> peak_busy_threads;
+
+    std::mutex window_mutex;
+    IdleClock::time_point window_start;
+    unsigned int needed_threads;
+};
+
+namespace
+{
+/// Counts the thread busy from when a MultiplexingDispatchable gives it a source
+class BusyOnceSourceTaken : public md::SourceDispatchObserver
+{
+public:
+    BusyOnceSourceTaken(md::ThreadedDispatcher::ThreadLoadMonitor& load_monitor)
+        : load_monitor{load_monitor}
+    {
+    }
+
+    ~BusyOnceSourceTaken()
+    {
+        if (busy)
+        {
+            load_monitor.work_finished();
+        }
+    }
+
+    void source_taken() override
+    {
+        // Nested multiplexers each report the same work
+        if (!busy)
+        {
+            busy = true;
+            load_monitor.work_starting();
+        }
+    }
+
+private:
+    md::ThreadedDispatcher::ThreadLoadMonitor& load_monitor;
+    bool busy{false};
+};
+
+/// Reports to the ThreadLoadMonitor while the dispatchee is actually running
+class LoadMonitoredDispatchable : public md::Dispatchable
+{
+public:
+    LoadMonitoredDispatchable(
+        std::shared_ptr<md::Dispatchable> const& dispatchee,
+        std::shared_ptr<md::ThreadedDispatcher::ThreadLoadMonitor> const& load_monitor)
+        : dispatchee{dispatchee},
+          load_monitor{load_monitor},
+          multiplexed{std::dynamic_pointer_cast<md::MultiplexingDispatchable>(dispatchee) != nullptr}
+    {
+    }
+
+    mir::Fd watch_fd() const override
+    {
+        return dispatchee->watch_fd();
+    }
+
+    bool dispatch(md::FdEvents events) override
+    {
+        // Each event wakes every thread, and a MultiplexingDispatchable gives
+        // its sources to only one of them: the rest have nothing to do, so
+        // aren't busy
+        if (multiplexed)
+        {
+            BusyOnceSourceTaken const busy{*load_monitor};
+            return dispatchee->dispatch(events);
+        }
+
+        auto const busy = mir::raii::paired_calls(
+            [this]() { load_monitor->work_starting(); },
+            [this]() { load_monitor->work_finished(); });
+
+        return dispatchee->dispatch(events);
+    }
+
+    md::FdEvents relevant_events() const override
+    {
+        return dispatchee->relevant_events();
+    }
+
+private:
+    std::shared_ptr<md::Dispatchable> const dispatchee;
+    std::shared_ptr<md::ThreadedDispatcher::ThreadLoadMonitor> const load_monitor;
+    bool const multiplexed;
+};
+
 void dispatch_loop(std::string const& name,
     std::shared_ptr<md::ThreadedDispatcher::ThreadShutdownRequestHandler> thread_register,
+    std::shared_ptr<md::ThreadedDispatcher::ThreadLoadMonitor> load_monitor,
     std::shared_ptr<md::Dispatchable> dispatcher,
     std::function<void()> const& exception_handler)
 {
@@ -182,15 +444,22 @@ void dispatch_loop(std::string const& name,
     // This does not have to be std::atomic<bool> because thread_register is guaranteed to
     // only ever be dispatch()ed from one thread at a time.
     bool running{true};
+    // Set if we leave for want of work, rather than being told to
+    bool retired{false};
 
     auto thread_registrar = mir::raii::paired_calls(
-    [&running, thread_register]()
+    [&running, thread_register, load_monitor]()
     {
         thread_register->register_thread(running);
+        load_monitor->thread_started();
     },
-    [thread_register]()
+    [&retired, thread_register, load_monitor]()
     {
-        thread_register->unregister_thread();
+        load_monitor->thread_stopped();
+        if (!retired)
+        {
+            thread_register->unregister_thread();
+        }
     });
 
     try
@@ -200,7 +469,20 @@ void dispatch_loop(std::string const& name,
         waiter.events = POLL_IN;
         while (running)
         {
-            if (poll(&waiter, 1, -1) < 0)
+            auto const timeout = load_monitor->wait_timeout();
+            if (timeout == 0)
+            {
+                retired = thread_register->retire_thread(load_monitor->minimum_threads());
+                if (retired)
+                {
+                    break;
+                }
+                load_monitor->thread_kept();
+                continue;
+            }
+
+            auto const result = poll(&waiter, 1, timeout);
+            if (result < 0)
             {
                 if (errno == EINTR)
                     continue;
@@ -208,7 +490,20 @@ void dispatch_loop(std::string const& name,
                                                          std::system_category(),
                                                          "Failed to wait for event"}));
             }
-            dispatcher->dispatch(md::FdEvent::readable);
+
+            if (result > 0)
+            {
+                dispatcher->dispatch(md::FdEvent::readable);
+
+                if (auto const needed = load_monitor->threads_needed_if_surplus())
+                {
+                    retired = thread_register->retire_thread(needed);
+                    if (retired)
+                    {
+                        break;
+                    }
+                }
+            }
         }
     }
     catch(...)
@@ -228,7 +523,10 @@ md::ThreadedDispatcher::ThreadedDispatcher(std::string const& name,
                                            std::function<void()> const& exception_handler)
     : name_base{name},
       thread_exiter{std::make_shared<ThreadShutdownRequestHandler>()},
+      load_monitor{std::make_shared<ThreadLoadMonitor>([this]() { add_thread_if_below_limit(); })},
       dispatcher{std::make_shared<MultiplexingDispatchable>()},
+      dispatchee{dispatchee},
+      load_monitored{false},
       exception_handler{exception_handler}
 {
 
@@ -239,8 +537,7 @@ md::ThreadedDispatcher::ThreadedDispatcher(std::string const& name,
     // as desired.
     dispatcher->add_watch(dispatchee, md::DispatchReentrancy::reentrant);
 
-    mir::SignalBlocker blocker;
-    threadpool.emplace_back(&dispatch_loop, name_base, thread_exiter, dispatcher, exception_handler);
+    start_thread();
 }
 
 md::ThreadedDispatcher::~ThreadedDispatcher() noexcept
@@ -272,8 +569,8 @@ md::ThreadedDispatcher::~ThreadedDispatcher() noexcept
 void md::ThreadedDispatcher::add_thread()
 {
     std::lock_guard<decltype(thread_pool_mutex)> lock{thread_pool_mutex};
-    mir::SignalBlocker blocker;
-    threadpool.emplace_back(&dispatch_loop, name_base, thread_exiter, dispatcher, exception_handler);
+    join_retired_threads();
+    start_thread();
 }
 
 void md::ThreadedDispatcher::remove_thread()
@@ -282,6 +579,7 @@ void md::ThreadedDispatcher::remove_thread()
 
     // Find that thread in our vector, join() it, then remove it.
     std::lock_guard<decltype(thread_pool_mutex)> threadpool_lock{thread_pool_mutex};
+    join_retired_threads();
 
     auto dying_thread = std::find_if(threadpool.begin(),
                                      threadpool.end(),
@@ -289,6 +587,91 @@ void md::ThreadedDispatcher::remove_thread()
     {
             return candidate.get_id() == terminated_thread_id;
     });
-    dying_thread->join();
-    threadpool.erase(dying_thread);
+
+    // join_retired_threads() may already have reaped it
+    if (dying_thread != threadpool.end())
+    {
+        dying_thread->join();
+        threadpool.erase(dying_thread);
+    }
+}
+
+void md::ThreadedDispatcher::set_thread_limits(
+    unsigned int min_threads,
+    unsigned int max_threads,
+    std::chrono::milliseconds idle_timeout)
+{
+    if (min_threads == 0 || min_threads > max_threads)
+    {
+        BOOST_THROW_EXCEPTION((std::invalid_argument{"Invalid thread limits"}));
+    }
+
+    std::lock_guard<decltype(thread_pool_mutex)> lock{thread_pool_mutex};
+
+    // Only pay for watching the load once there's a thread count to adapt
+    if (!load_monitored)
+    {
+        dispatcher->remove_watch(dispatchee);
+        dispatcher->add_watch(
+            std::make_shared<LoadMonitoredDispatchable>(dispatchee, load_monitor),
+            md::DispatchReentrancy::reentrant);
+        load_monitored = true;
+    }
+
+    load_monitor->set_limits(min_threads, max_threads, idle_timeout);
+
+    join_retired_threads();
+
+    while (threadpool.size() < min_threads)
+    {
+        start_thread();
+    }
+}
+
+unsigned int md::ThreadedDispatcher::thread_count()
+{
+    std::lock_guard<decltype(thread_pool_mutex)> lock{thread_pool_mutex};
+    join_retired_threads();
+    return threadpool.size();
+}
+
+void md::ThreadedDispatcher::add_thread_if_below_limit()
+{
+    // Called from our threads; if the pool is being changed (or destroyed)
+    // there's no need to add to it.
+    std::unique_lock<decltype(thread_pool_mutex)> lock{thread_pool_mutex, std::try_to_lock};
+    if (!lock.owns_lock())
+    {
+        return;
+    }
+
+    join_retired_threads();
+
+    if (threadpool.size() < load_monitor->maximum_threads())
+    {
+        start_thread();
+    }
+}
+
+void md::ThreadedDispatcher::start_thread()
+{
+    load_monitor->thread_created();
+
+    mir::SignalBlocker blocker;
+    threadpool.emplace_back(&dispatch_loop, name_base, thread_exiter, load_monitor, dispatcher, exception_handler);
+}
+
+void md::ThreadedDispatcher::join_retired_threads()
+{
+    for (auto const& retired_thread_id : thread_exiter->take_retired_threads())
+    {
+        auto retired_thread = std::find_if(threadpool.begin(),
+                                           threadpool.end(),
+                                           [&retired_thread_id](std::thread const& candidate)
+        {
+            return candidate.get_id() == retired_thread_id;
+        });
+        retired_thread->join();
+        threadpool.erase(retired_thread);
+    }
 }
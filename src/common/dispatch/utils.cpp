@@ -63,3 +63,27 @@ int md::fd_event_to_epoll(FdEvents const& event)
     }
     return epoll_value;
 }
+
+namespace
+{
+thread_local md::SourceDispatchObserver* source_dispatch_observer{nullptr};
+}
+
+md::SourceDispatchObserver::SourceDispatchObserver()
+    : previous{source_dispatch_observer}
+{
+    source_dispatch_observer = this;
+}
+
+md::SourceDispatchObserver::~SourceDispatchObserver()
+{
+    source_dispatch_observer = previous;
+}
+
+void md::SourceDispatchObserver::notify_source_taken()
+{
+    if (source_dispatch_observer)
+    {
+        source_dispatch_observer->source_taken();
+    }
+}
@@ -31,6 +31,30 @@ FdEvents epoll_to_fd_event(epoll_event const& event);
 
 int fd_event_to_epoll(FdEvents const& event);
 
+/**
+ * Hears when a MultiplexingDispatchable dispatched on this thread takes one of
+ * its sources to dispatch, so knows that the thread has work rather than
+ * having been woken for an event another thread took.
+ */
+class SourceDispatchObserver
+{
+public:
+    /// Installs this observer for the calling thread, until destroyed
+    SourceDispatchObserver();
+    virtual ~SourceDispatchObserver();
+
+    virtual void source_taken() = 0;
+
+    /// Tells the calling thread's observer, if any, that a source was taken
+    static void notify_source_taken();
+
+private:
+    SourceDispatchObserver(SourceDispatchObserver const&) = delete;
+    SourceDispatchObserver& operator=(SourceDispatchObserver const&) = delete;
+
+    SourceDispatchObserver* const previous;
+};
+
 }
 }
 
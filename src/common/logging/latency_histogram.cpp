@@ -0,0 +1,154 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/latency_histogram.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace ml = mir::logging;
+using namespace std::chrono;
+
+namespace
+{
+unsigned int highest_bit(uint64_t value)
+{
+    return 63 - __builtin_clzll(value);
+}
+
+void append_ms(std::string& out, char const* label, nanoseconds value)
+{
+    long long const usec = duration_cast<microseconds>(value).count();
+
+    char str[48];
+    snprintf(str, sizeof str, " %s=%lld.%03lldms", label, usec / 1000LL, usec % 1000LL);
+    out += str;
+}
+}
+
+ml::LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+unsigned int ml::LatencyHistogram::bucket_for(uint64_t usec)
+{
+    if (usec < sub_buckets)
+        return usec;
+
+    auto const octave = highest_bit(usec);
+    if (octave >= octaves)
+        return bucket_count - 1;
+
+    auto const shift = octave - 2;
+    auto const sub_bucket = (usec >> shift) & (sub_buckets - 1);
+
+    return sub_buckets + shift * sub_buckets + sub_bucket;
+}
+
+uint64_t ml::LatencyHistogram::bucket_upper_bound(unsigned int bucket)
+{
+    if (bucket < sub_buckets)
+        return bucket + 1;
+
+    auto const shift = (bucket - sub_buckets) / sub_buckets;
+    auto const sub_bucket = (bucket - sub_buckets) % sub_buckets;
+    uint64_t const lower = uint64_t{sub_buckets + sub_bucket} << shift;
+
+    return lower + (uint64_t{1} << shift);
+}
+
+void ml::LatencyHistogram::record(nanoseconds latency)
+{
+    // Clock skew between the event source and us can yield small negative values
+    int64_t const ns = latency.count() < 0 ? 0 : latency.count();
+
+    buckets[bucket_for(ns / 1000)].fetch_add(1, std::memory_order_relaxed);
+
+    auto current_max = max_ns.load(std::memory_order_relaxed);
+    while (ns > current_max &&
+           !max_ns.compare_exchange_weak(current_max, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t ml::LatencyHistogram::count() const
+{
+    uint64_t total{0};
+    for (auto const& bucket : buckets)
+        total += bucket.load(std::memory_order_relaxed);
+    return total;
+}
+
+nanoseconds ml::LatencyHistogram::max() const
+{
+    return nanoseconds{max_ns.load(std::memory_order_relaxed)};
+}
+
+nanoseconds ml::LatencyHistogram::percentile(double percentile) const
+{
+    std::array<uint64_t, bucket_count> snapshot;
+    uint64_t total{0};
+    for (unsigned int i = 0; i != bucket_count; ++i)
+    {
+        snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+        total += snapshot[i];
+    }
+
+    if (total == 0)
+        return nanoseconds{0};
+
+    if (percentile < 0.0) percentile = 0.0;
+    if (percentile > 100.0) percentile = 100.0;
+
+    // The rank of the sample we're looking for (1-based, rounded up)
+    auto rank = static_cast<uint64_t>(percentile / 100.0 * total);
+    if (rank * 100.0 < percentile * total || rank == 0)
+        ++rank;
+
+    uint64_t seen{0};
+    for (unsigned int i = 0; i != bucket_count; ++i)
+    {
+        seen += snapshot[i];
+        if (seen >= rank)
+        {
+            // Don't report a bucket bound beyond what we actually observed
+            nanoseconds const bound = microseconds{bucket_upper_bound(i)};
+            return std::min(bound, max());
+        }
+    }
+
+    return max();
+}
+
+std::string ml::LatencyHistogram::summary() const
+{
+    std::string result{"count=" + std::to_string(count())};
+
+    append_ms(result, "p50", percentile(50));
+    append_ms(result, "p90", percentile(90));
+    append_ms(result, "p99", percentile(99));
+    append_ms(result, "max", max());
+
+    return result;
+}
+
+void ml::LatencyHistogram::reset()
+{
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_LOGGING_LATENCY_HISTOGRAM_H_
+#define MIR_LOGGING_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace mir
+{
+namespace logging
+{
+
+/**
+ * A fixed-bucket histogram of latencies.
+ *
+ * Buckets are spaced logarithmically (four per power of two microseconds)
+ * so the relative error of any reported percentile is bounded at 25%
+ * from 1us up to roughly 16 seconds. Larger values are clamped into the
+ * last bucket.
+ *
+ * record() is lock-free and may be called concurrently from any thread;
+ * readers see a consistent-enough view for reporting purposes.
+ */
+class LatencyHistogram
+{
+public:
+    static unsigned int const sub_buckets = 4;
+    static unsigned int const octaves = 24;
+    static unsigned int const bucket_count = sub_buckets + (octaves - 2) * sub_buckets;
+
+    LatencyHistogram();
+
+    void record(std::chrono::nanoseconds latency);
+
+    /// Number of samples recorded since construction or the last reset()
+    uint64_t count() const;
+
+    /// The largest sample recorded since construction or the last reset()
+    std::chrono::nanoseconds max() const;
+
+    /**
+     * Upper bound of the bucket containing the given percentile.
+     * \param [in] percentile  in the range [0, 100]
+     * \returns zero if no samples have been recorded
+     */
+    std::chrono::nanoseconds percentile(double percentile) const;
+
+    /// A one-line human readable summary ("count=... p50=...ms ...")
+    std::string summary() const;
+
+    void reset();
+
+    /// Index of the bucket a latency of the given number of microseconds falls into
+    static unsigned int bucket_for(uint64_t usec);
+    /// Exclusive upper bound, in microseconds, of the given bucket
+    static uint64_t bucket_upper_bound(unsigned int bucket);
+
+private:
+    LatencyHistogram(LatencyHistogram const&) = delete;
+    LatencyHistogram& operator=(LatencyHistogram const&) = delete;
+
+    std::array<std::atomic<uint64_t>, bucket_count> buckets;
+    std::atomic<int64_t> max_ns;
+};
+
+}
+}
+
+#endif // MIR_LOGGING_LATENCY_HISTOGRAM_H_
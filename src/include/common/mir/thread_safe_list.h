@@ -20,10 +20,12 @@
 #ifndef MIR_THREAD_SAFE_LIST_H_
 #define MIR_THREAD_SAFE_LIST_H_
 
-#include "mir/recursive_read_write_mutex.h"
-
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <vector>
 
 namespace mir
 {
@@ -31,86 +33,176 @@ namespace mir
 /*
  * Requirements for type 'Element'
  *  - for_each():
- *    - copy-assignable
+ *    - copy-constructible
  *  - add():
- *    - copy-assignable
+ *    - copy-constructible
  *    - conversion to bool: indicates whether this is a valid element
  *  - remove(), remove_all():
- *    - copy-assignable
- *    - Element{}: default construction should create an invalid element
+ *    - copy-constructible
  *    - bool operator==: equality of elements
- *    - bool operator!=: inequality of elements
- *  - clear():
- *    - copy-assignable
- *    - Element{}: value initialization should create an invalid element
+ *
+ * Iteration is wait-free: each item holds a pointer to an immutable copy of
+ * its element, and readers only count themselves in and out of the item.
+ * Writers swap the pointer and wait for the readers already counted in to
+ * leave before reclaiming the copy (RCU style). So, as before, once remove()
+ * returns the element is no longer in use on any other thread. A writer
+ * spins briefly, then sleeps until a reader leaving the item wakes it;
+ * readers only touch the lock when a writer is waiting.
+ *
+ * An element removed from within its own for_each() callback stays valid
+ * until the outermost for_each() on that thread returns.
  */
 
 template<class Element>
 class ThreadSafeList
 {
 public:
+    ThreadSafeList() = default;
+    ~ThreadSafeList();
+
     void add(Element const& element);
     void remove(Element const& element);
     unsigned int remove_all(Element const& element);
     void clear();
-    void for_each(std::function<void(Element const& element)> const& f);
+    /// \param f   invoked as f(Element const&)
+    template<typename F>
+    void for_each(F const& f);
 
 private:
     struct ListItem
     {
         ListItem() {}
-        RecursiveReadWriteMutex mutex;
-        Element element{};
+        std::atomic<Element const*> element{nullptr};
+        std::atomic<unsigned int> readers{0};
         std::atomic<ListItem*> next{nullptr};
 
         ~ListItem() { delete next.load(); }
     } head;
+
+    /// The items this thread is iterating, and the elements it removed while doing so
+    struct ThreadState
+    {
+        std::vector<ListItem const*> in_use;
+        std::vector<Element const*> retired;
+
+        ~ThreadState() { for (auto const element : retired) delete element; }
+    };
+
+    static ThreadState& this_thread();
+
+    /// Marks an item whose element is being removed, so it isn't reused before readers leave
+    static Element const* retiring();
+    static bool is_live(Element const* element) { return element && element != retiring(); }
+
+    void enter(ListItem& item) { ++item.readers; }
+    void leave(ListItem& item);
+
+    Element const* claim_if(ListItem& item, std::function<bool(Element const&)> const& predicate);
+    void retire(ListItem& item, Element const* element);
+
+    std::atomic<unsigned int> waiting_writers{0};
+    std::mutex writer_mutex;
+    std::condition_variable readers_left;
 };
 
 template<class Element>
-void ThreadSafeList<Element>::for_each(
-    std::function<void(Element const& element)> const& f)
+ThreadSafeList<Element>::~ThreadSafeList()
 {
-    ListItem* current_item = &head;
-
-    while (current_item)
+    for (ListItem* current_item = &head; current_item; current_item = current_item->next)
     {
-        RecursiveReadLock lock{current_item->mutex};
+        auto const element = current_item->element.load();
+        if (is_live(element)) delete element;
+    }
+}
 
-        // We need to take a copy in case we recursively remove during call
-        if (auto const copy_of_element = current_item->element) f(copy_of_element);
+template<class Element>
+auto ThreadSafeList<Element>::this_thread() -> ThreadState&
+{
+    static thread_local ThreadState state;
+    return state;
+}
 
-        current_item = current_item->next;
+template<class Element>
+Element const* ThreadSafeList<Element>::retiring()
+{
+    static char const marker{};
+    return reinterpret_cast<Element const*>(&marker);
+}
+
+template<class Element>
+void ThreadSafeList<Element>::leave(ListItem& item)
+{
+    --item.readers;
+
+    // Both are sequentially consistent, so either we see the writer waiting or it sees us gone
+    if (waiting_writers)
+    {
+        std::lock_guard<std::mutex> lock{writer_mutex};
+        readers_left.notify_all();
     }
 }
 
 template<class Element>
-void ThreadSafeList<Element>::add(Element const& element)
+template<typename F>
+void ThreadSafeList<Element>::for_each(F const& f)
 {
-    ListItem* current_item = &head;
+    auto& state = this_thread();
 
-    do
+    struct Hold
     {
-        // Note: we release the read lock to avoid two threads calling add at
-        // the same time mutually blocking the other's upgrade to write lock.
+        Hold(ThreadSafeList& list, ThreadState& state, ListItem* item) :
+            list{list}, state{state}, item{item}
         {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element) continue;
+            state.in_use.push_back(item);
+            list.enter(*item);
         }
 
-        RecursiveWriteLock lock{current_item->mutex};
-
-        if (!current_item->element)
+        ~Hold()
         {
-            current_item->element = element;
-            return;
+            list.leave(*item);
+            state.in_use.pop_back();
+
+            // Leaving the outermost iteration, elements removed inside it can go
+            if (state.in_use.empty() && !state.retired.empty())
+            {
+                for (auto const element : state.retired) delete element;
+                state.retired.clear();
+            }
         }
+
+        ThreadSafeList& list;
+        ThreadState& state;
+        ListItem* const item;
+    };
+
+    for (ListItem* current_item = &head; current_item; current_item = current_item->next)
+    {
+        Hold const hold{*this, state, current_item};
+
+        auto const element = current_item->element.load();
+        if (is_live(element)) f(*element);
+    }
+}
+
+template<class Element>
+void ThreadSafeList<Element>::add(Element const& element)
+{
+    if (!element) return;
+
+    auto const new_element = new Element(element);
+    ListItem* current_item = &head;
+
+    do
+    {
+        Element const* expected{nullptr};
+        if (current_item->element.compare_exchange_strong(expected, new_element))
+            return;
     }
     while (current_item->next && (current_item = current_item->next));
 
     // No empty Items so append a new one
     auto new_item = new ListItem;
-    new_item->element = element;
+    new_item->element = new_element;
 
     for (ListItem* expected{nullptr};
         !current_item->next.compare_exchange_weak(expected, new_item);
@@ -121,22 +213,62 @@ void ThreadSafeList<Element>::add(Element const& element)
 }
 
 template<class Element>
-void ThreadSafeList<Element>::remove(Element const& element)
+Element const* ThreadSafeList<Element>::claim_if(
+    ListItem& item,
+    std::function<bool(Element const&)> const& predicate)
 {
-    ListItem* current_item = &head;
+    // Count ourselves as a reader, so the element can't be reclaimed while we look at it
+    enter(item);
+    auto element = item.element.load();
+    auto const claimed = is_live(element) && predicate(*element) &&
+        item.element.compare_exchange_strong(element, retiring());
+    leave(item);
 
-    do
+    return claimed ? element : nullptr;
+}
+
+template<class Element>
+void ThreadSafeList<Element>::retire(ListItem& item, Element const* element)
+{
+    auto& state = this_thread();
+    auto const own_readers = static_cast<unsigned int>(
+        std::count(state.in_use.begin(), state.in_use.end(), &item));
+
+    // Readers that counted in before the claim may still be using the element
+    auto const readers_gone = [&item, own_readers] { return item.readers <= own_readers; };
+
+    // Most readers are only running a short callback, so don't sleep straight away
+    for (int spins = 0; spins != 100 && !readers_gone(); ++spins)
+        ;
+
+    if (!readers_gone())
     {
+        ++waiting_writers;
         {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
+            std::unique_lock<std::mutex> lock{writer_mutex};
+            readers_left.wait(lock, readers_gone);
         }
+        --waiting_writers;
+    }
 
-        RecursiveWriteLock lock{current_item->mutex};
+    item.element = nullptr;
+
+    if (own_readers)
+        state.retired.push_back(element);
+    else
+        delete element;
+}
+
+template<class Element>
+void ThreadSafeList<Element>::remove(Element const& element)
+{
+    ListItem* current_item = &head;
 
-        if (current_item->element == element)
+    do
+    {
+        if (auto const claimed = claim_if(*current_item, [&](Element const& e) { return e == element; }))
         {
-            current_item->element = Element{};
+            retire(*current_item, claimed);
             return;
         }
     }
@@ -151,16 +283,9 @@ unsigned int ThreadSafeList<Element>::remove_all(Element const& element)
 
     do
     {
+        if (auto const claimed = claim_if(*current_item, [&](Element const& e) { return e == element; }))
         {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
-        }
-
-        RecursiveWriteLock lock{current_item->mutex};
-
-        if (current_item->element == element)
-        {
-            current_item->element = Element{};
+            retire(*current_item, claimed);
             ++removed;
         }
     }
@@ -176,8 +301,8 @@ void ThreadSafeList<Element>::clear()
 
     do
     {
-        RecursiveWriteLock lock{current_item->mutex};
-        current_item->element = Element{};
+        if (auto const claimed = claim_if(*current_item, [](Element const&) { return true; }))
+            retire(*current_item, claimed);
     }
     while ((current_item = current_item->next));
 }
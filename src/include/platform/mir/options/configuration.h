@@ -52,6 +52,8 @@ extern char const* const cursor_opt;
 extern char const* const fatal_except_opt;
 extern char const* const debug_opt;
 extern char const* const composite_delay_opt;
+extern char const* const skip_unchanged_frames_opt;
+extern char const* const main_loop_opt;
 extern char const* const enable_key_repeat_opt;
 
 extern char const* const name_opt;
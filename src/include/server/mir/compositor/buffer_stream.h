@@ -25,6 +25,7 @@
 #include "mir_toolkit/common.h"
 #include "mir/graphics/buffer_id.h"
 
+#include <cstdint>
 #include <memory>
 
 namespace mir
@@ -49,6 +50,8 @@ public:
     virtual void drop_old_buffers() = 0;
     virtual bool has_submitted_buffer() const = 0;
     virtual bool framedropping() const = 0;
+    /// Increases with each submitted buffer, so callers can tell whether the content has changed
+    virtual uint64_t frames_submitted() const = 0;
 };
 
 }
@@ -56,6 +56,7 @@ class Drawer;
 class DisplayBufferCompositorFactory;
 class Compositor;
 class CompositorReport;
+class MirroredOutputs;
 }
 namespace frontend
 {
@@ -90,6 +91,7 @@ namespace detail { class FrontendShell; }
 namespace time
 {
 class Clock;
+class AlarmFactory;
 }
 namespace scene
 {
@@ -342,6 +344,8 @@ public:
     /** @} */
 
     virtual std::shared_ptr<time::Clock> the_clock();
+    /// Alarms for high-volume internal timers, dispatched from the main loop
+    virtual std::shared_ptr<time::AlarmFactory> the_alarm_factory();
     virtual std::shared_ptr<ServerActionQueue> the_server_action_queue();
     virtual std::shared_ptr<SharedLibraryProberReport>  the_shared_library_prober_report();
 
@@ -430,6 +434,7 @@ protected:
     CachedPtr<graphics::DisplayReport> display_report;
     CachedPtr<time::Clock> clock;
     CachedPtr<MainLoop> main_loop;
+    CachedPtr<time::AlarmFactory> alarm_factory;
     CachedPtr<ServerStatusListener> server_status_listener;
     CachedPtr<graphics::DisplayConfigurationPolicy> display_configuration_policy;
     CachedPtr<graphics::nested::MirClientHostConnection> host_connection;
@@ -474,6 +479,10 @@ private:
 
     CachedPtr<shell::detail::FrontendShell> frontend_shell;
     std::vector<mir::ExtensionDescription> the_extensions();
+
+    CachedPtr<compositor::MirroredOutputs> mirrored_outputs;
+
+    std::shared_ptr<compositor::MirroredOutputs> the_mirrored_outputs();
 };
 }
 
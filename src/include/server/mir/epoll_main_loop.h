@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_EPOLL_MAIN_LOOP_H_
+#define MIR_EPOLL_MAIN_LOOP_H_
+
+#include "mir/main_loop.h"
+#include "mir/time/timer_wheel_alarm_factory.h"
+#include "mir/fd.h"
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <signal.h>
+
+namespace mir
+{
+
+/**
+ * A MainLoop built directly on epoll.
+ *
+ * Fd handlers are epoll watches, alarms live in a TimerWheelAlarmFactory
+ * (one timerfd), signals arrive through a self-pipe and server actions are
+ * a queue woken by an eventfd. This avoids the per-iteration poll array
+ * rebuild and GMainContext locking of GLibMainLoop; the behaviour is
+ * otherwise the same.
+ */
+class EpollMainLoop : public MainLoop
+{
+public:
+    EpollMainLoop(std::shared_ptr<time::Clock> const& clock);
+    ~EpollMainLoop();
+
+    void run() override;
+    void stop() override;
+
+    void register_signal_handler(
+        std::initializer_list<int> signals,
+        std::function<void(int)> const& handler) override;
+
+    void register_signal_handler(
+        std::initializer_list<int> signals,
+        mir::UniqueModulePtr<std::function<void(int)>> handler) override;
+
+    void register_fd_handler(
+        std::initializer_list<int> fds,
+        void const* owner,
+        std::function<void(int)> const& handler) override;
+
+    void register_fd_handler(
+        std::initializer_list<int> fds,
+        void const* owner,
+        mir::UniqueModulePtr<std::function<void(int)>> handler) override;
+
+    void unregister_fd_handler(void const* owner) override;
+
+    void enqueue(void const* owner, ServerAction const& action) override;
+    void enqueue_with_guaranteed_execution(ServerAction const& action) override;
+
+    void pause_processing_for(void const* owner) override;
+    void resume_processing_for(void const* owner) override;
+
+    std::unique_ptr<mir::time::Alarm> create_alarm(
+        std::function<void()> const& callback) override;
+
+    std::unique_ptr<mir::time::Alarm> create_alarm(
+        std::unique_ptr<LockableCallback> callback) override;
+
+    void spawn(std::function<void()>&& work) override;
+
+    /// Blocks until the loop has completed an iteration that checked every source
+    void reprocess_all_sources();
+
+private:
+    struct FdHandler;
+    struct SignalHandler;
+    struct QueuedAction
+    {
+        void const* owner;
+        ServerAction action;
+        bool pausable;
+    };
+
+    void add_fd_handler(int fd, void const* owner, std::function<void(int)> const& handler);
+    void add_signal_handler(std::vector<int> const& signals, std::function<void(int)> const& handler);
+    void add_action(void const* owner, ServerAction const& action, bool pausable);
+
+    void watch(int fd);
+    void wake();
+    bool stop_pending();
+    void handle_stop();
+    void dispatch_fd(int fd);
+    void dispatch_signals();
+    void dispatch_alarms();
+    void dispatch_actions();
+    bool has_dispatchable_actions();
+    bool should_process_actions_for(void const* owner);
+    void handle_exception(std::exception_ptr const& e);
+
+    std::shared_ptr<time::Clock> const clock;
+    Fd const epoll_fd;
+    Fd const wake_fd;
+    Fd signal_read_fd;
+    Fd signal_write_fd;
+    time::TimerWheelAlarmFactory alarms;
+
+    std::atomic<bool> running;
+    std::atomic<bool> stop_requested;
+
+    std::mutex fd_handlers_mutex;
+    std::unordered_map<int, std::vector<std::shared_ptr<FdHandler>>> fd_handlers;
+
+    std::mutex signal_handlers_mutex;
+    std::vector<std::shared_ptr<SignalHandler>> signal_handlers;
+    std::unordered_map<int, struct sigaction> handled_signals;
+
+    std::mutex actions_mutex;
+    std::deque<QueuedAction> actions;
+    std::vector<void const*> do_not_process;
+
+    std::mutex run_on_halt_mutex;
+    std::deque<ServerAction> run_on_halt_queue;
+
+    std::exception_ptr main_loop_exception;
+};
+
+}
+
+#endif
@@ -27,6 +27,7 @@
 namespace mir
 {
 namespace graphics { class PlatformIpcOperations; }
+namespace input { class InputReport; }
 namespace frontend
 {
 class MessageProcessorReport;
@@ -48,7 +49,8 @@ public:
         std::shared_ptr<ProtobufIpcFactory> const& ipc_factory,
         std::shared_ptr<SessionAuthorizer> const& session_authorizer,
         std::shared_ptr<graphics::PlatformIpcOperations> const& operations,
-        std::shared_ptr<MessageProcessorReport> const& report);
+        std::shared_ptr<MessageProcessorReport> const& report,
+        std::shared_ptr<input::InputReport> const& input_report);
     ~ProtobufConnectionCreator() noexcept;
 
     void create_connection_for(
@@ -67,6 +69,7 @@ private:
     std::shared_ptr<SessionAuthorizer> const session_authorizer;
     std::shared_ptr<graphics::PlatformIpcOperations> const operations;
     std::shared_ptr<MessageProcessorReport> const report;
+    std::shared_ptr<input::InputReport> const input_report;
     std::atomic<int> next_session_id;
     std::shared_ptr<detail::Connections<detail::SocketConnection>> const connections;
 };
@@ -20,10 +20,13 @@
 #define MIR_SCENE_SESSION_CONTAINER_H_
 
 #include <functional>
+#include <string>
 #include <vector>
 #include <memory>
 #include <mutex>
 
+#include <sys/types.h>
+
 namespace mir
 {
 namespace scene
@@ -36,8 +39,14 @@ public:
     virtual void insert_session(std::shared_ptr<Session> const& session) = 0;
     virtual void remove_session(std::shared_ptr<Session> const& session) = 0;
 
+    /// f is called without any lock held, and may insert or remove sessions
     virtual void for_each(std::function<void(std::shared_ptr<Session> const&)> f) const = 0;
 
+    /// The sessions of process pid, in the order for_each would visit them
+    virtual std::vector<std::shared_ptr<Session>> sessions_of(pid_t pid) const = 0;
+    /// The sessions called name, in the order for_each would visit them
+    virtual std::vector<std::shared_ptr<Session>> sessions_named(std::string const& name) const = 0;
+
     // For convenience the successor of the null session is defined as the last session
     // which would be passed to the for_each callback
     virtual std::shared_ptr<Session> successor_of(std::shared_ptr<Session> const&) const = 0;
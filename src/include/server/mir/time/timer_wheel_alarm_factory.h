@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TIME_TIMER_WHEEL_ALARM_FACTORY_H_
+#define MIR_TIME_TIMER_WHEEL_ALARM_FACTORY_H_
+
+#include "mir/time/alarm_factory.h"
+#include "mir/dispatch/dispatchable.h"
+
+#include <chrono>
+#include <memory>
+
+namespace mir
+{
+namespace time
+{
+class Clock;
+
+/**
+ * An AlarmFactory whose alarms are kept in a hierarchical timer wheel
+ * and driven by a single timerfd.
+ *
+ * Scheduling, rescheduling and cancelling an alarm are O(1) regardless of
+ * how many alarms are pending, and only the (bounded) work of advancing the
+ * wheel is done when the timer fires.
+ *
+ * Alarm callbacks are invoked from dispatch(), so they run on whichever
+ * thread dispatches the watch_fd() - typically the server main loop.
+ */
+class TimerWheelAlarmFactory : public AlarmFactory, public dispatch::Dispatchable
+{
+public:
+    /**
+     * \param [in] clock       The clock used for scheduling
+     * \param [in] resolution  The granularity of the wheel; alarms never trigger
+     *                         early, but may be up to this late
+     */
+    TimerWheelAlarmFactory(
+        std::shared_ptr<Clock> const& clock,
+        std::chrono::nanoseconds resolution = std::chrono::milliseconds{1});
+    ~TimerWheelAlarmFactory();
+
+    std::unique_ptr<Alarm> create_alarm(std::function<void()> const& callback) override;
+    std::unique_ptr<Alarm> create_alarm(std::unique_ptr<LockableCallback> callback) override;
+
+    Fd watch_fd() const override;
+    bool dispatch(dispatch::FdEvents events) override;
+    dispatch::FdEvents relevant_events() const override;
+
+    /// The number of alarms currently scheduled
+    size_t pending_alarms() const;
+
+private:
+    class Wheel;
+    class AlarmImpl;
+
+    std::shared_ptr<Wheel> const wheel;
+};
+
+}
+}
+
+#endif // MIR_TIME_TIMER_WHEEL_ALARM_FACTORY_H_
@@ -28,9 +28,13 @@
 #include <mir/shell/persistent_surface_store.h>
 #include <mir/shell/surface_ready_observer.h>
 
+#define MIR_LOG_COMPONENT "miral::Window Management"
+#include <mir/log.h>
+
 #include <boost/throw_exception.hpp>
 
 #include <algorithm>
+#include <chrono>
 
 using namespace mir;
 using namespace mir::geometry;
@@ -38,25 +42,141 @@ using namespace mir::geometry;
 namespace
 {
 int const title_bar_height = 12;
+
+using LockClock = std::chrono::steady_clock;
+
+// Holding the lock for longer than a frame delays input delivery noticeably
+auto const slow_lock_hold = std::chrono::milliseconds{16};
+auto const lock_statistics_interval = std::chrono::minutes{1};
+
+auto as_ms(LockClock::duration duration) -> double
+{
+    return std::chrono::duration<double, std::milli>{duration}.count();
+}
 }
 
+/// Times how long each operation waits for, and holds, the mutex
+class miral::BasicWindowManager::LockStatistics
+{
+public:
+    struct Totals
+    {
+        uint64_t count{0};
+        LockClock::duration waited{};
+        LockClock::duration held{};
+        LockClock::duration max_held{};
+    };
+
+    // Keyed by __func__ of the locking operation
+    using PerOperation = std::map<char const*, Totals>;
+
+    /// What record() found worth logging, to be logged once the mutex is released
+    struct Report
+    {
+        char const* slow_operation{nullptr};
+        LockClock::duration slow_hold{};
+        PerOperation totals;
+
+        void log() const
+        {
+            if (slow_operation)
+            {
+                mir::log_warning("%s held the window management lock for %.1fms", slow_operation, as_ms(slow_hold));
+            }
+
+            for (auto const& operation : totals)
+            {
+                auto const& t = operation.second;
+                mir::log_debug("%s: locked %llu times, held for %.3fms mean, %.3fms max, waited %.3fms mean",
+                    operation.first, static_cast<unsigned long long>(t.count),
+                    as_ms(t.held) / t.count, as_ms(t.max_held), as_ms(t.waited) / t.count);
+            }
+        }
+    };
+
+    ~LockStatistics() { Report{nullptr, {}, std::move(per_operation)}.log(); }
+
+    // Called with the mutex held
+    auto record(char const* operation, LockClock::duration waited, LockClock::duration held) -> Report
+    {
+        Report report;
+
+        auto& totals = per_operation[operation];
+        ++totals.count;
+        totals.waited += waited;
+        totals.held += held;
+        totals.max_held = std::max(totals.max_held, held);
+
+        if (held > slow_lock_hold)
+        {
+            report.slow_operation = operation;
+            report.slow_hold = held;
+        }
+
+        auto const now = LockClock::now();
+        if (now - last_report > lock_statistics_interval)
+        {
+            report.totals.swap(per_operation);
+            last_report = now;
+        }
+
+        return report;
+    }
+
+private:
+    PerOperation per_operation;
+    LockClock::time_point last_report{LockClock::now()};
+};
+
+/// Holds the mutex, publishing the model state for lock-free queries and timing the hold on release
+struct miral::BasicWindowManager::TimedLock
+{
+    TimedLock(BasicWindowManager* self, char const* operation) :
+        self{self},
+        operation{operation},
+        requested{LockClock::now()},
+        lock{self->mutex},
+        acquired{LockClock::now()}
+    {
+        self->mutex_owner = std::this_thread::get_id();
+    }
+
+    ~TimedLock()
+    {
+        self->publish();
+        self->mutex_owner = std::thread::id{};
+        auto const report = self->lock_statistics->record(operation, acquired - requested, LockClock::now() - acquired);
+        lock.unlock();
+
+        // Logging may block, so don't do it while holding the mutex
+        report.log();
+    }
+
+    BasicWindowManager* const self;
+    char const* const operation;
+    LockClock::time_point const requested;
+    std::unique_lock<std::mutex> lock;
+    LockClock::time_point const acquired;
+};
+
 struct miral::BasicWindowManager::Locker
 {
-    explicit Locker(miral::BasicWindowManager* self);
+    Locker(miral::BasicWindowManager* self, char const* operation);
 
     ~Locker()
     {
         policy->advise_end();
     }
 
-    std::lock_guard<std::mutex> const lock;
+    TimedLock const lock;
     WindowManagementPolicy* const policy;
 };
 
-miral::BasicWindowManager::Locker::Locker(BasicWindowManager* self) :
-    lock{self->mutex},
+miral::BasicWindowManager::Locker::Locker(BasicWindowManager* self, char const* operation) :
+    lock{self, operation},
     policy{self->policy.get()}
 {
+    self->infos_may_have_changed = true;
     policy->advise_begin();
     std::vector<std::weak_ptr<Workspace>> workspaces;
     {
@@ -77,6 +197,7 @@ miral::BasicWindowManager::BasicWindowManager(
     focus_controller(focus_controller),
     display_layout(display_layout),
     persistent_surface_store{persistent_surface_store},
+    lock_statistics{std::make_unique<LockStatistics>()},
     policy(build(WindowManagerTools{this})),
     display_config_monitor{std::make_shared<DisplayConfigurationListeners>()}
 {
@@ -93,13 +214,13 @@ miral::BasicWindowManager::~BasicWindowManager()
 }
 void miral::BasicWindowManager::add_session(std::shared_ptr<scene::Session> const& session)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     policy->advise_new_app(app_info[session] = ApplicationInfo(session));
 }
 
 void miral::BasicWindowManager::remove_session(std::shared_ptr<scene::Session> const& session)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     policy->advise_delete_app(app_info[session]);
     app_info.erase(session);
 }
@@ -110,7 +231,7 @@ auto miral::BasicWindowManager::add_surface(
     std::function<frontend::SurfaceId(std::shared_ptr<scene::Session> const& session, scene::SurfaceCreationParameters const& params)> const& build)
 -> frontend::SurfaceId
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
 
     auto& session_info = info_for(session);
 
@@ -158,7 +279,7 @@ auto miral::BasicWindowManager::add_surface(
     std::shared_ptr<scene::Surface> const scene_surface = window_info.window();
     scene_surface->add_observer(std::make_shared<shell::SurfaceReadyObserver>(
         [this, &window_info](std::shared_ptr<scene::Session> const&, std::shared_ptr<scene::Surface> const&)
-            { Locker lock{this}; policy->handle_window_ready(window_info); },
+            { Locker lock{this, "handle_window_ready"}; policy->handle_window_ready(window_info); },
         session,
         scene_surface));
 
@@ -177,7 +298,7 @@ void miral::BasicWindowManager::modify_surface(
     std::shared_ptr<scene::Surface> const& surface,
     shell::SurfaceSpecification const& modifications)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     auto& info = info_for(surface);
     WindowSpecification mods{modifications};
     validate_modification_request(mods, info);
@@ -189,7 +310,7 @@ void miral::BasicWindowManager::remove_surface(
     std::shared_ptr<scene::Session> const& session,
     std::weak_ptr<scene::Surface> const& surface)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     remove_window(session, info_for(surface));
 }
 
@@ -312,26 +433,31 @@ void miral::BasicWindowManager::remove_display(geometry::Rectangle const& /*area
 
 bool miral::BasicWindowManager::handle_keyboard_event(MirKeyboardEvent const* event)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
+    // Input only changes the infos through the tools the policy calls
+    infos_may_have_changed = false;
     update_event_timestamp(event);
     return policy->handle_keyboard_event(event);
 }
 
 bool miral::BasicWindowManager::handle_touch_event(MirTouchEvent const* event)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
+    infos_may_have_changed = false;
     update_event_timestamp(event);
     return policy->handle_touch_event(event);
 }
 
 bool miral::BasicWindowManager::handle_pointer_event(MirPointerEvent const* event)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
+    infos_may_have_changed = false;
     update_event_timestamp(event);
 
     cursor = {
         mir_pointer_event_axis_value(event, mir_pointer_axis_x),
         mir_pointer_event_axis_value(event, mir_pointer_axis_y)};
+    published_cursor = cursor;
 
     return policy->handle_pointer_event(event);
 }
@@ -341,7 +467,7 @@ void miral::BasicWindowManager::handle_raise_surface(
     std::shared_ptr<scene::Surface> const& surface,
     uint64_t timestamp)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     if (timestamp >= last_input_event_timestamp)
         policy->handle_raise_window(info_for(surface));
 }
@@ -351,7 +477,7 @@ void miral::BasicWindowManager::handle_request_drag_and_drop(
     std::shared_ptr<mir::scene::Surface> const& surface,
     uint64_t timestamp)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     if (timestamp >= last_input_event_timestamp)
         policy->handle_request_drag_and_drop(info_for(surface));
 }
@@ -361,7 +487,7 @@ void miral::BasicWindowManager::handle_request_move(
     std::shared_ptr<mir::scene::Surface> const& surface,
     uint64_t timestamp)
 {
-    std::lock_guard<decltype(mutex)> lock(mutex);
+    TimedLock lock{this, __func__};
     if (timestamp >= last_input_event_timestamp && last_input_event)
     {
         policy->handle_request_move(info_for(surface), mir_event_get_input_event(last_input_event));
@@ -374,7 +500,7 @@ void miral::BasicWindowManager::handle_request_resize(
     uint64_t timestamp,
     MirResizeEdge edge)
 {
-    std::lock_guard<decltype(mutex)> lock(mutex);
+    TimedLock lock{this, __func__};
     if (timestamp >= last_input_event_timestamp && last_input_event)
     {
         policy->handle_request_resize(info_for(surface), mir_event_get_input_event(last_input_event), edge);
@@ -417,7 +543,7 @@ int miral::BasicWindowManager::set_surface_attribute(
         return surface->configure(attrib, value);
     }
 
-    Locker lock{this};
+    Locker lock{this, __func__};
     auto& info = info_for(surface);
 
     validate_modification_request(modification, info);
@@ -441,15 +567,68 @@ int miral::BasicWindowManager::set_surface_attribute(
     }
 }
 
+auto miral::BasicWindowManager::holds_mutex() const -> bool
+{
+    return mutex_owner == std::this_thread::get_id();
+}
+
+void miral::BasicWindowManager::publish()
+{
+    auto const current = std::atomic_load(&published);
+    auto const active_window = mru_active_windows.top();
+    auto const application_count = static_cast<unsigned int>(app_info.size());
+    bool const copy_infos = infos_may_have_changed && info_snapshots_used;
+    infos_may_have_changed = false;
+
+    // Most operations change none of this, so only copy the outputs when something has changed
+    if (copy_infos ||
+        active_window != current->active_window || !(outputs == current->outputs) ||
+        application_count != current->application_count)
+    {
+        auto next = std::make_shared<Published>(
+            Published{active_window, outputs, application_count, current->applications, current->windows});
+
+        if (copy_infos)
+        {
+            next->applications = std::make_shared<SessionInfoMap const>(app_info);
+            next->windows = std::make_shared<SurfaceInfoMap const>(window_info);
+        }
+
+        std::atomic_store(&published, std::shared_ptr<Published const>{std::move(next)});
+    }
+}
+
+auto miral::BasicWindowManager::info_snapshots() const -> std::shared_ptr<Published const>
+{
+    auto snapshot = std::atomic_load(&published);
+
+    if (!snapshot->windows)
+    {
+        // Until they are first wanted there are no copies: take them now, and keep them from then on
+        {
+            TimedLock const lock{const_cast<BasicWindowManager*>(this), __func__};
+            info_snapshots_used = true;
+            infos_may_have_changed = true;
+        }
+        snapshot = std::atomic_load(&published);
+    }
+
+    return snapshot;
+}
+
 auto miral::BasicWindowManager::count_applications() const
 -> unsigned int
 {
-    return app_info.size();
+    if (holds_mutex())
+        return app_info.size();
+
+    return std::atomic_load(&published)->application_count;
 }
 
 
 void miral::BasicWindowManager::for_each_application(std::function<void(ApplicationInfo& info)> const& functor)
 {
+    infos_may_have_changed = true;
     for(auto& info : app_info)
     {
         functor(info.second);
@@ -473,12 +652,14 @@ auto miral::BasicWindowManager::find_application(std::function<bool(ApplicationI
 auto miral::BasicWindowManager::info_for(std::weak_ptr<scene::Session> const& session) const
 -> ApplicationInfo&
 {
+    infos_may_have_changed = true;
     return const_cast<ApplicationInfo&>(app_info.at(session));
 }
 
 auto miral::BasicWindowManager::info_for(std::weak_ptr<scene::Surface> const& surface) const
 -> WindowInfo&
 {
+    infos_may_have_changed = true;
     return const_cast<WindowInfo&>(window_info.at(surface));
 }
 
@@ -488,6 +669,27 @@ auto miral::BasicWindowManager::info_for(Window const& window) const
     return info_for(std::weak_ptr<mir::scene::Surface>(window));
 }
 
+auto miral::BasicWindowManager::info_snapshot_for(Application const& application) const
+-> std::shared_ptr<ApplicationInfo const>
+{
+    if (holds_mutex())
+        return std::make_shared<ApplicationInfo const>(app_info.at(application));
+
+    // Share the published copy, rather than copying it again
+    auto const applications = info_snapshots()->applications;
+    return {applications, &applications->at(application)};
+}
+
+auto miral::BasicWindowManager::info_snapshot_for(Window const& window) const
+-> std::shared_ptr<WindowInfo const>
+{
+    if (holds_mutex())
+        return std::make_shared<WindowInfo const>(window_info.at(std::weak_ptr<mir::scene::Surface>(window)));
+
+    auto const windows = info_snapshots()->windows;
+    return {windows, &windows->at(std::weak_ptr<mir::scene::Surface>(window))};
+}
+
 void miral::BasicWindowManager::ask_client_to_close(Window const& window)
 {
     if (auto const mir_surface = std::shared_ptr<scene::Surface>(window))
@@ -504,7 +706,10 @@ void miral::BasicWindowManager::force_close(Window const& window)
 
 auto miral::BasicWindowManager::active_window() const -> Window
 {
-    return mru_active_windows.top();
+    if (holds_mutex())
+        return mru_active_windows.top();
+
+    return std::atomic_load(&published)->active_window;
 }
 
 void miral::BasicWindowManager::focus_next_application()
@@ -676,11 +881,21 @@ auto miral::BasicWindowManager::window_at(geometry::Point cursor) const
 -> Window
 {
     auto surface_at = focus_controller->surface_at(cursor);
-    return surface_at ? info_for(surface_at).window() : Window{};
+    return surface_at ? window_info.at(surface_at).window() : Window{};
 }
 
 auto miral::BasicWindowManager::active_output()
 -> geometry::Rectangle const
+{
+    if (holds_mutex())
+        return active_output_for(outputs, cursor);
+
+    auto const snapshot = std::atomic_load(&published);
+    return active_output_for(snapshot->outputs, published_cursor);
+}
+
+auto miral::BasicWindowManager::active_output_for(Rectangles const& outputs, Point cursor) const
+-> geometry::Rectangle
 {
     geometry::Rectangle result;
 
@@ -1235,7 +1450,7 @@ void miral::BasicWindowManager::update_event_timestamp(MirInputEvent const* iev)
 
 void miral::BasicWindowManager::invoke_under_lock(std::function<void()> const& callback)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     callback();
 }
 
@@ -2103,7 +2318,7 @@ void miral::BasicWindowManager::for_each_window_in_workspace(
 
 void miral::BasicWindowManager::add_display_for_testing(mir::geometry::Rectangle const& area)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     outputs.add(area);
 
     update_windows_for_outputs();
@@ -2111,7 +2326,7 @@ void miral::BasicWindowManager::add_display_for_testing(mir::geometry::Rectangle
 
 void miral::BasicWindowManager::advise_output_create(miral::Output const& output)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     outputs.add(output.extents());
 
     update_windows_for_outputs();
@@ -2120,7 +2335,7 @@ void miral::BasicWindowManager::advise_output_create(miral::Output const& output
 
 void miral::BasicWindowManager::advise_output_update(miral::Output const& updated, miral::Output const& original)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     outputs.remove(original.extents());
     outputs.add(updated.extents());
 
@@ -2130,7 +2345,7 @@ void miral::BasicWindowManager::advise_output_update(miral::Output const& update
 
 void miral::BasicWindowManager::advise_output_delete(miral::Output const& output)
 {
-    Locker lock{this};
+    Locker lock{this, __func__};
     outputs.remove(output.extents());
 
     update_windows_for_outputs();
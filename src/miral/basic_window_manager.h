@@ -36,8 +36,10 @@
 #include <boost/bimap.hpp>
 #include <boost/bimap/multiset_of.hpp>
 
+#include <atomic>
 #include <map>
 #include <mutex>
+#include <thread>
 
 namespace mir
 {
@@ -161,6 +163,10 @@ public:
 
     auto info_for(Window const& window) const -> WindowInfo& override;
 
+    auto info_snapshot_for(Application const& application) const -> std::shared_ptr<ApplicationInfo const> override;
+
+    auto info_snapshot_for(Window const& window) const -> std::shared_ptr<WindowInfo const> override;
+
     void ask_client_to_close(Window const& window) override;
 
     void force_close(Window const& window) override;
@@ -212,9 +218,35 @@ private:
 
     std::shared_ptr<DeadWorkspaces> const dead_workspaces{std::make_shared<DeadWorkspaces>()};
 
+    // The model state that queries return by value. This is replaced (never modified) under the
+    // mutex, so threads that don't hold the mutex can read it without waiting for those that do.
+    struct Published
+    {
+        Window active_window;
+        mir::geometry::Rectangles outputs;
+        unsigned int application_count{0};
+        // Copies of the info maps, only kept once info_snapshot_for() has been used
+        std::shared_ptr<SessionInfoMap const> applications;
+        std::shared_ptr<SurfaceInfoMap const> windows;
+    };
+
+    std::shared_ptr<Published const> published{std::make_shared<Published>()};
+
+    // The cursor moves with every pointer event, so it is published on its own
+    std::atomic<mir::geometry::Point> published_cursor{mir::geometry::Point{}};
+
+    std::atomic<bool> mutable info_snapshots_used{false};
+
+    // Set when the infos may have been changed under the mutex, so need copying when it's released
+    bool mutable infos_may_have_changed{false};
+
+    class LockStatistics;
+    std::unique_ptr<LockStatistics> const lock_statistics;
+
     std::unique_ptr<WindowManagementPolicy> const policy;
 
     std::mutex mutex;
+    std::atomic<std::thread::id> mutex_owner{std::thread::id{}};
     SessionInfoMap app_info;
     SurfaceInfoMap window_info;
     mir::geometry::Rectangles outputs;
@@ -234,8 +266,13 @@ private:
 
     std::shared_ptr<DisplayConfigurationListeners> const display_config_monitor;
 
+    struct TimedLock;
     struct Locker;
 
+    auto holds_mutex() const -> bool;
+    void publish();
+    auto info_snapshots() const -> std::shared_ptr<Published const>;
+
     void update_event_timestamp(MirKeyboardEvent const* kev);
     void update_event_timestamp(MirPointerEvent const* pev);
     void update_event_timestamp(MirTouchEvent const* tev);
@@ -265,6 +302,8 @@ private:
     void advise_output_update(Output const& updated, Output const& original) override;
     void advise_output_delete(Output const& output) override;
     void update_windows_for_outputs();
+    auto active_output_for(mir::geometry::Rectangles const& outputs, mir::geometry::Point cursor) const
+        -> mir::geometry::Rectangle;
 };
 }
 
@@ -50,6 +50,10 @@ void miral::DisplayConfigurationListeners::initial_configuration(std::shared_ptr
     configuration_applied(configuration);
 }
 
+void miral::DisplayConfigurationListeners::configuration_timing(std::chrono::nanoseconds, bool)
+{
+}
+
 void miral::DisplayConfigurationListeners::configuration_failed(
     std::shared_ptr<mir::graphics::DisplayConfiguration const> const&,
     std::exception const&)
@@ -43,6 +43,8 @@ private:
     void initial_configuration(std::shared_ptr<mir::graphics::DisplayConfiguration const> const& configuration) override;
     void configuration_applied(std::shared_ptr<mir::graphics::DisplayConfiguration const> const& config) override;
 
+    void configuration_timing(std::chrono::nanoseconds, bool) override;
+
     void configuration_failed(
         std::shared_ptr<mir::graphics::DisplayConfiguration const> const&,
         std::exception const&) override;
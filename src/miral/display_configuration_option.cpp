@@ -40,6 +40,12 @@ char const* const display_alpha_descr = "Select a display mode with alpha[{on,of
 char const* const display_alpha_off = "off";
 char const* const display_alpha_on = "on";
 
+char const* const adaptive_sync_opt = "adaptive-sync";
+char const* const adaptive_sync_descr = "Refresh outputs that support it as frames arrive [{on,off}]";
+
+char const* const adaptive_sync_off = "off";
+char const* const adaptive_sync_on = "on";
+
 class PixelFormatSelector : public mg::DisplayConfigurationPolicy
 {
 public:
@@ -50,6 +56,15 @@ private:
     bool const with_alpha;
 };
 
+class AdaptiveSyncSelector : public mg::DisplayConfigurationPolicy
+{
+public:
+    AdaptiveSyncSelector(std::shared_ptr<mg::DisplayConfigurationPolicy> const& base_policy);
+    virtual void apply_to(mg::DisplayConfiguration& conf);
+private:
+    std::shared_ptr<mg::DisplayConfigurationPolicy> const base_policy;
+};
+
 bool contains_alpha(MirPixelFormat format)
 {
     return (format == mir_pixel_format_abgr_8888 ||
@@ -88,11 +103,27 @@ void PixelFormatSelector::apply_to(mg::DisplayConfiguration& conf)
         });
 }
 
+AdaptiveSyncSelector::AdaptiveSyncSelector(
+    std::shared_ptr<mg::DisplayConfigurationPolicy> const& base_policy) :
+    base_policy{base_policy}
+{}
+
+void AdaptiveSyncSelector::apply_to(mg::DisplayConfiguration& conf)
+{
+    base_policy->apply_to(conf);
+    conf.for_each_output(
+        [&](mg::UserDisplayConfigurationOutput& conf_output)
+        {
+            conf_output.adaptive_sync = conf_output.adaptive_sync_supported;
+        });
+}
+
 void miral::display_configuration_options(mir::Server& server)
 {
     // Add choice of monitor configuration
     server.add_configuration_option(display_config_opt, display_config_descr,   sidebyside_opt_val);
     server.add_configuration_option(display_alpha_opt,  display_alpha_descr,    display_alpha_off);
+    server.add_configuration_option(adaptive_sync_opt,  adaptive_sync_descr,    adaptive_sync_off);
 
     server.wrap_display_configuration_policy(
         [&](std::shared_ptr<mg::DisplayConfigurationPolicy> const& wrapped)
@@ -101,6 +132,7 @@ void miral::display_configuration_options(mir::Server& server)
             auto const options = server.get_options();
             auto display_layout = options->get<std::string>(display_config_opt);
             auto with_alpha = options->get<std::string>(display_alpha_opt) == display_alpha_on;
+            auto adaptive_sync = options->get<std::string>(adaptive_sync_opt) == adaptive_sync_on;
 
             auto layout_selector = wrapped;
 
@@ -110,6 +142,12 @@ void miral::display_configuration_options(mir::Server& server)
                 layout_selector = std::make_shared<mg::SingleDisplayConfigurationPolicy>();
 
             // Whatever the layout select a pixel format with requested alpha
-            return std::make_shared<PixelFormatSelector>(layout_selector, with_alpha);
+            std::shared_ptr<mg::DisplayConfigurationPolicy> const format_selector =
+                std::make_shared<PixelFormatSelector>(layout_selector, with_alpha);
+
+            if (adaptive_sync)
+                return std::make_shared<AdaptiveSyncSelector>(format_selector);
+
+            return format_selector;
         });
 }
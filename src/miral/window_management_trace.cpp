@@ -413,6 +413,26 @@ try {
 }
 MIRAL_TRACE_EXCEPTION
 
+auto miral::WindowManagementTrace::info_snapshot_for(Application const& application) const -> std::shared_ptr<ApplicationInfo const>
+try {
+    log_input();
+    auto result = wrapped.info_snapshot_for(application);
+    mir::log_info("%s -> %s", __func__, result->application()->name().c_str());
+    trace_count++;
+    return result;
+}
+MIRAL_TRACE_EXCEPTION
+
+auto miral::WindowManagementTrace::info_snapshot_for(Window const& window) const -> std::shared_ptr<WindowInfo const>
+try {
+    log_input();
+    auto result = wrapped.info_snapshot_for(window);
+    mir::log_info("%s -> %s", __func__, result->name().c_str());
+    trace_count++;
+    return result;
+}
+MIRAL_TRACE_EXCEPTION
+
 void miral::WindowManagementTrace::ask_client_to_close(miral::Window const& window)
 try {
     log_input();
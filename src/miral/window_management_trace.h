@@ -49,6 +49,10 @@ private:
 
     virtual auto info_for(Window const& window) const -> WindowInfo& override;
 
+    virtual auto info_snapshot_for(Application const& application) const -> std::shared_ptr<ApplicationInfo const> override;
+
+    virtual auto info_snapshot_for(Window const& window) const -> std::shared_ptr<WindowInfo const> override;
+
     virtual void ask_client_to_close(Window const& window) override;
     virtual void force_close(Window const& window) override;
 
@@ -47,6 +47,12 @@ auto miral::WindowManagerTools::info_for(std::weak_ptr<mir::scene::Surface> cons
 auto miral::WindowManagerTools::info_for(Window const& window) const -> WindowInfo&
 { return tools->info_for(window); }
 
+auto miral::WindowManagerTools::info_snapshot_for(Application const& application) const -> std::shared_ptr<ApplicationInfo const>
+{ return tools->info_snapshot_for(application); }
+
+auto miral::WindowManagerTools::info_snapshot_for(Window const& window) const -> std::shared_ptr<WindowInfo const>
+{ return tools->info_snapshot_for(window); }
+
 void miral::WindowManagerTools::ask_client_to_close(Window const& window)
 { tools->ask_client_to_close(window); }
 
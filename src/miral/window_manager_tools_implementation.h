@@ -54,6 +54,8 @@ public:
     virtual auto info_for(std::weak_ptr<mir::scene::Session> const& session) const -> ApplicationInfo& = 0;
     virtual auto info_for(std::weak_ptr<mir::scene::Surface> const& surface) const -> WindowInfo& = 0;
     virtual auto info_for(Window const& window) const -> WindowInfo& = 0;
+    virtual auto info_snapshot_for(Application const& application) const -> std::shared_ptr<ApplicationInfo const> = 0;
+    virtual auto info_snapshot_for(Window const& window) const -> std::shared_ptr<WindowInfo const> = 0;
 
     virtual void ask_client_to_close(Window const& window) = 0;
     virtual void force_close(Window const& window) = 0;
@@ -18,10 +18,11 @@
 
 #include "xcursor_loader.h"
 
-#include <mir/graphics/cursor_image.h>
+#include <mir/graphics/animated_cursor_image.h>
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
+#include <vector>
 
 #include <string.h>
 
@@ -66,12 +67,56 @@ public:
     {
         return {image->xhot, image->yhot};
     }
+    unsigned int delay() const
+    {
+        return image->delay;
+    }
 
 private:
     _XcursorImage *image;
     std::shared_ptr<_XcursorImages> const save_resource;
 };
 
+// Several same-sized images of one cursor are frames of an animation (e.g. "watch")
+class AnimatedXCursorImage : public mg::AnimatedCursorImage
+{
+public:
+    AnimatedXCursorImage(std::vector<_XcursorImage*> const& images, std::shared_ptr<_XcursorImages> const& save_resource)
+    {
+        for (auto const image : images)
+            frames.push_back(std::make_unique<XCursorImage>(image, save_resource));
+    }
+
+    void const* as_argb_8888() const override
+    {
+        return frames.front()->as_argb_8888();
+    }
+    geom::Size size() const override
+    {
+        return frames.front()->size();
+    }
+    geom::Displacement hotspot() const override
+    {
+        return frames.front()->hotspot();
+    }
+
+    size_t frame_count() const override
+    {
+        return frames.size();
+    }
+    mg::CursorImage const& frame(size_t index) const override
+    {
+        return *frames.at(index);
+    }
+    std::chrono::milliseconds frame_delay(size_t index) const override
+    {
+        return std::chrono::milliseconds{frames.at(index)->delay()};
+    }
+
+private:
+    std::vector<std::unique_ptr<XCursorImage>> frames;
+};
+
 std::string const
 xcursor_name_for_mir_cursor(std::string const& mir_cursor_name)
 {
@@ -167,18 +212,29 @@ void miral::XCursorLoader::load_appropriately_sized_image(_XcursorImages *images
             XcursorImagesDestroy(images);
         });
 
-    for (int i = 0; i < images->nimage; i++)
-    {
-        _XcursorImage *candidate = images->images[i];
-        if (candidate->width == mi::default_cursor_size.width.as_uint32_t() &&
-            candidate->height == mi::default_cursor_size.height.as_uint32_t())
+    auto const frames_sized = [images](unsigned int width, unsigned int height)
         {
-            loaded_images[std::string(images->name)] = std::make_shared<XCursorImage>(candidate, saved_xcursor_library_resource);
-            return;
-        }
-    }
+            std::vector<_XcursorImage*> frames;
+            for (int i = 0; i < images->nimage; i++)
+            {
+                _XcursorImage *candidate = images->images[i];
+                if (candidate->width == width && candidate->height == height)
+                    frames.push_back(candidate);
+            }
+            return frames;
+        };
+
+    auto frames = frames_sized(
+        mi::default_cursor_size.width.as_uint32_t(),
+        mi::default_cursor_size.height.as_uint32_t());
 
-    loaded_images[std::string(images->name)] = std::make_shared<XCursorImage>(images->images[0], saved_xcursor_library_resource);
+    if (frames.empty())
+        frames = frames_sized(images->images[0]->width, images->images[0]->height);
+
+    if (frames.size() > 1)
+        loaded_images[std::string(images->name)] = std::make_shared<AnimatedXCursorImage>(frames, saved_xcursor_library_resource);
+    else
+        loaded_images[std::string(images->name)] = std::make_shared<XCursorImage>(frames.front(), saved_xcursor_library_resource);
 }
 
 void miral::XCursorLoader::load_cursor_theme(std::string const& theme_name)
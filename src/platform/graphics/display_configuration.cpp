@@ -133,6 +133,8 @@ std::ostream& mg::operator<<(std::ostream& out, mg::DisplayConfigurationOutput c
     out << std::endl;
 
     out << "\torientation: " << val.orientation << '\n';
+    out << "\tadaptive sync: " << (val.adaptive_sync ? "on" : "off")
+        << (val.adaptive_sync_supported ? "" : " (unsupported)") << '\n';
     out << "}" << std::endl;
 
     return out;
@@ -188,7 +190,9 @@ bool mg::operator==(mg::DisplayConfigurationOutput const& val1,
                (val1.modes.size() == val2.modes.size()) &&
                (val1.custom_logical_size == val2.custom_logical_size) &&
                (val1.scale == val2.scale) &&
-               (val1.form_factor == val2.form_factor)};
+               (val1.form_factor == val2.form_factor) &&
+               (val1.adaptive_sync_supported == val2.adaptive_sync_supported) &&
+               (val1.adaptive_sync == val2.adaptive_sync)};
 
     if (equal)
     {
@@ -326,7 +330,9 @@ mg::UserDisplayConfigurationOutput::UserDisplayConfigurationOutput(
         gamma(master.gamma),
         gamma_supported(master.gamma_supported),
         edid(*reinterpret_cast<std::vector<uint8_t const>*>(&master.edid)),
-        custom_logical_size(master.custom_logical_size)
+        custom_logical_size(master.custom_logical_size),
+        adaptive_sync_supported(master.adaptive_sync_supported),
+        adaptive_sync(master.adaptive_sync)
 {
 }
 
@@ -54,6 +54,8 @@ char const* const mo::cursor_opt                  = "cursor";
 char const* const mo::fatal_except_opt            = "on-fatal-error-except";
 char const* const mo::debug_opt                   = "debug";
 char const* const mo::composite_delay_opt         = "composite-delay";
+char const* const mo::skip_unchanged_frames_opt   = "skip-unchanged-frames";
+char const* const mo::main_loop_opt               = "main-loop";
 char const* const mo::enable_key_repeat_opt       = "enable-key-repeat";
 
 char const* const mo::off_opt_value = "off";
@@ -186,6 +188,11 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "frames from clients before compositing). Higher values result in "
             "lower latency but risk causing frame skipping. "
             "Default: A negative value means decide automatically.")
+        (skip_unchanged_frames_opt, po::value<bool>()->default_value(false),
+            "Don't render or post a scheduled frame that would be identical "
+            "to the last one. Off by default, so kiosks and other mostly "
+            "static displays must enable it. Only enable this if the display "
+            "buffer compositor draws nothing but the scene's renderables.")
         (name_opt, po::value<std::string>(),
             "When nested, the name Mir uses when registering with the host.")
         (nested_passthrough_opt, po::value<bool>()->default_value(true),
@@ -200,6 +207,8 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Cursor (mouse pointer) to use [{auto,null,software}]")
         (enable_key_repeat_opt, po::value<bool>()->default_value(true),
              "Enable server generated key repeat")
+        (main_loop_opt, po::value<std::string>()->default_value("glib"),
+            "Implementation of the server main loop [{glib,epoll}]")
         (fatal_except_opt, "On \"fatal error\" conditions [e.g. drivers behaving "
             "in unexpected ways] throw an exception (instead of a core dump)")
         (debug_opt, "Enable extra development debugging. "
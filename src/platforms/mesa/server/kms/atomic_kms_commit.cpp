@@ -0,0 +1,202 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "atomic_kms_commit.h"
+#include "kms-utils/drm_mode_resources.h"
+
+#include <boost/throw_exception.hpp>
+#include <system_error>
+
+namespace mgm = mir::graphics::mesa;
+namespace mgk = mir::graphics::kms;
+namespace geom = mir::geometry;
+
+namespace
+{
+uint32_t crtc_bit_for(int drm_fd, uint32_t crtc_id)
+{
+    int crtc_index{-1};
+    int index{0};
+    mgk::DRMModeResources{drm_fd}.for_each_crtc(
+        [&](mgk::DRMModeCrtcUPtr crtc)
+        {
+            if (crtc->crtc_id == crtc_id)
+                crtc_index = index;
+            ++index;
+        });
+
+    if (crtc_index < 0)
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to find index of CRTC"});
+
+    return 1u << crtc_index;
+}
+
+/// The planes of \a type usable on the CRTC with \a crtc_bit, with the mask of CRTCs each could serve
+std::vector<std::pair<uint32_t, uint32_t>> planes_for(int drm_fd, uint32_t crtc_bit, uint64_t type)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> planes;
+    mgk::PlaneResources plane_res{drm_fd};
+
+    for (auto& plane : plane_res.planes())
+    {
+        if (plane->possible_crtcs & crtc_bit)
+        {
+            mgk::ObjectProperties plane_props{drm_fd, plane->plane_id, DRM_MODE_OBJECT_PLANE};
+            if (plane_props["type"] == type)
+                planes.emplace_back(plane->plane_id, plane->possible_crtcs);
+        }
+    }
+
+    return planes;
+}
+}
+
+uint32_t mgm::AtomicKMSCommit::primary_plane_for(int drm_fd, uint32_t crtc_id)
+{
+    auto const planes = planes_for(drm_fd, crtc_bit_for(drm_fd, crtc_id), DRM_PLANE_TYPE_PRIMARY);
+
+    if (planes.empty())
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Could not find primary plane for CRTC"});
+
+    return planes.front().first;
+}
+
+std::vector<uint32_t> mgm::AtomicKMSCommit::overlay_planes_for(int drm_fd, uint32_t crtc_id)
+{
+    auto const crtc_bit = crtc_bit_for(drm_fd, crtc_id);
+
+    std::vector<uint32_t> overlays;
+    for (auto const& plane : planes_for(drm_fd, crtc_bit, DRM_PLANE_TYPE_OVERLAY))
+    {
+        /* Only take the plane if we are the lowest numbered CRTC it can serve */
+        auto const possible_crtcs = plane.second;
+        if ((possible_crtcs & (~possible_crtcs + 1)) == crtc_bit)
+            overlays.push_back(plane.first);
+    }
+
+    return overlays;
+}
+
+mgm::AtomicKMSCommit::AtomicKMSCommit(int drm_fd, Modeset modeset)
+    : drm_fd{drm_fd},
+      flags{modeset == Modeset::allowed ? static_cast<uint32_t>(DRM_MODE_ATOMIC_ALLOW_MODESET) : 0u},
+      request{drmModeAtomicAlloc(), &drmModeAtomicFree}
+{
+    if (!request)
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to allocate atomic KMS request"});
+}
+
+mgm::AtomicKMSCommit::~AtomicKMSCommit()
+{
+    /* The kernel keeps its own reference to any mode we committed */
+    for (auto blob : mode_blobs)
+        drmModeDestroyPropertyBlob(drm_fd, blob);
+}
+
+void mgm::AtomicKMSCommit::set_crtc(
+    uint32_t crtc_id,
+    uint32_t connector_id,
+    drmModeModeInfo const& mode,
+    uint32_t fb_id,
+    geom::Displacement offset)
+{
+    uint32_t mode_id{0};
+    auto const ret = drmModeCreatePropertyBlob(drm_fd, &mode, sizeof(mode), &mode_id);
+    if (ret != 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(-ret, std::system_category(), "Failed to create DRM mode property blob"));
+    }
+    mode_blobs.push_back(mode_id);
+
+    /* Activate the CRTC and set the mode */
+    mgk::ObjectProperties crtc_props{drm_fd, crtc_id, DRM_MODE_OBJECT_CRTC};
+    add_property(crtc_id, crtc_props.id_for("MODE_ID"), mode_id);
+    add_property(crtc_id, crtc_props.id_for("ACTIVE"), 1);
+
+    /* Set CRTC for the output */
+    mgk::ObjectProperties connector_props{drm_fd, connector_id, DRM_MODE_OBJECT_CONNECTOR};
+    add_property(connector_id, connector_props.id_for("CRTC_ID"), crtc_id);
+
+    auto const plane_id = primary_plane_for(drm_fd, crtc_id);
+    set_plane(
+        plane_id,
+        mgk::ObjectProperties{drm_fd, plane_id, DRM_MODE_OBJECT_PLANE},
+        crtc_id,
+        fb_id,
+        {geom::Point{} + offset, {mode.hdisplay, mode.vdisplay}},
+        {{0, 0}, {mode.hdisplay, mode.vdisplay}});
+}
+
+void mgm::AtomicKMSCommit::set_plane(
+    uint32_t plane_id,
+    mgk::ObjectProperties const& plane_props,
+    uint32_t crtc_id,
+    uint32_t fb_id,
+    geom::Rectangle const& source,
+    geom::Rectangle const& destination)
+{
+    /* Source viewport, our part of the framebuffer. Coordinates are 16.16 fixed point format */
+    add_property(plane_id, plane_props.id_for("SRC_X"), uint64_t{source.top_left.x.as_uint32_t()} << 16);
+    add_property(plane_id, plane_props.id_for("SRC_Y"), uint64_t{source.top_left.y.as_uint32_t()} << 16);
+    add_property(plane_id, plane_props.id_for("SRC_W"), uint64_t{source.size.width.as_uint32_t()} << 16);
+    add_property(plane_id, plane_props.id_for("SRC_H"), uint64_t{source.size.height.as_uint32_t()} << 16);
+
+    /* Destination viewport. Coordinates are *not* 16.16 */
+    add_property(plane_id, plane_props.id_for("CRTC_X"), destination.top_left.x.as_int());
+    add_property(plane_id, plane_props.id_for("CRTC_Y"), destination.top_left.y.as_int());
+    add_property(plane_id, plane_props.id_for("CRTC_W"), destination.size.width.as_uint32_t());
+    add_property(plane_id, plane_props.id_for("CRTC_H"), destination.size.height.as_uint32_t());
+
+    /* Set a surface for the plane, and connect to the CRTC */
+    add_property(plane_id, plane_props.id_for("FB_ID"), fb_id);
+    add_property(plane_id, plane_props.id_for("CRTC_ID"), crtc_id);
+}
+
+void mgm::AtomicKMSCommit::disable_plane(uint32_t plane_id, mgk::ObjectProperties const& plane_props)
+{
+    add_property(plane_id, plane_props.id_for("FB_ID"), 0);
+    add_property(plane_id, plane_props.id_for("CRTC_ID"), 0);
+}
+
+bool mgm::AtomicKMSCommit::test() const
+{
+    return drmModeAtomicCommit(
+        drm_fd,
+        request.get(),
+        DRM_MODE_ATOMIC_TEST_ONLY | flags,
+        nullptr) == 0;
+}
+
+void mgm::AtomicKMSCommit::commit()
+{
+    auto const ret = drmModeAtomicCommit(drm_fd, request.get(), flags, nullptr);
+    if (ret != 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(-ret, std::system_category(), "Failed to commit atomic KMS configuration"));
+    }
+}
+
+void mgm::AtomicKMSCommit::add_property(uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    auto const ret = drmModeAtomicAddProperty(request.get(), object_id, property_id, value);
+    if (ret < 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(-ret, std::system_category(), "Failed to add property to atomic KMS request"));
+    }
+}
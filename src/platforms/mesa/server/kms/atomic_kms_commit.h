@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_MESA_ATOMIC_KMS_COMMIT_H_
+#define MIR_GRAPHICS_MESA_ATOMIC_KMS_COMMIT_H_
+
+#include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
+
+#include <xf86drmMode.h>
+
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace kms
+{
+class ObjectProperties;
+}
+
+namespace mesa
+{
+
+/**
+ * The CRTC state of any number of outputs on one DRM device, set in a single
+ * atomic commit.
+ *
+ * Requires DRM_CLIENT_CAP_ATOMIC to have been set on the device.
+ */
+class AtomicKMSCommit
+{
+public:
+    enum class Modeset
+    {
+        allowed,
+        forbidden   ///< For per-frame plane updates, which must never cause a modeset
+    };
+
+    explicit AtomicKMSCommit(int drm_fd, Modeset modeset = Modeset::allowed);
+    ~AtomicKMSCommit();
+
+    static uint32_t primary_plane_for(int drm_fd, uint32_t crtc_id);
+    /**
+     * The overlay planes \a crtc_id may use. A plane that could serve several
+     * CRTCs is only offered to the first of them, so no two CRTCs compete
+     * for it.
+     */
+    static std::vector<uint32_t> overlay_planes_for(int drm_fd, uint32_t crtc_id);
+
+    /**
+     * Add scanning out \a fb_id from \a offset on \a crtc_id, through its
+     * primary plane, to \a connector_id with \a mode.
+     *
+     * \throws std::runtime_error if the CRTC has no primary plane.
+     */
+    void set_crtc(
+        uint32_t crtc_id,
+        uint32_t connector_id,
+        drmModeModeInfo const& mode,
+        uint32_t fb_id,
+        geometry::Displacement offset);
+
+    /**
+     * Add scanning out \a source of \a fb_id on \a plane_id, to
+     * \a destination on \a crtc_id. The rectangles are in pixels.
+     */
+    void set_plane(
+        uint32_t plane_id,
+        kms::ObjectProperties const& plane_props,
+        uint32_t crtc_id,
+        uint32_t fb_id,
+        geometry::Rectangle const& source,
+        geometry::Rectangle const& destination);
+
+    /// Add turning \a plane_id off
+    void disable_plane(uint32_t plane_id, kms::ObjectProperties const& plane_props);
+
+    /// Whether the driver would accept the commit, without applying it
+    bool test() const;
+
+    /**
+     * Apply the commit, with a modeset where needed and allowed.
+     *
+     * \throws std::system_error if the driver rejects it.
+     */
+    void commit();
+
+private:
+    AtomicKMSCommit(AtomicKMSCommit const&) = delete;
+    AtomicKMSCommit& operator=(AtomicKMSCommit const&) = delete;
+
+    void add_property(uint32_t object_id, uint32_t property_id, uint64_t value);
+
+    int const drm_fd;
+    uint32_t const flags;
+    std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)> const request;
+    std::vector<uint32_t> mode_blobs;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_MESA_ATOMIC_KMS_COMMIT_H_ */
@@ -46,3 +46,17 @@ bool mgm::BypassMatch::operator()(std::shared_ptr<graphics::Renderable> const& r
     bypass_is_feasible = (is_opaque && fits && is_orthogonal);
     return bypass_is_feasible;
 }
+
+mgm::OverlayMatch::OverlayMatch(geometry::Rectangle const& rect)
+    : view_area(rect),
+      identity(1)
+{
+}
+
+bool mgm::OverlayMatch::operator()(std::shared_ptr<graphics::Renderable> const& renderable) const
+{
+    auto const is_opaque = !((renderable->alpha() != 1.0f) || renderable->shaped());
+    auto const fits = view_area.contains(renderable->screen_position());
+    auto const is_orthogonal = (renderable->transformation() == identity);
+    return is_opaque && fits && is_orthogonal;
+}
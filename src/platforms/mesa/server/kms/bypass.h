@@ -39,6 +39,21 @@ private:
     glm::mat4 const identity;
 };
 
+/**
+ * Matches renderables that could be shown on an overlay plane of the output
+ * showing rect: opaque, untransformed and entirely on that output. Whether
+ * their buffers can be scanned out is for the caller to check.
+ */
+class OverlayMatch
+{
+public:
+    OverlayMatch(geometry::Rectangle const& rect);
+    bool operator()(std::shared_ptr<graphics::Renderable> const&) const;
+private:
+    geometry::Rectangle const view_area;
+    glm::mat4 const identity;
+};
+
 } // namespace mesa
 } // namespace graphics
 } // namespace mir
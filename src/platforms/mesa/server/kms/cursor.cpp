@@ -22,12 +22,14 @@
 #include "kms_output_container.h"
 #include "kms_display_configuration.h"
 #include "mir/geometry/rectangle.h"
-#include "mir/graphics/cursor_image.h"
+#include "mir/graphics/animated_cursor_image.h"
+#include "mir/log.h"
 
 #include <xf86drm.h>
 
 #include <boost/exception/errinfo_errno.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 
@@ -97,18 +99,40 @@ gbm_device* gbm_create_device_checked(int fd)
     }
     return device;
 }
+
+// Enough for the frames of a typical animated cursor plus a few static ones
+size_t const max_cached_images = 32;
+
+// Some Xcursor themes have frames without a delay; don't spin on them
+std::chrono::milliseconds const min_frame_delay{10};
+
+// FNV-1a; we only need to tell images apart, not resist attacks
+size_t hash_image(std::vector<uint8_t> const& argb8888, geom::Size size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto const mix = [&hash](uint8_t byte) { hash = (hash ^ byte) * 1099511628211ull; };
+
+    for (auto const dimension : {size.width.as_uint32_t(), size.height.as_uint32_t()})
+    {
+        for (auto shift = 0; shift != 32; shift += 8)
+            mix(dimension >> shift);
+    }
+
+    for (auto const byte : argb8888)
+        mix(byte);
+
+    return hash;
+}
 }
 
-mgm::Cursor::GBMBOWrapper::GBMBOWrapper(int fd, MirOrientation orientation) :
-    device{gbm_create_device_checked(fd)},
+mgm::Cursor::GBMBOWrapper::GBMBOWrapper(gbm_device* device, int fd) :
     buffer{
         gbm_bo_create(
             device,
             get_drm_cursor_width(fd),
             get_drm_cursor_height(fd),
             GBM_FORMAT_ARGB8888,
-            GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE)},
-    current_orientation{orientation}
+            GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE)}
 {
     if (!buffer) BOOST_THROW_EXCEPTION(std::runtime_error("failed to create gbm buffer"));
 }
@@ -120,28 +144,20 @@ inline mgm::Cursor::GBMBOWrapper::operator gbm_bo*()
 
 inline mgm::Cursor::GBMBOWrapper::~GBMBOWrapper()
 {
-    if (device)
-        gbm_device_destroy(device);
     if (buffer)
         gbm_bo_destroy(buffer);
 }
 
 mgm::Cursor::GBMBOWrapper::GBMBOWrapper(GBMBOWrapper&& from)
-    : device{from.device},
-      buffer{from.buffer},
-      current_orientation{from.current_orientation}
+    : buffer{from.buffer}
 {
     from.buffer = nullptr;
-    from.device = nullptr;
 }
 
-auto mir::graphics::mesa::Cursor::GBMBOWrapper::change_orientation(MirOrientation new_orientation) -> bool
+mgm::Cursor::DeviceBuffers::DeviceBuffers(int fd) :
+    device{gbm_create_device_checked(fd), &gbm_device_destroy}
 {
-    if (current_orientation == new_orientation)
-        return false;
-
-    current_orientation = new_orientation;
-    return true;
+    images.push_back({GBMBOWrapper{device.get(), fd}, false, 0, mir_orientation_normal, 0});
 }
 
 mgm::Cursor::Cursor(
@@ -149,7 +165,13 @@ mgm::Cursor::Cursor(
     std::shared_ptr<CurrentConfiguration> const& current_configuration) :
         output_container(output_container),
         current_position(),
+        frames{Image{{}, {}, {}, 0, {}}},
+        current_frame{0},
+        visible(false),
+        suspended(false),
         last_set_failed(false),
+        stop_animation(false),
+        buffer_use_count{0},
         min_buffer_width{std::numeric_limits<uint32_t>::max()},
         min_buffer_height{std::numeric_limits<uint32_t>::max()},
         current_configuration(current_configuration)
@@ -162,7 +184,7 @@ mgm::Cursor::Cursor(
                 [this, &kms_conf](auto const& output)
                 {
                     // I'm not sure why g++ needs the explicit "this->" but it does - alan_g
-                    this->buffer_for_output(*kms_conf.get_output_for(output.id));
+                    this->buffers_for_device(kms_conf.get_output_for(output.id)->drm_fd());
                 });
         });
 
@@ -173,6 +195,15 @@ mgm::Cursor::Cursor(
 
 mgm::Cursor::~Cursor() noexcept
 {
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        stop_animation = true;
+    }
+    animation_changed.notify_all();
+
+    if (animation_thread.joinable())
+        animation_thread.join();
+
     hide();
 }
 
@@ -192,9 +223,11 @@ void mgm::Cursor::write_buffer_data_locked(
 
 void mgm::Cursor::pad_and_write_image_data_locked(
     std::lock_guard<std::mutex> const& lg,
-    GBMBOWrapper& buffer)
+    GBMBOWrapper& buffer,
+    MirOrientation orientation)
 {
-    auto const orientation = buffer.orientation();
+    auto const& size = frames[current_frame].size;
+    auto const& argb8888 = frames[current_frame].argb8888;
     bool const sideways = orientation == mir_orientation_left || orientation == mir_orientation_right;
 
     auto const min_width  = sideways ? min_buffer_width : min_buffer_height;
@@ -283,6 +316,7 @@ void mgm::Cursor::show()
     {
         visible = true;
         place_cursor_at_locked(lg, current_position, ForceState);
+        animation_changed.notify_all();
     }
 }
 
@@ -290,24 +324,57 @@ void mgm::Cursor::show(CursorImage const& cursor_image)
 {
     std::lock_guard<std::mutex> lg(guard);
 
-    size = cursor_image.size();
+    auto const copy_of = [](CursorImage const& image, std::chrono::milliseconds delay)
+        {
+            auto const size = image.size();
+            auto const data = static_cast<uint8_t const*>(image.as_argb_8888());
+            std::vector<uint8_t> argb8888(data, data + size.width.as_uint32_t() * size.height.as_uint32_t() * 4);
+            auto const hash = hash_image(argb8888, size);
 
-    argb8888.resize(size.width.as_uint32_t() * size.height.as_uint32_t() * 4);
-    memcpy(argb8888.data(), cursor_image.as_argb_8888(), argb8888.size());
+            return Image{std::move(argb8888), size, image.hotspot(), hash, std::max(delay, min_frame_delay)};
+        };
 
-    hotspot = cursor_image.hotspot();
+    std::vector<Image> new_frames;
+    if (auto const animation = dynamic_cast<AnimatedCursorImage const*>(&cursor_image))
     {
-        auto locked_buffers = buffers.lock();
-        for (auto& pair : *locked_buffers)
+        for (size_t i = 0; i != animation->frame_count(); ++i)
+            new_frames.push_back(copy_of(animation->frame(i), animation->frame_delay(i)));
+    }
+
+    if (new_frames.empty())
+        new_frames.push_back(copy_of(cursor_image, {}));
+
+    // Being asked for the animation we're already running shouldn't restart it
+    auto const same_image = [](Image const& lhs, Image const& rhs)
         {
-            pad_and_write_image_data_locked(lg, pair.second);
-        }
+            return lhs.hash == rhs.hash &&
+                lhs.size == rhs.size &&
+                lhs.hotspot == rhs.hotspot &&
+                lhs.delay == rhs.delay;
+        };
+
+    if (!std::equal(frames.begin(), frames.end(), new_frames.begin(), new_frames.end(), same_image))
+    {
+        frames = std::move(new_frames);
+        current_frame = 0;
+        next_frame_due = std::chrono::steady_clock::now() + frames.front().delay;
     }
 
     // Writing the data could throw an exception so lets
     // hold off on setting visible until after we have succeeded.
+    for_each_used_output([&](KMSOutput& output, geom::Rectangle const& output_rect, MirOrientation orientation)
+        {
+            if (output_rect.contains(current_position))
+                buffer_for_output_locked(lg, output, orientation);
+        });
+
     visible = true;
     place_cursor_at_locked(lg, current_position, ForceState);
+
+    if (frames.size() > 1 && !animation_thread.joinable())
+        animation_thread = std::thread{[this] { animate(); }};
+
+    animation_changed.notify_all();
 }
 
 void mgm::Cursor::move_to(geometry::Point position)
@@ -318,6 +385,7 @@ void mgm::Cursor::move_to(geometry::Point position)
 void mir::graphics::mesa::Cursor::suspend()
 {
     std::lock_guard<std::mutex> lg(guard);
+    suspended = true;
     clear(lg);
 }
 
@@ -333,7 +401,10 @@ void mir::graphics::mesa::Cursor::clear(std::lock_guard<std::mutex> const&)
 
 void mgm::Cursor::resume()
 {
-    place_cursor_at(current_position, ForceState);
+    std::lock_guard<std::mutex> lg(guard);
+    suspended = false;
+    place_cursor_at_locked(lg, current_position, ForceState);
+    animation_changed.notify_all();
 }
 
 void mgm::Cursor::hide()
@@ -386,30 +457,29 @@ void mgm::Cursor::place_cursor_at_locked(
     {
         if (output_rect.contains(position))
         {
+            auto const& image = frames[current_frame];
             auto dp = transform(output_rect, position - output_rect.top_left, orientation);
-            auto hs = transform(geom::Rectangle{{0,0}, size}, hotspot, orientation);
+            auto hs = transform(geom::Rectangle{{0,0}, image.size}, image.hotspot, orientation);
 
             // It's a little strange that we implement hotspot this way as there is
             // drmModeSetCursor2 with hotspot support. However it appears to not actually
             // work on radeon and intel. There also seems to be precedent in weston for
             // implementing hotspot in this fashion.
             output.move_cursor(geom::Point{} + dp - hs);
-            auto& buffer = buffer_for_output(output);
 
-            auto const changed_orientation = buffer.change_orientation(orientation);
-
-            if (changed_orientation)
-                pad_and_write_image_data_locked(lg, buffer);
-
-            if (force_state || !output.has_cursor() || changed_orientation)
+            // An orientation change comes with a configuration change, which
+            // forces the state on resume(), so only the image can go stale here.
+            if (force_state != UpdateState || !output.has_cursor())
             {
+                auto& buffer = buffer_for_output_locked(lg, output, orientation);
+
                 if (!output.set_cursor(buffer) || !output.has_cursor())
                     set_on_all_outputs = false;
             }
         }
         else
         {
-            if (force_state || output.has_cursor())
+            if (force_state == ForceState || output.has_cursor())
             {
                 output.clear_cursor();
             }
@@ -419,16 +489,64 @@ void mgm::Cursor::place_cursor_at_locked(
     last_set_failed = !set_on_all_outputs;
 }
 
-mgm::Cursor::GBMBOWrapper& mgm::Cursor::buffer_for_output(KMSOutput const& output)
+void mgm::Cursor::animate()
+{
+    std::unique_lock<std::mutex> lock{guard};
+
+    while (!stop_animation)
+    {
+        if (frames.size() < 2 || !visible || suspended)
+        {
+            animation_changed.wait(lock);
+        }
+        else if (animation_changed.wait_until(lock, next_frame_due) == std::cv_status::timeout)
+        {
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> lg{guard};
+                advance_animation_locked(lg);
+            }
+            lock.lock();
+        }
+    }
+}
+
+void mgm::Cursor::advance_animation_locked(std::lock_guard<std::mutex> const& lg)
+{
+    auto const now = std::chrono::steady_clock::now();
+
+    // Things may have changed while we weren't holding the lock
+    if (frames.size() < 2 || !visible || suspended || stop_animation || now < next_frame_due)
+        return;
+
+    current_frame = (current_frame + 1) % frames.size();
+
+    next_frame_due += frames[current_frame].delay;
+    if (next_frame_due < now)
+        next_frame_due = now + frames[current_frame].delay;
+
+    try
+    {
+        place_cursor_at_locked(lg, current_position, UpdateImage);
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_error("Failed to show cursor animation frame, stopping animation: %s", error.what());
+        frames = {frames[current_frame]};
+        current_frame = 0;
+    }
+}
+
+auto mgm::Cursor::buffers_for_device(int drm_fd) -> DeviceBuffers&
 {
     auto locked_buffers = buffers.lock();
 
     auto buffer_it = std::find_if(
         locked_buffers->begin(),
         locked_buffers->end(),
-        [&output](auto const& candidate)
+        [drm_fd](auto const& candidate)
             {
-                return candidate.first == output.drm_fd();
+                return candidate.first == drm_fd;
             });
 
     if (buffer_it != locked_buffers->end())
@@ -436,17 +554,80 @@ mgm::Cursor::GBMBOWrapper& mgm::Cursor::buffer_for_output(KMSOutput const& outpu
         return buffer_it->second;
     }
 
-    locked_buffers->push_back(std::make_pair(output.drm_fd(), GBMBOWrapper(output.drm_fd(), mir_orientation_normal)));
+    locked_buffers->push_back(std::make_pair(drm_fd, DeviceBuffers{drm_fd}));
+
+    DeviceBuffers& device_buffers = locked_buffers->back().second;
+    gbm_bo* const bo = device_buffers.images.front().buffer;
 
-    GBMBOWrapper& bo = locked_buffers->back().second;
+    bool min_size_changed = false;
     if (gbm_bo_get_width(bo) < min_buffer_width)
     {
         min_buffer_width = gbm_bo_get_width(bo);
+        min_size_changed = true;
     }
     if (gbm_bo_get_height(bo) < min_buffer_height)
     {
         min_buffer_height = gbm_bo_get_height(bo);
+        min_size_changed = true;
+    }
+
+    // The images we already have were cropped to the old minimum size
+    if (min_size_changed)
+    {
+        for (auto& device : *locked_buffers)
+        {
+            for (auto& image : device.second.images)
+                image.filled = false;
+        }
+    }
+
+    return device_buffers;
+}
+
+auto mgm::Cursor::buffer_for_output_locked(
+    std::lock_guard<std::mutex> const& lg,
+    KMSOutput const& output,
+    MirOrientation orientation) -> GBMBOWrapper&
+{
+    auto& device_buffers = buffers_for_device(output.drm_fd());
+    auto& images = device_buffers.images;
+    auto const image_hash = frames[current_frame].hash;
+
+    auto cached = std::find_if(
+        images.begin(),
+        images.end(),
+        [image_hash, orientation](auto const& candidate)
+            {
+                return candidate.filled &&
+                    candidate.image_hash == image_hash &&
+                    candidate.orientation == orientation;
+            });
+
+    if (cached == images.end())
+    {
+        // Fill an unused buffer, a new one, or failing that the least recently used
+        cached = std::find_if(images.begin(), images.end(), [](auto const& candidate) { return !candidate.filled; });
+
+        if (cached == images.end() && images.size() < max_cached_images)
+        {
+            images.push_back({GBMBOWrapper{device_buffers.device.get(), output.drm_fd()}, false, 0, orientation, 0});
+            cached = images.end() - 1;
+        }
+        else if (cached == images.end())
+        {
+            cached = std::min_element(
+                images.begin(),
+                images.end(),
+                [](auto const& lhs, auto const& rhs) { return lhs.last_used < rhs.last_used; });
+        }
+
+        cached->filled = false;
+        pad_and_write_image_data_locked(lg, cached->buffer, orientation);
+        cached->filled = true;
+        cached->image_hash = image_hash;
+        cached->orientation = orientation;
     }
 
-    return bo;
+    cached->last_used = ++buffer_use_count;
+    return cached->buffer;
 }
@@ -23,15 +23,19 @@
 #include "mir/graphics/cursor.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/size.h"
 
 #include "mir_toolkit/common.h"
 #include "mutex.h"
 
 #include <gbm.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 namespace mir
@@ -84,8 +88,20 @@ public:
     void resume();
 
 private:
-    enum ForceCursorState { UpdateState, ForceState };
+    enum ForceCursorState { UpdateState, ForceState, UpdateImage };
     struct GBMBOWrapper;
+    struct DeviceBuffers;
+
+    /// A copy of one image (or animation frame) to be shown
+    struct Image
+    {
+        std::vector<uint8_t> argb8888;
+        geometry::Size size;
+        geometry::Displacement hotspot;
+        size_t hash;
+        std::chrono::milliseconds delay;
+    };
+
     void for_each_used_output(std::function<void(KMSOutput&, geometry::Rectangle const&, MirOrientation orientation)> const& f);
     void place_cursor_at(geometry::Point position, ForceCursorState force_state);
     void place_cursor_at_locked(std::lock_guard<std::mutex> const&, geometry::Point position, ForceCursorState force_state);
@@ -96,41 +112,73 @@ private:
         size_t count);
     void pad_and_write_image_data_locked(
         std::lock_guard<std::mutex> const&,
-        GBMBOWrapper& buffer);
+        GBMBOWrapper& buffer,
+        MirOrientation orientation);
     void clear(std::lock_guard<std::mutex> const&);
+    void animate();
+    void advance_animation_locked(std::lock_guard<std::mutex> const&);
+
+    DeviceBuffers& buffers_for_device(int drm_fd);
+    GBMBOWrapper& buffer_for_output_locked(
+        std::lock_guard<std::mutex> const&,
+        KMSOutput const& output,
+        MirOrientation orientation);
 
-    GBMBOWrapper& buffer_for_output(KMSOutput const& output);
-    
     std::mutex guard;
 
     KMSOutputContainer& output_container;
     geometry::Point current_position;
-    geometry::Displacement hotspot;
-    geometry::Size size;
-    std::vector<uint8_t> argb8888;
+
+    // frames[current_frame] is the image being shown; more than one frame is an animation
+    std::vector<Image> frames;
+    size_t current_frame;
+    std::chrono::steady_clock::time_point next_frame_due;
 
     bool visible;
+    bool suspended;
     bool last_set_failed;
 
+    std::condition_variable animation_changed;
+    bool stop_animation;
+    std::thread animation_thread;
+
     struct GBMBOWrapper
     {
-        GBMBOWrapper(int fd, MirOrientation orientation);
+        GBMBOWrapper(gbm_device* device, int fd);
         operator gbm_bo*();
 
-        auto orientation() const -> MirOrientation { return current_orientation; }
-        auto change_orientation(MirOrientation new_orientation) -> bool;
-
         ~GBMBOWrapper();
 
         GBMBOWrapper(GBMBOWrapper&& from);
     private:
-        gbm_device* device;
         gbm_bo* buffer;
-        MirOrientation current_orientation;
         GBMBOWrapper(GBMBOWrapper const&) = delete;
         GBMBOWrapper& operator=(GBMBOWrapper const&) = delete;
     };
-    Mutex<std::vector<std::pair<int, GBMBOWrapper>>> buffers;
+
+    /*
+     * Each DRM device keeps a few buffers already filled with recently shown
+     * images, so going back to one of them (e.g. the frames of an animation)
+     * is a cursor plane update with no copying.
+     */
+    struct DeviceBuffers
+    {
+        struct CachedImage
+        {
+            GBMBOWrapper buffer;
+            bool filled;
+            size_t image_hash;
+            MirOrientation orientation;
+            uint64_t last_used;
+        };
+
+        explicit DeviceBuffers(int fd);
+
+        std::unique_ptr<gbm_device, void(*)(gbm_device*)> device;
+        std::vector<CachedImage> images;
+    };
+    Mutex<std::vector<std::pair<int, DeviceBuffers>>> buffers;
+    uint64_t buffer_use_count;
 
     uint32_t min_buffer_width;
     uint32_t min_buffer_height;
@@ -23,6 +23,8 @@
 #include "kms_display_configuration.h"
 #include "kms_output.h"
 #include "kms_page_flipper.h"
+#include "atomic_kms_commit.h"
+#include "drm_device_tasks.h"
 #include "mir/console_services.h"
 #include "mir/graphics/overlapping_output_grouping.h"
 #include "mir/graphics/event_handler_register.h"
@@ -43,6 +45,8 @@
 #include "kms-utils/drm_mode_resources.h"
 #include "kms-utils/kms_connector.h"
 
+#include <xf86drm.h>
+
 #include <stdexcept>
 #include <algorithm>
 #include <unordered_map>
@@ -209,6 +213,15 @@ mgm::Display::Display(std::vector<std::shared_ptr<helpers::DRMHelper>> const& dr
 
     log_drm_details(drm);
 
+    for (auto const& helper : drm)
+    {
+        if (drmSetClientCap(helper->fd, DRM_CLIENT_CAP_ATOMIC, 1) == 0)
+        {
+            mir::log_info("Using atomic modesetting on DRM fd %d", helper->fd);
+            atomic_kms_fds.insert(helper->fd);
+        }
+    }
+
     initial_conf_policy->apply_to(current_display_configuration);
 
     configure(current_display_configuration);
@@ -323,11 +336,13 @@ void mgm::Display::resume()
 
         /*
          * After resuming (e.g. because we switched back to the display server VT)
-         * we need to reset the CRTCs. For active displays we schedule a CRTC reset
-         * on the next swap. For connected but unused outputs we clear the CRTC.
+         * we may need to reset the CRTCs. For active displays whose CRTC was
+         * changed while we were away we schedule a CRTC reset on the next swap;
+         * the rest just page flip, avoiding a redundant modeset. For connected
+         * but unused outputs we clear the CRTC.
          */
         for (auto& db_ptr : display_buffers)
-            db_ptr->schedule_set_crtc();
+            db_ptr->schedule_set_crtc_if_changed();
 
         clear_connected_unused_outputs();
     }
@@ -472,7 +487,7 @@ void add_to_drm_device_group(
 
 void mgm::Display::configure_locked(
     mgm::RealKMSDisplayConfiguration const& kms_conf,
-    std::lock_guard<std::mutex> const&)
+    std::lock_guard<std::mutex> const& lock)
 {
     // Treat the current_display_configuration as incompatible with itself,
     // before it's fully constructed, to force proper initialization.
@@ -481,6 +496,14 @@ void mgm::Display::configure_locked(
         compatible(kms_conf, current_display_configuration)};
     std::vector<std::unique_ptr<DisplayBuffer>> display_buffers_new;
 
+    /*
+     * New display buffers don't set their CRTCs themselves. On devices with
+     * atomic modesetting we set them all at once, and only once the driver
+     * has accepted the whole configuration.
+     */
+    std::unordered_map<int, std::unique_ptr<AtomicKMSCommit>> atomic_commits;
+    std::unordered_map<int, std::vector<DisplayBuffer*>> legacy_display_buffers;
+
     if (!comp)
     {
         /*
@@ -524,6 +547,7 @@ void mgm::Display::configure_locked(
                     auto const mode_index = kms_conf.get_kms_mode_index(conf_output.id,
                                                                   conf_output.current_mode_index);
                     kms_output->configure(conf_output.top_left - bounding_rect.top_left, mode_index);
+                    kms_output->set_adaptive_sync(conf_output.adaptive_sync);
                     if (!comp)
                     {
                         kms_output->set_power_mode(conf_output.power_mode);
@@ -583,11 +607,77 @@ void mgm::Display::configure_locked(
                         bounding_rect,
                         transformation);
 
+                    auto const drm_fd = group.front()->drm_fd();
+                    if (atomic_kms_fds.count(drm_fd))
+                    {
+                        auto& commit = atomic_commits[drm_fd];
+                        if (!commit)
+                            commit = std::make_unique<AtomicKMSCommit>(drm_fd);
+                        db->add_crtcs_to(*commit);
+                    }
+                    else
+                    {
+                        legacy_display_buffers[drm_fd].push_back(db.get());
+                    }
+
                     display_buffers_new.push_back(std::move(db));
                 }
             }
         });
 
+    for (auto const& commit : atomic_commits)
+    {
+        if (!commit.second->test())
+        {
+            BOOST_THROW_EXCEPTION(
+                std::runtime_error("Display configuration rejected by the KMS driver"));
+        }
+    }
+
+    std::vector<int> modeset_fds;
+    for (auto const& commit : atomic_commits)
+        modeset_fds.push_back(commit.first);
+    for (auto const& dbs : legacy_display_buffers)
+        modeset_fds.push_back(dbs.first);
+
+    /*
+     * Each device is set on its own thread: a modeset blocks until the
+     * monitor has synced, which we needn't wait for one device at a time.
+     */
+    try
+    {
+        for_each_drm_device("Setting display configuration", modeset_fds,
+            [this, &atomic_commits, &legacy_display_buffers](int drm_fd)
+            {
+                auto const commit = atomic_commits.find(drm_fd);
+                if (commit != atomic_commits.end())
+                {
+                    commit->second->commit();
+                    listener->report_successful_drm_mode_set_crtc_on_construction();
+                }
+                else
+                {
+                    for (auto db : legacy_display_buffers.at(drm_fd))
+                        db->set_crtcs();
+                }
+            });
+    }
+    catch (std::exception const&)
+    {
+        /*
+         * Other devices may already be showing the new configuration, from
+         * display buffers we are about to destroy. Set every device back to
+         * the current configuration, which (as at construction) is treated as
+         * incompatible with itself so every CRTC is set again.
+         */
+        if (&kms_conf != &current_display_configuration)
+        {
+            mir::log_warning("Failed to set display configuration; restoring the previous one on every DRM device");
+            configure_locked(current_display_configuration, lock);
+        }
+        throw;
+    }
+
     if (!comp)
         display_buffers = std::move(display_buffers_new);
 
@@ -29,6 +29,7 @@
 
 #include <atomic>
 #include <mutex>
+#include <unordered_set>
 #include <vector>
 
 namespace mir
@@ -124,6 +125,8 @@ private:
     BypassOption bypass_option;
     std::weak_ptr<Cursor> cursor;
     std::shared_ptr<GLConfig> const gl_config;
+    /// The DRM fds that support atomic modesetting, on which configure() sets all CRTCs in one commit
+    std::unordered_set<int> atomic_kms_fds;
 };
 
 }
@@ -18,6 +18,7 @@
 
 #include "display_buffer.h"
 #include "kms_output.h"
+#include "atomic_kms_commit.h"
 #include "mir/graphics/display_report.h"
 #include "mir/graphics/transformation.h"
 #include "bypass.h"
@@ -35,9 +36,11 @@
 #include <drm_fourcc.h>
 
 #include <sstream>
+#include <system_error>
 #include <stdexcept>
 #include <chrono>
 #include <thread>
+#include <mutex>
 #include <algorithm>
 
 namespace mg = mir::graphics;
@@ -483,6 +486,69 @@ public:
 };
 }
 
+class mgm::DisplayBuffer::BypassFrames
+{
+public:
+    /**
+     * \a frame is about to be flipped to on \a flips outputs. It replaces
+     * what's visible only once every one of them has flipped.
+     */
+    void schedule(std::shared_ptr<Buffer> const& frame, unsigned flips)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        scheduled = frame;
+        flips_outstanding = flips;
+    }
+
+    /// Called from the page flip callback of each output showing \a frame
+    void flipped(Buffer const* frame)
+    {
+        std::shared_ptr<Buffer> replaced;
+
+        std::lock_guard<std::mutex> lock{mutex};
+        if (scheduled && scheduled.get() == frame && --flips_outstanding == 0)
+        {
+            replaced = std::move(visible);
+            visible = std::move(scheduled);
+        }
+    }
+
+    /**
+     * Whatever was scheduled is on screen now, even if no page flip
+     * callback said so (a set_crtc(), or a powered off output).
+     *
+     * \return  Whether a bypass frame is on screen.
+     */
+    bool complete()
+    {
+        std::shared_ptr<Buffer> replaced;
+
+        std::lock_guard<std::mutex> lock{mutex};
+        if (scheduled)
+        {
+            replaced = std::move(visible);
+            visible = std::move(scheduled);
+            flips_outstanding = 0;
+        }
+        return visible != nullptr;
+    }
+
+    /// A composited frame is on screen, in place of any bypass frame
+    void composited()
+    {
+        std::shared_ptr<Buffer> replaced;
+
+        std::lock_guard<std::mutex> lock{mutex};
+        replaced = std::move(visible);
+    }
+
+private:
+    std::mutex mutex;
+    std::shared_ptr<Buffer> visible;
+    std::shared_ptr<Buffer> scheduled;
+    unsigned flips_outstanding{0};
+};
+
 mgm::DisplayBuffer::DisplayBuffer(
     mgm::BypassOption option,
     std::shared_ptr<DisplayReport> const& listener,
@@ -490,7 +556,8 @@ mgm::DisplayBuffer::DisplayBuffer(
     GBMOutputSurface&& surface_gbm,
     geom::Rectangle const& area,
     glm::mat2 const& transformation)
-    : listener(listener),
+    : bypass_frames{std::make_shared<BypassFrames>()},
+      listener(listener),
       bypass_option(option),
       outputs(outputs),
       surface{std::move(surface_gbm)},
@@ -546,11 +613,8 @@ mgm::DisplayBuffer::DisplayBuffer(
         }
     }
 
-    set_crtc(*outputs.front()->fb_for(visible_composite_frame));
-
     release_current();
 
-    listener->report_successful_drm_mode_set_crtc_on_construction();
     listener->report_successful_display_construction();
     surface.report_egl_configuration(
         [&listener] (EGLDisplay disp, EGLConfig cfg)
@@ -561,31 +625,42 @@ mgm::DisplayBuffer::DisplayBuffer(
 
 mgm::DisplayBuffer::~DisplayBuffer()
 {
+    /*
+     * post() doesn't wait for its page flip, so the last frame may still be
+     * on its way to the screen: don't let go of the buffers till it is.
+     */
+    wait_for_page_flip();
 }
 
 geom::Rectangle mgm::DisplayBuffer::view_area() const
 {
+    std::lock_guard<std::mutex> lock{transformation_mutex};
     return area;
 }
 
 glm::mat2 mgm::DisplayBuffer::transformation() const
 {
+    std::lock_guard<std::mutex> lock{transformation_mutex};
     return transform;
 }
 
 void mgm::DisplayBuffer::set_transformation(glm::mat2 const& t, geometry::Rectangle const& a)
 {
+    std::lock_guard<std::mutex> lock{transformation_mutex};
     transform = t;
     area = a;
 }
 
 bool mgm::DisplayBuffer::overlay(RenderableList const& renderable_list)
 {
+    overlays.clear();
+    overlay_bufs.clear();
+
     glm::mat2 static const no_transformation(1);
-    if (transform == no_transformation &&
+    if (transformation() == no_transformation &&
        (bypass_option == mgm::BypassOption::allowed))
     {
-        mgm::BypassMatch bypass_match(area);
+        mgm::BypassMatch bypass_match(view_area());
         auto bypass_it = std::find_if(renderable_list.rbegin(), renderable_list.rend(), bypass_match);
         if (bypass_it != renderable_list.rend())
         {
@@ -610,6 +685,88 @@ bool mgm::DisplayBuffer::overlay(RenderableList const& renderable_list)
     return false;
 }
 
+std::size_t mgm::DisplayBuffer::overlay_topmost(RenderableList const& renderable_list)
+{
+    overlays.clear();
+    overlay_bufs.clear();
+
+    glm::mat2 static const no_transformation(1);
+    if (!atomic_kms ||
+        outputs.size() != 1 ||
+        transformation() != no_transformation ||
+        bypass_option != mgm::BypassOption::allowed ||
+        !visible_composite_frame)
+    {
+        return 0;
+    }
+
+    auto& output = *outputs.front();
+    auto const planes = output.overlay_planes();
+    auto const area = view_area();
+    mgm::OverlayMatch const overlay_match{area};
+
+    /*
+     * Take renderables from the top down while they can be scanned out
+     * directly. We don't control the stacking order of the overlay planes
+     * themselves, so those we take mustn't overlap each other.
+     */
+    std::vector<std::size_t> taken;
+    for (auto it = renderable_list.rbegin();
+         it != renderable_list.rend() && overlays.size() < planes.size();
+         ++it)
+    {
+        auto const& renderable = *it;
+        auto const position = renderable->screen_position();
+
+        // Offscreen renderables neither need a plane nor get in the way
+        if (!area.overlaps(position))
+            continue;
+
+        if (!overlay_match(renderable))
+            break;
+
+        auto const buffer = renderable->buffer();
+        auto const native = std::dynamic_pointer_cast<mgm::NativeBuffer>(buffer->native_buffer_handle());
+        if (!native || !(native->flags & mir_buffer_flag_can_scanout) ||
+            needs_bounce_buffer(output, native->bo))
+        {
+            break;
+        }
+
+        auto const fb = output.fb_for(native->bo);
+        if (!fb)
+            break;
+
+        geom::Rectangle const destination{
+            geom::Point{} + (position.top_left - area.top_left),
+            position.size};
+
+        auto const overlaps_taken = std::any_of(overlays.begin(), overlays.end(),
+            [&](OverlayPlane const& plane) { return plane.destination.overlaps(destination); });
+        if (overlaps_taken)
+            break;
+
+        overlays.push_back(OverlayPlane{
+            planes[overlays.size()],
+            fb,
+            {{0, 0}, buffer->size()},
+            destination});
+        overlay_bufs.push_back(buffer);
+        taken.push_back(std::distance(renderable_list.rbegin(), it) + 1);
+    }
+
+    /* Fall back to compositing the lowest of them until the driver is happy */
+    auto const& composite_fb = *output.fb_for(visible_composite_frame);
+    while (!overlays.empty() && !test_overlays(composite_fb))
+    {
+        overlays.pop_back();
+        overlay_bufs.pop_back();
+        taken.pop_back();
+    }
+
+    return taken.empty() ? 0 : taken.back();
+}
+
 void mgm::DisplayBuffer::for_each_display_buffer(
     std::function<void(graphics::DisplayBuffer&)> const& f)
 {
@@ -623,6 +780,28 @@ void mgm::DisplayBuffer::swap_buffers()
     bypass_bufobj = nullptr;
 }
 
+void mgm::DisplayBuffer::set_crtcs()
+{
+    set_crtc(*outputs.front()->fb_for(visible_composite_frame));
+
+    listener->report_successful_drm_mode_set_crtc_on_construction();
+}
+
+void mgm::DisplayBuffer::add_crtcs_to(AtomicKMSCommit& commit)
+{
+    atomic_kms = true;
+
+    auto const& frame = *outputs.front()->fb_for(visible_composite_frame);
+
+    for (auto& output : outputs)
+    {
+        if (!output->add_crtc_to(commit, frame))
+            mir::log_error("Failed to set DRM CRTC. "
+                "Screen contents may be incomplete. "
+                "Try plugging the monitor in again.");
+    }
+}
+
 void mgm::DisplayBuffer::set_crtc(FBHandle const& forced_frame)
 {
     for (auto& output : outputs)
@@ -652,9 +831,21 @@ void mgm::DisplayBuffer::post()
     wait_for_page_flip();
 
     mgm::FBHandle *bufobj;
+    std::function<void()> on_flipped;
     if (bypass_buf)
     {
         bufobj = bypass_bufobj;
+
+        /*
+         * Give the replaced bypass buffer back to its client as soon as the
+         * flip completes, rather than waiting here for it or holding it till
+         * the next frame. In clone mode that's once the last output flips.
+         */
+        bypass_frames->schedule(bypass_buf, outputs.size());
+        on_flipped = [frames = bypass_frames, frame = bypass_buf.get()]
+            {
+                frames->flipped(frame);
+            };
     }
     else
     {
@@ -664,11 +855,21 @@ void mgm::DisplayBuffer::post()
             fatal_error("Failed to get front buffer object");
     }
 
+    if (!needs_set_crtc && (!overlays.empty() || !visible_overlay_planes.empty()))
+    {
+        /*
+         * Frames with overlays, or taking them down, need an atomic commit
+         * of all the planes. It completes with the next vblank, so it stands
+         * in for the page flip. [will complete in this thread]
+         */
+        if (!commit_overlays(*bufobj))
+            needs_set_crtc = true;
+    }
     /*
      * Try to schedule a page flip as first preference to avoid tearing.
-     * [will complete in a background thread]
+     * [will complete in the DRM event thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*bufobj))
+    else if (!needs_set_crtc && !schedule_page_flip(*bufobj, on_flipped))
         needs_set_crtc = true;
 
     /*
@@ -685,50 +886,42 @@ void mgm::DisplayBuffer::post()
 
     // Predicted worst case render time for the next frame...
     auto predicted_render_time = 50ms;
+    auto throttle = true;
 
+    /*
+     * We don't wait for the flip here: the compositor can prepare the next
+     * frame while this one is pending, and the next post() waits only if
+     * the flip still hasn't completed by then.
+     */
     if (bypass_buf)
     {
-        /*
-         * For composited frames we defer wait_for_page_flip till just before
-         * the next frame, but not for bypass frames. Deferring the flip of
-         * bypass frames would increase the time we held
-         * visible_bypass_frame unacceptably, resulting in client stuttering
-         * unless we allocate more buffers (which I'm trying to avoid).
-         * Also, bypass does not need the deferred page flip because it has
-         * no compositing/rendering step for which to save time for.
-         */
-        scheduled_bypass_frame = bypass_buf;
-        wait_for_page_flip();
-
         // It's very likely the next frame will be bypassed like this one so
         // we only need time for kernel page flip scheduling...
         predicted_render_time = 5ms;
-    }
-    else
-    {
-        /*
-         * Not in clone mode? We can afford to wait for the page flip then,
-         * making us double-buffered (noticeably less laggy than the triple
-         * buffering that clone mode requires).
-         */
-        if (outputs.size() == 1)
-            wait_for_page_flip();
 
         /*
-         * TODO: If you're optimistic about your GPU performance and/or
-         *       measure it carefully you may wish to set predicted_render_time
-         *       to a lower value here for lower latency.
-         *
-         *predicted_render_time = 9ms; // e.g. about the same as Weston
+         * An adaptive sync output refreshes when we flip to it, so there's
+         * no fixed vblank to line the next frame up with: flip the next
+         * buffer as soon as it arrives. We still can't outpace the mode's
+         * refresh rate, as the next post() waits for this flip.
          */
+        if (outputs.size() == 1 && outputs.front()->adaptive_sync())
+            throttle = false;
     }
+    /*
+     * TODO: If you're optimistic about your GPU performance and/or
+     *       measure it carefully you may wish to set predicted_render_time
+     *       to a lower value here for lower latency.
+     *
+     *predicted_render_time = 9ms; // e.g. about the same as Weston
+     */
 
     // Buffer lifetimes are managed exclusively by scheduled*/visible* now
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
 
     recommend_sleep = 0ms;
-    if (outputs.size() == 1)
+    if (throttle && outputs.size() == 1)
     {
         auto const& output = outputs.front();
         auto const min_frame_interval = 1000ms / output->max_refresh_rate();
@@ -742,7 +935,62 @@ std::chrono::milliseconds mgm::DisplayBuffer::recommended_sleep() const
     return recommend_sleep;
 }
 
-bool mgm::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
+std::vector<mgm::OverlayPlane> mgm::DisplayBuffer::overlay_changes() const
+{
+    auto changes = overlays;
+
+    for (auto plane_id : visible_overlay_planes)
+    {
+        auto const still_used = std::any_of(overlays.begin(), overlays.end(),
+            [plane_id](OverlayPlane const& plane) { return plane.plane_id == plane_id; });
+
+        if (!still_used)
+            changes.push_back(OverlayPlane{plane_id, nullptr, {}, {}});
+    }
+
+    return changes;
+}
+
+bool mgm::DisplayBuffer::test_overlays(FBHandle const& bufobj) const
+{
+    auto& output = *outputs.front();
+    AtomicKMSCommit commit{output.drm_fd(), AtomicKMSCommit::Modeset::forbidden};
+
+    return output.add_frame_to(commit, bufobj, overlay_changes()) && commit.test();
+}
+
+bool mgm::DisplayBuffer::commit_overlays(FBHandle const& bufobj)
+{
+    auto& output = *outputs.front();
+    AtomicKMSCommit commit{output.drm_fd(), AtomicKMSCommit::Modeset::forbidden};
+
+    if (!output.add_frame_to(commit, bufobj, overlay_changes()))
+        return false;
+
+    try
+    {
+        commit.commit();
+    }
+    catch (std::system_error const& error)
+    {
+        mir::log_warning("Failed to show overlay planes: %s", error.what());
+        return false;
+    }
+
+    /* The previous overlay buffers are off the screen now */
+    visible_overlay_bufs = std::move(overlay_bufs);
+    overlay_bufs.clear();
+    visible_overlay_planes.clear();
+    for (auto const& plane : overlays)
+        visible_overlay_planes.push_back(plane.plane_id);
+    overlays.clear();
+
+    return true;
+}
+
+bool mgm::DisplayBuffer::schedule_page_flip(
+    FBHandle const& bufobj,
+    std::function<void()> const& on_flipped)
 {
     /*
      * Schedule the current front buffer object for display. Note that
@@ -750,8 +998,10 @@ bool mgm::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
      */
     for (auto& output : outputs)
     {
-        if (output->schedule_page_flip(bufobj))
+        if (output->schedule_page_flip(bufobj, on_flipped))
             page_flips_pending = true;
+        else if (on_flipped)
+            on_flipped();   // No callback is coming to count this output off
     }
 
     return page_flips_pending;
@@ -767,16 +1017,19 @@ void mgm::DisplayBuffer::wait_for_page_flip()
         page_flips_pending = false;
     }
 
-    if (scheduled_bypass_frame || scheduled_composite_frame)
+    /*
+     * The last frame we posted is on screen now, so whatever it replaced
+     * can be released.
+     */
+    if (scheduled_composite_frame)
     {
-        // Why are both of these grouped into a single statement?
-        // Because in either case both types of frame need releasing each time.
-
-        visible_bypass_frame = scheduled_bypass_frame;
-        scheduled_bypass_frame = nullptr;
-
         visible_composite_frame = std::move(scheduled_composite_frame);
         scheduled_composite_frame = nullptr;
+        bypass_frames->composited();
+    }
+    else if (bypass_frames->complete())
+    {
+        visible_composite_frame = nullptr;
     }
 }
 
@@ -800,6 +1053,18 @@ void mgm::DisplayBuffer::schedule_set_crtc()
     needs_set_crtc = true;
 }
 
+void mgm::DisplayBuffer::schedule_set_crtc_if_changed()
+{
+    for (auto& output : outputs)
+    {
+        if (!output->crtc_is_unchanged())
+        {
+            needs_set_crtc = true;
+            return;
+        }
+    }
+}
+
 mg::NativeDisplayBuffer* mgm::DisplayBuffer::native_display_buffer()
 {
     return this;
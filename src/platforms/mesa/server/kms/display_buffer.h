@@ -25,9 +25,11 @@
 #include "display_helpers.h"
 #include "egl_helper.h"
 #include "platform_common.h"
+#include "kms_output.h"
 
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <atomic>
 
 namespace mir
@@ -43,6 +45,7 @@ namespace mesa
 
 class Platform;
 class FBHandle;
+class AtomicKMSCommit;
 class KMSOutput;
 class NativeBuffer;
 
@@ -112,6 +115,7 @@ public:
     void release_current() override;
     void swap_buffers() override;
     bool overlay(RenderableList const& renderlist) override;
+    std::size_t overlay_topmost(RenderableList const& renderlist) override;
     void bind() override;
 
     void for_each_display_buffer(
@@ -123,14 +127,27 @@ public:
     NativeDisplayBuffer* native_display_buffer() override;
 
     void set_transformation(glm::mat2 const& t, geometry::Rectangle const& a);
+    /// Show the initial, cleared, frame on our outputs; a new DisplayBuffer does not set the CRTCs itself
+    void set_crtcs();
+    /// As set_crtcs(), but as part of \a commit. This also lets later frames use overlay planes.
+    void add_crtcs_to(AtomicKMSCommit& commit);
     void schedule_set_crtc();
+    void schedule_set_crtc_if_changed();
     void wait_for_page_flip();
 
 private:
-    bool schedule_page_flip(FBHandle const& bufobj);
+    bool schedule_page_flip(FBHandle const& bufobj, std::function<void()> const& on_flipped);
     void set_crtc(FBHandle const&);
+    bool test_overlays(FBHandle const& bufobj) const;
+    bool commit_overlays(FBHandle const& bufobj);
+    std::vector<OverlayPlane> overlay_changes() const;
 
-    std::shared_ptr<graphics::Buffer> visible_bypass_frame, scheduled_bypass_frame;
+    /*
+     * Shared with the page flip callbacks, which give the replaced bypass
+     * buffer back as soon as the new one is on screen.
+     */
+    class BypassFrames;
+    std::shared_ptr<BypassFrames> const bypass_frames;
     std::shared_ptr<Buffer> bypass_buf{nullptr};
     FBHandle* bypass_bufobj{nullptr};
     std::shared_ptr<DisplayReport> const listener;
@@ -150,9 +167,24 @@ private:
     GBMOutputSurface::FrontBuffer visible_composite_frame;
     GBMOutputSurface::FrontBuffer scheduled_composite_frame;
 
+    /*
+     * A reconfiguration that keeps this DisplayBuffer changes these while the
+     * compositor thread may be reading them.
+     */
+    std::mutex mutable transformation_mutex;
     geometry::Rectangle area;
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
+
+    /*
+     * Overlay planes need atomic modesetting, to check the driver can show
+     * them before we rely on it.
+     */
+    bool atomic_kms{false};
+    std::vector<OverlayPlane> overlays;
+    std::vector<std::shared_ptr<graphics::Buffer>> overlay_bufs;
+    std::vector<std::shared_ptr<graphics::Buffer>> visible_overlay_bufs;
+    std::vector<uint32_t> visible_overlay_planes;
     std::chrono::milliseconds recommend_sleep{0};
     bool page_flips_pending;
 };
@@ -0,0 +1,80 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_MESA_DRM_DEVICE_TASKS_H_
+#define MIR_GRAPHICS_MESA_DRM_DEVICE_TASKS_H_
+
+#include "mir/log.h"
+
+#include <chrono>
+#include <future>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace mesa
+{
+/**
+ * Runs \a task(drm_fd) for each DRM device and waits for all of them.
+ *
+ * The kernel serialises mode setting and connector probing per device,
+ * not across devices, so with more than one device each gets its own
+ * thread. The time taken is logged against \a phase.
+ *
+ * \throws  the first exception thrown by a task, once all have finished
+ */
+template<typename Task>
+void for_each_drm_device(char const* phase, std::vector<int> const& drm_fds, Task const& task)
+{
+    if (drm_fds.empty())
+        return;
+
+    auto const start = std::chrono::steady_clock::now();
+
+    if (drm_fds.size() == 1)
+    {
+        task(drm_fds.front());
+    }
+    else
+    {
+        std::vector<std::future<void>> pending;
+        for (auto drm_fd : drm_fds)
+            pending.push_back(std::async(std::launch::async, [&task, drm_fd] { task(drm_fd); }));
+
+        for (auto& done : pending)
+            done.wait();
+
+        for (auto& done : pending)
+            done.get();
+    }
+
+    auto const elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    mir::log_info(
+        "%s on %zu DRM device(s) took %lld.%03lldms",
+        phase,
+        drm_fds.size(),
+        static_cast<long long>(elapsed.count() / 1000),
+        static_cast<long long>(elapsed.count() % 1000));
+}
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_MESA_DRM_DEVICE_TASKS_H_ */
@@ -22,6 +22,7 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/graphics/display_configuration.h"
 #include "mir/graphics/frame.h"
 #include "mir_toolkit/common.h"
@@ -29,6 +30,8 @@
 #include "kms-utils/drm_mode_resources.h"
 
 #include <gbm.h>
+#include <vector>
+#include <functional>
 
 namespace mir
 {
@@ -40,6 +43,16 @@ namespace mesa
 {
 
 class FBHandle;
+class AtomicKMSCommit;
+
+/// What an overlay plane shows in one frame
+struct OverlayPlane
+{
+    uint32_t plane_id;
+    FBHandle const* fb;                 ///< nullptr turns the plane off
+    geometry::Rectangle source;         ///< The part of fb to show
+    geometry::Rectangle destination;    ///< Relative to the output's top left
+};
 
 class KMSOutput
 {
@@ -65,8 +78,42 @@ public:
     virtual int max_refresh_rate() const = 0;
 
     virtual bool set_crtc(FBHandle const& fb) = 0;
+    /**
+     * As set_crtc(), but adding the change to \a commit rather than making it now.
+     *
+     * \return false if there is no CRTC to set.
+     */
+    virtual bool add_crtc_to(AtomicKMSCommit& commit, FBHandle const& fb) = 0;
+    /**
+     * The overlay planes this output may use in atomic commits.
+     */
+    virtual std::vector<uint32_t> overlay_planes() = 0;
+    /**
+     * Add showing \a fb on the primary plane, with \a overlays on top, to
+     * \a commit. Unlike add_crtc_to() this never needs a modeset.
+     *
+     * \return false if there is no CRTC to show them on.
+     */
+    virtual bool add_frame_to(
+        AtomicKMSCommit& commit,
+        FBHandle const& fb,
+        std::vector<OverlayPlane> const& overlays) = 0;
+    /**
+     * Whether the CRTC is still driving this output with the mode and offset
+     * we configured, so a page flip can replace set_crtc(). This is typically
+     * checked on regaining DRM master, as the other master may have left the
+     * CRTC as it was.
+     */
+    virtual bool crtc_is_unchanged() = 0;
     virtual void clear_crtc() = 0;
-    virtual bool schedule_page_flip(FBHandle const& fb) = 0;
+    /**
+     * Schedule \a fb to be shown on the next vblank.
+     *
+     * \param [in] on_flipped  Called, from the DRM event thread, once \a fb
+     *                         is on screen. Not called if the flip could not
+     *                         be scheduled, or the output is powered off.
+     */
+    virtual bool schedule_page_flip(FBHandle const& fb, std::function<void()> const& on_flipped) = 0;
     virtual void wait_for_page_flip() = 0;
 
     virtual bool set_cursor(gbm_bo* buffer) = 0;
@@ -76,6 +123,13 @@ public:
 
     virtual void set_power_mode(MirPowerMode mode) = 0;
     virtual void set_gamma(GammaCurves const& gamma) = 0;
+    /**
+     * Turn the output's variable refresh rate (adaptive sync) on or off.
+     * Turning it on does nothing if the driver or monitor can't do it.
+     */
+    virtual void set_adaptive_sync(bool enabled) = 0;
+    /// Whether the output refreshes as frames are flipped to it, rather than at a fixed rate
+    virtual bool adaptive_sync() const = 0;
     virtual Frame last_frame() const = 0;
 
     /**
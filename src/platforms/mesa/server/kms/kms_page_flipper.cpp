@@ -18,6 +18,9 @@
 
 #include "kms_page_flipper.h"
 #include "mir/graphics/display_report.h"
+#include "mir/dispatch/threaded_dispatcher.h"
+#include "mir/dispatch/readable_fd.h"
+#include "mir/fd.h"
 
 #include <stdexcept>
 #include <boost/throw_exception.hpp>
@@ -30,6 +33,7 @@
 
 namespace mg = mir::graphics;
 namespace mgm = mir::graphics::mesa;
+namespace md = mir::dispatch;
 
 namespace
 {
@@ -52,7 +56,11 @@ mgm::KMSPageFlipper::KMSPageFlipper(
     drm_fd{drm_fd},
     report{report},
     pending_page_flips(),
-    worker_tid()
+    callbacks_in_flight{0},
+    event_errno{0},
+    event_dispatcher{std::make_unique<md::ThreadedDispatcher>(
+        "Mir/DRM events",
+        std::make_shared<md::ReadableFd>(Fd{IntOwnedFd{drm_fd}}, [this]{ handle_events(); }))}
 {
     uint64_t mono = 0;
     if (drmGetCap(drm_fd, DRM_CAP_TIMESTAMP_MONOTONIC, &mono) || !mono)
@@ -61,16 +69,19 @@ mgm::KMSPageFlipper::KMSPageFlipper(
         clock_id = CLOCK_MONOTONIC;
 }
 
+mgm::KMSPageFlipper::~KMSPageFlipper() = default;
+
 bool mgm::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
                                         uint32_t fb_id,
-                                        uint32_t connector_id)
+                                        uint32_t connector_id,
+                                        std::function<void()> const& on_flipped)
 {
     std::unique_lock<std::mutex> lock{pf_mutex};
 
     if (pending_page_flips.find(crtc_id) != pending_page_flips.end())
         BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
 
-    pending_page_flips[crtc_id] = PageFlipEventData{crtc_id, connector_id, this};
+    pending_page_flips[crtc_id] = PageFlipEventData{crtc_id, connector_id, this, on_flipped};
 
     /*
      * It appears we can't tell the difference between flipping being
@@ -89,84 +100,71 @@ bool mgm::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
 }
 
 mg::Frame mgm::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
+{
+    std::unique_lock<std::mutex> lock{pf_mutex};
+
+    /*
+     * The event dispatcher completes the flip; we only need to wait if it
+     * hasn't happened yet.
+     */
+    pf_cv.wait(lock, [&]
+        { return (page_flip_is_done(crtc_id) && !callbacks_in_flight) || event_errno; });
+
+    if (!page_flip_is_done(crtc_id))
+    {
+        std::string const msg("Error while waiting for page-flip event");
+        BOOST_THROW_EXCEPTION(
+            boost::enable_error_info(
+                std::runtime_error(msg)) << boost::errinfo_errno(event_errno));
+    }
+
+    return completed_page_flips[crtc_id];
+}
+
+void mgm::KMSPageFlipper::handle_events()
 {
     drmEventContext evctx;
     memset(&evctx, 0, sizeof evctx);
     evctx.version = 2;  // We only support the old v2 page_flip_handler
     evctx.page_flip_handler = &page_flip_handler;
 
-    static std::thread::id const invalid_tid;
+    decltype(flipped_callbacks) flipped;
 
     {
-        std::unique_lock<std::mutex> lock{pf_mutex};
+        std::lock_guard<std::mutex> lock{pf_mutex};
 
         /*
-         * While another thread is the worker (it is controlling the
-         * page flip event loop) and our event has not arrived, wait.
+         * When we get a page flip event, page_flip_handler(), called through
+         * drmHandleEvent(), will update the pending_page_flips map.
          */
-        while (worker_tid != invalid_tid && !page_flip_is_done(crtc_id))
-            pf_cv.wait(lock);
-
-        /* If the page flip we are waiting for has arrived we are done. */
-        if (page_flip_is_done(crtc_id))
-            return completed_page_flips[crtc_id];
+        if (drmHandleEvent(drm_fd, &evctx) < 0 && errno != EINTR && errno != EAGAIN)
+            event_errno = errno;
 
-        /* ...otherwise we become the worker */
-        worker_tid = std::this_thread::get_id();
+        flipped.swap(flipped_callbacks);
+        ++callbacks_in_flight;
     }
 
-    /* Only the worker thread reaches this point */
-    bool done{false};
-
-    while (!done)
+    /*
+     * Run the completion callbacks without the lock, so they are free to
+     * schedule the next flip, but hold waiters back until they are done so
+     * nobody returning from wait_for_flip() can see a flip whose callback
+     * is still to come.
+     */
+    struct CallbacksDone
     {
-        fd_set fds;
-        FD_ZERO(&fds);
-        FD_SET(drm_fd, &fds);
-
-        /*
-         * Wait for a page flip event. When we get a page flip event,
-         * page_flip_handler(), called through drmHandleEvent(), will update
-         * the pending_page_flips map.
-         */
-        auto ret = select(drm_fd + 1, &fds, nullptr, nullptr, nullptr);
-
+        ~CallbacksDone()
         {
-            std::unique_lock<std::mutex> lock{pf_mutex};
-
-            if (ret > 0)
             {
-                drmHandleEvent(drm_fd, &evctx);
+                std::lock_guard<std::mutex> lock{self->pf_mutex};
+                --self->callbacks_in_flight;
             }
-            else if (ret < 0 && errno != EINTR)
-            {
-                std::string const msg("Error while waiting for page-flip event");
-                BOOST_THROW_EXCEPTION(
-                    boost::enable_error_info(
-                        std::runtime_error(msg)) << boost::errinfo_errno(errno));
-            }
-
-            done = page_flip_is_done(crtc_id);
-            /* Give up loop control if we are done */
-            if (done)
-                worker_tid = invalid_tid;
+            self->pf_cv.notify_all();
         }
+        KMSPageFlipper* const self;
+    } const done{this};
 
-        /*
-         * Wake up other (non-worker) threads, so they can check whether
-         * their page-flip events have arrived, or whether they can become
-         * the worker (see pf_cv.wait(lock) above).
-         */
-        pf_cv.notify_all();
-    }
-    return completed_page_flips[crtc_id];
-}
-
-std::thread::id mgm::KMSPageFlipper::debug_get_worker_tid()
-{
-    std::unique_lock<std::mutex> lock{pf_mutex};
-
-    return worker_tid;
+    for (auto const& on_flipped : flipped)
+        on_flipped();
 }
 
 /* This method should be called with the 'pf_mutex' locked */
@@ -175,6 +173,7 @@ bool mgm::KMSPageFlipper::page_flip_is_done(uint32_t crtc_id)
     return pending_page_flips.find(crtc_id) == pending_page_flips.end();
 }
 
+/* This method should be called with the 'pf_mutex' locked */
 void mgm::KMSPageFlipper::notify_page_flip(uint32_t crtc_id, int64_t msc,
                                            std::chrono::nanoseconds ust)
 {
@@ -185,6 +184,8 @@ void mgm::KMSPageFlipper::notify_page_flip(uint32_t crtc_id, int64_t msc,
         frame.msc = msc;
         frame.ust = {clock_id, ust};
         report->report_vsync(pending->second.connector_id, frame);
+        if (pending->second.on_flipped)
+            flipped_callbacks.push_back(std::move(pending->second.on_flipped));
         pending_page_flips.erase(pending);
     }
 }
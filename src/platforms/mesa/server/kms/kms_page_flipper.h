@@ -22,15 +22,21 @@
 #include "page_flipper.h"
 
 #include <unordered_map>
+#include <vector>
 #include <chrono>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
-#include <thread>
 #include <ctime>
 #include <sys/time.h>
 
 namespace mir
 {
+namespace dispatch
+{
+class ThreadedDispatcher;
+}
 namespace graphics
 {
 
@@ -45,21 +51,26 @@ struct PageFlipEventData
     uint32_t crtc_id;
     uint32_t connector_id;
     KMSPageFlipper* flipper;
+    std::function<void()> on_flipped;
 };
 
 class KMSPageFlipper : public PageFlipper
 {
 public:
     KMSPageFlipper(int drm_fd, std::shared_ptr<DisplayReport> const& report);
+    ~KMSPageFlipper();
 
-    bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
+    bool schedule_flip(
+        uint32_t crtc_id,
+        uint32_t fb_id,
+        uint32_t connector_id,
+        std::function<void()> const& on_flipped) override;
     Frame wait_for_flip(uint32_t crtc_id) override;
 
-    std::thread::id debug_get_worker_tid();
-
     void notify_page_flip(uint32_t crtc_id, int64_t msc, std::chrono::nanoseconds ust);
 private:
     bool page_flip_is_done(uint32_t crtc_id);
+    void handle_events();
 
     int const drm_fd;
     std::shared_ptr<DisplayReport> const report;
@@ -67,8 +78,12 @@ private:
     std::unordered_map<uint32_t,Frame> completed_page_flips;
     std::mutex pf_mutex;
     std::condition_variable pf_cv;
-    std::thread::id worker_tid;
+    std::vector<std::function<void()>> flipped_callbacks;
+    int callbacks_in_flight;
+    int event_errno;
     clockid_t clock_id;
+    /* Declared last, so its thread is stopped before the state it uses goes */
+    std::unique_ptr<dispatch::ThreadedDispatcher> const event_dispatcher;
 };
 
 }
@@ -21,6 +21,7 @@
 
 #include "mir/graphics/frame.h"
 #include <cstdint>
+#include <functional>
 
 namespace mir
 {
@@ -34,7 +35,19 @@ class PageFlipper
 public:
     virtual ~PageFlipper() {}
 
-    virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /**
+     * Schedule a page flip on the next vblank.
+     *
+     * \param [in] on_flipped  Called, from a thread owned by the page flipper,
+     *                         once the flip has completed. May be empty.
+     * \return  Whether the flip was scheduled. on_flipped is only ever called
+     *          for scheduled flips.
+     */
+    virtual bool schedule_flip(
+        uint32_t crtc_id,
+        uint32_t fb_id,
+        uint32_t connector_id,
+        std::function<void()> const& on_flipped) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
 protected:
@@ -18,9 +18,12 @@
 
 #include "real_kms_display_configuration.h"
 #include "mir/graphics/pixel_format_utils.h"
+#include "mir/graphics/overlapping_output_grouping.h"
+#include "mir/geometry/displacement.h"
 #include "mir/log.h"
 #include "kms_output_container.h"
 #include "kms_output.h"
+#include "drm_device_tasks.h"
 
 #include <cmath>
 #include <limits>
@@ -143,10 +146,11 @@ void populate_default_mir_config(mg::DisplayConfigurationOutput& to_populate)
 void mgm::RealKMSDisplayConfiguration::update()
 {
     decltype(outputs) new_outputs;
+    std::vector<int> drm_fds;
 
     displays->update_from_hardware_state();
     displays->for_each_output(
-        [this, &new_outputs](auto const& output) mutable
+        [this, &new_outputs, &drm_fds](auto const& output) mutable
         {
             DisplayConfigurationOutput mir_config;
 
@@ -167,10 +171,23 @@ void mgm::RealKMSDisplayConfiguration::update()
                 mir_config = existing_output->first;
             }
 
-            output->update_from_hardware_state(mir_config);
             mir_config.id = DisplayConfigurationOutputId{int(new_outputs.size() + 1)};
 
             new_outputs.emplace_back(mir_config, output);
+
+            if (std::find(drm_fds.begin(), drm_fds.end(), output->drm_fd()) == drm_fds.end())
+                drm_fds.push_back(output->drm_fd());
+        });
+
+    // Reading the EDIDs is slow, so do each device's outputs concurrently
+    for_each_drm_device("Reading output state", drm_fds,
+        [&new_outputs](int drm_fd)
+        {
+            for (auto& output : new_outputs)
+            {
+                if (output.second->drm_fd() == drm_fd)
+                    output.second->update_from_hardware_state(output.first);
+            }
         });
 
     outputs = new_outputs;
@@ -182,11 +199,42 @@ void mgm::RealKMSDisplayConfiguration::update()
     card.max_simultaneous_outputs = outputs.size();
 }
 
+namespace
+{
+using OutputOffsets = std::vector<std::pair<mg::DisplayConfigurationOutputId, geom::Displacement>>;
+
+// The outputs sharing each display buffer, and where each sits within it
+std::vector<OutputOffsets> display_buffer_layout(mg::DisplayConfiguration const& conf)
+{
+    std::vector<OutputOffsets> layout;
+
+    mg::OverlappingOutputGrouping grouping{conf};
+    grouping.for_each_group(
+        [&layout](mg::OverlappingOutputGroup const& group)
+        {
+            auto const origin = group.bounding_rectangle().top_left;
+            OutputOffsets offsets;
+            group.for_each_output(
+                [&](mg::DisplayConfigurationOutput const& output)
+                {
+                    offsets.emplace_back(output.id, output.top_left - origin);
+                });
+            std::sort(offsets.begin(), offsets.end(),
+                [](auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+            layout.push_back(std::move(offsets));
+        });
+
+    return layout;
+}
+}
+
 // Compatibility means conf1 can be attained from conf2 (and vice versa)
 // without recreating the display buffers (e.g. conf1 and conf2 are identical
 // except one of the outputs of conf1 is rotated w.r.t. that of conf2). If
 // the two outputs differ in their power state, the display buffers would need
 // to be allocated/destroyed, and hence should not be considered compatible.
+// Outputs may move so long as each display buffer keeps the same outputs in
+// the same places within it.
 bool mgm::compatible(mgm::RealKMSDisplayConfiguration const& conf1, mgm::RealKMSDisplayConfiguration const& conf2)
 {
     bool compatible{
@@ -210,6 +258,7 @@ bool mgm::compatible(mgm::RealKMSDisplayConfiguration const& conf1, mgm::RealKMS
                 clone.scale = conf1.outputs[i].first.scale;
                 clone.form_factor = conf1.outputs[i].first.form_factor;
                 clone.custom_logical_size = conf1.outputs[i].first.custom_logical_size;
+                clone.top_left = conf1.outputs[i].first.top_left;
                 compatible &= (conf1.outputs[i].first == clone);
             }
             else
@@ -217,5 +266,5 @@ bool mgm::compatible(mgm::RealKMSDisplayConfiguration const& conf1, mgm::RealKMS
         }
     }
 
-    return compatible;
+    return compatible && (display_buffer_layout(conf1) == display_buffer_layout(conf2));
 }
@@ -17,6 +17,7 @@
  */
 
 #include "real_kms_output.h"
+#include "atomic_kms_commit.h"
 #include "mir/graphics/display_configuration.h"
 #include "page_flipper.h"
 #include "kms-utils/kms_connector.h"
@@ -181,6 +182,82 @@ bool mgm::RealKMSOutput::set_crtc(FBHandle const& fb)
     return true;
 }
 
+bool mgm::RealKMSOutput::add_crtc_to(AtomicKMSCommit& commit, FBHandle const& fb)
+{
+    if (!ensure_crtc())
+    {
+        mir::log_error("Output %s has no associated CRTC to set a framebuffer on",
+                       mgk::connector_name(connector).c_str());
+        return false;
+    }
+
+    commit.set_crtc(
+        current_crtc->crtc_id,
+        connector->connector_id,
+        connector->modes[mode_index],
+        fb.get_drm_fb_id(),
+        fb_offset);
+
+    /* Don't leave a previous configuration's overlays on top */
+    ensure_planes();
+    for (auto plane_id : overlay_plane_ids)
+        commit.disable_plane(plane_id, plane_properties(plane_id));
+
+    using_saved_crtc = false;
+    return true;
+}
+
+std::vector<uint32_t> mgm::RealKMSOutput::overlay_planes()
+{
+    if (!ensure_crtc())
+        return {};
+
+    ensure_planes();
+    return overlay_plane_ids;
+}
+
+bool mgm::RealKMSOutput::add_frame_to(
+    AtomicKMSCommit& commit,
+    FBHandle const& fb,
+    std::vector<OverlayPlane> const& overlays)
+{
+    if (!ensure_crtc())
+        return false;
+
+    ensure_planes();
+
+    auto const& mode = connector->modes[mode_index];
+    geom::Size const mode_size{mode.hdisplay, mode.vdisplay};
+
+    commit.set_plane(
+        primary_plane_id,
+        plane_properties(primary_plane_id),
+        current_crtc->crtc_id,
+        fb.get_drm_fb_id(),
+        {geom::Point{} + fb_offset, mode_size},
+        {{0, 0}, mode_size});
+
+    for (auto const& overlay : overlays)
+    {
+        if (overlay.fb)
+        {
+            commit.set_plane(
+                overlay.plane_id,
+                plane_properties(overlay.plane_id),
+                current_crtc->crtc_id,
+                overlay.fb->get_drm_fb_id(),
+                overlay.source,
+                overlay.destination);
+        }
+        else
+        {
+            commit.disable_plane(overlay.plane_id, plane_properties(overlay.plane_id));
+        }
+    }
+
+    return true;
+}
+
 void mgm::RealKMSOutput::clear_crtc()
 {
     try
@@ -209,7 +286,7 @@ void mgm::RealKMSOutput::clear_crtc()
     current_crtc = nullptr;
 }
 
-bool mgm::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
+bool mgm::RealKMSOutput::schedule_page_flip(FBHandle const& fb, std::function<void()> const& on_flipped)
 {
     std::unique_lock<std::mutex> lg(power_mutex);
     if (power_mode != mir_power_mode_on)
@@ -223,7 +300,8 @@ bool mgm::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
     return page_flipper->schedule_flip(
         current_crtc->crtc_id,
         fb.get_drm_fb_id(),
-        connector->connector_id);
+        connector->connector_id,
+        on_flipped);
 }
 
 void mgm::RealKMSOutput::wait_for_page_flip()
@@ -318,6 +396,29 @@ bool mgm::RealKMSOutput::ensure_crtc()
     return (current_crtc != nullptr);
 }
 
+void mgm::RealKMSOutput::ensure_planes()
+{
+    if (planes_crtc_id == current_crtc->crtc_id)
+        return;
+
+    plane_props.clear();
+    primary_plane_id = AtomicKMSCommit::primary_plane_for(drm_fd_, current_crtc->crtc_id);
+    overlay_plane_ids = AtomicKMSCommit::overlay_planes_for(drm_fd_, current_crtc->crtc_id);
+    planes_crtc_id = current_crtc->crtc_id;
+}
+
+mgk::ObjectProperties const& mgm::RealKMSOutput::plane_properties(uint32_t plane_id)
+{
+    auto props = plane_props.find(plane_id);
+    if (props == plane_props.end())
+    {
+        props = plane_props.emplace(
+            plane_id,
+            mgk::ObjectProperties{drm_fd_, plane_id, DRM_MODE_OBJECT_PLANE}).first;
+    }
+    return props->second;
+}
+
 void mgm::RealKMSOutput::restore_saved_crtc()
 {
     if (!using_saved_crtc)
@@ -376,6 +477,56 @@ void mgm::RealKMSOutput::set_gamma(mg::GammaCurves const& gamma)
     // TODO: return bool in future? Then do what with it?
 }
 
+void mgm::RealKMSOutput::set_adaptive_sync(bool enabled)
+{
+    adaptive_sync_ = false;
+
+    if (!ensure_crtc())
+    {
+        mir::log_warning("Output %s has no associated CRTC to set adaptive sync on",
+                         mgk::connector_name(connector).c_str());
+        return;
+    }
+
+    mgk::ObjectProperties const crtc_props{
+        drm_fd_, current_crtc->crtc_id, DRM_MODE_OBJECT_CRTC};
+
+    /* Only drivers that can do adaptive sync have VRR_ENABLED; it's off unless we set it */
+    if (!crtc_props.has_property("VRR_ENABLED"))
+    {
+        if (enabled)
+            mir::log_warning("Output %s does not support adaptive sync",
+                             mgk::connector_name(connector).c_str());
+        return;
+    }
+
+    enabled = enabled && connector_is_vrr_capable(drm_fd_, connector->connector_id);
+
+    if (crtc_props["VRR_ENABLED"] != enabled)
+    {
+        auto const ret = drmModeObjectSetProperty(
+            drm_fd_,
+            current_crtc->crtc_id,
+            DRM_MODE_OBJECT_CRTC,
+            crtc_props.id_for("VRR_ENABLED"),
+            enabled);
+
+        if (ret)
+        {
+            mir::log_warning("Failed to set adaptive sync on output %s: %s",
+                             mgk::connector_name(connector).c_str(), strerror(-ret));
+            return;
+        }
+    }
+
+    adaptive_sync_ = enabled;
+}
+
+bool mgm::RealKMSOutput::adaptive_sync() const
+{
+    return adaptive_sync_;
+}
+
 void mgm::RealKMSOutput::refresh_hardware_state()
 {
     connector = kms::get_connector(drm_fd_, connector->connector_id);
@@ -524,6 +675,14 @@ std::vector<uint8_t> edid_for_connector(int drm_fd, uint32_t connector_id)
 
     return edid;
 }
+
+bool connector_is_vrr_capable(int drm_fd, uint32_t connector_id)
+{
+    mgk::ObjectProperties const connector_props{
+        drm_fd, connector_id, DRM_MODE_OBJECT_CONNECTOR};
+
+    return connector_props.has_property("vrr_capable") && connector_props["vrr_capable"];
+}
 }
 
 void mgm::RealKMSOutput::update_from_hardware_state(
@@ -601,6 +760,7 @@ void mgm::RealKMSOutput::update_from_hardware_state(
     output.subpixel_arrangement = kms_subpixel_to_mir_subpixel(connector->subpixel);
     output.gamma = gamma;
     output.edid = edid;
+    output.adaptive_sync_supported = connected && connector_is_vrr_capable(drm_fd_, connector->connector_id);
 }
 
 mgm::FBHandle* mgm::RealKMSOutput::fb_for(gbm_bo* bo) const
@@ -659,6 +819,34 @@ bool mgm::RealKMSOutput::buffer_requires_migration(gbm_bo* bo) const
     return gbm_device_get_fd(gbm_bo_get_device(bo)) != drm_fd_;
 }
 
+bool mgm::RealKMSOutput::crtc_is_unchanged()
+{
+    if (!current_crtc || using_saved_crtc)
+        return false;
+
+    try
+    {
+        auto const connector_now = kms::get_connector(drm_fd_, connector->connector_id);
+        if (!connector_now->encoder_id)
+            return false;
+
+        auto const encoder = kms::get_encoder(drm_fd_, connector_now->encoder_id);
+        if (encoder->crtc_id != current_crtc->crtc_id)
+            return false;
+
+        auto const crtc = kms::get_crtc(drm_fd_, current_crtc->crtc_id);
+        return crtc->buffer_id &&
+               crtc->mode_valid &&
+               kms_modes_are_equal(crtc->mode, connector->modes[mode_index]) &&
+               static_cast<int>(crtc->x) == fb_offset.dx.as_int() &&
+               static_cast<int>(crtc->y) == fb_offset.dy.as_int();
+    }
+    catch (std::exception const&)
+    {
+        return false;
+    }
+}
+
 int mgm::RealKMSOutput::drm_fd() const
 {
     return drm_fd_;
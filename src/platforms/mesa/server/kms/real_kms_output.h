@@ -25,6 +25,8 @@
 
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <unordered_map>
 
 namespace mir
 {
@@ -52,8 +54,15 @@ public:
     int max_refresh_rate() const override;
 
     bool set_crtc(FBHandle const& fb) override;
+    bool add_crtc_to(AtomicKMSCommit& commit, FBHandle const& fb) override;
+    std::vector<uint32_t> overlay_planes() override;
+    bool add_frame_to(
+        AtomicKMSCommit& commit,
+        FBHandle const& fb,
+        std::vector<OverlayPlane> const& overlays) override;
+    bool crtc_is_unchanged() override;
     void clear_crtc() override;
-    bool schedule_page_flip(FBHandle const& fb) override;
+    bool schedule_page_flip(FBHandle const& fb, std::function<void()> const& on_flipped) override;
     void wait_for_page_flip() override;
 
     bool set_cursor(gbm_bo* buffer) override;
@@ -63,6 +72,8 @@ public:
 
     void set_power_mode(MirPowerMode mode) override;
     void set_gamma(GammaCurves const& gamma) override;
+    void set_adaptive_sync(bool enabled) override;
+    bool adaptive_sync() const override;
 
     Frame last_frame() const override;
 
@@ -76,6 +87,8 @@ public:
 private:
     bool ensure_crtc();
     void restore_saved_crtc();
+    void ensure_planes();
+    kms::ObjectProperties const& plane_properties(uint32_t plane_id);
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
@@ -88,11 +101,20 @@ private:
     bool using_saved_crtc;
     bool has_cursor_;
 
+    /* The planes of current_crtc, which we look up once rather than every frame */
+    uint32_t planes_crtc_id{0};
+    uint32_t primary_plane_id{0};
+    std::vector<uint32_t> overlay_plane_ids;
+    std::unordered_map<uint32_t, kms::ObjectProperties> plane_props;
+
     MirPowerMode power_mode;
     int dpms_enum_id;
 
     std::mutex power_mutex;
 
+    /* Read by the compositor, while the display configuration sets it */
+    std::atomic<bool> adaptive_sync_{false};
+
     AtomicFrame last_frame_;
 };
 
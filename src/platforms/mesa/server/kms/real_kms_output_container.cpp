@@ -19,8 +19,11 @@
 #include <algorithm>
 #include "real_kms_output_container.h"
 #include "real_kms_output.h"
+#include "drm_device_tasks.h"
 #include "kms-utils/drm_mode_resources.h"
 
+#include <mutex>
+
 namespace mgm = mir::graphics::mesa;
 
 mgm::RealKMSOutputContainer::RealKMSOutputContainer(
@@ -39,45 +42,61 @@ void mgm::RealKMSOutputContainer::for_each_output(std::function<void(std::shared
 
 void mgm::RealKMSOutputContainer::update_from_hardware_state()
 {
-    decltype(outputs) new_outputs;
+    // Each device is probed on its own thread; the results are kept in
+    // drm_fds order so output ids stay stable from one probe to the next.
+    std::vector<decltype(outputs)> new_outputs_by_device(drm_fds.size());
+    std::mutex page_flipper_mutex;
+
+    for_each_drm_device("Probing outputs", drm_fds,
+        [&](int drm_fd)
+        {
+            auto const device_index = std::find(drm_fds.begin(), drm_fds.end(), drm_fd) - drm_fds.begin();
+            auto& new_outputs = new_outputs_by_device[device_index];
 
-    for (auto drm_fd : drm_fds)
-    {
-        kms::DRMModeResources resources{drm_fd};
+            kms::DRMModeResources resources{drm_fd};
 
+            for (auto &&connector : resources.connectors())
+            {
+                // Caution: O(n²) here, but n is the number of outputs, so should
+                // conservatively be << 100.
+                auto existing_output = std::find_if(
+                    outputs.begin(),
+                    outputs.end(),
+                    [&connector, drm_fd](auto const &candidate)
+                    {
+                        return
+                            connector->connector_id == candidate->id() &&
+                            drm_fd == candidate->drm_fd();
+                    });
 
-        for (auto &&connector : resources.connectors())
-        {
-            // Caution: O(n²) here, but n is the number of outputs, so should
-            // conservatively be << 100.
-            auto existing_output = std::find_if(
-                outputs.begin(),
-                outputs.end(),
-                [&connector, drm_fd](auto const &candidate)
+                if (existing_output != outputs.end())
                 {
-                    return
-                        connector->connector_id == candidate->id() &&
-                        drm_fd == candidate->drm_fd();
-                });
+                    // We could drop this down to O(n) by being smarter about moving out
+                    // of the outputs vector.
+                    //
+                    // That's a bit of a faff, so just do the simple thing for now.
+                    new_outputs.push_back(*existing_output);
+                    new_outputs.back()->refresh_hardware_state();
+                }
+                else
+                {
+                    std::shared_ptr<PageFlipper> page_flipper;
+                    {
+                        std::lock_guard<std::mutex> lock{page_flipper_mutex};
+                        page_flipper = construct_page_flipper(drm_fd);
+                    }
 
-            if (existing_output != outputs.end())
-            {
-                // We could drop this down to O(n) by being smarter about moving out
-                // of the outputs vector.
-                //
-                // That's a bit of a faff, so just do the simple thing for now.
-                new_outputs.push_back(*existing_output);
-                new_outputs.back()->refresh_hardware_state();
-            }
-            else
-            {
-                new_outputs.push_back(std::make_shared<RealKMSOutput>(
-                    drm_fd,
-                    std::move(connector),
-                    construct_page_flipper(drm_fd)));
+                    new_outputs.push_back(std::make_shared<RealKMSOutput>(
+                        drm_fd,
+                        std::move(connector),
+                        page_flipper));
+                }
             }
-        }
+        });
+
+    decltype(outputs) new_outputs;
+    for (auto const& device_outputs : new_outputs_by_device)
+        new_outputs.insert(new_outputs.end(), device_outputs.begin(), device_outputs.end());
 
-    }
     outputs = new_outputs;
 }
@@ -27,6 +27,7 @@
 #include "mir/gl/tessellation_helpers.h"
 #include "mir/gl/texture_cache.h"
 #include "mir/gl/texture.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/log.h"
 #include "mir/report_exception.h"
 
@@ -34,16 +35,80 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
+#include <cstring>
 
 namespace mg = mir::graphics;
 namespace mgl = mir::gl;
 namespace mrg = mir::renderer::gl;
 namespace geom = mir::geometry;
 
+namespace
+{
+// Older buffers than this are just redrawn in full
+std::size_t const max_tracked_buffer_age = 4;
+
+// Damage spread over more separate areas than this is repainted as one
+std::size_t const max_repainted_areas = 4;
+
+bool is_empty(geom::Rectangle const& rect)
+{
+    return rect.size.width.as_int() <= 0 || rect.size.height.as_int() <= 0;
+}
+
+/// Merges overlapping damage so each pixel is repainted in one area only
+std::vector<geom::Rectangle> separate_areas(geom::Rectangles const& damage)
+{
+    std::vector<geom::Rectangle> areas;
+
+    for (auto const& rect : damage)
+    {
+        if (is_empty(rect))
+            continue;
+
+        auto area = rect;
+        for (auto merged = true; merged;)
+        {
+            merged = false;
+            for (auto i = areas.begin(); i != areas.end();)
+            {
+                if (i->overlaps(area))
+                {
+                    area = geom::Rectangles{*i, area}.bounding_rectangle();
+                    i = areas.erase(i);
+                    merged = true;
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+        areas.push_back(area);
+    }
+
+    if (areas.size() > max_repainted_areas)
+        areas = {damage.bounding_rectangle()};
+
+    return areas;
+}
+
+bool current_display_supports_buffer_age()
+{
+    auto const disp = eglGetCurrentDisplay();
+    if (disp == EGL_NO_DISPLAY)
+        return false;
+
+    auto const extensions = eglQueryString(disp, EGL_EXTENSIONS);
+    return extensions && strstr(extensions, "EGL_EXT_buffer_age");
+}
+}
+
 mrg::CurrentRenderTarget::CurrentRenderTarget(mg::DisplayBuffer* display_buffer)
     : render_target{
         dynamic_cast<renderer::gl::RenderTarget*>(display_buffer->native_display_buffer())}
@@ -137,7 +202,8 @@ mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
       default_program(family.add_program(vshader, default_fshader)),
       alpha_program(family.add_program(vshader, alpha_fshader)),
       texture_cache(mgl::DefaultProgramFactory().create_texture_cache()),
-      display_transform(1)
+      display_transform(1),
+      buffer_age_supported(current_display_supports_buffer_age())
 {
     eglBindAPI(MIR_SERVER_EGL_OPENGL_API);
     EGLDisplay disp = eglGetCurrentDisplay();
@@ -184,6 +250,9 @@ mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
     mir::log_info("GL framebuffer bits: RGBA=%d%d%d%d, depth=%d, stencil=%d",
                   rbits, gbits, bbits, abits, dbits, sbits);
 
+    if (buffer_age_supported)
+        mir::log_info("Redrawing only damaged areas using EGL_EXT_buffer_age");
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     set_viewport(display_buffer.view_area());
@@ -205,13 +274,43 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
 {
     render_target.bind();
 
+    std::vector<geom::Rectangle> repaint{viewport};
+    if (buffer_age_supported)
+    {
+        damage_history.push_front(damage_since_last_frame(renderables));
+        if (damage_history.size() > max_tracked_buffer_age)
+            damage_history.pop_back();
+
+        repaint = areas_to_repaint();
+    }
+
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT);
 
     ++frameno;
-    for (auto const& r : renderables)
-        draw(*r, r->alpha() < 1.0f ? alpha_program : default_program);
+    if (repaint.size() == 1 && repaint.front().contains(viewport))
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+        for (std::size_t i = 0; i != renderables.size(); ++i)
+            draw_tessellated(i, renderables[i]);
+    }
+    else if (!repaint.empty())
+    {
+        // Separate areas are repainted apart, so what lies between keeps its pixels
+        glEnable(GL_SCISSOR_TEST);
+        for (auto const& area : repaint)
+        {
+            scissor_to(area);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            for (std::size_t i = 0; i != renderables.size(); ++i)
+            {
+                if (!drawn[i].bounded || drawn[i].bounds.overlaps(area))
+                    draw_tessellated(i, renderables[i]);
+            }
+        }
+        glDisable(GL_SCISSOR_TEST);
+    }
 
     render_target.swap_buffers();
 
@@ -223,6 +322,193 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
         mir::log_debug("GL error: %d", gl_error);
 }
 
+void mrg::Renderer::draw_tessellated(
+    std::size_t index, std::shared_ptr<mg::Renderable> const& renderable) const
+{
+    // Without damage tracking nothing has been tessellated yet this frame
+    tessellated = index < tessellations.size() ? &tessellations[index] : nullptr;
+    draw(*renderable, renderable->alpha() < 1.0f ? alpha_program : default_program);
+}
+
+mrg::Renderer::DrawnRenderable mrg::Renderer::describe(
+    mg::Renderable const& renderable,
+    std::vector<mgl::Primitive>& tessellation) const
+{
+    DrawnRenderable result{
+        renderable.id(),
+        renderable.buffer()->id(),
+        renderable.screen_position(),
+        renderable.alpha(),
+        renderable.shaped(),
+        renderable.transformation() == glm::mat4(1)};
+
+    // These primitives are drawn too, so each renderable is tessellated
+    // once a frame. Shells may tessellate outside screen_position() (e.g.
+    // decorations), so bound what is actually drawn.
+    tessellation.clear();
+    tessellate(tessellation, renderable);
+
+    if (!result.bounded)
+        return result;
+
+    GLfloat left = result.bounds.left().as_int();
+    GLfloat top = result.bounds.top().as_int();
+    GLfloat right = result.bounds.right().as_int();
+    GLfloat bottom = result.bounds.bottom().as_int();
+
+    for (auto const& p : tessellation)
+    {
+        // We can't see changes to other textures, nor where depth moves vertices
+        if (p.tex_id != 0)
+            result.bounded = false;
+
+        for (int i = 0; i != std::min<int>(p.nvertices, mgl::Primitive::max_vertices); ++i)
+        {
+            auto const& position = p.vertices[i].position;
+            if (position[2] != 0.0f)
+                result.bounded = false;
+
+            left = std::min(left, position[0]);
+            top = std::min(top, position[1]);
+            right = std::max(right, position[0]);
+            bottom = std::max(bottom, position[1]);
+        }
+    }
+
+    geom::Point const top_left{static_cast<int>(std::floor(left)), static_cast<int>(std::floor(top))};
+    result.bounds = {
+        top_left,
+        geom::Size{
+            static_cast<int>(std::ceil(right)) - top_left.x.as_int(),
+            static_cast<int>(std::ceil(bottom)) - top_left.y.as_int()}};
+
+    return result;
+}
+
+geom::Rectangles mrg::Renderer::damage_since_last_frame(mg::RenderableList const& renderables) const
+{
+    // Keep the primitives' storage from frame to frame
+    if (tessellations.size() < renderables.size())
+        tessellations.resize(renderables.size());
+
+    std::vector<DrawnRenderable> now;
+    now.reserve(renderables.size());
+    for (std::size_t i = 0; i != renderables.size(); ++i)
+        now.push_back(describe(*renderables[i], tessellations[i]));
+
+    auto const previous = std::move(drawn);
+    drawn = std::move(now);
+
+    // Nothing to compare against: the first frame, or the viewport changed
+    if (damage_history.empty())
+        return {viewport};
+
+    std::unordered_map<mg::Renderable::ID, std::size_t> previous_index;
+    for (std::size_t i = 0; i != previous.size(); ++i)
+        previous_index[previous[i].id] = i;
+
+    std::vector<bool> still_drawn(previous.size(), false);
+    geom::Rectangles damage;
+    bool everything = false;
+    std::size_t last_index = 0;
+
+    for (auto const& current : drawn)
+    {
+        auto const found = previous_index.find(current.id);
+        if (found == previous_index.end())
+        {
+            everything |= !current.bounded;
+            damage.add(current.bounds);
+            continue;
+        }
+
+        auto const& before = previous[found->second];
+        still_drawn[found->second] = true;
+
+        // Restacking changes what is on top wherever renderables overlap
+        everything |= found->second < last_index;
+        last_index = found->second;
+
+        everything |= !current.bounded || !before.bounded;
+
+        if (current.buffer != before.buffer ||
+            current.bounds != before.bounds ||
+            current.alpha != before.alpha ||
+            current.shaped != before.shaped)
+        {
+            damage.add(before.bounds);
+            damage.add(current.bounds);
+        }
+    }
+
+    for (std::size_t i = 0; i != previous.size(); ++i)
+    {
+        if (!still_drawn[i])
+        {
+            everything |= !previous[i].bounded;
+            damage.add(previous[i].bounds);
+        }
+    }
+
+    if (everything)
+        return {viewport};
+
+    geom::Rectangles visible;
+    for (auto const& rect : damage)
+        visible.add(rect.intersection_with(viewport));
+
+    return visible;
+}
+
+std::vector<geom::Rectangle> mrg::Renderer::areas_to_repaint() const
+{
+    // Render targets drawing to their own framebuffer object don't age with the surface
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+
+    EGLint age = 0;
+    if (framebuffer != 0 ||
+        !gl_viewport_valid ||
+        display_transform != glm::mat4(1) ||
+        !eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW), EGL_BUFFER_AGE_EXT, &age) ||
+        age <= 0 || static_cast<std::size_t>(age) > damage_history.size())
+    {
+        return {viewport};
+    }
+
+    // The back buffer is missing whatever changed in the frames since it was drawn
+    geom::Rectangles stale;
+    for (auto i = 0; i != age; ++i)
+    {
+        for (auto const& rect : damage_history[i])
+            stale.add(rect);
+    }
+
+    return separate_areas(stale);
+}
+
+void mrg::Renderer::scissor_to(geom::Rectangle const& area) const
+{
+    // Map from the (unrotated) viewport to GL window coordinates, which are
+    // letterboxed within the buffer and have the origin at the bottom left
+    auto const scale_x = static_cast<float>(gl_viewport[2]) / viewport.size.width.as_int();
+    auto const scale_y = static_cast<float>(gl_viewport[3]) / viewport.size.height.as_int();
+    auto const left = static_cast<GLint>(
+        std::floor((area.left().as_int() - viewport.left().as_int()) * scale_x));
+    auto const right = static_cast<GLint>(
+        std::ceil((area.right().as_int() - viewport.left().as_int()) * scale_x));
+    auto const top = static_cast<GLint>(
+        std::floor((area.top().as_int() - viewport.top().as_int()) * scale_y));
+    auto const bottom = static_cast<GLint>(
+        std::ceil((area.bottom().as_int() - viewport.top().as_int()) * scale_y));
+
+    glScissor(
+        gl_viewport[0] + left,
+        gl_viewport[1] + gl_viewport[3] - bottom,
+        right - left,
+        bottom - top);
+}
+
 void mrg::Renderer::draw(mg::Renderable const& renderable,
                           Renderer::Program const& prog) const
 {
@@ -255,8 +541,12 @@ void mrg::Renderer::draw(mg::Renderable const& renderable,
     glEnableVertexAttribArray(prog.position_attr);
     glEnableVertexAttribArray(prog.texcoord_attr);
 
-    primitives.clear();
-    tessellate(primitives, renderable);
+    if (!tessellated)
+    {
+        primitives.clear();
+        tessellate(primitives, renderable);
+        tessellated = &primitives;
+    }
 
     // if we fail to load the texture, we need to carry on (part of lp:1629275)
     try
@@ -290,7 +580,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable,
             glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
         }
 
-        for (auto const& p : primitives)
+        for (auto const& p : *tessellated)
         {
             BlendSeparate blend;
 
@@ -334,6 +624,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable,
 
     glDisableVertexAttribArray(prog.texcoord_attr);
     glDisableVertexAttribArray(prog.position_attr);
+    tessellated = nullptr;
 }
 
 void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
@@ -397,6 +688,10 @@ void mrg::Renderer::update_gl_viewport()
     auto surf = eglGetCurrentSurface(EGL_DRAW);
     EGLint buf_width = 0, buf_height = 0;
 
+    // Whatever is in the back buffers was drawn for another viewport
+    damage_history.clear();
+    gl_viewport_valid = false;
+
     if (viewport_width > 0.0f && viewport_height > 0.0f &&
         eglQuerySurface(dpy, surf, EGL_WIDTH, &buf_width) && buf_width > 0 &&
         eglQuerySurface(dpy, surf, EGL_HEIGHT, &buf_height) && buf_height > 0)
@@ -412,6 +707,12 @@ void mrg::Renderer::update_gl_viewport()
         GLint offset_y = (buf_height - reduced_height) / 2;
 
         glViewport(offset_x, offset_y, reduced_width, reduced_height);
+
+        gl_viewport[0] = offset_x;
+        gl_viewport[1] = offset_y;
+        gl_viewport[2] = reduced_width;
+        gl_viewport[3] = reduced_height;
+        gl_viewport_valid = true;
     }
 }
 
@@ -428,5 +729,6 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
 void mrg::Renderer::suspend()
 {
     texture_cache->invalidate();
+    damage_history.clear();
 }
 
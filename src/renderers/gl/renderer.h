@@ -23,12 +23,14 @@
 
 #include <mir/renderer/renderer.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/gl/primitive.h>
 #include "mir/renderer/gl/render_target.h"
 
 #include MIR_SERVER_GL_H
+#include <deque>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -84,6 +86,10 @@ protected:
      *                            grown and/or modified.
      * \param [in]     renderable The renderable surface being tessellated.
      *
+     * \note When the EGL surface reports its buffer age only the parts of
+     *       the screen that changed are redrawn, so the primitives must be
+     *       a pure function of the renderable and its buffer.
+     *
      * \note The cohesion of this function to gl::Renderer is quite loose and it
      *       does not strictly need to reside here.
      *       However it seems a good choice under gl::Renderer while this remains
@@ -123,13 +129,43 @@ protected:
                       Renderer::Program const& prog) const;
 
 private:
+    /// What we need to know about a renderable to tell if it has changed
+    struct DrawnRenderable
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer;
+        geometry::Rectangle bounds;
+        float alpha;
+        bool shaped;
+        bool bounded;   ///< Whether it is drawn entirely within bounds
+    };
+
     void update_gl_viewport();
+    void draw_tessellated(std::size_t index, std::shared_ptr<graphics::Renderable> const& renderable) const;
+    DrawnRenderable describe(
+        graphics::Renderable const& renderable,
+        std::vector<mir::gl::Primitive>& tessellation) const;
+    geometry::Rectangles damage_since_last_frame(graphics::RenderableList const& renderables) const;
+    /// The areas the back buffer needs repainted; just the viewport if all of it does
+    std::vector<geometry::Rectangle> areas_to_repaint() const;
+    void scissor_to(geometry::Rectangle const& area) const;
 
     std::unique_ptr<mir::gl::TextureCache> const texture_cache;
     geometry::Rectangle viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
+    /// This frame's primitives, one set per renderable, when tracking damage
+    std::vector<std::vector<mir::gl::Primitive>> mutable tessellations;
+    /// The primitives draw() should use rather than tessellating again
+    mutable std::vector<mir::gl::Primitive> const* tessellated = nullptr;
+
+    bool const buffer_age_supported;
+    GLint gl_viewport[4] = {0, 0, 0, 0};
+    bool gl_viewport_valid = false;
+    std::vector<DrawnRenderable> mutable drawn;
+    /// Damage of the most recent frames, newest first
+    std::deque<geometry::Rectangles> mutable damage_history;
 };
 
 }
@@ -18,6 +18,7 @@
 
 #include "compositing_screencast.h"
 #include "screencast_display_buffer.h"
+#include "mirrored_outputs.h"
 #include "queueing_schedule.h"
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/buffer_properties.h"
@@ -56,6 +57,18 @@ bool needs_virtual_output(mg::DisplayConfiguration const& conf, geom::Rectangle
     return empty == disp_rects.bounding_rectangle().intersection_with(region);
 }
 
+bool covers_an_output(mg::DisplayConfiguration const& conf, geom::Rectangle const& region)
+{
+    bool result = false;
+    conf.for_each_output([&](mg::DisplayConfigurationOutput const& disp_conf)
+    {
+        if (disp_conf.used && disp_conf.extents() == region)
+            result = true;
+    });
+
+    return result;
+}
+
 std::unique_ptr<mg::VirtualOutput> make_virtual_output(mg::Display& display, geom::Rectangle const& rect)
 {
     if (needs_virtual_output(*display.configuration(), rect))
@@ -73,11 +86,13 @@ public:
         std::shared_ptr<Scene> const& scene,
         mg::Display& display,
         DisplayBufferCompositorFactory& db_compositor_factory,
+        std::shared_ptr<MirroredOutputs> const& mirrored_outputs,
         std::vector<std::shared_ptr<mg::Buffer>> const& buffers,
         geom::Rectangle const& capture_region,
         geom::Size const& capture_size,
         MirMirrorMode mirror_mode)
     : scene{scene},
+      mirrored_outputs{mirrored_outputs},
       display_buffer{std::make_unique<ScreencastDisplayBuffer>(capture_region, capture_size, mirror_mode, free_queue, ready_queue, display)},
       display_buffer_compositor{db_compositor_factory.create_compositor_for(*display_buffer)},
       virtual_output{make_virtual_output(display, capture_region)},
@@ -87,13 +102,29 @@ public:
         for (auto buffer : buffers)
             free_queue.schedule(buffer);
 
+        if (covers_an_output(*display.configuration(), capture_region))
+        {
+            auto const gl_context_raii = mir::raii::paired_calls(
+                [this] { display_buffer->make_current(); },
+                [this] { display_buffer->release_current(); });
+
+            mirrored_frame = mirrored_outputs->start_mirroring(capture_region);
+        }
+
         scene->register_compositor(this);
+        scene->set_view_area(this, capture_region);
         if (virtual_output)
             virtual_output->enable();
     }
     ~ScreencastSessionContext()
     {
         scene->unregister_compositor(this);
+
+        if (mirrored_frame)
+        {
+            display_buffer->make_current();
+            mirrored_outputs->stop_mirroring(mirrored_frame);
+        }
     }
 
     std::shared_ptr<mg::Buffer> capture()
@@ -107,7 +138,7 @@ public:
         if (last_captured_buffer)
             free_queue.schedule(last_captured_buffer);
 
-        display_buffer_compositor->composite(scene->scene_elements_for(this));
+        composite();
 
         last_captured_buffer = ready_queue.next_buffer();
         return last_captured_buffer;
@@ -138,7 +169,7 @@ public:
         for(auto i = 0u; i < scheduled; i++)
             free_queue.schedule(free_queue.next_buffer());
 
-        display_buffer_compositor->composite(scene->scene_elements_for(this));
+        composite();
         if (buffer != ready_queue.next_buffer())
             throw std::runtime_error("unable to capture to buffer");
 
@@ -147,14 +178,28 @@ public:
     }
 
 private:
+    void composite()
+    {
+        // When capturing a whole output, what it just rendered will do
+        if (mirrored_frame &&
+            mirrored_outputs->draw_latest(*mirrored_frame, [this](GLuint frame) { display_buffer->blit(frame); }))
+        {
+            return;
+        }
+
+        display_buffer_compositor->composite(scene->scene_elements_for(this));
+    }
+
     std::mutex mutex;
     std::shared_ptr<Scene> const scene;
+    std::shared_ptr<MirroredOutputs> const mirrored_outputs;
     QueueingSchedule free_queue;
     QueueingSchedule ready_queue;
     std::unique_ptr<ScreencastDisplayBuffer> display_buffer;
 
     std::unique_ptr<compositor::DisplayBufferCompositor> display_buffer_compositor;
     std::unique_ptr<graphics::VirtualOutput> virtual_output;
+    std::shared_ptr<MirroredOutputs::Frame> mirrored_frame;
     std::shared_ptr<mg::Buffer> last_captured_buffer;
     geom::Size queue_size;
     MirMirrorMode mirror_mode;
@@ -165,11 +210,13 @@ mc::CompositingScreencast::CompositingScreencast(
     std::shared_ptr<Scene> const& scene,
     std::shared_ptr<mg::Display> const& display,
     std::shared_ptr<mg::GraphicBufferAllocator> const& buffer_allocator,
-    std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory)
+    std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
+    std::shared_ptr<MirroredOutputs> const& mirrored_outputs)
     : scene{scene},
       display{display},
       buffer_allocator{buffer_allocator},
-      db_compositor_factory{db_compositor_factory}
+      db_compositor_factory{db_compositor_factory},
+      mirrored_outputs{mirrored_outputs}
 {
 }
 
@@ -244,7 +291,7 @@ mc::CompositingScreencast::create_session_context(
     MirMirrorMode mirror_mode)
 {
     return std::make_shared<detail::ScreencastSessionContext>(
-        scene, *display, *db_compositor_factory, buffers, rect, size, mirror_mode);
+        scene, *display, *db_compositor_factory, mirrored_outputs, buffers, rect, size, mirror_mode);
 }
 
 void mc::CompositingScreencast::capture(
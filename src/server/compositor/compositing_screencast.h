@@ -39,6 +39,7 @@ class Scene;
 namespace detail { struct ScreencastSessionContext; }
 
 class DisplayBufferCompositorFactory;
+class MirroredOutputs;
 
 class CompositingScreencast : public frontend::Screencast
 {
@@ -47,7 +48,8 @@ public:
         std::shared_ptr<Scene> const& scene,
         std::shared_ptr<graphics::Display> const& display,
         std::shared_ptr<graphics::GraphicBufferAllocator> const& buffer_allocator,
-        std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory);
+        std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
+        std::shared_ptr<MirroredOutputs> const& mirrored_outputs);
 
     frontend::ScreencastSessionId create_session(
         geometry::Rectangle const& region,
@@ -73,6 +75,7 @@ private:
     std::shared_ptr<graphics::Display> const display;
     std::shared_ptr<graphics::GraphicBufferAllocator> const buffer_allocator;
     std::shared_ptr<DisplayBufferCompositorFactory> const db_compositor_factory;
+    std::shared_ptr<MirroredOutputs> const mirrored_outputs;
 
     std::unordered_map<frontend::ScreencastSessionId,
                        std::shared_ptr<detail::ScreencastSessionContext>> session_contexts;
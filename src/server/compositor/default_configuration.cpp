@@ -24,6 +24,8 @@
 #include "multi_threaded_compositor.h"
 #include "gl/renderer_factory.h"
 #include "compositing_screencast.h"
+#include "mirrored_outputs.h"
+#include "mirroring_display_buffer_compositor_factory.h"
 #include "mir/main_loop.h"
 
 #include "mir/frontend/screencast.h"
@@ -75,11 +77,15 @@ mir::DefaultServerConfiguration::the_compositor()
             return std::make_shared<mc::MultiThreadedCompositor>(
                 the_display(),
                 the_scene(),
-                the_display_buffer_compositor_factory(),
+                std::make_shared<mc::MirroringDisplayBufferCompositorFactory>(
+                    the_display_buffer_compositor_factory(),
+                    the_mirrored_outputs()),
                 the_shell(),
+                the_display_configuration_observer_registrar(),
                 the_compositor_report(),
                 composite_delay,
-                !the_options()->is_set(options::host_socket_opt));
+                !the_options()->is_set(options::host_socket_opt),
+                the_options()->get<bool>(options::skip_unchanged_frames_opt));
         });
 }
 
@@ -101,7 +107,17 @@ std::shared_ptr<mf::Screencast> mir::DefaultServerConfiguration::the_screencast(
                 the_scene(),
                 the_display(),
                 the_buffer_allocator(),
-                the_display_buffer_compositor_factory()
+                the_display_buffer_compositor_factory(),
+                the_mirrored_outputs()
                 );
         });
 }
+
+std::shared_ptr<mc::MirroredOutputs> mir::DefaultServerConfiguration::the_mirrored_outputs()
+{
+    return mirrored_outputs(
+        []()
+        {
+            return std::make_shared<mc::MirroredOutputs>();
+        });
+}
@@ -79,9 +79,18 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     }
     else
     {
+        /*
+         * The display buffer may still show the top-most renderables itself
+         * (e.g. on overlay planes), leaving us to composite those beneath.
+         */
+        auto const overlaid = display_buffer.overlay_topmost(renderable_list);
+        mg::RenderableList const composited{
+            renderable_list.begin(),
+            renderable_list.end() - overlaid};
+
         renderer->set_output_transform(display_buffer.transformation());
         renderer->set_viewport(view_area);
-        renderer->render(renderable_list);
+        renderer->render(composited);
 
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
@@ -0,0 +1,218 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mirrored_outputs.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// The EGL_KHR_fence_sync entry points, if the EGL implementation has them
+struct FenceSync
+{
+    FenceSync() :
+        create{reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"))},
+        destroy{reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"))},
+        client_wait{reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(eglGetProcAddress("eglClientWaitSyncKHR"))}
+    {
+    }
+
+    bool available() const { return create && destroy && client_wait; }
+
+    PFNEGLCREATESYNCKHRPROC const create;
+    PFNEGLDESTROYSYNCKHRPROC const destroy;
+    PFNEGLCLIENTWAITSYNCKHRPROC const client_wait;
+};
+}
+
+class mc::MirroredOutputs::Frame
+{
+public:
+    Frame(geom::Rectangle const& view_area) : view_area{view_area} {}
+
+    /// Fences the copy just issued in the current context, in place of the last one
+    void fence_copy()
+    {
+        discard_fence();
+
+        if (fence_sync.available())
+        {
+            display = eglGetCurrentDisplay();
+            copied = fence_sync.create(display, EGL_SYNC_FENCE_KHR, nullptr);
+        }
+
+        // Without a fence the copy has to be complete before we go on
+        if (copied == EGL_NO_SYNC_KHR)
+            glFinish();
+    }
+
+    /// Waits, in whatever context is current, for the last copy to complete
+    void wait_for_copy()
+    {
+        if (copied == EGL_NO_SYNC_KHR)
+            return;
+
+        fence_sync.client_wait(display, copied, 0, EGL_FOREVER_KHR);
+        discard_fence();
+    }
+
+    void discard_fence()
+    {
+        if (copied != EGL_NO_SYNC_KHR)
+            fence_sync.destroy(display, copied);
+        copied = EGL_NO_SYNC_KHR;
+    }
+
+    geom::Rectangle const view_area;
+
+    std::mutex mutex;
+    GLuint texture{0};
+    geom::Size size;
+    bool up_to_date{false};
+
+private:
+    FenceSync const fence_sync;
+    EGLDisplay display{EGL_NO_DISPLAY};
+    EGLSyncKHR copied{EGL_NO_SYNC_KHR};
+};
+
+auto mc::MirroredOutputs::start_mirroring(geom::Rectangle const& view_area) -> std::shared_ptr<Frame>
+{
+    auto const frame = std::make_shared<Frame>(view_area);
+
+    glGenTextures(1, &frame->texture);
+    glBindTexture(GL_TEXTURE_2D, frame->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    frames.push_back(frame);
+    return frame;
+}
+
+void mc::MirroredOutputs::stop_mirroring(std::shared_ptr<Frame> const& frame)
+{
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        frames.erase(std::remove(frames.begin(), frames.end(), frame), frames.end());
+    }
+
+    // Wait for any copy in progress before deleting its target
+    std::lock_guard<decltype(frame->mutex)> lock{frame->mutex};
+    frame->discard_fence();
+    glDeleteTextures(1, &frame->texture);
+    frame->texture = 0;
+    frame->up_to_date = false;
+}
+
+bool mc::MirroredOutputs::draw_latest(Frame& frame, std::function<void(GLuint texture)> const& draw)
+{
+    // Held while drawing so the next frame isn't copied over this one meanwhile
+    std::lock_guard<decltype(frame.mutex)> lock{frame.mutex};
+
+    if (!frame.up_to_date)
+        return false;
+
+    frame.wait_for_copy();
+    draw(frame.texture);
+    return true;
+}
+
+void mc::MirroredOutputs::frame_rendered(geom::Rectangle const& view_area)
+{
+    auto const mirrors = frames_for(view_area);
+    if (mirrors.empty())
+        return;
+
+    // The renderer letterboxes the frame within the viewport
+    GLint viewport[4] = {0, 0, 0, 0};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    geom::Size const size{viewport[2], viewport[3]};
+
+    if (viewport[2] <= 0 || viewport[3] <= 0)
+    {
+        frame_not_rendered(view_area);
+        return;
+    }
+
+    GLint previous_texture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+
+    bool copied = false;
+
+    for (auto const& frame : mirrors)
+    {
+        std::lock_guard<decltype(frame->mutex)> lock{frame->mutex};
+        if (!frame->texture)
+            continue;
+
+        glBindTexture(GL_TEXTURE_2D, frame->texture);
+
+        // GL_RGB, as the framebuffer may well have no alpha channel to copy
+        if (frame->size != size)
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB,
+                         size.width.as_int(), size.height.as_int(), 0,
+                         GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            frame->size = size;
+        }
+
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+                            viewport[0], viewport[1], viewport[2], viewport[3]);
+
+        // The screencast waits on this, in its own context, before drawing the copy
+        frame->fence_copy();
+        copied = true;
+
+        frame->up_to_date = true;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, previous_texture);
+
+    // Another context waiting on the fences can't flush this one for them
+    if (copied)
+        glFlush();
+}
+
+void mc::MirroredOutputs::frame_not_rendered(geom::Rectangle const& view_area)
+{
+    for (auto const& frame : frames_for(view_area))
+    {
+        std::lock_guard<decltype(frame->mutex)> lock{frame->mutex};
+        frame->up_to_date = false;
+    }
+}
+
+auto mc::MirroredOutputs::frames_for(geom::Rectangle const& view_area) -> std::vector<std::shared_ptr<Frame>>
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+
+    std::vector<std::shared_ptr<Frame>> result;
+    for (auto const& frame : frames)
+    {
+        if (frame->view_area == view_area)
+            result.push_back(frame);
+    }
+    return result;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_MIRRORED_OUTPUTS_H_
+#define MIR_COMPOSITOR_MIRRORED_OUTPUTS_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include MIR_SERVER_GL_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+/**
+ * Copies of the frames most recently rendered for outputs that a screencast
+ * covers exactly, so the screencast can show them rather than composite the
+ * whole scene again.
+ *
+ * The copies are GL textures shared between the display's contexts, so
+ * those calls that touch them expect one of those contexts to be current.
+ */
+class MirroredOutputs
+{
+public:
+    class Frame;
+
+    /// Starts copying frames rendered for the output occupying \a view_area
+    std::shared_ptr<Frame> start_mirroring(geometry::Rectangle const& view_area);
+    void stop_mirroring(std::shared_ptr<Frame> const& frame);
+
+    /**
+     * Draws the latest copy of \a frame with \a draw(texture), once the
+     * copy has completed.
+     *
+     * \returns false, without calling \a draw, if no up to date copy exists
+     *          (e.g. the output was last shown without GL rendering)
+     */
+    bool draw_latest(Frame& frame, std::function<void(GLuint texture)> const& draw);
+
+    /**
+     * Called by an output's compositor once the frame for \a view_area has
+     * been rendered into the bound framebuffer, before it is swapped.
+     */
+    void frame_rendered(geometry::Rectangle const& view_area);
+
+    /// Called when (part of) the frame for \a view_area is not rendered with GL
+    void frame_not_rendered(geometry::Rectangle const& view_area);
+
+private:
+    std::vector<std::shared_ptr<Frame>> frames_for(geometry::Rectangle const& view_area);
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Frame>> frames;
+};
+}
+}
+
+#endif /* MIR_COMPOSITOR_MIRRORED_OUTPUTS_H_ */
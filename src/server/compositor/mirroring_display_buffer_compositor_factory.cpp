@@ -0,0 +1,161 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mirroring_display_buffer_compositor_factory.h"
+#include "mirrored_outputs.h"
+
+#include "mir/compositor/display_buffer_compositor.h"
+#include "mir/graphics/display_buffer.h"
+#include "mir/renderer/gl/render_target.h"
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mrgl = mir::renderer::gl;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Passes everything to the output, noting whether GL rendered all of each frame
+class MirroringDisplayBuffer : public mg::DisplayBuffer,
+                               public mg::NativeDisplayBuffer,
+                               public mrgl::RenderTarget
+{
+public:
+    MirroringDisplayBuffer(
+        mg::DisplayBuffer& output,
+        mrgl::RenderTarget& output_target,
+        std::shared_ptr<mc::MirroredOutputs> const& mirrored_outputs) :
+        output{output},
+        output_target{output_target},
+        mirrored_outputs{mirrored_outputs}
+    {
+    }
+
+    ~MirroringDisplayBuffer()
+    {
+        // The output is reconfigured before it's composited again, so it may
+        // never show the area mirrored last again
+        mirrored_outputs->frame_not_rendered(mirrored_area);
+    }
+
+    geom::Rectangle view_area() const override
+    {
+        return output.view_area();
+    }
+
+    bool overlay(mg::RenderableList const& renderlist) override
+    {
+        auto const overlaid = output.overlay(renderlist);
+        if (overlaid)
+            mirrored_outputs->frame_not_rendered(output.view_area());
+        return overlaid;
+    }
+
+    std::size_t overlay_topmost(mg::RenderableList const& renderlist) override
+    {
+        auto const overlaid = output.overlay_topmost(renderlist);
+        frame_complete = overlaid == 0;
+        return overlaid;
+    }
+
+    glm::mat2 transformation() const override
+    {
+        return output.transformation();
+    }
+
+    mg::NativeDisplayBuffer* native_display_buffer() override
+    {
+        return this;
+    }
+
+    void make_current() override
+    {
+        output_target.make_current();
+    }
+
+    void release_current() override
+    {
+        output_target.release_current();
+    }
+
+    void bind() override
+    {
+        output_target.bind();
+    }
+
+    void swap_buffers() override
+    {
+        mirrored_area = output.view_area();
+
+        // A rotated frame doesn't match what the screencast would render
+        if (frame_complete && output.transformation() == glm::mat2(1))
+            mirrored_outputs->frame_rendered(mirrored_area);
+        else
+            mirrored_outputs->frame_not_rendered(mirrored_area);
+
+        output_target.swap_buffers();
+    }
+
+private:
+    mg::DisplayBuffer& output;
+    mrgl::RenderTarget& output_target;
+    std::shared_ptr<mc::MirroredOutputs> const mirrored_outputs;
+    bool frame_complete{true};
+    geom::Rectangle mirrored_area;
+};
+
+class MirroringDisplayBufferCompositor : public mc::DisplayBufferCompositor
+{
+public:
+    MirroringDisplayBufferCompositor(
+        std::unique_ptr<MirroringDisplayBuffer> display_buffer,
+        mc::DisplayBufferCompositorFactory& wrapped_factory) :
+        display_buffer{std::move(display_buffer)},
+        wrapped{wrapped_factory.create_compositor_for(*this->display_buffer)}
+    {
+    }
+
+    void composite(mc::SceneElementSequence&& scene_sequence) override
+    {
+        wrapped->composite(std::move(scene_sequence));
+    }
+
+private:
+    // The wrapped compositor renders to display_buffer, so must go first
+    std::unique_ptr<MirroringDisplayBuffer> const display_buffer;
+    std::unique_ptr<mc::DisplayBufferCompositor> const wrapped;
+};
+}
+
+mc::MirroringDisplayBufferCompositorFactory::MirroringDisplayBufferCompositorFactory(
+    std::shared_ptr<DisplayBufferCompositorFactory> const& wrapped,
+    std::shared_ptr<MirroredOutputs> const& mirrored_outputs) :
+    wrapped{wrapped},
+    mirrored_outputs{mirrored_outputs}
+{
+}
+
+std::unique_ptr<mc::DisplayBufferCompositor>
+mc::MirroringDisplayBufferCompositorFactory::create_compositor_for(mg::DisplayBuffer& display_buffer)
+{
+    auto const render_target = dynamic_cast<mrgl::RenderTarget*>(display_buffer.native_display_buffer());
+    if (!render_target)
+        return wrapped->create_compositor_for(display_buffer);
+
+    return std::make_unique<MirroringDisplayBufferCompositor>(
+        std::make_unique<MirroringDisplayBuffer>(display_buffer, *render_target, mirrored_outputs),
+        *wrapped);
+}
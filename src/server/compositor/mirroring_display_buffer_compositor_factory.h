@@ -0,0 +1,49 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_MIRRORING_DISPLAY_BUFFER_COMPOSITOR_FACTORY_H_
+#define MIR_COMPOSITOR_MIRRORING_DISPLAY_BUFFER_COMPOSITOR_FACTORY_H_
+
+#include "mir/compositor/display_buffer_compositor_factory.h"
+
+namespace mir
+{
+namespace compositor
+{
+class MirroredOutputs;
+
+/**
+ * Creates compositors that, besides rendering the output, give any
+ * screencast mirroring it a copy of each frame via MirroredOutputs.
+ */
+class MirroringDisplayBufferCompositorFactory : public DisplayBufferCompositorFactory
+{
+public:
+    MirroringDisplayBufferCompositorFactory(
+        std::shared_ptr<DisplayBufferCompositorFactory> const& wrapped,
+        std::shared_ptr<MirroredOutputs> const& mirrored_outputs);
+
+    std::unique_ptr<DisplayBufferCompositor> create_compositor_for(graphics::DisplayBuffer& display_buffer) override;
+
+private:
+    std::shared_ptr<DisplayBufferCompositorFactory> const wrapped;
+    std::shared_ptr<MirroredOutputs> const mirrored_outputs;
+};
+
+}
+}
+
+#endif /* MIR_COMPOSITOR_MIRRORING_DISPLAY_BUFFER_COMPOSITOR_FACTORY_H_ */
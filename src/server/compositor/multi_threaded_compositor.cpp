@@ -17,20 +17,26 @@
  */
 
 #include "multi_threaded_compositor.h"
+#include "occlusion.h"
 #include "mir/graphics/display.h"
 #include "mir/graphics/display_buffer.h"
+#include "mir/graphics/display_configuration_observer.h"
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/display_buffer_compositor_factory.h"
 #include "mir/compositor/display_listener.h"
 #include "mir/compositor/scene.h"
+#include "mir/compositor/scene_element.h"
 #include "mir/compositor/compositor_report.h"
 #include "mir/scene/legacy_scene_change_notification.h"
 #include "mir/scene/surface_observer.h"
 #include "mir/scene/surface.h"
+#include "mir/graphics/renderable.h"
+#include "mir/graphics/buffer.h"
 #include "mir/terminate_with_current_exception.h"
 #include "mir/raii.h"
 #include "mir/unwind_helpers.h"
 #include "mir/thread_name.h"
+#include "mir/observer_registrar.h"
 
 #include <thread>
 #include <chrono>
@@ -43,6 +49,63 @@ namespace mc = mir::compositor;
 namespace mg = mir::graphics;
 namespace ms = mir::scene;
 
+namespace
+{
+/// Everything about an element that the renderer draws from
+struct ElementState
+{
+    mg::Renderable::ID id;
+    mg::BufferID buffer;
+    mir::geometry::Rectangle position;
+    float alpha;
+    glm::mat4 transformation;
+};
+
+bool operator==(ElementState const& lhs, ElementState const& rhs)
+{
+    return lhs.id == rhs.id &&
+           lhs.buffer == rhs.buffer &&
+           lhs.position == rhs.position &&
+           lhs.alpha == rhs.alpha &&
+           lhs.transformation == rhs.transformation;
+}
+
+using FrameState = std::vector<ElementState>;
+
+/*
+ * Only the buffers of elements the renderer would draw are looked at:
+ * buffer() acquires a buffer from the stream, and an occluded stream
+ * must not be consumed just to find out that it isn't shown.
+ */
+FrameState state_of(mc::SceneElementSequence const& elements, mir::geometry::Rectangle const& view_area)
+{
+    auto visible = elements;
+    mc::filter_occlusions_from(visible, view_area);
+    auto next_visible = visible.begin();
+
+    FrameState state;
+    state.reserve(elements.size());
+    for (auto const& element : elements)
+    {
+        auto const renderable = element->renderable();
+        mg::BufferID buffer_id{};
+        if (next_visible != visible.end() && *next_visible == element)
+        {
+            ++next_visible;
+            if (auto const buffer = renderable->buffer())
+                buffer_id = buffer->id();
+        }
+        state.push_back({
+            renderable->id(),
+            buffer_id,
+            renderable->screen_position(),
+            renderable->alpha(),
+            renderable->transformation()});
+    }
+    return state;
+}
+}
+
 namespace mir
 {
 namespace compositor
@@ -57,13 +120,15 @@ public:
         std::shared_ptr<mc::Scene> const& scene,
         std::shared_ptr<DisplayListener> const& display_listener,
         std::chrono::milliseconds fixed_composite_delay,
-        std::shared_ptr<CompositorReport> const& report) :
+        std::shared_ptr<CompositorReport> const& report,
+        bool skip_unchanged_frames) :
         compositor_factory{db_compositor_factory},
         group(group),
         scene(scene),
         running{true},
         frames_scheduled{0},
         force_sleep{fixed_composite_delay},
+        skip_unchanged_frames{skip_unchanged_frames},
         display_listener{display_listener},
         report{report},
         started_future{started.get_future()}
@@ -89,19 +154,26 @@ public:
                                   CompositorReport::SubCompositorId{comp_id});
         });
 
+        // Where each display buffer was when the scene and display listener were last told
+        std::vector<geometry::Rectangle> view_areas;
+        for (auto& compositor : compositors)
+            view_areas.push_back(std::get<0>(compositor)->view_area());
+
         //Appease TSan, avoid destructor and this thread accessing the same shared_ptr instance
         auto const disp_listener = display_listener;
         auto display_registration = mir::raii::paired_calls(
-            [this, &disp_listener]{group.for_each_display_buffer([&disp_listener](mg::DisplayBuffer& buffer)
-                { disp_listener->add_display(buffer.view_area()); });},
-            [this, &disp_listener]{group.for_each_display_buffer([&disp_listener](mg::DisplayBuffer& buffer)
-                { disp_listener->remove_display(buffer.view_area()); });});
+            [&disp_listener, &view_areas]{ for (auto const& area : view_areas) disp_listener->add_display(area); },
+            [&disp_listener, &view_areas]{ for (auto const& area : view_areas) disp_listener->remove_display(area); });
 
         auto compositor_registration = mir::raii::paired_calls(
-            [this,&compositors]
+            [this,&compositors,&view_areas]
             {
-                for (auto& compositor : compositors)
-                    scene->register_compositor(std::get<1>(compositor).get());
+                for (size_t i = 0; i != compositors.size(); ++i)
+                {
+                    auto const comp_id = std::get<1>(compositors[i]).get();
+                    scene->register_compositor(comp_id);
+                    scene->set_view_area(comp_id, view_areas[i]);
+                }
             },
             [this,&compositors]{
                 for (auto& compositor : compositors)
@@ -110,13 +182,16 @@ public:
 
         started.set_value();
 
+        // What each compositor last rendered, for skip_unchanged_frames
+        std::vector<FrameState> last_frames(compositors.size());
+
         try
         {
             std::unique_lock<std::mutex> lock{run_mutex};
             while (running)
             {
                 /* Wait until compositing has been scheduled or we are stopped */
-                run_cv.wait(lock, [&]{ return (frames_scheduled > 0) || !running; });
+                run_cv.wait(lock, [&]{ return (frames_scheduled > 0 && !paused) || !running; });
 
                 /*
                  * Check if we are running before compositing, since we may have
@@ -132,28 +207,93 @@ public:
                      * to ensure all surfaces' queues are fully drained.
                      */
                     frames_scheduled--;
+                    bool const must_render = not_posted_yet || redraw_requested;
                     not_posted_yet = false;
+                    redraw_requested = false;
+                    bool const first_frame_after_resume = resuming;
+                    auto const resumed_at = resume_time;
+                    resuming = false;
+                    compositing = true;
                     lock.unlock();
 
-                    for (auto& tuple : compositors)
+                    /*
+                     * A display configuration that keeps the display buffers
+                     * may still have moved or resized them. Keep the scene's
+                     * view of each output, and the display listener, in step.
+                     */
+                    bool changed = must_render || !skip_unchanged_frames;
+                    for (size_t i = 0; i != compositors.size(); ++i)
                     {
-                        auto& compositor = std::get<1>(tuple);
-                        compositor->composite(scene->scene_elements_for(compositor.get()));
+                        auto const view_area = std::get<0>(compositors[i])->view_area();
+                        if (view_area != view_areas[i])
+                        {
+                            scene->set_view_area(std::get<1>(compositors[i]).get(), view_area);
+                            disp_listener->remove_display(view_areas[i]);
+                            disp_listener->add_display(view_area);
+                            view_areas[i] = view_area;
+                            changed = true;
+                        }
                     }
-                    group.post();
+
+                    std::vector<SceneElementSequence> frames;
+                    frames.reserve(compositors.size());
+                    for (auto& tuple : compositors)
+                        frames.push_back(scene->scene_elements_for(std::get<1>(tuple).get()));
 
                     /*
-                     * "Predictive bypass" optimization: If the last frame was
-                     * bypassed/overlayed or you simply have a fast GPU, it is
-                     * beneficial to sleep for most of the next frame. This reduces
-                     * the latency between snapshotting the scene and post()
-                     * completing by almost a whole frame.
+                     * A frame is only worth rendering and posting if something
+                     * the renderer draws from has changed: a new buffer in a
+                     * visible stream, or a surface moved, restacked, faded or
+                     * appeared. The group is
+                     * posted as a whole, so if any output changed they all render.
                      */
-                    auto delay = force_sleep >= std::chrono::milliseconds::zero() ?
-                                 force_sleep : group.recommended_sleep();
-                    std::this_thread::sleep_for(delay);
+                    if (skip_unchanged_frames)
+                    {
+                        for (size_t i = 0; i != frames.size(); ++i)
+                        {
+                            auto frame = state_of(frames[i], view_areas[i]);
+                            if (frame != last_frames[i])
+                            {
+                                last_frames[i] = std::move(frame);
+                                changed = true;
+                            }
+                        }
+                    }
+
+                    if (changed)
+                    {
+                        for (size_t i = 0; i != frames.size(); ++i)
+                            std::get<1>(compositors[i])->composite(std::move(frames[i]));
+                        group.post();
+
+                        if (first_frame_after_resume)
+                        {
+                            auto const time_to_first_frame = std::chrono::steady_clock::now() - resumed_at;
+                            for (auto& tuple : compositors)
+                                report->resumed_frame(std::get<1>(tuple).get(), time_to_first_frame);
+                        }
+
+                        /*
+                         * "Predictive bypass" optimization: If the last frame was
+                         * bypassed/overlayed or you simply have a fast GPU, it is
+                         * beneficial to sleep for most of the next frame. This reduces
+                         * the latency between snapshotting the scene and post()
+                         * completing by almost a whole frame.
+                         */
+                        auto delay = force_sleep >= std::chrono::milliseconds::zero() ?
+                                     force_sleep : group.recommended_sleep();
+                        std::this_thread::sleep_for(delay);
+                    }
+                    else
+                    {
+                        for (auto& tuple : compositors)
+                            report->skipped_frame(std::get<1>(tuple).get());
+                    }
+                    frames.clear();  // Release any buffers before counting what's pending
 
                     lock.lock();
+                    compositing = false;
+                    idle_cv.notify_all();
 
                     /*
                      * Note the compositor may have chosen to ignore any number
@@ -215,6 +355,19 @@ public:
         }
     }
 
+    /// Render the next frame whether or not the scene has changed
+    void schedule_redraw()
+    {
+        std::lock_guard<std::mutex> lock{run_mutex};
+        redraw_requested = true;
+
+        if (frames_scheduled < 1)
+        {
+            frames_scheduled = 1;
+            run_cv.notify_one();
+        }
+    }
+
     void stop()
     {
         std::lock_guard<std::mutex> lock{run_mutex};
@@ -222,6 +375,28 @@ public:
         run_cv.notify_one();
     }
 
+    /// Stop posting frames, keeping the display buffer compositors, once any frame in progress is done
+    void pause()
+    {
+        std::unique_lock<std::mutex> lock{run_mutex};
+        paused = true;
+        idle_cv.wait(lock, [this]{ return !compositing; });
+    }
+
+    /// Post a fresh frame, as whatever was on screen while paused is gone
+    void resume()
+    {
+        std::lock_guard<std::mutex> lock{run_mutex};
+        paused = false;
+        resuming = true;
+        resume_time = std::chrono::steady_clock::now();
+        redraw_requested = true;
+
+        if (frames_scheduled < 1)
+            frames_scheduled = 1;
+        run_cv.notify_one();
+    }
+
     void wait_until_started()
     {
         if (started_future.wait_for(10s) != std::future_status::ready)
@@ -237,6 +412,7 @@ private:
     bool running;
     int frames_scheduled;
     std::chrono::milliseconds force_sleep{-1};
+    bool const skip_unchanged_frames;
     std::mutex run_mutex;
     std::condition_variable run_cv;
     std::shared_ptr<DisplayListener> const display_listener;
@@ -244,27 +420,67 @@ private:
     std::promise<void> started;
     std::future<void> started_future;
     bool not_posted_yet = true;
+    bool redraw_requested = false;
+    bool paused = false;
+    bool compositing = false;
+    std::condition_variable idle_cv;
+    bool resuming = false;
+    std::chrono::steady_clock::time_point resume_time;
 };
 
 }
 }
 
+/// Redraws every output after a display configuration that the compositor was not restarted for
+class mc::MultiThreadedCompositor::DisplayConfigurationTracker : public mg::DisplayConfigurationObserver
+{
+public:
+    DisplayConfigurationTracker(MultiThreadedCompositor* self) : self{self} {}
+
+    void configuration_applied(std::shared_ptr<mg::DisplayConfiguration const> const&) override
+    {
+        self->schedule_redraw();
+    }
+
+    void initial_configuration(std::shared_ptr<mg::DisplayConfiguration const> const&) override {}
+    void configuration_timing(std::chrono::nanoseconds, bool) override {}
+    void base_configuration_updated(std::shared_ptr<mg::DisplayConfiguration const> const&) override {}
+    void session_configuration_applied(
+        std::shared_ptr<frontend::Session> const&,
+        std::shared_ptr<mg::DisplayConfiguration> const&) override {}
+    void session_configuration_removed(std::shared_ptr<frontend::Session> const&) override {}
+    void configuration_failed(
+        std::shared_ptr<mg::DisplayConfiguration const> const&,
+        std::exception const&) override {}
+    void catastrophic_configuration_error(
+        std::shared_ptr<mg::DisplayConfiguration const> const&,
+        std::exception const&) override {}
+
+private:
+    MultiThreadedCompositor* const self;
+};
+
 mc::MultiThreadedCompositor::MultiThreadedCompositor(
     std::shared_ptr<mg::Display> const& display,
     std::shared_ptr<mc::Scene> const& scene,
     std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
     std::shared_ptr<DisplayListener> const& display_listener,
+    std::shared_ptr<ObserverRegistrar<mg::DisplayConfigurationObserver>> const& display_configuration_observers,
     std::shared_ptr<CompositorReport> const& compositor_report,
     std::chrono::milliseconds fixed_composite_delay,
-    bool compose_on_start)
+    bool compose_on_start,
+    bool skip_unchanged_frames)
     : display{display},
       scene{scene},
       display_buffer_compositor_factory{db_compositor_factory},
       display_listener{display_listener},
+      display_configuration_observers{display_configuration_observers},
       report{compositor_report},
       state{CompositorState::stopped},
       fixed_composite_delay{fixed_composite_delay},
       compose_on_start{compose_on_start},
+      skip_unchanged_frames{skip_unchanged_frames},
+      display_configuration_tracker{std::make_shared<DisplayConfigurationTracker>(this)},
       thread_pool{1}
 {
     observer = std::make_shared<ms::LegacySceneChangeNotification>(
@@ -297,6 +513,13 @@ void mc::MultiThreadedCompositor::schedule_compositing(int num, geometry::Rectan
         f->schedule_compositing(num, damage);
 }
 
+void mc::MultiThreadedCompositor::schedule_redraw()
+{
+    report->scheduled();
+    for (auto& f : thread_functors)
+        f->schedule_redraw();
+}
+
 void mc::MultiThreadedCompositor::start()
 {
     auto stopped = CompositorState::stopped;
@@ -321,6 +544,7 @@ void mc::MultiThreadedCompositor::start()
 
     /* Add the observer after we have created the compositing threads */
     scene->add_observer(observer);
+    display_configuration_observers->register_interest(display_configuration_tracker);
 
     /* Optional first render */
     if (compose_on_start)
@@ -332,23 +556,31 @@ void mc::MultiThreadedCompositor::start()
 void mc::MultiThreadedCompositor::stop()
 {
     auto started = CompositorState::started;
+    auto paused = CompositorState::paused;
 
-    if (!state.compare_exchange_strong(started, CompositorState::stopping))
+    /* A paused compositor has already removed its observers */
+    bool const was_paused = state.compare_exchange_strong(paused, CompositorState::stopping);
+
+    if (!was_paused && !state.compare_exchange_strong(started, CompositorState::stopping))
         return;
 
     /* To cleanup state if any code below throws */
-    auto cleanup_if_unwinding = on_unwind([this]
+    auto cleanup_if_unwinding = on_unwind([this, was_paused]
         {
             // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=62258
             // After using rethrow_exception() (and catching the exception),
             // all subsequent calls to uncaught_exception() return `true'.
             if (state == CompositorState::stopped) return;
 
-            state = CompositorState::started;
+            state = was_paused ? CompositorState::paused : CompositorState::started;
         });
 
-    /* Remove the observer before destroying the compositing threads */
-    scene->remove_observer(observer);
+    /* Remove the observers before destroying the compositing threads */
+    if (!was_paused)
+    {
+        display_configuration_observers->unregister_interest(*display_configuration_tracker);
+        scene->remove_observer(observer);
+    }
 
     destroy_compositing_threads();
 
@@ -361,6 +593,61 @@ void mc::MultiThreadedCompositor::stop()
     state = CompositorState::stopped;
 }
 
+void mc::MultiThreadedCompositor::pause()
+{
+    auto started = CompositorState::started;
+
+    if (!state.compare_exchange_strong(started, CompositorState::stopping))
+        return;
+
+    /* To cleanup state if any code below throws */
+    auto cleanup_if_unwinding = on_unwind([this]
+        {
+            if (state == CompositorState::paused) return;
+
+            state = CompositorState::started;
+        });
+
+    display_configuration_observers->unregister_interest(*display_configuration_tracker);
+    scene->remove_observer(observer);
+
+    /*
+     * Unlike stop() we keep the compositing threads, and with them the
+     * display buffer compositors and their renderers' GL state, as the
+     * display keeps its display buffers while paused.
+     */
+    for (auto& f : thread_functors)
+        f->pause();
+
+    state = CompositorState::paused;
+}
+
+void mc::MultiThreadedCompositor::resume()
+{
+    auto paused = CompositorState::paused;
+
+    if (!state.compare_exchange_strong(paused, CompositorState::starting))
+        return;
+
+    /* To cleanup state if any code below throws */
+    auto cleanup_if_unwinding = on_unwind([this]
+        {
+            if (state == CompositorState::started) return;
+
+            for (auto& f : thread_functors)
+                f->pause();
+            state = CompositorState::paused;
+        });
+
+    for (auto& f : thread_functors)
+        f->resume();
+
+    scene->add_observer(observer);
+    display_configuration_observers->register_interest(display_configuration_tracker);
+
+    state = CompositorState::started;
+}
+
 void mc::MultiThreadedCompositor::create_compositing_threads()
 {
     /* Start the display buffer compositing threads */
@@ -368,7 +655,7 @@ void mc::MultiThreadedCompositor::create_compositing_threads()
     {
         auto thread_functor = std::make_unique<mc::CompositingFunctor>(
             display_buffer_compositor_factory, group, scene, display_listener,
-            fixed_composite_delay, report);
+            fixed_composite_delay, report, skip_unchanged_frames);
 
         futures.push_back(thread_pool.run(std::ref(*thread_functor), &group));
         thread_functors.push_back(std::move(thread_functor));
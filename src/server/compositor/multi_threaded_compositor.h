@@ -31,10 +31,14 @@
 
 namespace mir
 {
+template<class Observer>
+class ObserverRegistrar;
+
 namespace geometry { struct Rectangle; }
 namespace graphics
 {
 class Display;
+class DisplayConfigurationObserver;
 }
 namespace scene
 {
@@ -55,7 +59,8 @@ enum class CompositorState
     started,
     stopped,
     starting,
-    stopping
+    stopping,
+    paused
 };
 
 class MultiThreadedCompositor : public Compositor
@@ -66,13 +71,17 @@ public:
         std::shared_ptr<Scene> const& scene,
         std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
         std::shared_ptr<DisplayListener> const& display_listener,
+        std::shared_ptr<ObserverRegistrar<graphics::DisplayConfigurationObserver>> const& display_configuration_observers,
         std::shared_ptr<CompositorReport> const& compositor_report,
         std::chrono::milliseconds fixed_composite_delay,  // -1 = automatic
-        bool compose_on_start);
+        bool compose_on_start,
+        bool skip_unchanged_frames = false);
     ~MultiThreadedCompositor();
 
     void start();
     void stop();
+    void pause();
+    void resume();
 
 private:
     void create_compositing_threads();
@@ -82,6 +91,7 @@ private:
     std::shared_ptr<Scene> const scene;
     std::shared_ptr<DisplayBufferCompositorFactory> const display_buffer_compositor_factory;
     std::shared_ptr<DisplayListener> const display_listener;
+    std::shared_ptr<ObserverRegistrar<graphics::DisplayConfigurationObserver>> const display_configuration_observers;
     std::shared_ptr<CompositorReport> const report;
 
     std::vector<std::unique_ptr<CompositingFunctor>> thread_functors;
@@ -90,11 +100,15 @@ private:
     std::atomic<CompositorState> state;
     std::chrono::milliseconds fixed_composite_delay;
     bool compose_on_start;
+    bool const skip_unchanged_frames;
 
     void schedule_compositing(int number_composites);
     void schedule_compositing(int number_composites, geometry::Rectangle const& damage) const;
+    void schedule_redraw();
 
     std::shared_ptr<mir::scene::Observer> observer;
+    class DisplayConfigurationTracker;
+    std::shared_ptr<graphics::DisplayConfigurationObserver> const display_configuration_tracker;
     mir::thread::BasicThreadPool thread_pool;
 };
 
@@ -25,12 +25,15 @@
 #include "mir/renderer/gl/context.h"
 #include "mir/renderer/gl/texture_target.h"
 #include "mir/renderer/gl/context_source.h"
+#include "mir/gl/program.h"
 #include "mir/raii.h"
 
+#include <glm/gtc/type_ptr.hpp>
 #include <boost/throw_exception.hpp>
 
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
+namespace mgl = mir::gl;
 namespace mrgl = mir::renderer::gl;
 namespace geom = mir::geometry;
 
@@ -52,6 +55,30 @@ auto as_context_source(mg::Display* display)
     return ctx;
 }
 
+GLchar const* const blit_vshader =
+{
+    "attribute vec2 position;\n"
+    "attribute vec2 texcoord;\n"
+    "uniform mat4 transform;\n"
+    "varying vec2 v_texcoord;\n"
+    "void main() {\n"
+    "   gl_Position = transform * vec4(position, 0.0, 1.0);\n"
+    "   v_texcoord = texcoord;\n"
+    "}\n"
+};
+
+GLchar const* const blit_fshader =
+{
+    "#ifdef GL_ES\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "uniform sampler2D tex;\n"
+    "varying vec2 v_texcoord;\n"
+    "void main() {\n"
+    "   gl_FragColor = texture2D(tex, v_texcoord);\n"
+    "}\n"
+};
+
 template <void (*Generate)(GLsizei,GLuint*), void (*Delete)(GLsizei,GLuint const*)>
 mc::detail::GLResource<Delete> allocate_gl_resource()
 {
@@ -114,6 +141,7 @@ mc::ScreencastDisplayBuffer::ScreencastDisplayBuffer(
 mc::ScreencastDisplayBuffer::~ScreencastDisplayBuffer()
 {
     make_current();
+    blit_program.reset();
     color_tex.reset();
     depth_rbo.reset();
     fbo.reset();
@@ -224,3 +252,52 @@ void mc::ScreencastDisplayBuffer::set_transformation(glm::mat2 const& t)
 {
     transform = t;
 }
+
+void mc::ScreencastDisplayBuffer::blit(GLuint texture)
+{
+    make_current();
+    bind();
+
+    if (!blit_program)
+    {
+        blit_program = std::make_unique<mgl::SimpleProgram>(blit_vshader, blit_fshader);
+        blit_position_attr = glGetAttribLocation(*blit_program, "position");
+        blit_texcoord_attr = glGetAttribLocation(*blit_program, "texcoord");
+        blit_transform_uniform = glGetUniformLocation(*blit_program, "transform");
+        blit_tex_uniform = glGetUniformLocation(*blit_program, "tex");
+    }
+
+    // The texture holds a GL framebuffer, so its origin is the bottom left of
+    // the view area. Transforming the corners as the renderer does leaves the
+    // captured image just as if the scene had been composited here.
+    GLfloat const vertices[] =
+    {
+    //  position     texcoord
+        -1.0f,  1.0f, 0.0f, 1.0f,
+        -1.0f, -1.0f, 0.0f, 0.0f,
+         1.0f,  1.0f, 1.0f, 1.0f,
+         1.0f, -1.0f, 1.0f, 0.0f,
+    };
+    auto const stride = 4 * sizeof(GLfloat);
+
+    glUseProgram(*blit_program);
+    glUniform1i(blit_tex_uniform, 0);
+    glUniformMatrix4fv(blit_transform_uniform, 1, GL_FALSE, glm::value_ptr(glm::mat4(transform)));
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glDisable(GL_BLEND);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glEnableVertexAttribArray(blit_position_attr);
+    glEnableVertexAttribArray(blit_texcoord_attr);
+    glVertexAttribPointer(blit_position_attr, 2, GL_FLOAT, GL_FALSE, stride, &vertices[0]);
+    glVertexAttribPointer(blit_texcoord_attr, 2, GL_FLOAT, GL_FALSE, stride, &vertices[2]);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glDisableVertexAttribArray(blit_texcoord_attr);
+    glDisableVertexAttribArray(blit_position_attr);
+
+    swap_buffers();
+}
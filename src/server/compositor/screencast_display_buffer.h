@@ -32,6 +32,11 @@ namespace graphics
 class Display;
 }
 
+namespace gl
+{
+class Program;
+}
+
 namespace renderer
 {
 namespace gl
@@ -109,7 +114,6 @@ public:
     void release_current() override;
 
     bool overlay(graphics::RenderableList const&) override;
-
     void swap_buffers() override;
 
     glm::mat2 transformation() const override;
@@ -121,6 +125,9 @@ public:
     void set_transformation(glm::mat2 const& transform);
     void commit();
 
+    /// Renders a frame by drawing \a texture over the whole view area
+    void blit(GLuint texture);
+
 private:
     std::unique_ptr<renderer::gl::Context> gl_context;
     geometry::Rectangle const rect;
@@ -137,6 +144,12 @@ private:
     detail::GLResource<glDeleteRenderbuffers> depth_rbo;
     detail::GLResource<glDeleteFramebuffers> fbo;
 
+    std::unique_ptr<gl::Program> blit_program;
+    GLint blit_position_attr{-1};
+    GLint blit_texcoord_attr{-1};
+    GLint blit_transform_uniform{-1};
+    GLint blit_tex_uniform{-1};
+
     geometry::Size current_size;
 };
 
@@ -42,6 +42,7 @@ mc::Stream::Stream(
     size(size),
     pf(pf),
     first_frame_posted(false),
+    frame_count{0},
     frame_callback{[](auto){}}
 {
 }
@@ -58,6 +59,7 @@ void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
         first_frame_posted = true;
         pf = buffer->pixel_format();
         schedule->schedule(buffer);
+        ++frame_count;
     }
     {
         std::lock_guard<decltype(callback_mutex)> lock{callback_mutex};
@@ -164,6 +166,11 @@ bool mc::Stream::has_submitted_buffer() const
     return first_frame_posted;
 }
 
+uint64_t mc::Stream::frames_submitted() const
+{
+    return frame_count;
+}
+
 void mc::Stream::set_scale(float)
 {
 }
@@ -27,6 +27,7 @@
 #include "mir/geometry/size.h"
 #include "multi_monitor_arbiter.h"
 #include <mutex>
+#include <atomic>
 #include <memory>
 #include <set>
 
@@ -56,6 +57,7 @@ public:
     int buffers_ready_for_compositor(void const* user_id) const override;
     void drop_old_buffers() override;
     bool has_submitted_buffer() const override;
+    uint64_t frames_submitted() const override;
     void set_scale(float scale) override;
 
 private:
@@ -69,6 +71,8 @@ private:
     geometry::Size size; 
     MirPixelFormat pf;
     bool first_frame_posted;
+    // Not guarded by mutex, so it can be read from with_most_recent_buffer_do()
+    std::atomic<uint64_t> frame_count;
 
     std::mutex callback_mutex;
     std::function<void(geometry::Size const&)> frame_callback;
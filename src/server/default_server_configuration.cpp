@@ -21,6 +21,7 @@
 #include "mir/options/default_configuration.h"
 #include "mir/abnormal_exit.h"
 #include "mir/glib_main_loop.h"
+#include "mir/epoll_main_loop.h"
 #include "mir/default_server_status_listener.h"
 #include "mir/emergency_cleanup.h"
 #include "mir/default_configuration.h"
@@ -37,6 +38,7 @@
 #include "mir/input/vt_filter.h"
 #include "mir/input/input_manager.h"
 #include "mir/time/steady_clock.h"
+#include "mir/time/timer_wheel_alarm_factory.h"
 #include "mir/geometry/rectangles.h"
 #include "mir/default_configuration.h"
 #include "mir/scene/null_prompt_session_listener.h"
@@ -169,7 +171,32 @@ std::shared_ptr<mir::MainLoop> mir::DefaultServerConfiguration::the_main_loop()
     return main_loop(
         [this]() -> std::shared_ptr<mir::MainLoop>
         {
-            return std::make_shared<mir::GLibMainLoop>(the_clock());
+            auto const opt = the_options()->get<std::string>(options::main_loop_opt);
+
+            if (opt == "glib")
+                return std::make_shared<mir::GLibMainLoop>(the_clock());
+            else if (opt == "epoll")
+                return std::make_shared<mir::EpollMainLoop>(the_clock());
+
+            throw AbnormalExit(std::string("Invalid ") + options::main_loop_opt + " option: " + opt +
+                " (valid options are: \"glib\" and \"epoll\")");
+        });
+}
+
+std::shared_ptr<mir::time::AlarmFactory> mir::DefaultServerConfiguration::the_alarm_factory()
+{
+    return alarm_factory(
+        [this]() -> std::shared_ptr<mir::time::AlarmFactory>
+        {
+            auto const wheel = std::make_shared<mir::time::TimerWheelAlarmFactory>(the_clock());
+
+            // The main loop keeps the wheel alive and runs its callbacks
+            the_main_loop()->register_fd_handler(
+                {wheel->watch_fd()},
+                wheel.get(),
+                [wheel](int) { wheel->dispatch(mir::dispatch::FdEvent::readable); });
+
+            return wheel;
         });
 }
 
@@ -97,8 +97,8 @@ struct mir::DisplayServer::Private
                 [&, this] { display_changer->resume_display_config_processing(); });
 
             auto comp = try_but_revert_if_unwinding(
-                [this] { compositor->stop(); },
-                [&, this] { compositor->start(); });
+                [this] { compositor->pause(); },
+                [&, this] { compositor->resume(); });
 
             display->pause();
         }
@@ -121,8 +121,8 @@ struct mir::DisplayServer::Private
                 [&, this] { display->pause(); });
 
             auto comp = try_but_revert_if_unwinding(
-                [this] { compositor->start(); },
-                [&, this] { compositor->stop(); });
+                [this] { compositor->resume(); },
+                [&, this] { compositor->pause(); });
 
             auto display_config_processing = try_but_revert_if_unwinding(
                 [this] { display_changer->resume_display_config_processing(); },
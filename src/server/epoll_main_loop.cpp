@@ -0,0 +1,659 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/epoll_main_loop.h"
+#include "mir/lockable_callback.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <sstream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace md = mir::dispatch;
+
+struct mir::EpollMainLoop::FdHandler
+{
+    FdHandler(void const* owner, std::function<void(int)> const& handler)
+        : owner{owner}, handler{handler}
+    {
+    }
+
+    void const* const owner;
+    std::function<void(int)> const handler;
+
+    // Held while the handler runs, so that unregistering can guarantee
+    // no further calls. Recursive to allow unregistering from the handler.
+    std::recursive_mutex mutex;
+    bool enabled{true};
+};
+
+struct mir::EpollMainLoop::SignalHandler
+{
+    std::vector<int> const signals;
+    std::function<void(int)> const handler;
+};
+
+namespace
+{
+/*
+ * signalfd() only sees signals that are blocked in every thread, which we
+ * can't guarantee for threads created by clients of libmirserver, so (like
+ * GLibMainLoop) we use a self-pipe written from a plain signal handler.
+ */
+class SignalPipes
+{
+public:
+    static void add(int write_fd)
+    {
+        init();
+
+        for (auto& wfd : write_fds)
+        {
+            int v = -1;
+            if (wfd.compare_exchange_strong(v, write_fd))
+                return;
+        }
+
+        BOOST_THROW_EXCEPTION(
+            std::runtime_error(
+                "Failed to add signal write fd. Have you created too many main loops?"));
+    }
+
+    static void remove(int write_fd)
+    {
+        for (auto& wfd : write_fds)
+        {
+            int v = write_fd;
+            if (wfd.compare_exchange_strong(v, -1))
+                break;
+        }
+    }
+
+    static void notify_of_signal(int sig)
+    {
+        for (auto const& write_fd : write_fds)
+        {
+            // As in GLibMainLoop: a stale fd here is benign
+            if (write_fd >= 0 && write(write_fd, &sig, sizeof(sig))) {}
+        }
+    }
+
+private:
+    static void init()
+    {
+        static std::once_flag once;
+        std::call_once(once,
+            []
+            {
+                for (auto& wfd : write_fds)
+                    wfd = -1;
+            });
+    }
+
+    static std::array<std::atomic<int>, 10> write_fds;
+};
+
+std::array<std::atomic<int>, 10> SignalPipes::write_fds;
+
+mir::Fd create_epoll_fd()
+{
+    int const fd = epoll_create1(EPOLL_CLOEXEC);
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create epoll fd"}));
+    }
+    return mir::Fd{fd};
+}
+
+mir::Fd create_wake_fd()
+{
+    int const fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create wakeup eventfd"}));
+    }
+    return mir::Fd{fd};
+}
+
+template<typename Handler>
+std::function<void(int)> with_exception_handling(
+    Handler const& handler,
+    std::function<void(std::exception_ptr const&)> const& exception_handler)
+{
+    return [handler, exception_handler] (int value)
+        {
+            try { handler(value); }
+            catch (...) { exception_handler(std::current_exception()); }
+        };
+}
+}
+
+mir::EpollMainLoop::EpollMainLoop(std::shared_ptr<time::Clock> const& clock)
+    : clock{clock},
+      epoll_fd{create_epoll_fd()},
+      wake_fd{create_wake_fd()},
+      alarms{clock},
+      running{false},
+      stop_requested{false}
+{
+    int pipefd[2];
+    if (pipe2(pipefd, O_CLOEXEC | O_NONBLOCK) == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to create signal pipe"));
+    }
+
+    signal_read_fd = mir::Fd{pipefd[0]};
+    signal_write_fd = mir::Fd{pipefd[1]};
+
+    SignalPipes::add(signal_write_fd);
+
+    watch(wake_fd);
+    watch(signal_read_fd);
+    watch(alarms.watch_fd());
+}
+
+mir::EpollMainLoop::~EpollMainLoop()
+{
+    for (auto const& handled : handled_signals)
+        sigaction(handled.first, &handled.second, nullptr);
+
+    SignalPipes::remove(signal_write_fd);
+}
+
+void mir::EpollMainLoop::run()
+{
+    main_loop_exception = nullptr;
+    {
+        std::lock_guard<std::mutex> lock{run_on_halt_mutex};
+        running = true;
+    }
+
+    std::array<epoll_event, 64> events;
+
+    while (true)
+    {
+        int const timeout = has_dispatchable_actions() ? 0 : -1;
+        int const ready = epoll_wait(epoll_fd, events.data(), events.size(), timeout);
+
+        if (ready < 0 && errno != EINTR)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "epoll_wait failed"}));
+        }
+
+        for (int i = 0; i < ready && !stop_pending(); ++i)
+        {
+            int const fd = events[i].data.fd;
+
+            if (fd == wake_fd)
+            {
+                uint64_t value;
+                if (read(wake_fd, &value, sizeof value)) {}
+            }
+            else if (fd == signal_read_fd)
+            {
+                dispatch_signals();
+            }
+            else if (fd == alarms.watch_fd())
+            {
+                dispatch_alarms();
+            }
+            else
+            {
+                dispatch_fd(fd);
+            }
+        }
+
+        if (!stop_pending())
+            dispatch_actions();
+
+        if (stop_pending())
+        {
+            handle_stop();
+            break;
+        }
+    }
+
+    if (main_loop_exception)
+        std::rethrow_exception(main_loop_exception);
+}
+
+void mir::EpollMainLoop::stop()
+{
+    stop_requested = true;
+    wake();
+}
+
+bool mir::EpollMainLoop::stop_pending()
+{
+    return stop_requested;
+}
+
+void mir::EpollMainLoop::handle_stop()
+{
+    stop_requested = false;
+    {
+        std::lock_guard<std::mutex> lock{run_on_halt_mutex};
+        running = false;
+    }
+
+    // We know any other thread sees running == false here, so don't need
+    // to lock run_on_halt_queue.
+    for (auto& action : run_on_halt_queue)
+    {
+        try { action(); }
+        catch (...) { handle_exception(std::current_exception()); }
+    }
+    run_on_halt_queue.clear();
+}
+
+void mir::EpollMainLoop::register_signal_handler(
+    std::initializer_list<int> sigs,
+    std::function<void(int)> const& handler)
+{
+    add_signal_handler(
+        sigs,
+        with_exception_handling(handler, [this] (auto const& e) { handle_exception(e); }));
+}
+
+void mir::EpollMainLoop::register_signal_handler(
+    std::initializer_list<int> sigs,
+    mir::UniqueModulePtr<std::function<void(int)>> handler)
+{
+    std::shared_ptr<std::function<void(int)>> const shared_handler{std::move(handler)};
+
+    add_signal_handler(
+        sigs,
+        with_exception_handling(
+            [shared_handler] (int sig) { (*shared_handler)(sig); },
+            [this] (auto const& e) { handle_exception(e); }));
+}
+
+void mir::EpollMainLoop::add_signal_handler(
+    std::vector<int> const& sigs,
+    std::function<void(int)> const& handler)
+{
+    std::lock_guard<std::mutex> lock{signal_handlers_mutex};
+
+    signal_handlers.push_back(std::make_shared<SignalHandler>(SignalHandler{sigs, handler}));
+
+    for (auto sig : sigs)
+    {
+        if (handled_signals.find(sig) != handled_signals.end())
+            continue;
+
+        struct sigaction old_action;
+        struct sigaction new_action;
+
+        new_action.sa_handler = SignalPipes::notify_of_signal;
+        sigfillset(&new_action.sa_mask);
+        new_action.sa_flags = 0;
+
+        if (sigaction(sig, &new_action, &old_action) == -1)
+        {
+            std::stringstream msg;
+            msg << "Failed to register action for signal " << sig;
+            BOOST_THROW_EXCEPTION(
+                std::system_error(errno, std::system_category(), msg.str()));
+        }
+
+        handled_signals.emplace(sig, old_action);
+    }
+}
+
+void mir::EpollMainLoop::dispatch_signals()
+{
+    int sig;
+    while (!stop_pending() && read(signal_read_fd, &sig, sizeof sig) == sizeof sig)
+    {
+        decltype(signal_handlers) handlers;
+        {
+            std::lock_guard<std::mutex> lock{signal_handlers_mutex};
+            handlers = signal_handlers;
+        }
+
+        for (auto const& handler : handlers)
+        {
+            if (std::find(handler->signals.begin(), handler->signals.end(), sig) != handler->signals.end())
+                handler->handler(sig);
+        }
+    }
+}
+
+void mir::EpollMainLoop::register_fd_handler(
+    std::initializer_list<int> fds,
+    void const* owner,
+    std::function<void(int)> const& handler)
+{
+    auto const handler_with_exception_handling =
+        with_exception_handling(handler, [this] (auto const& e) { handle_exception(e); });
+
+    for (auto fd : fds)
+        add_fd_handler(fd, owner, handler_with_exception_handling);
+}
+
+void mir::EpollMainLoop::register_fd_handler(
+    std::initializer_list<int> fds,
+    void const* owner,
+    mir::UniqueModulePtr<std::function<void(int)>> handler)
+{
+    std::shared_ptr<std::function<void(int)>> const shared_handler{std::move(handler)};
+
+    auto const handler_with_exception_handling =
+        with_exception_handling(
+            [shared_handler] (int fd) { (*shared_handler)(fd); },
+            [this] (auto const& e) { handle_exception(e); });
+
+    for (auto fd : fds)
+        add_fd_handler(fd, owner, handler_with_exception_handling);
+}
+
+void mir::EpollMainLoop::add_fd_handler(
+    int fd, void const* owner, std::function<void(int)> const& handler)
+{
+    std::lock_guard<std::mutex> lock{fd_handlers_mutex};
+
+    // Always (re)add the watch: the fd may have been closed and its number
+    // reused without the previous handler being unregistered
+    watch(fd);
+    fd_handlers[fd].push_back(std::make_shared<FdHandler>(owner, handler));
+}
+
+void mir::EpollMainLoop::unregister_fd_handler(void const* owner)
+{
+    std::vector<std::shared_ptr<FdHandler>> removed;
+    {
+        std::lock_guard<std::mutex> lock{fd_handlers_mutex};
+
+        for (auto i = fd_handlers.begin(); i != fd_handlers.end();)
+        {
+            auto& handlers = i->second;
+            auto const new_end = std::stable_partition(
+                handlers.begin(), handlers.end(),
+                [owner] (auto const& handler) { return handler->owner != owner; });
+
+            removed.insert(removed.end(), new_end, handlers.end());
+            handlers.erase(new_end, handlers.end());
+
+            if (handlers.empty())
+            {
+                // The fd may already be closed, in which case epoll has forgotten it
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, i->first, nullptr);
+                i = fd_handlers.erase(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    // Wait for any in-progress call and prevent further ones
+    for (auto const& handler : removed)
+    {
+        std::lock_guard<std::recursive_mutex> lock{handler->mutex};
+        handler->enabled = false;
+    }
+}
+
+void mir::EpollMainLoop::dispatch_fd(int fd)
+{
+    std::vector<std::shared_ptr<FdHandler>> handlers;
+    {
+        std::lock_guard<std::mutex> lock{fd_handlers_mutex};
+        auto const i = fd_handlers.find(fd);
+        if (i != fd_handlers.end())
+            handlers = i->second;
+    }
+
+    for (auto const& handler : handlers)
+    {
+        std::lock_guard<std::recursive_mutex> lock{handler->mutex};
+        if (handler->enabled)
+            handler->handler(fd);
+    }
+}
+
+void mir::EpollMainLoop::enqueue(void const* owner, ServerAction const& action)
+{
+    auto const action_with_exception_handling =
+        [this, action]
+        {
+            try { action(); }
+            catch (...) { handle_exception(std::current_exception()); }
+        };
+
+    add_action(owner, action_with_exception_handling, true);
+}
+
+void mir::EpollMainLoop::enqueue_with_guaranteed_execution(mir::ServerAction const& action)
+{
+    auto const action_with_exception_handling =
+        [this]
+        {
+            try
+            {
+                mir::ServerAction action;
+                {
+                    std::lock_guard<std::mutex> lock{run_on_halt_mutex};
+                    // Already run when the loop stopped
+                    if (run_on_halt_queue.empty())
+                        return;
+                    action = run_on_halt_queue.front();
+                    run_on_halt_queue.pop_front();
+                }
+                action();
+            }
+            catch (...)
+            {
+                handle_exception(std::current_exception());
+            }
+        };
+
+    {
+        std::lock_guard<std::mutex> lock{run_on_halt_mutex};
+
+        if (!running)
+        {
+            action();
+            return;
+        }
+        else
+        {
+            run_on_halt_queue.push_back(action);
+        }
+    }
+
+    add_action(nullptr, action_with_exception_handling, false);
+}
+
+void mir::EpollMainLoop::spawn(std::function<void()>&& work)
+{
+    auto const action_with_exception_handling =
+        [this, action = std::move(work)]
+        {
+            try { action(); }
+            catch (...) { handle_exception(std::current_exception()); }
+        };
+
+    add_action(nullptr, action_with_exception_handling, false);
+}
+
+void mir::EpollMainLoop::add_action(void const* owner, ServerAction const& action, bool pausable)
+{
+    {
+        std::lock_guard<std::mutex> lock{actions_mutex};
+        actions.push_back({owner, action, pausable});
+    }
+    wake();
+}
+
+void mir::EpollMainLoop::dispatch_actions()
+{
+    // Actions enqueued while we're dispatching wait for the next iteration
+    std::deque<QueuedAction> batch;
+    {
+        std::lock_guard<std::mutex> lock{actions_mutex};
+        batch.swap(actions);
+    }
+
+    std::deque<QueuedAction> deferred;
+
+    while (!batch.empty())
+    {
+        auto queued = std::move(batch.front());
+        batch.pop_front();
+
+        if (stop_pending() || (queued.pausable && !should_process_actions_for(queued.owner)))
+        {
+            deferred.push_back(std::move(queued));
+            continue;
+        }
+
+        queued.action();
+    }
+
+    if (!deferred.empty())
+    {
+        std::lock_guard<std::mutex> lock{actions_mutex};
+        actions.insert(
+            actions.begin(),
+            std::make_move_iterator(deferred.begin()),
+            std::make_move_iterator(deferred.end()));
+    }
+}
+
+bool mir::EpollMainLoop::has_dispatchable_actions()
+{
+    std::lock_guard<std::mutex> lock{actions_mutex};
+
+    return std::any_of(actions.begin(), actions.end(),
+        [this] (QueuedAction const& queued)
+        {
+            return !queued.pausable ||
+                std::find(do_not_process.begin(), do_not_process.end(), queued.owner) == do_not_process.end();
+        });
+}
+
+void mir::EpollMainLoop::pause_processing_for(void const* owner)
+{
+    std::lock_guard<std::mutex> lock{actions_mutex};
+
+    auto const iter = std::find(do_not_process.begin(), do_not_process.end(), owner);
+    if (iter == do_not_process.end())
+        do_not_process.push_back(owner);
+}
+
+void mir::EpollMainLoop::resume_processing_for(void const* owner)
+{
+    {
+        std::lock_guard<std::mutex> lock{actions_mutex};
+
+        auto const new_end = std::remove(do_not_process.begin(), do_not_process.end(), owner);
+        do_not_process.erase(new_end, do_not_process.end());
+    }
+
+    // Wake up the loop to reprocess the queue
+    wake();
+}
+
+bool mir::EpollMainLoop::should_process_actions_for(void const* owner)
+{
+    std::lock_guard<std::mutex> lock{actions_mutex};
+
+    auto const iter = std::find(do_not_process.begin(), do_not_process.end(), owner);
+    return iter == do_not_process.end();
+}
+
+std::unique_ptr<mir::time::Alarm> mir::EpollMainLoop::create_alarm(
+    std::function<void()> const& callback)
+{
+    return alarms.create_alarm(callback);
+}
+
+std::unique_ptr<mir::time::Alarm> mir::EpollMainLoop::create_alarm(
+    std::unique_ptr<LockableCallback> callback)
+{
+    return alarms.create_alarm(std::move(callback));
+}
+
+void mir::EpollMainLoop::dispatch_alarms()
+{
+    try
+    {
+        alarms.dispatch(md::FdEvent::readable);
+    }
+    catch (...)
+    {
+        handle_exception(std::current_exception());
+    }
+}
+
+void mir::EpollMainLoop::reprocess_all_sources()
+{
+    std::condition_variable reprocessed_cv;
+    std::mutex reprocessed_mutex;
+    bool reprocessed = false;
+
+    // fd watches are level triggered so are always reprocessed; alarms
+    // depend on the clock, which may have been changed under us
+    add_action(
+        nullptr,
+        [&]
+        {
+            dispatch_alarms();
+
+            std::lock_guard<std::mutex> lock{reprocessed_mutex};
+            reprocessed = true;
+            reprocessed_cv.notify_all();
+        },
+        false);
+
+    std::unique_lock<std::mutex> reprocessed_lock{reprocessed_mutex};
+    reprocessed_cv.wait(reprocessed_lock, [&] { return reprocessed == true; });
+}
+
+void mir::EpollMainLoop::watch(int fd)
+{
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1 && errno != EEXIST)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to watch fd"}));
+    }
+}
+
+void mir::EpollMainLoop::wake()
+{
+    uint64_t const one{1};
+    if (write(wake_fd, &one, sizeof one)) {}
+}
+
+void mir::EpollMainLoop::handle_exception(std::exception_ptr const& e)
+{
+    main_loop_exception = e;
+    stop();
+}
@@ -31,6 +31,8 @@ class DisplayServer : public mir::protobuf::DisplayServer
 {
 public:
     virtual void client_pid(int pid) = 0;
+    /// Called for each message received from the client, before it is dispatched
+    virtual void client_activity() = 0;
 };
 }
 }
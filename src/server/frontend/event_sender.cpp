@@ -22,6 +22,7 @@
 #include "mir/graphics/display_configuration.h"
 #include "mir/variable_length_array.h"
 #include "mir/input/device.h"
+#include "mir/input/input_report.h"
 #include "mir/input/mir_input_config.h"
 #include "mir/input/mir_input_config_serialization.h"
 #include "mir/input/mir_pointer_config.h"
@@ -44,9 +45,13 @@ namespace mi = mir::input;
 
 mfd::EventSender::EventSender(
     std::shared_ptr<MessageSender> const& socket_sender,
-    std::shared_ptr<mg::PlatformIpcOperations> const& buffer_packer) :
+    std::shared_ptr<mg::PlatformIpcOperations> const& buffer_packer,
+    std::shared_ptr<mi::InputReport> const& input_report,
+    int client_fd) :
     sender(socket_sender),
-    buffer_packer(buffer_packer)
+    buffer_packer(buffer_packer),
+    input_report(input_report),
+    client_fd(client_fd)
 {
 }
 
@@ -59,6 +64,18 @@ void mfd::EventSender::handle_event(EventUPtr&& event)
     ev->set_raw(MirEvent::serialize(event.get()));
 
     send_event_sequence(seq, {});
+
+    if (mir_event_get_type(event.get()) == mir_event_type_input)
+    {
+        auto const input_event = mir_event_get_input_event(event.get());
+        auto const event_time = mir_input_event_get_event_time(input_event);
+        auto const seq_id = next_input_seq_id++;
+
+        if (mir_input_event_get_type(input_event) == mir_input_event_type_key)
+            input_report->published_key_event(client_fd, seq_id, event_time);
+        else
+            input_report->published_motion_event(client_fd, seq_id, event_time);
+    }
 }
 
 void mfd::EventSender::handle_display_config_change(
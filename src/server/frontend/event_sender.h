@@ -21,11 +21,13 @@
 
 #include "mir/frontend/event_sink.h"
 #include "mir/frontend/fd_sets.h"
+#include <atomic>
 #include <memory>
 
 namespace mir
 {
 namespace graphics { class PlatformIpcOperations; }
+namespace input { class InputReport; }
 namespace protobuf
 {
 class EventSequence;
@@ -42,7 +44,9 @@ class EventSender : public  mir::frontend::EventSink
 public:
     explicit EventSender(
         std::shared_ptr<MessageSender> const& socket_sender,
-        std::shared_ptr<graphics::PlatformIpcOperations> const& buffer_packer);
+        std::shared_ptr<graphics::PlatformIpcOperations> const& buffer_packer,
+        std::shared_ptr<input::InputReport> const& input_report,
+        int client_fd);
     void handle_event(EventUPtr&& event) override;
     void handle_lifecycle_event(MirLifecycleState state) override;
     void handle_display_config_change(graphics::DisplayConfiguration const& config) override;
@@ -60,6 +64,9 @@ private:
 
     std::shared_ptr<MessageSender> const sender;
     std::shared_ptr<graphics::PlatformIpcOperations> const buffer_packer;
+    std::shared_ptr<input::InputReport> const input_report;
+    int const client_fd;
+    std::atomic<uint32_t> next_input_seq_id{0};
 };
 
 }
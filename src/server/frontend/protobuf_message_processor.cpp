@@ -192,6 +192,7 @@ bool mfd::ProtobufMessageProcessor::dispatch(
     std::vector<mir::Fd> const& side_channel_fds)
 {
     report->received_invocation(display_server.get(), invocation.id(), invocation.method_name());
+    display_server->client_activity();
 
     bool result = true;
 
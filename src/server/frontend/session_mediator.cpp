@@ -153,6 +153,12 @@ void mf::SessionMediator::client_pid(int pid)
     client_pid_ = pid;
 }
 
+void mf::SessionMediator::client_activity()
+{
+    if (notify_client_activity)
+        notify_client_activity();
+}
+
 void mf::SessionMediator::connect(
     const ::mir::protobuf::ConnectParameters* request,
     ::mir::protobuf::Connection* response,
@@ -162,6 +168,7 @@ void mf::SessionMediator::connect(
 
     auto const session = shell->open_session(client_pid_, request->application_name(), event_sink);
     weak_session = session;
+    notify_client_activity = anr_detector->activity_notifier(session.get());
     connection_context.handle_client_connect(session);
 
     auto ipc_package = ipc_operations->connection_ipc_package();
@@ -639,6 +646,7 @@ void mf::SessionMediator::disconnect(
         destroy_screencast_sessions();
     }
     weak_session.reset();
+    notify_client_activity = nullptr;
 
     done->Run();
 }
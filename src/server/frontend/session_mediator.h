@@ -135,6 +135,7 @@ public:
     ~SessionMediator() noexcept;
 
     void client_pid(int pid) override;
+    void client_activity() override;
 
     void connect(
         mir::protobuf::ConnectParameters const* request,
@@ -312,6 +313,7 @@ private:
     ScreencastBufferTracker screencast_buffer_tracker;
 
     std::weak_ptr<Session> weak_session;
+    std::function<void()> notify_client_activity;
     detail::PromptSessionStore prompt_sessions;
 
     std::map<frontend::SurfaceId, frontend::BufferStreamId> legacy_default_stream_map;
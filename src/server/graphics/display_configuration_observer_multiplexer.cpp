@@ -32,6 +32,13 @@ void mg::DisplayConfigurationObserverMultiplexer::configuration_applied(
     for_each_observer(&mg::DisplayConfigurationObserver::configuration_applied, config);
 }
 
+void mg::DisplayConfigurationObserverMultiplexer::configuration_timing(
+    std::chrono::nanoseconds duration,
+    bool incremental)
+{
+    for_each_observer(&mg::DisplayConfigurationObserver::configuration_timing, duration, incremental);
+}
+
 void mg::DisplayConfigurationObserverMultiplexer::base_configuration_updated(
     std::shared_ptr<DisplayConfiguration const> const& base_config)
 {
@@ -176,6 +176,12 @@ bool mgn::detail::DisplayBuffer::overlay(RenderableList const& list)
     return true;
 }
 
+std::size_t mgn::detail::DisplayBuffer::overlay_topmost(RenderableList const&)
+{
+    // The host only shows our surface content as a whole
+    return 0;
+}
+
 void mgn::detail::DisplayBuffer::release_buffer(MirBuffer* b, MirPresentationChain *c)
 {
     std::unique_lock<std::mutex> lk(mutex);
@@ -63,6 +63,7 @@ public:
     glm::mat2 transformation() const override;
 
     bool overlay(RenderableList const& renderlist) override;
+    std::size_t overlay_topmost(RenderableList const& renderlist) override;
 
     NativeDisplayBuffer* native_display_buffer() override;
 
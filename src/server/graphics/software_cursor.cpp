@@ -21,11 +21,14 @@
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/graphics/pixel_format_utils.h"
 #include "mir/graphics/renderable.h"
+#include "mir/graphics/buffer.h"
 #include "mir/graphics/buffer_properties.h"
 #include "mir/input/scene.h"
 #include "mir/renderer/sw/pixel_source.h"
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <mutex>
 
@@ -36,6 +39,8 @@ namespace mrs = mir::renderer::software;
 
 namespace
 {
+// Enough for the usual arrow, text, resize and busy cursors
+size_t const max_cached_images = 8;
 
 MirPixelFormat get_8888_format(std::vector<MirPixelFormat> const& formats)
 {
@@ -185,19 +190,47 @@ mg::SoftwareCursor::create_renderable_for(CursorImage const& cursor_image, geom:
     if (pixels_size == 0)
         BOOST_THROW_EXCEPTION(std::logic_error("zero sized software cursor image is invalid"));
 
-    auto new_renderable = std::make_shared<detail::CursorRenderable>(
-        allocator->alloc_buffer({cursor_image.size(), format, mg::BufferUsage::software}),
+    return std::make_shared<detail::CursorRenderable>(
+        buffer_for(cursor_image, pixels_size),
         position + hotspot - cursor_image.hotspot());
+}
+
+std::shared_ptr<mg::Buffer>
+mg::SoftwareCursor::buffer_for(CursorImage const& cursor_image, size_t pixels_size)
+{
+    auto const pixels = static_cast<unsigned char const*>(cursor_image.as_argb_8888());
+
+    auto const cached = std::find_if(cached_images.begin(), cached_images.end(),
+        [&](CachedImage const& image)
+        {
+            return image.size == cursor_image.size() &&
+                   std::memcmp(image.pixels.data(), pixels, pixels_size) == 0;
+        });
+
+    if (cached != cached_images.end())
+    {
+        auto image = std::move(*cached);
+        cached_images.erase(cached);
+        cached_images.push_front(std::move(image));
+        return cached_images.front().buffer;
+    }
+
+    auto const buffer = allocator->alloc_buffer({cursor_image.size(), format, mg::BufferUsage::software});
 
     // TODO: The buffer pixel format may not be argb_8888, leading to
     // incorrect cursor colors. We need to transform the data to match
     // the buffer pixel format.
-    auto pixel_source = dynamic_cast<mrs::PixelSource*>(new_renderable->buffer()->native_buffer_base());
+    auto pixel_source = dynamic_cast<mrs::PixelSource*>(buffer->native_buffer_base());
     if (pixel_source)
-        pixel_source->write(static_cast<unsigned char const*>(cursor_image.as_argb_8888()), pixels_size);
+        pixel_source->write(pixels, pixels_size);
     else
         BOOST_THROW_EXCEPTION(std::logic_error("could not write to buffer for software cursor"));
-    return new_renderable;
+
+    cached_images.push_front({cursor_image.size(), {pixels, pixels + pixels_size}, buffer});
+    if (cached_images.size() > max_cached_images)
+        cached_images.pop_back();
+
+    return buffer;
 }
 
 void mg::SoftwareCursor::hide()
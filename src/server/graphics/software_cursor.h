@@ -22,13 +22,17 @@
 #include "mir/graphics/cursor.h"
 #include "mir_toolkit/client_types.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/size.h"
+#include <deque>
 #include <mutex>
+#include <vector>
 
 namespace mir
 {
 namespace input { class Scene; }
 namespace graphics
 {
+class Buffer;
 class GraphicBufferAllocator;
 class Renderable;
 
@@ -53,6 +57,16 @@ public:
 private:
     std::shared_ptr<detail::CursorRenderable> create_renderable_for(
         CursorImage const& cursor_image, geometry::Point position);
+    std::shared_ptr<Buffer> buffer_for(CursorImage const& cursor_image, size_t pixels_size);
+
+    /// A buffer holding a cursor image. These are never written again once
+    /// filled, as the compositor may still be reading one.
+    struct CachedImage
+    {
+        geometry::Size size;
+        std::vector<unsigned char> pixels;
+        std::shared_ptr<Buffer> buffer;
+    };
 
     std::shared_ptr<GraphicBufferAllocator> const allocator;
     std::shared_ptr<input::Scene> const scene;
@@ -61,6 +75,7 @@ private:
     std::shared_ptr<detail::CursorRenderable> renderable;
     bool visible;
     geometry::Displacement hotspot;
+    std::deque<CachedImage> cached_images; ///< Most recently used first
 };
 
 }
@@ -103,6 +103,9 @@ struct mi::BasicSeat::OutputTracker : mg::DisplayConfigurationObserver
         update_outputs(*config.get());
     }
 
+    void configuration_timing(std::chrono::nanoseconds, bool) override
+    {}
+
     void base_configuration_updated(std::shared_ptr<mg::DisplayConfiguration const> const&) override
     {}
 
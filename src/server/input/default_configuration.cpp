@@ -77,7 +77,10 @@ mir::DefaultServerConfiguration::the_event_filter_chain_dispatcher()
         [this]() -> std::shared_ptr<mi::EventFilterChainDispatcher>
         {
             std::initializer_list<std::shared_ptr<mi::EventFilter> const> filter_list {default_filter};
-            return std::make_shared<mi::EventFilterChainDispatcher>(filter_list, the_surface_input_dispatcher());
+            return std::make_shared<mi::EventFilterChainDispatcher>(
+                filter_list,
+                the_surface_input_dispatcher(),
+                the_input_report());
         });
 }
 
@@ -120,7 +123,7 @@ mir::DefaultServerConfiguration::the_input_dispatcher()
                 !options->is_set(options::host_socket_opt);
 
             return std::make_shared<mi::KeyRepeatDispatcher>(
-                the_event_filter_chain_dispatcher(), the_main_loop(), the_cookie_authority(),
+                the_event_filter_chain_dispatcher(), the_alarm_factory(), the_cookie_authority(),
                 enable_repeat, key_repeat_timeout, key_repeat_delay, false);
         });
 }
@@ -17,14 +17,19 @@
  */
 
 #include "event_filter_chain_dispatcher.h"
+#include "mir/input/input_report.h"
+
+#include "mir_toolkit/event.h"
 
 namespace mi = mir::input;
 
 mi::EventFilterChainDispatcher::EventFilterChainDispatcher(
     std::initializer_list<std::shared_ptr<mi::EventFilter> const> const& values,
-    std::shared_ptr<mi::InputDispatcher> const& next_dispatcher)
+    std::shared_ptr<mi::InputDispatcher> const& next_dispatcher,
+    std::shared_ptr<mi::InputReport> const& report)
     : filters(values.begin(), values.end()),
-      next_dispatcher(next_dispatcher)
+      next_dispatcher(next_dispatcher),
+      report(report)
 {
 }
 
@@ -64,9 +69,13 @@ void mi::EventFilterChainDispatcher::prepend(std::shared_ptr<EventFilter> const&
 
 bool mi::EventFilterChainDispatcher::dispatch(std::shared_ptr<MirEvent const> const& event)
 {
-    if (!handle(*event))
-        return next_dispatcher->dispatch(event);
-    return true;
+    if (handle(*event))
+        return true;
+
+    if (mir_event_get_type(event.get()) == mir_event_type_input)
+        report->dispatched_event(mir_input_event_get_event_time(mir_event_get_input_event(event.get())));
+
+    return next_dispatcher->dispatch(event);
 }
 
 // Should we start/stop dispatch of filter chain here?
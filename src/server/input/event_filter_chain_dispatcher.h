@@ -29,13 +29,15 @@ namespace mir
 {
 namespace input
 {
+class InputReport;
 
 class EventFilterChainDispatcher : public CompositeEventFilter, public mir::input::InputDispatcher
 {
 public:
     EventFilterChainDispatcher(
         std::initializer_list<std::shared_ptr<EventFilter> const> const& values,
-        std::shared_ptr<InputDispatcher> const& next_dispatcher);
+        std::shared_ptr<InputDispatcher> const& next_dispatcher,
+        std::shared_ptr<InputReport> const& report);
 
     // CompositeEventFilter
     bool handle(MirEvent const& event) override;
@@ -52,6 +54,7 @@ private:
     
     std::vector<std::weak_ptr<EventFilter>> filters;
     std::shared_ptr<InputDispatcher> const next_dispatcher;
+    std::shared_ptr<InputReport> const report;
 };
 
 }
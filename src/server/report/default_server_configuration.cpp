@@ -38,7 +38,8 @@ std::unique_ptr<mir::report::ReportFactory> mir::DefaultServerConfiguration::rep
 
     if (opt == options::log_opt_value)
     {
-        return std::make_unique<report::LoggingReportFactory>(the_logger(), the_clock());
+        return std::make_unique<report::LoggingReportFactory>(
+            the_logger(), the_clock(), [this] { return the_alarm_factory(); });
     }
     else if (opt == options::lttng_opt_value)
     {
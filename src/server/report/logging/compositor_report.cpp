@@ -95,6 +95,7 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
             ).count();
 
         long bypass_percent = dn ? (nbypassed - last_reported_bypassed) * 100L / dn : 0;
+        long skipped = nskipped - last_reported_skipped;
 
         // Keep everything premultiplied by 1000 to guarantee accuracy
         // and avoid floating point.
@@ -103,12 +104,13 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
         long avg_latency_usec = dn ? dl / dn : 0;
         long dt_msec = dt / 1000L;
 
-        char msg[128];
+        char msg[160];
         snprintf(msg, sizeof msg, "Display %p averaged %ld.%03ld FPS, "
                  "%ld.%03ld ms/frame, "
                  "latency %ld.%03ld ms, "
                  "%ld frames over %ld.%03ld sec, "
-                 "%ld%% bypassed",
+                 "%ld%% bypassed, "
+                 "%ld unchanged frames skipped",
                  id,
                  frames_per_1000sec / 1000,
                  frames_per_1000sec % 1000,
@@ -119,7 +121,8 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
                  dn,
                  dt_msec / 1000,
                  dt_msec % 1000,
-                 bypass_percent
+                 bypass_percent,
+                 skipped
                  );
 
         logger.log(ml::Severity::informational, msg, component);
@@ -130,6 +133,7 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
     last_reported_latency_sum = latency_sum;
     last_reported_nframes = nframes;
     last_reported_bypassed = nbypassed;
+    last_reported_skipped = nskipped;
 }
 
 void mrl::CompositorReport::finished_frame(SubCompositorId id)
@@ -166,6 +170,20 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.prev_bypassed = inst.bypassed;
 }
 
+void mrl::CompositorReport::skipped_frame(SubCompositorId id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    instance[id].nskipped++;
+}
+
+void mrl::CompositorReport::resumed_frame(SubCompositorId id, std::chrono::nanoseconds time_to_first_frame)
+{
+    char msg[128];
+    snprintf(msg, sizeof msg, "Display %p resumed, first frame posted after %.3fms",
+             id, std::chrono::duration<double, std::milli>{time_to_first_frame}.count());
+    logger->log(ml::Severity::informational, msg, component);
+}
+
 void mrl::CompositorReport::started()
 {
     logger->log(ml::Severity::informational, "Started", component);
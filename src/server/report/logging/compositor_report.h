@@ -47,6 +47,8 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void skipped_frame(SubCompositorId id) override;
+    void resumed_frame(SubCompositorId id, std::chrono::nanoseconds time_to_first_frame) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
@@ -67,6 +69,7 @@ private:
         TimePoint latency_sum;
         long nframes = 0;
         long nbypassed = 0;
+        long nskipped = 0;
         bool bypassed = true;
         bool prev_bypassed = false;
 
@@ -75,6 +78,7 @@ private:
         TimePoint last_reported_latency_sum;
         long last_reported_nframes = 0;
         long last_reported_bypassed = 0;
+        long last_reported_skipped = 0;
 
         void log(mir::logging::Logger& logger, SubCompositorId id);
     };
@@ -60,6 +60,13 @@ void mrl::DisplayConfigurationReport::configuration_applied(
     log_configuration(severity, *config);
 }
 
+void mrl::DisplayConfigurationReport::configuration_timing(std::chrono::nanoseconds duration, bool incremental)
+{
+    logger->log(component, severity, "Display configuration took %.3fms (%s)",
+                std::chrono::duration<double, std::milli>{duration}.count(),
+                incremental ? "outputs kept compositing" : "compositing restarted on all outputs");
+}
+
 void mrl::DisplayConfigurationReport::base_configuration_updated(
     std::shared_ptr<mg::DisplayConfiguration const> const& base_config)
 {
@@ -44,6 +44,8 @@ public:
     void configuration_applied(
         std::shared_ptr<graphics::DisplayConfiguration const> const& config) override;
 
+    void configuration_timing(std::chrono::nanoseconds duration, bool incremental) override;
+
     void base_configuration_updated(std::shared_ptr<graphics::DisplayConfiguration const> const& base_config) override;
 
     void session_configuration_applied(std::shared_ptr<frontend::Session> const& session,
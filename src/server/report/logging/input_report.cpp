@@ -20,21 +20,34 @@
 
 #include "mir/logging/logger.h"
 #include "mir/logging/input_timestamp.h"
+#include "mir/time/alarm.h"
+#include "mir/time/alarm_factory.h"
 
 #include <linux/input.h>
 
 #include <sstream>
 #include <cstring>
-#include <mutex>
 
 namespace mrl = mir::report::logging;
 namespace ml = mir::logging;
 
-mrl::InputReport::InputReport(const std::shared_ptr<ml::Logger>& logger)
-    : logger(logger)
+namespace
+{
+auto const latency_summary_interval = std::chrono::seconds(10);
+}
+
+mrl::InputReport::InputReport(
+    std::shared_ptr<ml::Logger> const& logger,
+    std::shared_ptr<mir::time::Clock> const& clock,
+    std::shared_ptr<mir::time::AlarmFactory> const& alarm_factory)
+    : logger(logger),
+      clock(clock),
+      summary_alarm(alarm_factory->create_alarm([this] { log_latency_summary(); }))
 {
 }
 
+mrl::InputReport::~InputReport() noexcept(true) = default;
+
 const char* mrl::InputReport::component()
 {
     static const char* s = "input";
@@ -126,6 +139,13 @@ void mrl::InputReport::received_event_from_kernel(int64_t when, int type, int co
        << " value=" << value;
 
     logger->log(ml::Severity::informational, ss.str(), component());
+
+    record_latency(read_latency, when);
+}
+
+void mrl::InputReport::dispatched_event(int64_t event_time)
+{
+    record_latency(dispatch_latency, event_time);
 }
 
 void mrl::InputReport::published_key_event(int dest_fd, uint32_t seq_id, int64_t event_time)
@@ -138,6 +158,8 @@ void mrl::InputReport::published_key_event(int dest_fd, uint32_t seq_id, int64_t
        << " dest_fd=" << dest_fd;
 
     logger->log(ml::Severity::informational, ss.str(), component());
+
+    record_latency(publish_latency, event_time);
 }
 
 void mrl::InputReport::published_motion_event(int dest_fd, uint32_t seq_id, int64_t event_time)
@@ -150,6 +172,8 @@ void mrl::InputReport::published_motion_event(int dest_fd, uint32_t seq_id, int6
        << " dest_fd=" << dest_fd;
 
     logger->log(ml::Severity::informational, ss.str(), component());
+
+    record_latency(publish_latency, event_time);
 }
 
 void mrl::InputReport::opened_input_device(char const* device_name, char const* input_platform)
@@ -173,3 +197,37 @@ void mrl::InputReport::failed_to_open_input_device(char const* device_name, char
 
     logger->log(ml::Severity::informational, ss.str(), component());
 }
+
+void mrl::InputReport::record_latency(ml::LatencyHistogram& stage, int64_t event_time)
+{
+    // Input event times are CLOCK_MONOTONIC, as is our clock
+    auto const now = clock->now();
+    stage.record(now.time_since_epoch() - std::chrono::nanoseconds(event_time));
+
+    if (!summary_scheduled.exchange(true))
+        summary_alarm->reschedule_in(latency_summary_interval);
+}
+
+void mrl::InputReport::log_latency_summary()
+{
+    // Cleared first, so latencies recorded while we log get a summary of their own
+    summary_scheduled = false;
+
+    struct { char const* name; ml::LatencyHistogram& histogram; } const stages[] = {
+        {"read", read_latency},
+        {"dispatch", dispatch_latency},
+        {"publish", publish_latency}};
+
+    for (auto const& stage : stages)
+    {
+        if (!stage.histogram.count())
+            continue;
+
+        logger->log(
+            ml::Severity::informational,
+            std::string{"Latency summary stage="} + stage.name + " " + stage.histogram.summary(),
+            component());
+
+        stage.histogram.reset();
+    }
+}
@@ -20,7 +20,10 @@
 #define MIR_REPORT_LOGGING_INPUT_REPORT_H_
 
 #include "mir/input/input_report.h"
+#include "mir/logging/latency_histogram.h"
+#include "mir/time/clock.h"
 
+#include <atomic>
 #include <memory>
 
 namespace mir
@@ -29,6 +32,11 @@ namespace logging
 {
 class Logger;
 }
+namespace time
+{
+class Alarm;
+class AlarmFactory;
+}
 namespace report
 {
 namespace logging
@@ -37,10 +45,13 @@ namespace logging
 class InputReport : public input::InputReport
 {
 public:
-    InputReport(std::shared_ptr<mir::logging::Logger> const& logger);
-    virtual ~InputReport() noexcept(true) = default;
+    InputReport(std::shared_ptr<mir::logging::Logger> const& logger,
+                std::shared_ptr<time::Clock> const& clock,
+                std::shared_ptr<time::AlarmFactory> const& alarm_factory);
+    virtual ~InputReport() noexcept(true);
 
     void received_event_from_kernel(int64_t when, int type, int code, int value) override;
+    void dispatched_event(int64_t event_time) override;
 
     void published_key_event(int dest_fd, uint32_t seq_id, int64_t event_time) override;
     void published_motion_event(int dest_fd, uint32_t seq_id, int64_t event_time) override;
@@ -49,7 +60,20 @@ public:
     void failed_to_open_input_device(char const* device_name, char const* input_platform) override;
 private:
     char const* component();
+    void record_latency(mir::logging::LatencyHistogram& stage, int64_t event_time);
+    void log_latency_summary();
+
     std::shared_ptr<mir::logging::Logger> const logger;
+    std::shared_ptr<time::Clock> const clock;
+
+    // Latency from the event timestamp to each stage of the input pipeline
+    mir::logging::LatencyHistogram read_latency;
+    mir::logging::LatencyHistogram dispatch_latency;
+    mir::logging::LatencyHistogram publish_latency;
+
+    // Set while a summary is scheduled, so the alarm only runs while there's input
+    std::atomic<bool> summary_scheduled{false};
+    std::unique_ptr<time::Alarm> const summary_alarm;
 };
 
 }
@@ -34,9 +34,11 @@
 namespace mr = mir::report;
 
 mr::LoggingReportFactory::LoggingReportFactory(std::shared_ptr<mir::logging::Logger> const& logger,
-                                               std::shared_ptr<time::Clock> const& clock)
+                                               std::shared_ptr<time::Clock> const& clock,
+                                               std::function<std::shared_ptr<time::AlarmFactory>()> const& the_alarm_factory)
     : logger(logger),
-    clock(clock)
+    clock(clock),
+    the_alarm_factory(the_alarm_factory)
 {
 }
 
@@ -72,7 +74,7 @@ std::shared_ptr<mir::frontend::MessageProcessorReport> mr::LoggingReportFactory:
 
 std::shared_ptr<mir::input::InputReport> mr::LoggingReportFactory::create_input_report()
 {
-    return std::make_shared<logging::InputReport>(logger);
+    return std::make_shared<logging::InputReport>(logger, clock, the_alarm_factory());
 }
 
 std::shared_ptr<mir::input::SeatObserver> mr::LoggingReportFactory::create_seat_report()
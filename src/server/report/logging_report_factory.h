@@ -21,6 +21,8 @@
 
 #include "report_factory.h"
 
+#include <functional>
+
 namespace mir
 {
 namespace logging
@@ -30,6 +32,7 @@ class Logger;
 namespace time
 {
 class Clock;
+class AlarmFactory;
 }
 class DefaultServerConfiguration;
 namespace report
@@ -38,8 +41,11 @@ namespace report
 class LoggingReportFactory : public report::ReportFactory
 {
 public:
+    /// \a the_alarm_factory is only called when a report needs it, which
+    /// lets reports be set up before the main loop exists
     LoggingReportFactory(std::shared_ptr<mir::logging::Logger> const& logger,
-                         std::shared_ptr<time::Clock> const& clock);
+                         std::shared_ptr<time::Clock> const& clock,
+                         std::function<std::shared_ptr<time::AlarmFactory>()> const& the_alarm_factory);
     std::shared_ptr<compositor::CompositorReport> create_compositor_report() override;
     std::shared_ptr<graphics::DisplayReport> create_display_report() override;
     std::shared_ptr<scene::SceneReport> create_scene_report() override;
@@ -54,6 +60,7 @@ public:
 private:
     std::shared_ptr<mir::logging::Logger> const logger;
     std::shared_ptr<time::Clock> const clock;
+    std::function<std::shared_ptr<time::AlarmFactory>()> const the_alarm_factory;
 };
 }
 }
@@ -62,3 +62,14 @@ void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::skipped_frame(SubCompositorId id)
+{
+    mir_tracepoint(mir_server_compositor, skipped_frame, id);
+}
+
+void mir::report::lttng::CompositorReport::resumed_frame(
+    SubCompositorId id, std::chrono::nanoseconds time_to_first_frame)
+{
+    mir_tracepoint(mir_server_compositor, resumed_frame, id, time_to_first_frame.count());
+}
@@ -40,6 +40,8 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void skipped_frame(SubCompositorId id) override;
+    void resumed_frame(SubCompositorId id, std::chrono::nanoseconds time_to_first_frame) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
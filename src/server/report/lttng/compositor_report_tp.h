@@ -77,6 +77,25 @@ TRACEPOINT_EVENT(
     )
 )
 
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    skipped_frame,
+    TP_ARGS(void const*, id),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+    )
+)
+
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    resumed_frame,
+    TP_ARGS(void const*, id, int64_t, time_to_first_frame_ns),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(int64_t, time_to_first_frame_ns, time_to_first_frame_ns)
+    )
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     buffers_in_frame,
@@ -39,6 +39,15 @@ TRACEPOINT_EVENT(
      )
 )
 
+TRACEPOINT_EVENT(
+    mir_server_input,
+    dispatched_event,
+    TP_ARGS(int64_t, event_time),
+    TP_FIELDS(
+        ctf_integer(int64_t, event_time, event_time)
+     )
+)
+
 TRACEPOINT_EVENT(
     mir_server_input,
     published_key_event,
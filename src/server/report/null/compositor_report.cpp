@@ -40,6 +40,14 @@ void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::skipped_frame(SubCompositorId)
+{
+}
+
+void mrn::CompositorReport::resumed_frame(SubCompositorId, std::chrono::nanoseconds)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
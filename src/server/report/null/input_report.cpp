@@ -24,6 +24,10 @@ void mrn::InputReport::received_event_from_kernel(int64_t /* when */, int /* typ
 {
 }
 
+void mrn::InputReport::dispatched_event(int64_t /* event_time */)
+{
+}
+
 void mrn::InputReport::published_key_event(int /* dest_fd */, uint32_t /* seq_id */, int64_t /* event_time */)
 {
 }
@@ -36,6 +36,7 @@ public:
     virtual ~InputReport() noexcept(true) = default;
 
     void received_event_from_kernel(int64_t when, int type, int code, int value) override;
+    void dispatched_event(int64_t event_time) override;
 
     void published_key_event(int dest_fd, uint32_t seq_id, int64_t event_time) override;
     void published_motion_event(int dest_fd, uint32_t seq_id, int64_t event_time) override;
@@ -53,7 +53,8 @@ std::unique_ptr<mr::ReportFactory> factory_for_type(
     case ReportOutput::Discarded:
         return std::make_unique<mr::NullReportFactory>();
     case ReportOutput::Log:
-        return std::make_unique<mr::LoggingReportFactory>(config.the_logger(), config.the_clock());
+        return std::make_unique<mr::LoggingReportFactory>(
+            config.the_logger(), config.the_clock(), [&config] { return config.the_alarm_factory(); });
     case ReportOutput::LTTNG:
         return std::make_unique<mr::LttngReportFactory>();
     }
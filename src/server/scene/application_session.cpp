@@ -258,6 +258,21 @@ void ms::ApplicationSession::take_snapshot(SnapshotCallback const& snapshot_take
     snapshot_taken(Snapshot());
 }
 
+void ms::ApplicationSession::take_thumbnail(geometry::Size const& size, SnapshotCallback const& thumbnail_taken)
+{
+    for(auto const& surface_it : surfaces)
+    {
+        if (default_surface() == surface_it.second)
+        {
+            auto id = default_content_map[surface_it.first];
+            snapshot_strategy->take_thumbnail_of(checked_find(id)->second, size, thumbnail_taken);
+            return;
+        }
+    }
+
+    thumbnail_taken(Snapshot());
+}
+
 std::shared_ptr<ms::Surface> ms::ApplicationSession::default_surface() const
 {
     std::unique_lock<std::mutex> lock(surfaces_and_streams_mutex);
@@ -76,6 +76,7 @@ public:
     std::shared_ptr<Surface> surface_after(std::shared_ptr<Surface> const&) const override;
 
     void take_snapshot(SnapshotCallback const& snapshot_taken) override;
+    void take_thumbnail(geometry::Size const& size, SnapshotCallback const& thumbnail_taken) override;
     std::shared_ptr<Surface> default_surface() const override;
 
     std::string name() const override;
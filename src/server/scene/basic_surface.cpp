@@ -26,6 +26,7 @@
 #include "mir/graphics/cursor_image.h"
 #include "mir/graphics/pixel_format_utils.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/renderer/sw/pixel_source.h"
 
 #include "mir/scene/scene_report.h"
@@ -903,6 +904,39 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
     return list;
 }
 
+bool ms::BasicSurface::could_appear_in(geom::Rectangle const& area) const
+{
+    static glm::mat4 const identity(1);
+
+    std::unique_lock<std::mutex> lk(guard);
+    if (transformation_matrix != identity)
+        return true;  // The transformation could put it anywhere
+
+    for (auto const& info : layers)
+    {
+        auto const size = info.size.is_set() ? info.size.value() : info.stream->stream_size();
+        if (area.overlaps({surface_rect.top_left + info.displacement, size}))
+            return true;
+    }
+    return false;
+}
+
+geom::Rectangle ms::BasicSurface::stream_extents() const
+{
+    geom::Rectangle const surface_area{top_left(), size()};
+
+    geom::Rectangles extents;
+    extents.add(surface_area);
+
+    std::unique_lock<std::mutex> lk(guard);
+    for (auto const& info : layers)
+    {
+        auto const size = info.size.is_set() ? info.size.value() : info.stream->stream_size();
+        extents.add({surface_area.top_left + info.displacement, size});
+    }
+    return extents.bounding_rectangle();
+}
+
 void ms::BasicSurface::set_confine_pointer_state(MirPointerConfinementState state)
 {
     confine_pointer_state_ = state;
@@ -105,6 +105,8 @@ public:
     bool visible() const override;
     
     graphics::RenderableList generate_renderables(compositor::CompositorID id) const override;
+    bool could_appear_in(geometry::Rectangle const& area) const override;
+    geometry::Rectangle stream_extents() const override;
     int buffers_ready_for_compositor(void const* compositor_id) const override;
 
     MirWindowType type() const override;
@@ -17,6 +17,7 @@
  */
 
 #include "default_session_container.h"
+#include "mir/scene/session.h"
 
 #include <boost/throw_exception.hpp>
 
@@ -25,57 +26,123 @@
 
 namespace ms = mir::scene;
 
+namespace
+{
+template<typename Index, typename Key>
+void remove_from(Index& index, Key const& key, ms::Session const* session)
+{
+    auto const entry = index.find(key);
+    if (entry == index.end())
+        return;
+
+    auto& sessions = entry->second;
+    sessions.erase(
+        std::remove_if(sessions.begin(), sessions.end(), [session](auto const& i) { return i->get() == session; }),
+        sessions.end());
+    if (sessions.empty())
+        index.erase(entry);
+}
+
+template<typename Index, typename Key>
+auto lookup(Index const& index, Key const& key, std::mutex& guard)
+-> std::vector<std::shared_ptr<ms::Session>>
+{
+    std::vector<std::shared_ptr<ms::Session>> result;
+
+    std::unique_lock<std::mutex> lk(guard);
+
+    auto const entry = index.find(key);
+    if (entry != index.end())
+    {
+        for (auto const& session : entry->second)
+            result.push_back(*session);
+    }
+
+    return result;
+}
+}
+
 void ms::DefaultSessionContainer::insert_session(std::shared_ptr<Session> const& session)
 {
+    // Don't call out to the session with the lock held
+    auto const pid = session->process_id();
+    auto const name = session->name();
+
     std::unique_lock<std::mutex> lk(guard);
 
-    apps.push_back(session);
+    if (positions.count(session.get()))
+        BOOST_THROW_EXCEPTION(std::logic_error("Session already inserted"));
+
+    auto const position = apps.insert(apps.end(), session);
+    positions[session.get()] = position;
+    by_pid[pid].push_back(position);
+    by_name[name].push_back(position);
+    snapshot.reset();
 }
 
 void ms::DefaultSessionContainer::remove_session(std::shared_ptr<Session> const& session)
 {
+    auto const pid = session->process_id();
+    auto const name = session->name();
+
     std::unique_lock<std::mutex> lk(guard);
 
-    auto it = std::find(apps.begin(), apps.end(), session);
-    if (it != apps.end())
-    {
-        apps.erase(it);
-    }
-    else
-    {
+    auto const position = positions.find(session.get());
+    if (position == positions.end())
         BOOST_THROW_EXCEPTION(std::logic_error("Invalid Session"));
-    }
+
+    remove_from(by_pid, pid, session.get());
+    remove_from(by_name, name, session.get());
+    apps.erase(position->second);
+    positions.erase(position);
+    snapshot.reset();
 }
 
 void ms::DefaultSessionContainer::for_each(std::function<void(std::shared_ptr<Session> const&)> f) const
 {
-    std::unique_lock<std::mutex> lk(guard);
+    std::shared_ptr<Snapshot const> current;
+    {
+        std::unique_lock<std::mutex> lk(guard);
+
+        if (!snapshot)
+            snapshot = std::make_shared<Snapshot const>(apps.begin(), apps.end());
+
+        current = snapshot;
+    }
 
-    for (auto const ptr : apps)
+    for (auto const& ptr : *current)
     {
         f(ptr);
     }
 }
 
+auto ms::DefaultSessionContainer::sessions_of(pid_t pid) const
+-> std::vector<std::shared_ptr<Session>>
+{
+    return lookup(by_pid, pid, guard);
+}
+
+auto ms::DefaultSessionContainer::sessions_named(std::string const& name) const
+-> std::vector<std::shared_ptr<Session>>
+{
+    return lookup(by_name, name, guard);
+}
+
 std::shared_ptr<ms::Session> ms::DefaultSessionContainer::successor_of(std::shared_ptr<Session> const& session) const
 {
-    std::shared_ptr<Session> result, first;
+    std::unique_lock<std::mutex> lk(guard);
 
     if (!session && apps.size())
         return apps.back();
     else if(!session)
         return std::shared_ptr<Session>();
 
-    for (auto it = apps.begin(); it != apps.end(); it++)
-    {
-        if (*it == session)
-        {
-            auto successor = ++it;
-            if (successor == apps.end())
-                return *apps.begin();
-            else return *successor;
-        }
-    }
+    auto const position = positions.find(session.get());
+    if (position == positions.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Invalid session"));
 
-    BOOST_THROW_EXCEPTION(std::logic_error("Invalid session"));
+    auto successor = std::next(position->second);
+    if (successor == apps.end())
+        return apps.front();
+    else return *successor;
 }
@@ -19,9 +19,12 @@
 #ifndef MIR_SCENE_DEFAULT_SESSION_CONTAINER_H_
 #define MIR_SCENE_DEFAULT_SESSION_CONTAINER_H_
 
-#include <vector>
+#include <list>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "mir/scene/session_container.h"
 
@@ -29,6 +32,10 @@ namespace mir
 {
 namespace scene
 {
+/**
+ * Sessions in insertion order, indexed by identity, pid and name so that
+ * insertion, removal, successor_of() and the lookups don't search the list.
+ */
 class DefaultSessionContainer : public SessionContainer
 {
 public:
@@ -36,10 +43,25 @@ public:
     void remove_session(std::shared_ptr<Session> const& session) override;
     void for_each(std::function<void(std::shared_ptr<Session> const&)> f) const override;
 
+    std::vector<std::shared_ptr<Session>> sessions_of(pid_t pid) const override;
+    std::vector<std::shared_ptr<Session>> sessions_named(std::string const& name) const override;
+
     std::shared_ptr<Session> successor_of(std::shared_ptr<Session> const& session) const override;
 
 private:
-    std::vector<std::shared_ptr<Session>> apps;
+    using Sessions = std::list<std::shared_ptr<Session>>;
+    using Snapshot = std::vector<std::shared_ptr<Session>>;
+
+    template<typename Key>
+    using Index = std::unordered_map<Key, std::vector<Sessions::iterator>>;
+
+    Sessions apps;
+    std::unordered_map<Session const*, Sessions::iterator> positions;
+    Index<pid_t> by_pid;
+    Index<std::string> by_name;
+
+    /// Rebuilt by for_each() after the sessions change
+    mutable std::shared_ptr<Snapshot const> snapshot;
     mutable std::mutex guard;
 };
 
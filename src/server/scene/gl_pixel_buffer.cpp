@@ -17,15 +17,29 @@
  */
 
 #include "gl_pixel_buffer.h"
+#include "pixel_conversion.h"
 #include "mir/graphics/buffer.h"
 #include "mir/renderer/gl/context.h"
 #include "mir/renderer/gl/texture_source.h"
 
+#include <cstdio>
 #include <stdexcept>
 #include <boost/throw_exception.hpp>
+#include <EGL/egl.h>
 #include MIR_SERVER_GL_H
 #include MIR_SERVER_GLEXT_H
 
+/* Pixel buffer objects are core in GLES 3 and GL 2.1, but we build against GLES 2 headers */
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+
 namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
@@ -39,19 +53,100 @@ bool is_big_endian()
     return (*reinterpret_cast<char*>(&n) != 1);
 }
 
-inline uint32_t abgr_to_argb(uint32_t p)
+char const* const scaling_vertex_shader =
+    "attribute vec2 position;\n"
+    "varying vec2 v_texcoord;\n"
+    "void main() {\n"
+    "   gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+    "   v_texcoord = position;\n"
+    "}\n";
+
+char const* const scaling_fragment_shader =
+    "precision mediump float;\n"
+    "uniform sampler2D tex;\n"
+    "varying vec2 v_texcoord;\n"
+    "void main() {\n"
+    "   gl_FragColor = texture2D(tex, v_texcoord);\n"
+    "}\n";
+
+GLuint compile_shader(GLenum type, char const* source)
 {
-    return ((p << 16) & 0x00ff0000) | /* Move R to new position */
-           ((p) & 0x0000ff00) |       /* G remains at same position */
-           ((p >> 16) & 0x000000ff) | /* Move B to new position */
-           ((p) & 0xff000000);        /* A remains at same position */
+    GLuint const shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint compiled{GL_FALSE};
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled != GL_TRUE)
+    {
+        glDeleteShader(shader);
+        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to compile GLPixelBuffer scaling shader"));
+    }
+
+    return shader;
 }
 
+/* glMapBufferRange() is needed to read a pixel buffer object back: GLES 3.0 or GL 3.0 */
+bool gl_has_map_buffer_range()
+{
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+    if (!version)
+        return false;
+
+    int major{0};
+    if (std::sscanf(version, "OpenGL ES %d.", &major) != 1 &&
+        std::sscanf(version, "%d.", &major) != 1)
+        return false;
+
+    return major >= 3;
+}
 }
 
+struct ms::GLPixelBuffer::PackBuffers
+{
+    using MapBufferRange = void* (*)(GLenum, GLintptr, GLsizeiptr, GLbitfield);
+    using UnmapBuffer = GLboolean (*)(GLenum);
+
+    /// A read back into one of the pixel buffer objects
+    struct Read
+    {
+        GLuint name;
+        geom::Size size;
+        GLuint format;
+    };
+
+    PackBuffers(MapBufferRange map_buffer_range, UnmapBuffer unmap_buffer)
+        : map_buffer_range{map_buffer_range},
+          unmap_buffer{unmap_buffer}
+    {
+        GLuint names[2];
+        glGenBuffers(2, names);
+        reads[0].name = names[0];
+        reads[1].name = names[1];
+    }
+
+    ~PackBuffers()
+    {
+        GLuint const names[]{reads[0].name, reads[1].name};
+        glDeleteBuffers(2, names);
+    }
+
+    Read& oldest()
+    {
+        return reads[(next + 2 - in_flight) % 2];
+    }
+
+    MapBufferRange const map_buffer_range;
+    UnmapBuffer const unmap_buffer;
+    Read reads[2];
+    unsigned int next{0};
+    unsigned int in_flight{0};
+};
+
 ms::GLPixelBuffer::GLPixelBuffer(std::unique_ptr<renderer::gl::Context> gl_context)
     : gl_context{std::move(gl_context)},
-      tex{0}, fbo{0}, gl_pixel_format{0}, pixels_need_y_flip{false}
+      tex{0}, fbo{0}, scaled_tex{0}, program{0}, position_attr{0},
+      pack_buffers_probed{false}, gl_pixel_format{0}, pixels_need_y_flip{false}
 {
     /*
      * TODO: Handle systems that are big-endian, and therefore GL_BGRA doesn't
@@ -73,10 +168,16 @@ ms::GLPixelBuffer::~GLPixelBuffer() noexcept
     if (tex != 0 || fbo != 0)
         gl_context->make_current();
 
+    pack_buffers.reset();
+
     if (tex != 0)
         glDeleteTextures(1, &tex);
     if (fbo != 0)
         glDeleteFramebuffers(1, &fbo);
+    if (scaled_tex != 0)
+        glDeleteTextures(1, &scaled_tex);
+    if (program != 0)
+        glDeleteProgram(program);
 }
 
 void ms::GLPixelBuffer::prepare()
@@ -93,6 +194,21 @@ void ms::GLPixelBuffer::prepare()
         glGenFramebuffers(1, &fbo);
 
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    if (!pack_buffers_probed)
+    {
+        pack_buffers_probed = true;
+        if (gl_has_map_buffer_range())
+        {
+            auto const map_buffer_range = reinterpret_cast<PackBuffers::MapBufferRange>(
+                eglGetProcAddress("glMapBufferRange"));
+            auto const unmap_buffer = reinterpret_cast<PackBuffers::UnmapBuffer>(
+                eglGetProcAddress("glUnmapBuffer"));
+
+            if (map_buffer_range && unmap_buffer)
+                pack_buffers = std::make_unique<PackBuffers>(map_buffer_range, unmap_buffer);
+        }
+    }
 }
 
 void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer)
@@ -103,60 +219,200 @@ void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer)
     pixels.resize(width * height * 4);
 
     prepare();
+    bind_buffer_texture(buffer);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+
+    gl_pixel_format = read_pixels(width, height, pixels.data());
+
+    size_ = buffer.size();
+    pixels_need_y_flip = true;
+}
+
+void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer, geom::Size const& size)
+{
+    auto const width = size.width.as_uint32_t();
+    auto const height = size.height.as_uint32_t();
+
+    pixels.resize(width * height * 4);
+
+    prepare();
+    draw_scaled(buffer, size);
+    gl_pixel_format = read_pixels(width, height, pixels.data());
+
+    /* Drawing keeps the row order of the buffer texture, so this needs flipping too */
+    size_ = size;
+    pixels_need_y_flip = true;
+}
+
+bool ms::GLPixelBuffer::begin_fill_from(graphics::Buffer& buffer, geom::Size const& size)
+{
+    prepare();
+    if (!pack_buffers)
+        return false;
+
+    if (pack_buffers->in_flight == 2)
+        BOOST_THROW_EXCEPTION(std::logic_error("GLPixelBuffer already has two fills outstanding"));
+
+    auto const width = size.width.as_uint32_t();
+    auto const height = size.height.as_uint32_t();
+
+    draw_scaled(buffer, size);
+
+    auto& read = pack_buffers->reads[pack_buffers->next];
+    pack_buffers->next = (pack_buffers->next + 1) % 2;
+    ++pack_buffers->in_flight;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, read.name);
+    glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, nullptr, GL_STREAM_READ);
+    read.format = read_pixels(width, height, nullptr);
+    read.size = size;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    /* Start the transfer now; end_fill() waits for it when mapping */
+    glFlush();
+
+    return true;
+}
 
+void ms::GLPixelBuffer::end_fill()
+{
+    if (!pack_buffers || pack_buffers->in_flight == 0)
+        BOOST_THROW_EXCEPTION(std::logic_error("GLPixelBuffer has no fill outstanding"));
+
+    auto const& read = pack_buffers->oldest();
+    --pack_buffers->in_flight;
+
+    auto const width = read.size.width.as_uint32_t();
+    auto const height = read.size.height.as_uint32_t();
+
+    gl_context->make_current();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, read.name);
+    auto const mapped = pack_buffers->map_buffer_range(
+        GL_PIXEL_PACK_BUFFER, 0, width * height * 4, GL_MAP_READ_BIT);
+    if (!mapped)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to map GLPixelBuffer pixel buffer object"));
+    }
+
+    pixels.resize(width * height * 4);
+    if (read.format == GL_RGBA)
+        copy_flipped_abgr_to_argb(mapped, pixels.data(), width, height);
+    else
+        copy_flipped(mapped, pixels.data(), width, height);
+
+    pack_buffers->unmap_buffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    gl_pixel_format = read.format;
+    size_ = read.size;
+    pixels_need_y_flip = false;
+}
+
+void ms::GLPixelBuffer::draw_scaled(graphics::Buffer& buffer, geom::Size const& size)
+{
+    bind_buffer_texture(buffer);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    prepare_scaling(size);
+
+    /* Draw the buffer texture over the whole of the (smaller) scaled texture */
+    static GLfloat const vertices[] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glViewport(0, 0, size.width.as_int(), size.height.as_int());
+    glUseProgram(program);
+    glVertexAttribPointer(position_attr, 2, GL_FLOAT, GL_FALSE, 0, vertices);
+    glEnableVertexAttribArray(position_attr);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(position_attr);
+}
+
+void ms::GLPixelBuffer::bind_buffer_texture(graphics::Buffer& buffer)
+{
     auto const texture_source =
         dynamic_cast<mir::renderer::gl::TextureSource*>(
             buffer.native_buffer_base());
     if (!texture_source)
         BOOST_THROW_EXCEPTION(std::logic_error("Buffer does not support GL rendering"));
     texture_source->gl_bind_to_texture();
+}
 
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+void ms::GLPixelBuffer::prepare_scaling(geom::Size const& size)
+{
+    if (program == 0)
+    {
+        auto const vertex_shader = compile_shader(GL_VERTEX_SHADER, scaling_vertex_shader);
+        auto const fragment_shader = compile_shader(GL_FRAGMENT_SHADER, scaling_fragment_shader);
+
+        program = glCreateProgram();
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+        glLinkProgram(program);
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+
+        GLint linked{GL_FALSE};
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked != GL_TRUE)
+        {
+            glDeleteProgram(program);
+            program = 0;
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to link GLPixelBuffer scaling program"));
+        }
 
-    /* First try to get pixels as BGRA */
-    glGetError();
-    gl_pixel_format = GL_BGRA_EXT;
-    glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, pixels.data());
+        position_attr = glGetAttribLocation(program, "position");
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "tex"), 0);
+    }
 
-    /* If getting pixels as BGRA failed, fall back to RGBA */
-    if (glGetError() != GL_NO_ERROR)
+    if (scaled_tex == 0)
+        glGenTextures(1, &scaled_tex);
+
+    glBindTexture(GL_TEXTURE_2D, scaled_tex);
+    if (scaled_size != size)
     {
-        gl_pixel_format = GL_RGBA;
-        glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, pixels.data());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                     size.width.as_int(), size.height.as_int(),
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        scaled_size = size;
     }
 
-    size_ = buffer.size();
-    pixels_need_y_flip = true;
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, scaled_tex, 0);
+}
+
+GLuint ms::GLPixelBuffer::read_pixels(GLsizei width, GLsizei height, void* destination)
+{
+    /* First try to get pixels as BGRA */
+    glGetError();
+    glReadPixels(0, 0, width, height, GL_BGRA_EXT, GL_UNSIGNED_BYTE, destination);
+    if (glGetError() == GL_NO_ERROR)
+        return GL_BGRA_EXT;
+
+    /* If getting pixels as BGRA failed, fall back to RGBA */
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, destination);
+    return GL_RGBA;
 }
 
 void const* ms::GLPixelBuffer::as_argb_8888()
 {
     if (pixels_need_y_flip)
     {
-        auto const stride_val = stride().as_uint32_t();
+        auto const width = size_.width.as_uint32_t();
         auto const height = size_.height.as_uint32_t();
+        auto const convert = gl_pixel_format == GL_RGBA;
 
-        std::vector<char> tmp(stride_val);
-
-        for (unsigned int i = 0; i < height / 2; i++)
+        if (convert)
         {
-            /* Store line i */
-            tmp.assign(&pixels[i * stride_val], &pixels[(i + 1) * stride_val]);
-
-            /* Copy line height - i - 1 to line i */
-            copy_and_convert_pixel_line(&pixels[(height - i - 1) * stride_val],
-                                        &pixels[i * stride_val]);
-
-            /* Copy stored line (i) to height - i - 1 */
-            copy_and_convert_pixel_line(tmp.data(),
-                                        &pixels[(height - i - 1) * stride_val]);
+            flip_abgr_to_argb(pixels.data(), width, height);
         }
-
-        /* Process middle line if there is one */
-        if (height % 2 == 1)
+        else
         {
-            copy_and_convert_pixel_line(&pixels[(height / 2) * stride_val],
-                                        &pixels[(height / 2) * stride_val]);
+            flip(pixels.data(), width, height);
         }
 
         pixels_need_y_flip = false;
@@ -174,21 +430,3 @@ geom::Stride ms::GLPixelBuffer::stride() const
 {
     return geom::Stride{size_.width.as_uint32_t() * sizeof(uint32_t)};
 }
-
-void ms::GLPixelBuffer::copy_and_convert_pixel_line(char* src, char* dst)
-{
-    if (gl_pixel_format == GL_RGBA)
-    {
-        /* Convert from abgr_8888 to argb_8888 while copying */
-        auto pixels_src = reinterpret_cast<uint32_t*>(src);
-        auto pixels_dst = reinterpret_cast<uint32_t*>(dst);
-        auto const width = size_.width.as_uint32_t();
-
-        for (uint32_t n = 0; n < width; n++)
-            pixels_dst[n] = abgr_to_argb(pixels_src[n]);
-    }
-    else if (src != dst)
-    {
-        std::copy(src, src + stride().as_uint32_t(), dst);
-    }
-}
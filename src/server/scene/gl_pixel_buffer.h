@@ -42,7 +42,14 @@ class Context;
 
 namespace scene
 {
-/** Extracts the pixels from a graphics::Buffer using GL facilities. */
+/**
+ * Extracts the pixels from a graphics::Buffer using GL facilities.
+ *
+ * Where the GL implementation supports pixel buffer objects,
+ * begin_fill_from() reads back into one of a pair of them and returns
+ * without waiting for the GPU. end_fill() maps the older one, so one read
+ * back can be in flight while the previous one is converted.
+ */
 class GLPixelBuffer : public PixelBuffer
 {
 public:
@@ -50,17 +57,32 @@ public:
     ~GLPixelBuffer() noexcept;
 
     void fill_from(graphics::Buffer& buffer);
+    /// Scales on the GPU, by drawing the buffer into a texture of the requested size
+    void fill_from(graphics::Buffer& buffer, geometry::Size const& size);
+    bool begin_fill_from(graphics::Buffer& buffer, geometry::Size const& size);
+    void end_fill();
     void const* as_argb_8888();
     geometry::Size size() const;
     geometry::Stride stride() const;
 
 private:
     void prepare();
-    void copy_and_convert_pixel_line(char* src, char* dst);
+    void bind_buffer_texture(graphics::Buffer& buffer);
+    void prepare_scaling(geometry::Size const& size);
+    void draw_scaled(graphics::Buffer& buffer, geometry::Size const& size);
+    GLuint read_pixels(GLsizei width, GLsizei height, void* destination);
+
+    struct PackBuffers;
 
     std::unique_ptr<renderer::gl::Context> const gl_context;
     GLuint tex;
     GLuint fbo;
+    GLuint scaled_tex;
+    GLuint program;
+    GLint position_attr;
+    geometry::Size scaled_size;
+    std::unique_ptr<PackBuffers> pack_buffers;
+    bool pack_buffers_probed;
     std::vector<char> pixels;
     GLuint gl_pixel_format;
     bool pixels_need_y_flip;
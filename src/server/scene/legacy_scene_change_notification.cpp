@@ -20,6 +20,7 @@
 
 #include "mir/scene/legacy_scene_change_notification.h"
 #include "mir/scene/surface.h"
+#include "mir/geometry/rectangles.h"
 
 #include <boost/throw_exception.hpp>
 
@@ -49,6 +50,12 @@ ms::LegacySceneChangeNotification::~LegacySceneChangeNotification()
 
 namespace
 {
+/*
+ * Changes confined to the surface's bounds (including any streams displaced
+ * beyond them) are reported as damage to those bounds (both before and
+ * after, for a move or resize) so that only the outputs they touch are
+ * recomposited. Anything else is a scene change.
+ */
 class NonLegacySurfaceChangeNotification : public ms::LegacySurfaceChangeNotification
 {
 public:
@@ -57,48 +64,132 @@ public:
         std::function<void(int frames, mir::geometry::Rectangle const& damage)> const& damage_notify_change,
         ms::Surface* surface);
 
+    void resized_to(ms::Surface const* surf, mir::geometry::Size const& size) override;
     void moved_to(ms::Surface const* surf, const mir::geometry::Point&) override;
+    void hidden_set_to(ms::Surface const* surf, bool hide) override;
+    void alpha_set_to(ms::Surface const* surf, float alpha) override;
     void frame_posted(ms::Surface const* surf, int frames_available, const mir::geometry::Size& size) override;
 
 private:
-    mir::geometry::Point top_left;
+    bool changed_while_visible();
+    void damage(mir::geometry::Rectangle const& before, mir::geometry::Rectangle const& after);
+    void update_bounds();
+
+    ms::Surface* const surface;
     std::function<void(int frames, mir::geometry::Rectangle const& damage)> const damage_notify_change;
+
+    std::mutex mutex;
+    mir::geometry::Point top_left;
+    mir::geometry::Rectangle bounds;
+    bool was_visible;
 };
 
 NonLegacySurfaceChangeNotification::NonLegacySurfaceChangeNotification(
     std::function<void()> const& notify_scene_change,
     std::function<void(int frames, mir::geometry::Rectangle const& damage)> const& damage_notify_change,
     ms::Surface* surface) :
-    ms::LegacySurfaceChangeNotification(notify_scene_change, {}),
-    damage_notify_change(damage_notify_change)
+    ms::LegacySurfaceChangeNotification(
+        [this, notify_scene_change]
+        {
+            if (changed_while_visible())
+                notify_scene_change();
+        },
+        {}),
+    surface{surface},
+    damage_notify_change(damage_notify_change),
+    top_left{surface->top_left()},
+    bounds{surface->stream_extents()},
+    was_visible{false}
+{
+}
+
+bool NonLegacySurfaceChangeNotification::changed_while_visible()
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    auto const changed = surface->visible() || was_visible;
+    was_visible = surface->visible();
+    return changed;
+}
+
+void NonLegacySurfaceChangeNotification::damage(
+    mir::geometry::Rectangle const& before,
+    mir::geometry::Rectangle const& after)
+{
+    if (changed_while_visible())
+    {
+        damage_notify_change(1, before);
+        if (after != before)
+            damage_notify_change(1, after);
+    }
+}
+
+void NonLegacySurfaceChangeNotification::update_bounds()
 {
-    top_left = surface->top_left();
+    // Not called from frame_posted(), as the stream's callback lock is held there
+    auto const extents = surface->stream_extents();
+    auto const position = surface->top_left();
+
+    std::unique_lock<decltype(mutex)> lock{mutex};
+    auto const before = bounds;
+    bounds = extents;
+    top_left = position;
+    lock.unlock();
+
+    damage(before, extents);
+}
+
+void NonLegacySurfaceChangeNotification::resized_to(ms::Surface const*, mir::geometry::Size const&)
+{
+    update_bounds();
 }
 
-void NonLegacySurfaceChangeNotification::moved_to(ms::Surface const* surf, const mir::geometry::Point& top_left)
+void NonLegacySurfaceChangeNotification::moved_to(ms::Surface const*, const mir::geometry::Point&)
 {
-    this->top_left = top_left;
-    ms::LegacySurfaceChangeNotification::moved_to(surf, top_left);
+    // Also reports set_streams(), so the streams may have moved within the surface
+    update_bounds();
+}
+
+void NonLegacySurfaceChangeNotification::hidden_set_to(ms::Surface const*, bool)
+{
+    std::unique_lock<decltype(mutex)> lock{mutex};
+    auto const current = bounds;
+    lock.unlock();
+
+    damage(current, current);
+}
+
+void NonLegacySurfaceChangeNotification::alpha_set_to(ms::Surface const*, float)
+{
+    std::unique_lock<decltype(mutex)> lock{mutex};
+    auto const current = bounds;
+    lock.unlock();
+
+    damage(current, current);
 }
 
 void NonLegacySurfaceChangeNotification::frame_posted(ms::Surface const*, int frames_available, const mir::geometry::Size& size)
 {
-    mir::geometry::Rectangle const update_region{top_left, size};
-    damage_notify_change(frames_available, update_region);
+    std::unique_lock<decltype(mutex)> lock{mutex};
+    mir::geometry::Rectangles update_region;
+    update_region.add(bounds);
+    update_region.add({top_left, size});
+    lock.unlock();
+
+    damage_notify_change(frames_available, update_region.bounding_rectangle());
 }
 }
 
 void ms::LegacySceneChangeNotification::add_surface_observer(ms::Surface* surface)
 {
-    auto notifier = [surface, this, was_visible = false] () mutable
-        {
-            if (surface->visible() || was_visible)
-                scene_notify_change();
-            was_visible = surface->visible();
-        };
-
     if (buffer_notify_change)
     {
+        auto notifier = [surface, this, was_visible = false] () mutable
+            {
+                if (surface->visible() || was_visible)
+                    scene_notify_change();
+                was_visible = surface->visible();
+            };
+
         auto observer = std::make_shared<LegacySurfaceChangeNotification>(notifier, buffer_notify_change);
         surface->add_observer(observer);
 
@@ -107,7 +198,8 @@ void ms::LegacySceneChangeNotification::add_surface_observer(ms::Surface* surfac
     }
     else
     {
-        auto observer = std::make_shared<NonLegacySurfaceChangeNotification>(notifier, damage_notify_change, surface);
+        auto observer = std::make_shared<NonLegacySurfaceChangeNotification>(
+            scene_notify_change, damage_notify_change, surface);
         surface->add_observer(observer);
 
         std::unique_lock<decltype(surface_observers_guard)> lg(surface_observers_guard);
@@ -138,7 +230,12 @@ void ms::LegacySceneChangeNotification::surface_removed(ms::Surface* surface)
     }
 
     if (surface->visible())
-        scene_notify_change();
+    {
+        if (damage_notify_change)
+            damage_notify_change(1, surface->stream_extents());
+        else
+            scene_notify_change();
+    }
 }
 
 void ms::LegacySceneChangeNotification::surfaces_reordered()
@@ -16,6 +16,7 @@
  * Authored by: Kevin DuBois <kevin.dubois@canonical.com>
  */
 
+#include <chrono>
 #include <condition_variable>
 #include <boost/throw_exception.hpp>
 #include <unordered_set>
@@ -468,12 +469,20 @@ bool configuration_has_new_outputs_enabled(
 void ms::MediatingDisplayChanger::apply_config(
     std::shared_ptr<graphics::DisplayConfiguration> const& conf)
 {
+    auto const start = std::chrono::steady_clock::now();
     auto existing_configuration = display->configuration();
     try
     {
-        if (configuration_has_new_outputs_enabled(*display->configuration(), *conf) ||
+        /*
+         * Where the display can apply the change to its existing display
+         * buffers the compositor keeps running; it follows any change to
+         * the outputs' view areas and redraws on configuration_applied().
+         */
+        bool incremental = true;
+        if (configuration_has_new_outputs_enabled(*existing_configuration, *conf) ||
             !display->apply_if_configuration_preserves_display_buffers(*conf))
         {
+            incremental = false;
             ApplyNowAndRevertOnScopeExit comp{
                 [this] { compositor->stop(); },
                 [this] { compositor->start(); }};
@@ -481,6 +490,7 @@ void ms::MediatingDisplayChanger::apply_config(
         }
 
         observer->configuration_applied(conf);
+        observer->configuration_timing(std::chrono::steady_clock::now() - start, incremental);
         base_configuration_applied = false;
     }
     catch (std::exception const& e)
@@ -45,11 +45,43 @@ public:
      */
     virtual void fill_from(graphics::Buffer& buffer) = 0;
 
+    /**
+     * Fills the PixelBuffer with the contents of a graphics::Buffer scaled
+     * to size.
+     *
+     * \param [in] buffer the buffer to get the pixels of
+     * \param [in] size   the size to scale the pixels to
+     */
+    virtual void fill_from(graphics::Buffer& buffer, geometry::Size const& size) = 0;
+
+    /**
+     * Starts filling the PixelBuffer as fill_from(buffer, size) does, but
+     * without waiting for the read back to finish.
+     *
+     * At most two fills may be outstanding. Each is finished, oldest first,
+     * by a call to end_fill().
+     *
+     * \param [in] buffer the buffer to get the pixels of
+     * \param [in] size   the size to scale the pixels to
+     * \return false if the PixelBuffer can only be filled synchronously, in
+     *         which case nothing was started
+     */
+    virtual bool begin_fill_from(graphics::Buffer& /*buffer*/, geometry::Size const& /*size*/)
+    {
+        return false;
+    }
+
+    /**
+     * Waits for the oldest fill started by begin_fill_from() and makes its
+     * pixels those returned by as_argb_8888(), size() and stride().
+     */
+    virtual void end_fill() {}
+
     /**
      * The pixels in 0xAARRGGBB format.
      *
      * The pixel data is owned by the PixelBuffer object and is only valid
-     * until the next call to fill_from().
+     * until the next call to fill_from() or end_fill().
      *
      * This method may involve transformation of the extracted data.
      */
@@ -0,0 +1,138 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pixel_conversion.h"
+
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ms = mir::scene;
+
+namespace
+{
+inline uint32_t abgr_to_argb(uint32_t p)
+{
+    return ((p << 16) & 0x00ff0000) | /* Move R to new position */
+           ((p) & 0x0000ff00) |       /* G remains at same position */
+           ((p >> 16) & 0x000000ff) | /* Move B to new position */
+           ((p) & 0xff000000);        /* A remains at same position */
+}
+
+/* src and dst may be the same line, as each chunk is loaded before it is stored */
+void abgr_to_argb_line(uint8_t const* src, uint8_t* dst, uint32_t width)
+{
+    uint32_t n = 0;
+
+#if defined(__SSE2__)
+    /* SSE2 has no byte shuffle, so swap R and B with shifts within each pixel */
+    __m128i const ag_mask = _mm_set1_epi32(static_cast<int>(0xff00ff00));
+    __m128i const rb_mask = _mm_set1_epi32(0x00ff00ff);
+
+    for (; n + 4 <= width; n += 4)
+    {
+        __m128i const p = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + n * 4));
+        __m128i const ag = _mm_and_si128(p, ag_mask);
+        __m128i const rb = _mm_and_si128(p, rb_mask);
+        __m128i const br = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n * 4), _mm_or_si128(ag, br));
+    }
+#elif defined(__ARM_NEON)
+    for (; n + 16 <= width; n += 16)
+    {
+        uint8x16x4_t p = vld4q_u8(src + n * 4);
+        uint8x16_t const r = p.val[0];
+        p.val[0] = p.val[2];
+        p.val[2] = r;
+        vst4q_u8(dst + n * 4, p);
+    }
+#endif
+
+    for (; n < width; ++n)
+    {
+        uint32_t p;
+        std::memcpy(&p, src + n * 4, sizeof p);
+        p = abgr_to_argb(p);
+        std::memcpy(dst + n * 4, &p, sizeof p);
+    }
+}
+
+/* Swaps rows through a temporary line; convert() must also work in place, for the middle line */
+template<typename LineConversion>
+void flip_in_place(void* pixels, uint32_t width, uint32_t height, LineConversion convert)
+{
+    auto const stride = width * 4;
+    auto const rows = static_cast<uint8_t*>(pixels);
+    std::vector<uint8_t> tmp(stride);
+
+    for (uint32_t row = 0; row < height / 2; ++row)
+    {
+        auto const top = rows + row * stride;
+        auto const bottom = rows + (height - row - 1) * stride;
+
+        convert(top, tmp.data(), width);
+        convert(bottom, top, width);
+        std::memcpy(bottom, tmp.data(), stride);
+    }
+
+    /* Process middle line if there is one */
+    if (height % 2 == 1)
+    {
+        auto const middle = rows + (height / 2) * stride;
+        convert(middle, middle, width);
+    }
+}
+}
+
+void ms::copy_flipped(void const* src, void* dst, uint32_t width, uint32_t height)
+{
+    auto const stride = width * 4;
+    auto const from = static_cast<uint8_t const*>(src);
+    auto const to = static_cast<uint8_t*>(dst);
+
+    for (uint32_t row = 0; row < height; ++row)
+        std::memcpy(to + (height - row - 1) * stride, from + row * stride, stride);
+}
+
+void ms::copy_flipped_abgr_to_argb(void const* src, void* dst, uint32_t width, uint32_t height)
+{
+    auto const stride = width * 4;
+    auto const from = static_cast<uint8_t const*>(src);
+    auto const to = static_cast<uint8_t*>(dst);
+
+    for (uint32_t row = 0; row < height; ++row)
+        abgr_to_argb_line(from + row * stride, to + (height - row - 1) * stride, width);
+}
+
+void ms::flip(void* pixels, uint32_t width, uint32_t height)
+{
+    flip_in_place(pixels, width, height,
+        [](uint8_t const* src, uint8_t* dst, uint32_t width)
+        {
+            if (src != dst)
+                std::memcpy(dst, src, width * 4);
+        });
+}
+
+void ms::flip_abgr_to_argb(void* pixels, uint32_t width, uint32_t height)
+{
+    flip_in_place(pixels, width, height, &abgr_to_argb_line);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_PIXEL_CONVERSION_H_
+#define MIR_SCENE_PIXEL_CONVERSION_H_
+
+#include <cstdint>
+
+namespace mir
+{
+namespace scene
+{
+/**
+ * Copies height rows of width tightly packed 32-bit pixels from src to dst,
+ * reversing the order of the rows. src and dst must not overlap.
+ */
+void copy_flipped(void const* src, void* dst, uint32_t width, uint32_t height);
+
+/**
+ * As copy_flipped(), also converting each pixel from 0xAABBGGRR to 0xAARRGGBB.
+ *
+ * Uses SSE2 or NEON where the target has them.
+ */
+void copy_flipped_abgr_to_argb(void const* src, void* dst, uint32_t width, uint32_t height);
+
+/// As copy_flipped(), but in place
+void flip(void* pixels, uint32_t width, uint32_t height);
+
+/// As copy_flipped_abgr_to_argb(), but in place
+void flip_abgr_to_argb(void* pixels, uint32_t width, uint32_t height);
+}
+}
+
+#endif /* MIR_SCENE_PIXEL_CONVERSION_H_ */
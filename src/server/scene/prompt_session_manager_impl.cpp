@@ -122,20 +122,13 @@ std::shared_ptr<ms::PromptSession> ms::PromptSessionManagerImpl::start_prompt_se
     PromptSessionCreationParameters const& params) const
 {
     auto prompt_session = std::make_shared<PromptSessionImpl>();
-    std::shared_ptr<Session> application_session;
-
-    app_container->for_each(
-    [&](std::shared_ptr<Session> const& session)
-    {
-        if (session->process_id() == params.application_pid)
-        {
-            application_session = session;
-        }
-    });
+    auto const application_sessions = app_container->sessions_of(params.application_pid);
 
-    if (!application_session)
+    if (application_sessions.empty())
         BOOST_THROW_EXCEPTION(std::runtime_error("Could not identify application session"));
 
+    auto const application_session = application_sessions.back();
+
     std::lock_guard<std::mutex> lock(prompt_sessions_mutex);
 
     prompt_session_container->insert_prompt_session(prompt_session);
@@ -20,6 +20,7 @@
 #define MIR_SCENE_SNAPSHOT_STRATEGY_H_
 
 #include "mir/scene/snapshot.h"
+#include "mir/geometry/size.h"
 
 #include <memory>
 
@@ -38,6 +39,12 @@ public:
         std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
         SnapshotCallback const& snapshot_taken) = 0;
 
+    /// Like take_snapshot_of(), but scaled to size
+    virtual void take_thumbnail_of(
+        std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
+        geometry::Size const& size,
+        SnapshotCallback const& thumbnail_taken) = 0;
+
 protected:
     SnapshotStrategy() = default;
     SnapshotStrategy(SnapshotStrategy const&) = delete;
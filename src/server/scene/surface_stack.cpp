@@ -31,6 +31,7 @@
 #include <cassert>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 
 namespace ms = mir::scene;
@@ -111,32 +112,55 @@ private:
 ms::SurfaceStack::SurfaceStack(
     std::shared_ptr<SceneReport> const& report) :
     report{report},
+    current{std::make_shared<Snapshot>()},
+    view_areas{std::make_shared<ViewAreas>()},
     scene_changed{false}
 {
 }
 
+auto ms::SurfaceStack::snapshot() const -> std::shared_ptr<Snapshot const>
+{
+    return std::atomic_load(&current);
+}
+
+void ms::SurfaceStack::publish(std::shared_ptr<Snapshot const> const& next)
+{
+    std::atomic_store(&current, next);
+}
+
 mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
 {
-    RecursiveReadLock lg(guard);
+    auto const stack = snapshot();
+    auto const areas = std::atomic_load(&view_areas);
+    auto const view_area = areas->find(id);
 
     scene_changed = false;
     mc::SceneElementSequence elements;
-    for (auto const& surface : surfaces)
+    for (size_t i = 0; i != stack->surfaces.size(); ++i)
     {
+        auto const& surface = stack->surfaces[i];
         if (surface->visible())
         {
+            if (view_area != areas->end() && !surface->could_appear_in(view_area->second))
+            {
+                // Not on this output: don't snapshot its streams (or have the
+                // compositor acquire their buffers) just to discard them
+                stack->rendering_trackers[i]->occluded_in(id);
+                continue;
+            }
+
             for (auto& renderable : surface->generate_renderables(id))
             {
                 elements.emplace_back(
                     std::make_shared<SurfaceSceneElement>(
                         surface->name(),
                         renderable,
-                        rendering_trackers[surface.get()],
+                        stack->rendering_trackers[i],
                         id));
             }
         }
     }
-    for (auto const& renderable : overlays)
+    for (auto const& renderable : stack->overlays)
     {
         elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
     }
@@ -145,23 +169,20 @@ mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID i
 
 int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
 {
-    RecursiveReadLock lg(guard);
+    auto const stack = snapshot();
 
     int result = scene_changed ? 1 : 0;
-    for (auto const& surface : surfaces)
+    for (size_t i = 0; i != stack->surfaces.size(); ++i)
     {
-        if (surface->visible())
+        auto const& surface = stack->surfaces[i];
+        if (surface->visible() && stack->rendering_trackers[i]->is_exposed_in(id))
         {
-            auto const tracker = rendering_trackers.find(surface.get());
-            if (tracker != rendering_trackers.end() && tracker->second->is_exposed_in(id))
-            {
-                // Note that we ask the surface and not a Renderable.
-                // This is because we don't want to waste time and resources
-                // on a snapshot till we're sure we need it...
-                int ready = surface->buffers_ready_for_compositor(id);
-                if (ready > result)
-                    result = ready;
-            }
+            // Note that we ask the surface and not a Renderable.
+            // This is because we don't want to waste time and resources
+            // on a snapshot till we're sure we need it...
+            int ready = surface->buffers_ready_for_compositor(id);
+            if (ready > result)
+                result = ready;
         }
     }
     return result;
@@ -169,28 +190,49 @@ int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
 
 void ms::SurfaceStack::register_compositor(mc::CompositorID cid)
 {
-    RecursiveWriteLock lg(guard);
+    std::lock_guard<decltype(writer_mutex)> lg(writer_mutex);
 
     registered_compositors.insert(cid);
 
-    update_rendering_tracker_compositors();
+    for (auto const& tracker : current->rendering_trackers)
+        tracker->active_compositors(registered_compositors);
 }
 
 void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
 {
-    RecursiveWriteLock lg(guard);
+    std::lock_guard<decltype(writer_mutex)> lg(writer_mutex);
 
     registered_compositors.erase(cid);
 
-    update_rendering_tracker_compositors();
+    for (auto const& tracker : current->rendering_trackers)
+        tracker->active_compositors(registered_compositors);
+
+    if (view_areas->count(cid))
+    {
+        auto next = std::make_shared<ViewAreas>(*view_areas);
+        next->erase(cid);
+        std::atomic_store(&view_areas, std::shared_ptr<ViewAreas const>{next});
+    }
+}
+
+void ms::SurfaceStack::set_view_area(mc::CompositorID cid, geom::Rectangle const& view_area)
+{
+    std::lock_guard<decltype(writer_mutex)> lg(writer_mutex);
+
+    auto next = std::make_shared<ViewAreas>(*view_areas);
+    (*next)[cid] = view_area;
+    std::atomic_store(&view_areas, std::shared_ptr<ViewAreas const>{next});
 }
 
 void ms::SurfaceStack::add_input_visualization(
     std::shared_ptr<mg::Renderable> const& overlay)
 {
     {
-        RecursiveWriteLock lg(guard);
-        overlays.push_back(overlay);
+        std::lock_guard<decltype(writer_mutex)> lg(writer_mutex);
+
+        auto next = std::make_shared<Snapshot>(*current);
+        next->overlays.push_back(overlay);
+        publish(next);
     }
     emit_scene_changed();
 }
@@ -200,13 +242,17 @@ void ms::SurfaceStack::remove_input_visualization(
 {
     auto overlay = weak_overlay.lock();
     {
-        RecursiveWriteLock lg(guard);
-        auto const p = std::find(overlays.begin(), overlays.end(), overlay);
-        if (p == overlays.end())
+        std::lock_guard<decltype(writer_mutex)> lg(writer_mutex);
+
+        auto const p = std::find(current->overlays.begin(), current->overlays.end(), overlay);
+        if (p == current->overlays.end())
         {
             BOOST_THROW_EXCEPTION(std::runtime_error("Attempt to remove an overlay which was never added or which has been previously removed"));
         }
-        overlays.erase(p);
+
+        auto next = std::make_shared<Snapshot>(*current);
+        next->overlays.erase(next->overlays.begin() + (p - current->overlays.begin()));
+        publish(next);
     }
     
     emit_scene_changed();
@@ -214,10 +260,7 @@ void ms::SurfaceStack::remove_input_visualization(
 
 void ms::SurfaceStack::emit_scene_changed()
 {
-    {
-        RecursiveWriteLock lg(guard);
-        scene_changed = true;
-    }
+    scene_changed = true;
     observers.scene_changed();
 }
 
@@ -226,9 +269,15 @@ void ms::SurfaceStack::add_surface(
     mi::InputReceptionMode input_mode)
 {
     {
-        RecursiveWriteLock lg(guard);
-        surfaces.push_back(surface);
-        create_rendering_tracker_for(surface);
+        std::lock_guard<decltype(writer_mutex)> lg(writer_mutex);
+
+        auto const tracker = std::make_shared<RenderingTracker>(surface);
+        tracker->active_compositors(registered_compositors);
+
+        auto next = std::make_shared<Snapshot>(*current);
+        next->surfaces.push_back(surface);
+        next->rendering_trackers.push_back(tracker);
+        publish(next);
     }
     surface->set_reception_mode(input_mode);
     observers.surface_added(surface.get());
@@ -242,14 +291,20 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
 
     bool found_surface = false;
     {
-        RecursiveWriteLock lg(guard);
+        std::lock_guard<decltype(writer_mutex)> lg(writer_mutex);
 
+        auto const& surfaces = current->surfaces;
         auto const surface = std::find(surfaces.begin(), surfaces.end(), keep_alive);
 
         if (surface != surfaces.end())
         {
-            surfaces.erase(surface);
-            rendering_trackers.erase(keep_alive.get());
+            auto const index = surface - surfaces.begin();
+
+            auto next = std::make_shared<Snapshot>(*current);
+            next->surfaces.erase(next->surfaces.begin() + index);
+            next->rendering_trackers.erase(next->rendering_trackers.begin() + index);
+            publish(next);
+
             found_surface = true;
         }
     }
@@ -279,8 +334,8 @@ InReverse<Container> in_reverse(Container& container) { return InReverse<Contain
 auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 -> std::shared_ptr<Surface>
 {
-    RecursiveReadLock lg(guard);
-    for (auto const& surface : in_reverse(surfaces))
+    auto const stack = snapshot();
+    for (auto const& surface : in_reverse(stack->surfaces))
     {
         // TODO There's a lack of clarity about how the input area will
         // TODO be maintained and whether this test will detect clicks on
@@ -295,8 +350,8 @@ auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 
 void ms::SurfaceStack::for_each(std::function<void(std::shared_ptr<mi::Surface> const&)> const& callback)
 {
-    RecursiveReadLock lg(guard);
-    for (auto &surface : surfaces)
+    auto const stack = snapshot();
+    for (auto &surface : stack->surfaces)
     {
         callback(surface);
     }
@@ -309,13 +364,23 @@ void ms::SurfaceStack::raise(std::weak_ptr<Surface> const& s)
     {
         auto const surface = s.lock();
 
-        RecursiveWriteLock ul(guard);
+        std::lock_guard<decltype(writer_mutex)> lg(writer_mutex);
+
+        auto const& surfaces = current->surfaces;
         auto const p = std::find(surfaces.begin(), surfaces.end(), surface);
 
         if (p != surfaces.end())
         {
-            surfaces.erase(p);
-            surfaces.push_back(surface);
+            auto const index = p - surfaces.begin();
+            auto next = std::make_shared<Snapshot>(*current);
+
+            std::rotate(next->surfaces.begin() + index, next->surfaces.begin() + index + 1, next->surfaces.end());
+            std::rotate(
+                next->rendering_trackers.begin() + index,
+                next->rendering_trackers.begin() + index + 1,
+                next->rendering_trackers.end());
+
+            publish(next);
             surfaces_reordered = true;
         }
     }
@@ -331,45 +396,46 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
 {
     bool surfaces_reordered{false};
     {
-        RecursiveWriteLock ul(guard);
+        std::lock_guard<decltype(writer_mutex)> lg(writer_mutex);
+
+        auto const& old_surfaces = current->surfaces;
 
-        auto const old_surfaces = surfaces;
-        std::stable_partition(
-            begin(surfaces), end(surfaces),
-            [&](std::weak_ptr<Surface> const& s) { return !ss.count(s); });
+        auto next = std::make_shared<Snapshot>();
+        next->overlays = current->overlays;
+        next->surfaces.reserve(old_surfaces.size());
+        next->rendering_trackers.reserve(old_surfaces.size());
 
-        if (old_surfaces != surfaces)
+        // Those not being raised keep their order below those that are
+        for (auto const raised : {false, true})
+        {
+            for (size_t i = 0; i != old_surfaces.size(); ++i)
+            {
+                if (ss.count(old_surfaces[i]) == (raised ? 1u : 0u))
+                {
+                    next->surfaces.push_back(old_surfaces[i]);
+                    next->rendering_trackers.push_back(current->rendering_trackers[i]);
+                }
+            }
+        }
+
+        if (next->surfaces != old_surfaces)
+        {
+            publish(next);
             surfaces_reordered = true;
+        }
     }
 
     if (surfaces_reordered)
         observers.surfaces_reordered();
 }
 
-void ms::SurfaceStack::create_rendering_tracker_for(std::shared_ptr<Surface> const& surface)
-{
-    auto const tracker = std::make_shared<RenderingTracker>(surface);
-
-    RecursiveWriteLock ul(guard);
-    tracker->active_compositors(registered_compositors);
-    rendering_trackers[surface.get()] = tracker;
-}
-
-void ms::SurfaceStack::update_rendering_tracker_compositors()
-{
-    RecursiveReadLock ul(guard);
-
-    for (auto const& pair : rendering_trackers)
-        pair.second->active_compositors(registered_compositors);
-}
-
 void ms::SurfaceStack::add_observer(std::shared_ptr<ms::Observer> const& observer)
 {
     observers.add(observer);
 
     // Notify observer of existing surfaces
-    RecursiveReadLock lk(guard);
-    for (auto &surface : surfaces)
+    auto const stack = snapshot();
+    for (auto &surface : stack->surfaces)
     {
         observer->surface_exists(surface.get());
     }
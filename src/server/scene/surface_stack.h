@@ -24,7 +24,6 @@
 #include "mir/compositor/scene.h"
 #include "mir/scene/observer.h"
 #include "mir/input/scene.h"
-#include "mir/recursive_read_write_mutex.h"
 
 #include "mir/basic_observers.h"
 
@@ -76,6 +75,7 @@ public:
     int frames_pending(compositor::CompositorID) const override;
     void register_compositor(compositor::CompositorID id) override;
     void unregister_compositor(compositor::CompositorID id) override;
+    void set_view_area(compositor::CompositorID id, geometry::Rectangle const& view_area) override;
 
     // From Scene
     void for_each(std::function<void(std::shared_ptr<input::Surface> const&)> const& callback) override;
@@ -104,18 +104,31 @@ public:
 private:
     SurfaceStack(const SurfaceStack&) = delete;
     SurfaceStack& operator=(const SurfaceStack&) = delete;
-    void create_rendering_tracker_for(std::shared_ptr<Surface> const&);
-    void update_rendering_tracker_compositors();
 
-    RecursiveReadWriteMutex mutable guard;
+    /// An immutable view of the stack, replaced wholesale on each change
+    struct Snapshot
+    {
+        std::vector<std::shared_ptr<Surface>> surfaces;
+        /// The tracker of each of surfaces, in the same order
+        std::vector<std::shared_ptr<RenderingTracker>> rendering_trackers;
+        std::vector<std::shared_ptr<graphics::Renderable>> overlays;
+    };
+
+    std::shared_ptr<Snapshot const> snapshot() const;
+    /// Requires writer_mutex
+    void publish(std::shared_ptr<Snapshot const> const& next);
 
     std::shared_ptr<SceneReport> const report;
 
-    std::vector<std::shared_ptr<Surface>> surfaces;
-    std::map<Surface*,std::shared_ptr<RenderingTracker>> rendering_trackers;
+    // Readers take a reference to the current snapshot and never wait; writers
+    // are serialised by writer_mutex and publish a modified copy.
+    std::mutex writer_mutex;
+    std::shared_ptr<Snapshot const> current;
     std::set<compositor::CompositorID> registered_compositors;
-    
-    std::vector<std::shared_ptr<graphics::Renderable>> overlays;
+
+    // Published the same way as the stack
+    using ViewAreas = std::map<compositor::CompositorID, geometry::Rectangle>;
+    std::shared_ptr<ViewAreas const> view_areas;
 
     Observers observers;
     std::atomic<bool> scene_changed;
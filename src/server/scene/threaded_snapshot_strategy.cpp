@@ -19,11 +19,16 @@
 #include "threaded_snapshot_strategy.h"
 #include "pixel_buffer.h"
 #include "mir/compositor/buffer_stream.h"
+#include "mir/graphics/buffer.h"
 #include "mir/thread_name.h"
 
+#include <algorithm>
+#include <chrono>
 #include <deque>
 #include <mutex>
 #include <condition_variable>
+#include <unordered_map>
+#include <vector>
 
 namespace geom = mir::geometry;
 namespace ms = mir::scene;
@@ -37,8 +42,35 @@ struct WorkItem
 {
     std::shared_ptr<compositor::BufferStream> const stream;
     ms::SnapshotCallback const snapshot_taken;
+    bool const thumbnail;
+    geom::Size const thumbnail_size;
 };
 
+struct CachedThumbnail
+{
+    std::weak_ptr<compositor::BufferStream> stream;
+    uint64_t frames_submitted;
+    mir::graphics::BufferID buffer_id;
+    geom::Size requested_size;
+    geom::Size size;
+    geom::Stride stride;
+    std::vector<char> pixels;
+};
+
+/// A thumbnail whose read back has been started but not finished
+struct PendingThumbnail
+{
+    WorkItem work;
+    uint64_t frames_submitted;
+    mir::graphics::BufferID buffer_id;
+};
+
+/*
+ * How long an outstanding read back is left for the GPU to finish while
+ * there is no other work to overlap it with
+ */
+std::chrono::milliseconds const readback_grace{4};
+
 class SnapshottingFunctor
 {
 public:
@@ -54,6 +86,19 @@ public:
 
         while (running)
         {
+            if (!pending_thumbnails.empty())
+            {
+                work_cv.wait_for(lock, readback_grace, [this] { return !running || !work.empty(); });
+
+                if (work.empty())
+                {
+                    lock.unlock();
+                    finish_pending_thumbnails(0);
+                    lock.lock();
+                    continue;
+                }
+            }
+
             while (running && work.empty())
                 work_cv.wait(lock);
 
@@ -64,7 +109,10 @@ public:
 
                 lock.unlock();
 
-                take_snapshot(wi);
+                if (wi.thumbnail)
+                    take_thumbnail(wi);
+                else
+                    take_snapshot(wi);
 
                 lock.lock();
             }
@@ -73,6 +121,8 @@ public:
 
     void take_snapshot(WorkItem const& wi)
     {
+        finish_pending_thumbnails(0);
+
         wi.stream->with_most_recent_buffer_do([this](mir::graphics::Buffer& buffer) {
             pixels->fill_from(buffer);
         });
@@ -83,6 +133,95 @@ public:
                      pixels->as_argb_8888()});
     }
 
+    void take_thumbnail(WorkItem const& wi)
+    {
+        auto existing = thumbnails.find(wi.stream.get());
+        if (existing == thumbnails.end() || existing->second.stream.lock() != wi.stream)
+        {
+            // A new stream, or a new one at the address of an (expired) old one
+            drop_expired_thumbnails();
+            existing = thumbnails.emplace(wi.stream.get(), CachedThumbnail{wi.stream, 0, {}, {}, {}, {}, {}}).first;
+        }
+        auto& cached = existing->second;
+
+        // Read before the buffer so that, if we race with a submission, the next request refreshes
+        auto const frames_submitted = wi.stream->frames_submitted();
+
+        bool started{false};
+        wi.stream->with_most_recent_buffer_do([&](mir::graphics::Buffer& buffer)
+            {
+                if (!cached.pixels.empty() &&
+                    cached.frames_submitted == frames_submitted &&
+                    cached.buffer_id == buffer.id() &&
+                    cached.requested_size == wi.thumbnail_size)
+                {
+                    return;
+                }
+
+                if (pixels->begin_fill_from(buffer, wi.thumbnail_size))
+                {
+                    pending_thumbnails.push_back(PendingThumbnail{wi, frames_submitted, buffer.id()});
+                    started = true;
+                    return;
+                }
+
+                pixels->fill_from(buffer, wi.thumbnail_size);
+                cache_pixels(cached, frames_submitted, buffer.id(), wi.thumbnail_size);
+            });
+
+        /*
+         * Any earlier read back has had as long as it took to start this one,
+         * so wait for it now and leave this one in flight.
+         */
+        finish_pending_thumbnails(started ? 1 : 0);
+
+        if (!started)
+            wi.snapshot_taken(ms::Snapshot{cached.size, cached.stride, cached.pixels.data()});
+    }
+
+    void finish_pending_thumbnails(size_t leave_in_flight)
+    {
+        while (pending_thumbnails.size() > leave_in_flight)
+        {
+            auto const pending = pending_thumbnails.front();
+            pending_thumbnails.pop_front();
+
+            pixels->end_fill();
+
+            // The work item keeps the stream, and so its cache entry, alive
+            auto& cached = thumbnails.at(pending.work.stream.get());
+            cache_pixels(cached, pending.frames_submitted, pending.buffer_id, pending.work.thumbnail_size);
+
+            pending.work.snapshot_taken(ms::Snapshot{cached.size, cached.stride, cached.pixels.data()});
+        }
+    }
+
+    void cache_pixels(
+        CachedThumbnail& cached,
+        uint64_t frames_submitted,
+        mir::graphics::BufferID buffer_id,
+        geom::Size const& requested_size)
+    {
+        auto const data = static_cast<char const*>(pixels->as_argb_8888());
+        cached.frames_submitted = frames_submitted;
+        cached.buffer_id = buffer_id;
+        cached.requested_size = requested_size;
+        cached.size = pixels->size();
+        cached.stride = pixels->stride();
+        cached.pixels.assign(data, data + cached.stride.as_int() * cached.size.height.as_int());
+    }
+
+    void drop_expired_thumbnails()
+    {
+        for (auto i = thumbnails.begin(); i != thumbnails.end();)
+        {
+            if (i->second.stream.expired())
+                i = thumbnails.erase(i);
+            else
+                ++i;
+        }
+    }
+
     void schedule_snapshot(WorkItem const& wi)
     {
         std::lock_guard<std::mutex> lg{work_mutex};
@@ -103,6 +242,10 @@ private:
     std::mutex work_mutex;
     std::condition_variable work_cv;
     std::deque<WorkItem> work;
+
+    // Only touched on the snapshot thread
+    std::unordered_map<compositor::BufferStream const*, CachedThumbnail> thumbnails;
+    std::deque<PendingThumbnail> pending_thumbnails;
 };
 
 }
@@ -126,5 +269,13 @@ void ms::ThreadedSnapshotStrategy::take_snapshot_of(
     std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
     SnapshotCallback const& snapshot_taken)
 {
-    functor->schedule_snapshot(WorkItem{surface_buffer_access, snapshot_taken});
+    functor->schedule_snapshot(WorkItem{surface_buffer_access, snapshot_taken, false, {}});
+}
+
+void ms::ThreadedSnapshotStrategy::take_thumbnail_of(
+    std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
+    geometry::Size const& size,
+    SnapshotCallback const& thumbnail_taken)
+{
+    functor->schedule_snapshot(WorkItem{surface_buffer_access, thumbnail_taken, true, size});
 }
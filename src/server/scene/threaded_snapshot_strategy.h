@@ -42,6 +42,20 @@ public:
         std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
         SnapshotCallback const& snapshot_taken);
 
+    /**
+     * Thumbnails are scaled by the PixelBuffer and cached per stream; a
+     * thumbnail of a stream that hasn't had a frame submitted since the
+     * last one of the same size is served from the cache.
+     *
+     * Where the PixelBuffer can read back asynchronously, a new thumbnail's
+     * read back is left in flight while the one before it is finished, and
+     * thumbnail_taken is called once its read back is.
+     */
+    void take_thumbnail_of(
+        std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
+        geometry::Size const& size,
+        SnapshotCallback const& thumbnail_taken);
+
 private:
     std::shared_ptr<PixelBuffer> const pixels;
     std::unique_ptr<SnapshottingFunctor> functor;
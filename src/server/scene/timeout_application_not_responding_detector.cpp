@@ -21,22 +21,36 @@
 #include "mir/scene/session.h"
 
 #include "mir/time/alarm_factory.h"
+#include "mir/time/clock.h"
 
 namespace ms = mir::scene;
 namespace mt = mir::time;
 
+namespace
+{
+// Sessions due within 1/buckets_per_period of each other are checked together
+int const buckets_per_period = 8;
+}
+
 struct ms::TimeoutApplicationNotRespondingDetector::ANRContext
 {
     ANRContext(std::function<void()> const& pinger)
         : pinger{pinger},
           replied_since_last_ping{true},
-          flagged_as_unresponsive{false}
+          flagged_as_unresponsive{false},
+          active_since_last_check{std::make_shared<std::atomic<bool>>(false)},
+          queued{false},
+          serial{0}
     {
     }
 
     std::function<void()> const pinger;
     bool replied_since_last_ping;
     bool flagged_as_unresponsive;
+    /// Set by the activity notifier, read and cleared when the session is checked
+    std::shared_ptr<std::atomic<bool>> const active_since_last_check;
+    bool queued;
+    uint64_t serial;    ///< Identifies the current entry in buckets; any others are stale
 };
 
 void ms::TimeoutApplicationNotRespondingDetector::ANRObservers::session_unresponsive(
@@ -53,8 +67,11 @@ void ms::TimeoutApplicationNotRespondingDetector::ANRObservers::session_now_resp
 
 ms::TimeoutApplicationNotRespondingDetector::TimeoutApplicationNotRespondingDetector(
     mt::AlarmFactory& alarms,
+    std::shared_ptr<mt::Clock> const& clock,
     std::chrono::milliseconds period)
-    : period{period},
+    : clock{clock},
+      period{period},
+      bucket_width{period / buckets_per_period},
       alarm{alarms.create_alarm(std::bind(&TimeoutApplicationNotRespondingDetector::handle_ping_cycle, this))}
 {
 }
@@ -66,15 +83,21 @@ ms::TimeoutApplicationNotRespondingDetector::~TimeoutApplicationNotRespondingDet
 void ms::TimeoutApplicationNotRespondingDetector::register_session(
     frontend::Session const* session, std::function<void()> const& pinger)
 {
+    auto const scene_session = dynamic_cast<Session const*>(session);
     bool alarm_needs_schedule;
+    mt::Timestamp first_due;
     {
         std::lock_guard<std::mutex> lock{session_mutex};
-        sessions[dynamic_cast<Session const*>(session)] = std::make_unique<ANRContext>(pinger);
-        alarm_needs_schedule = alarm->state() != mt::Alarm::State::pending;
+        auto& context = sessions[scene_session];
+        context = std::make_unique<ANRContext>(pinger);
+        alarm_needs_schedule =
+            enqueue(scene_session, *context, clock->now() + period) ||
+            alarm->state() != mt::Alarm::State::pending;
+        first_due = buckets.begin()->first;
     }
     if (alarm_needs_schedule)
     {
-        alarm->reschedule_in(period);
+        alarm->reschedule_for(first_due);
     }
 }
 
@@ -82,37 +105,116 @@ void ms::TimeoutApplicationNotRespondingDetector::unregister_session(
     frontend::Session const* session)
 {
     std::lock_guard<std::mutex> lock{session_mutex};
+    // Any queued entry is discarded when its bucket comes due
     sessions.erase(dynamic_cast<Session const*>(session));
 }
 
 void ms::TimeoutApplicationNotRespondingDetector::pong_received(
    frontend::Session const* received_for)
 {
+    auto const session = dynamic_cast<Session const*>(received_for);
     bool needs_now_responsive_notification{false};
-    bool alarm_needs_rescheduling;
+    bool alarm_needs_rescheduling{false};
+    mt::Timestamp first_due;
     {
         std::lock_guard<std::mutex> lock{session_mutex};
 
-        auto& session_ctx = sessions.at(dynamic_cast<Session const*>(received_for));
-        if (session_ctx->flagged_as_unresponsive)
+        auto& session_ctx = *sessions.at(session);
+        if (session_ctx.flagged_as_unresponsive)
         {
-            session_ctx->flagged_as_unresponsive = false;
+            session_ctx.flagged_as_unresponsive = false;
             needs_now_responsive_notification = true;
         }
-        session_ctx->replied_since_last_ping = true;
+        session_ctx.replied_since_last_ping = true;
 
-        alarm_needs_rescheduling = alarm->state() != mt::Alarm::State::pending;
+        if (!session_ctx.queued)
+        {
+            alarm_needs_rescheduling =
+                enqueue(session, session_ctx, clock->now() + period) ||
+                alarm->state() != mt::Alarm::State::pending;
+            first_due = buckets.begin()->first;
+        }
     }
     if (needs_now_responsive_notification)
     {
-        observers.session_now_responsive(dynamic_cast<Session const*>(received_for));
+        observers.session_now_responsive(session);
     }
     if (alarm_needs_rescheduling)
     {
-        alarm->reschedule_in(period);
+        alarm->reschedule_for(first_due);
     }
 }
 
+std::function<void()> ms::TimeoutApplicationNotRespondingDetector::activity_notifier(
+    frontend::Session const* session)
+{
+    auto const scene_session = dynamic_cast<Session const*>(session);
+
+    std::lock_guard<std::mutex> lock{session_mutex};
+    auto const found = sessions.find(scene_session);
+    if (found == sessions.end())
+        return []{};
+
+    auto const active = found->second->active_since_last_check;
+    return [this, scene_session, active]
+        {
+            // Only the first message since the session was last checked has
+            // anything to report, and only if it was flagged as unresponsive:
+            // otherwise the flag is picked up when the session is next due.
+            if (!active->exchange(true, std::memory_order_relaxed))
+                unresponsive_session_active(scene_session, active.get());
+        };
+}
+
+void ms::TimeoutApplicationNotRespondingDetector::unresponsive_session_active(
+    Session const* session, std::atomic<bool> const* active_flag)
+{
+    bool alarm_needs_rescheduling{false};
+    mt::Timestamp first_due;
+    {
+        std::lock_guard<std::mutex> lock{session_mutex};
+
+        auto const found = sessions.find(session);
+        // Ignore sessions that have been unregistered (and any new session at the same address)
+        if (found == sessions.end() || found->second->active_since_last_check.get() != active_flag)
+            return;
+
+        auto& session_ctx = *found->second;
+        if (!session_ctx.flagged_as_unresponsive)
+            return;
+
+        session_ctx.flagged_as_unresponsive = false;
+        session_ctx.replied_since_last_ping = true;
+        session_ctx.active_since_last_check->store(false, std::memory_order_relaxed);
+
+        alarm_needs_rescheduling =
+            enqueue(session, session_ctx, clock->now() + period) ||
+            alarm->state() != mt::Alarm::State::pending;
+        first_due = buckets.begin()->first;
+    }
+    observers.session_now_responsive(session);
+    if (alarm_needs_rescheduling)
+    {
+        alarm->reschedule_for(first_due);
+    }
+}
+
+bool ms::TimeoutApplicationNotRespondingDetector::enqueue(
+    Session const* session, ANRContext& context, mt::Timestamp due)
+{
+    auto bucket = buckets.lower_bound(due);
+    if (bucket == buckets.end() || bucket->first >= due + bucket_width)
+    {
+        bucket = buckets.emplace_hint(bucket, due, std::vector<QueuedSession>{});
+    }
+
+    context.queued = true;
+    context.serial = next_serial++;
+    bucket->second.push_back(QueuedSession{session, context.serial});
+
+    return bucket == buckets.begin();
+}
+
 void ms::TimeoutApplicationNotRespondingDetector::register_observer(
     std::shared_ptr<Observer> const& observer)
 {
@@ -145,28 +247,56 @@ void ms::TimeoutApplicationNotRespondingDetector::unregister_observer(
 void ms::TimeoutApplicationNotRespondingDetector::handle_ping_cycle()
 {
     bool needs_rearm{false};
+    mt::Timestamp first_due;
     {
         std::lock_guard<std::mutex> lock{session_mutex};
-        for (auto const& session_pair : sessions)
+        auto const now = clock->now();
+
+        // Only the buckets that are due are touched, not every session
+        while (!buckets.empty() && buckets.begin()->first <= now)
         {
-            bool const newly_unresponsive =
-                !session_pair.second->replied_since_last_ping &&
-                !session_pair.second->flagged_as_unresponsive;
-            bool const needs_ping =
-                session_pair.second->replied_since_last_ping;
+            auto const due = buckets.begin()->first;
+            auto const bucket = std::move(buckets.begin()->second);
+            buckets.erase(buckets.begin());
 
-            if (newly_unresponsive)
-            {
-                session_pair.second->flagged_as_unresponsive = true;
-                unresponsive_sessions_temporary.push_back(session_pair.first);
-            }
-            else if (needs_ping)
+            // If we're running more than a period late, don't try to catch up
+            auto const next_due = due + period > now ? due + period : now + period;
+
+            for (auto const& queued : bucket)
             {
-                session_pair.second->pinger();
-                session_pair.second->replied_since_last_ping = false;
-                needs_rearm = true;
+                auto const found = sessions.find(queued.session);
+                if (found == sessions.end() || found->second->serial != queued.serial)
+                    continue;
+
+                auto& session_ctx = *found->second;
+                session_ctx.queued = false;
+
+                if (session_ctx.active_since_last_check->exchange(false, std::memory_order_relaxed))
+                {
+                    // The client has been talking to us; no need to ask if it's alive
+                    session_ctx.replied_since_last_ping = true;
+                    enqueue(queued.session, session_ctx, next_due);
+                }
+                else if (!session_ctx.replied_since_last_ping)
+                {
+                    // It won't be queued again until it responds
+                    session_ctx.flagged_as_unresponsive = true;
+                    unresponsive_sessions_temporary.push_back(queued.session);
+                }
+                else
+                {
+                    session_ctx.pinger();
+                    session_ctx.replied_since_last_ping = false;
+                    enqueue(queued.session, session_ctx, next_due);
+                }
             }
         }
+
+        needs_rearm = !buckets.empty();
+        if (needs_rearm)
+        {
+            first_due = buckets.begin()->first;
+        }
     }
 
     // Dispatch notifications outside the lock.
@@ -179,6 +309,6 @@ void ms::TimeoutApplicationNotRespondingDetector::handle_ping_cycle()
 
     if (needs_rearm)
     {
-        this->alarm->reschedule_in(this->period);
+        this->alarm->reschedule_for(first_due);
     }
 }
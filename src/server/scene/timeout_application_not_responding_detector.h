@@ -21,10 +21,16 @@
 
 #include "mir/scene/application_not_responding_detector.h"
 #include "mir/basic_observers.h"
+#include "mir/time/types.h"
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
 #include <unordered_map>
 #include <functional>
+#include <vector>
 
 namespace mir
 {
@@ -32,22 +38,34 @@ namespace time
 {
 class Alarm;
 class AlarmFactory;
+class Clock;
 }
 
 namespace scene
 {
+/**
+ * Pings each session once a period, flagging it unresponsive if it has not
+ * replied by the time its next ping is due.
+ *
+ * Sessions are queued in buckets by when they are next due, so each wakeup
+ * only touches the sessions due then. Sessions that have sent traffic since
+ * they were last checked are not pinged at all; the traffic only sets a
+ * per-session flag, which is read and cleared when the session is checked.
+ */
 class TimeoutApplicationNotRespondingDetector : public ApplicationNotRespondingDetector
 {
 public:
     TimeoutApplicationNotRespondingDetector(
         time::AlarmFactory& alarms,
+        std::shared_ptr<time::Clock> const& clock,
         std::chrono::milliseconds period);
 
     template<typename Rep, typename Period>
     TimeoutApplicationNotRespondingDetector(
         time::AlarmFactory& alarms,
+        std::shared_ptr<time::Clock> const& clock,
         std::chrono::duration<Rep, Period> period)
-        : TimeoutApplicationNotRespondingDetector(alarms,
+        : TimeoutApplicationNotRespondingDetector(alarms, clock,
               std::chrono::duration_cast<std::chrono::milliseconds>(period))
     {
     }
@@ -60,6 +78,7 @@ public:
     void unregister_session(frontend::Session const* session) override;
 
     void pong_received(frontend::Session const* received_for) override;
+    std::function<void()> activity_notifier(frontend::Session const* session) override;
 
     void register_observer(std::shared_ptr<Observer> const& observer) override;
     void unregister_observer(std::shared_ptr<Observer> const& observer) override;
@@ -67,6 +86,16 @@ private:
     void handle_ping_cycle();
 
     struct ANRContext;
+    struct QueuedSession
+    {
+        Session const* session;
+        uint64_t serial;
+    };
+    using Buckets = std::map<time::Timestamp, std::vector<QueuedSession>>;
+
+    void unresponsive_session_active(Session const* session, std::atomic<bool> const* active_flag);
+    /// Queues a session to be checked at (or just after) due; returns true if it is now the first due
+    bool enqueue(Session const* session, ANRContext& context, time::Timestamp due);
 
     class ANRObservers : public Observer, private BasicObservers<Observer>
     {
@@ -80,9 +109,14 @@ private:
 
     std::mutex session_mutex;
     std::unordered_map<Session const*, std::unique_ptr<ANRContext>> sessions;
+    Buckets buckets;
+    uint64_t next_serial{0};
     std::vector<Session const*> unresponsive_sessions_temporary;
 
+    std::shared_ptr<time::Clock> const clock;
     std::chrono::milliseconds const period;
+    /// Sessions due within this of a bucket are checked with it
+    std::chrono::milliseconds const bucket_width;
     std::unique_ptr<time::Alarm> const alarm;
 };
 }
@@ -0,0 +1,507 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/time/timer_wheel_alarm_factory.h"
+#include "mir/time/clock.h"
+#include "mir/lockable_callback.h"
+#include "mir/basic_callback.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace mt = mir::time;
+namespace md = mir::dispatch;
+
+/*
+ * A classic hierarchical timer wheel: four levels of 256 slots, each level
+ * covering 256 times the span of the one below. Alarms are placed on the
+ * lowest level whose span covers their delay and cascade down a level each
+ * time the level below wraps, so each alarm is touched at most four times
+ * between being scheduled and triggering.
+ */
+class mt::TimerWheelAlarmFactory::Wheel
+{
+public:
+    struct Entry : std::enable_shared_from_this<Entry>
+    {
+        explicit Entry(std::unique_ptr<LockableCallback> callback)
+            : callback{std::move(callback)}
+        {
+        }
+
+        std::unique_ptr<LockableCallback> const callback;
+
+        // Held while the callback runs, so that destroying the alarm can
+        // wait for an in-progress callback to complete
+        std::recursive_mutex dispatch_mutex;
+
+        // The following are protected by Wheel::mutex
+        Alarm::State state{Alarm::State::cancelled};
+        uint64_t generation{0};
+        uint64_t expiry_tick{0};
+        Entry* prev{nullptr};
+        Entry* next{nullptr};
+        Entry** slot{nullptr};
+        unsigned int level{0};
+    };
+
+    Wheel(std::shared_ptr<Clock> const& clock, std::chrono::nanoseconds resolution);
+
+    void schedule(Entry& entry, Timestamp when);
+    void unschedule(Entry& entry);
+    void fire_expired();
+
+    std::shared_ptr<Clock> const clock;
+    Fd const timer_fd;
+    std::mutex mutable mutex;
+    size_t pending{0};
+
+private:
+    static unsigned int const level_bits = 8;
+    static unsigned int const levels = 4;
+    static uint64_t const slots_per_level = uint64_t{1} << level_bits;
+    static uint64_t const slot_mask = slots_per_level - 1;
+    static uint64_t const max_delta = (uint64_t{1} << (level_bits * levels)) - 1;
+    static uint64_t const not_armed = ~uint64_t{0};
+
+    struct Expired
+    {
+        std::shared_ptr<Entry> entry;
+        uint64_t generation;
+    };
+
+    uint64_t tick_at_or_after(Timestamp t) const;
+    uint64_t tick_at_or_before(Timestamp t) const;
+    Timestamp time_of(uint64_t tick) const;
+
+    void link(Entry& entry);
+    void unlink(Entry& entry);
+    unsigned int cascade(unsigned int level, unsigned int index);
+    void advance_to(uint64_t target, std::vector<Expired>& expired);
+    uint64_t next_wakeup() const;
+    uint64_t next_cascade() const;
+    void arm(uint64_t tick);
+
+    std::chrono::nanoseconds const resolution;
+    Timestamp const origin;
+
+    // The next tick to be processed
+    uint64_t current_tick{0};
+    uint64_t armed_tick{not_armed};
+    std::array<std::array<Entry*, slots_per_level>, levels> slots{};
+    // Alarms scheduled for a tick we've already processed; they're
+    // counted as an extra level
+    Entry* overdue{nullptr};
+    std::array<size_t, levels + 1> level_count{};
+};
+
+namespace
+{
+mir::Fd create_timer_fd()
+{
+    int const fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create timerfd"}));
+    }
+    return mir::Fd{fd};
+}
+}
+
+mt::TimerWheelAlarmFactory::Wheel::Wheel(std::shared_ptr<Clock> const& clock, std::chrono::nanoseconds resolution)
+    : clock{clock},
+      timer_fd{create_timer_fd()},
+      resolution{resolution},
+      origin{clock->now()}
+{
+}
+
+uint64_t mt::TimerWheelAlarmFactory::Wheel::tick_at_or_after(Timestamp t) const
+{
+    if (t <= origin)
+        return 0;
+
+    auto const since_origin = std::chrono::duration_cast<std::chrono::nanoseconds>(t - origin);
+    return (since_origin.count() + resolution.count() - 1) / resolution.count();
+}
+
+uint64_t mt::TimerWheelAlarmFactory::Wheel::tick_at_or_before(Timestamp t) const
+{
+    if (t <= origin)
+        return 0;
+
+    auto const since_origin = std::chrono::duration_cast<std::chrono::nanoseconds>(t - origin);
+    return since_origin.count() / resolution.count();
+}
+
+mt::Timestamp mt::TimerWheelAlarmFactory::Wheel::time_of(uint64_t tick) const
+{
+    return origin + std::chrono::duration_cast<Duration>(resolution * tick);
+}
+
+void mt::TimerWheelAlarmFactory::Wheel::link(Entry& entry)
+{
+    auto level = levels;
+    auto head_ptr = &overdue;
+
+    // Alarms in the past are due on the next dispatch, even if the clock
+    // hasn't reached the next tick; those too far in the future go as far
+    // out as we can and get rescheduled when they reach the bottom.
+    if (entry.expiry_tick >= current_tick)
+    {
+        auto const delta = entry.expiry_tick - current_tick;
+        auto const expires = current_tick + (delta > max_delta ? max_delta : delta);
+
+        level = 0;
+        while (level + 1 < levels && (expires - current_tick) >= (uint64_t{1} << (level_bits * (level + 1))))
+            ++level;
+
+        head_ptr = &slots[level][(expires >> (level_bits * level)) & slot_mask];
+    }
+
+    auto& head = *head_ptr;
+
+    entry.prev = nullptr;
+    entry.next = head;
+    if (head)
+        head->prev = &entry;
+    head = &entry;
+    entry.slot = &head;
+    entry.level = level;
+
+    ++level_count[level];
+    ++pending;
+}
+
+void mt::TimerWheelAlarmFactory::Wheel::unlink(Entry& entry)
+{
+    if (!entry.slot)
+        return;
+
+    if (entry.prev)
+        entry.prev->next = entry.next;
+    else
+        *entry.slot = entry.next;
+
+    if (entry.next)
+        entry.next->prev = entry.prev;
+
+    --level_count[entry.level];
+    --pending;
+
+    entry.prev = nullptr;
+    entry.next = nullptr;
+    entry.slot = nullptr;
+}
+
+void mt::TimerWheelAlarmFactory::Wheel::schedule(Entry& entry, Timestamp when)
+{
+    unlink(entry);
+
+    entry.state = Alarm::State::pending;
+    ++entry.generation;
+    entry.expiry_tick = tick_at_or_after(when);
+    link(entry);
+
+    // Only touch the timerfd if this alarm needs an earlier wakeup
+    if (armed_tick == not_armed || entry.expiry_tick < armed_tick)
+        arm(next_wakeup());
+}
+
+void mt::TimerWheelAlarmFactory::Wheel::unschedule(Entry& entry)
+{
+    // Leave the timerfd armed; a spurious wakeup is cheaper than rescanning
+    unlink(entry);
+}
+
+unsigned int mt::TimerWheelAlarmFactory::Wheel::cascade(unsigned int level, unsigned int index)
+{
+    auto entry = slots[level][index];
+    while (entry)
+    {
+        auto const next = entry->next;
+        unlink(*entry);
+        link(*entry);
+        entry = next;
+    }
+    return index;
+}
+
+void mt::TimerWheelAlarmFactory::Wheel::advance_to(uint64_t target, std::vector<Expired>& expired)
+{
+    while (auto const entry = overdue)
+    {
+        unlink(*entry);
+        expired.push_back({entry->shared_from_this(), entry->generation});
+    }
+
+    while (current_tick <= target)
+    {
+        if (pending == 0)
+        {
+            current_tick = target + 1;
+            break;
+        }
+
+        unsigned int const index = current_tick & slot_mask;
+
+        if (index == 0 &&
+            cascade(1, (current_tick >> level_bits) & slot_mask) == 0 &&
+            cascade(2, (current_tick >> (2 * level_bits)) & slot_mask) == 0)
+        {
+            cascade(3, (current_tick >> (3 * level_bits)) & slot_mask);
+        }
+
+        if (level_count[0] == 0)
+        {
+            // Nothing on the bottom level; skip to where the next cascade happens
+            current_tick = std::min(target + 1, next_cascade());
+            continue;
+        }
+
+        auto entry = slots[0][index];
+        while (entry)
+        {
+            auto const next = entry->next;
+            unlink(*entry);
+
+            if (entry->expiry_tick > current_tick)
+                link(*entry);
+            else
+                expired.push_back({entry->shared_from_this(), entry->generation});
+
+            entry = next;
+        }
+
+        ++current_tick;
+    }
+}
+
+uint64_t mt::TimerWheelAlarmFactory::Wheel::next_wakeup() const
+{
+    if (pending == 0)
+        return not_armed;
+
+    if (overdue)
+        return current_tick - 1;
+
+    if (level_count[0] != 0)
+    {
+        auto const boundary = (current_tick | slot_mask) + 1;
+        for (auto tick = current_tick; tick != boundary; ++tick)
+        {
+            if (slots[0][tick & slot_mask])
+                return tick;
+        }
+    }
+
+    // Nothing due before the next cascade, at which point we look again
+    return next_cascade();
+}
+
+uint64_t mt::TimerWheelAlarmFactory::Wheel::next_cascade() const
+{
+    // Only a level with something in it can cascade anything down
+    unsigned int level = 1;
+    while (level + 1 < levels && level_count[level - 1] == 0 && level_count[level] == 0)
+        ++level;
+
+    auto const shift = level_bits * level;
+    return ((current_tick >> shift) + 1) << shift;
+}
+
+void mt::TimerWheelAlarmFactory::Wheel::arm(uint64_t tick)
+{
+    itimerspec spec{};
+
+    if (tick != not_armed)
+    {
+        auto const wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            clock->min_wait_until(time_of(tick)));
+
+        // A zero it_value would disarm the timer
+        auto const ns = std::max<std::chrono::nanoseconds::rep>(wait.count(), 1);
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = ns % 1000000000;
+    }
+
+    if (timerfd_settime(timer_fd, 0, &spec, nullptr) < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to arm timerfd"}));
+    }
+
+    armed_tick = tick;
+}
+
+void mt::TimerWheelAlarmFactory::Wheel::fire_expired()
+{
+    std::vector<Expired> expired;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        advance_to(tick_at_or_before(clock->now()), expired);
+        arm(next_wakeup());
+    }
+
+    std::exception_ptr first_error;
+
+    for (auto const& candidate : expired)
+    {
+        auto& entry = *candidate.entry;
+        try
+        {
+            // Preserve lock ordering: the caller's lock before our own
+            std::lock_guard<LockableCallback> handler_lock{*entry.callback};
+            std::lock_guard<std::recursive_mutex> dispatch_lock{entry.dispatch_mutex};
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+
+                // Cancelled, rescheduled or destroyed since we collected it
+                if (entry.state != Alarm::State::pending || entry.generation != candidate.generation)
+                    continue;
+
+                entry.state = Alarm::State::triggered;
+            }
+            (*entry.callback)();
+        }
+        catch (...)
+        {
+            // Don't let one failing callback lose the remaining alarms
+            if (!first_error)
+                first_error = std::current_exception();
+        }
+    }
+
+    if (first_error)
+        std::rethrow_exception(first_error);
+}
+
+class mt::TimerWheelAlarmFactory::AlarmImpl : public Alarm
+{
+public:
+    AlarmImpl(std::shared_ptr<Wheel> const& wheel, std::unique_ptr<LockableCallback> callback)
+        : wheel{wheel},
+          entry{std::make_shared<Wheel::Entry>(std::move(callback))}
+    {
+    }
+
+    ~AlarmImpl() override
+    {
+        // Wait for any in-progress callback (unless we're called from it)
+        std::lock_guard<std::recursive_mutex> dispatch_lock{entry->dispatch_mutex};
+        std::lock_guard<std::mutex> lock{wheel->mutex};
+        wheel->unschedule(*entry);
+        entry->state = State::cancelled;
+        ++entry->generation;
+    }
+
+    bool cancel() override
+    {
+        // Don't return while the callback is running (unless we're called from it)
+        std::lock_guard<std::recursive_mutex> dispatch_lock{entry->dispatch_mutex};
+        std::lock_guard<std::mutex> lock{wheel->mutex};
+        if (entry->state == State::pending)
+        {
+            wheel->unschedule(*entry);
+            entry->state = State::cancelled;
+            ++entry->generation;
+        }
+        return entry->state == State::cancelled;
+    }
+
+    State state() const override
+    {
+        std::lock_guard<std::mutex> lock{wheel->mutex};
+        return entry->state;
+    }
+
+    bool reschedule_in(std::chrono::milliseconds delay) override
+    {
+        return reschedule_for(wheel->clock->now() + delay);
+    }
+
+    bool reschedule_for(Timestamp timeout) override
+    {
+        std::lock_guard<std::mutex> lock{wheel->mutex};
+        auto const old_state = entry->state;
+        wheel->schedule(*entry, timeout);
+        return old_state == State::pending;
+    }
+
+private:
+    std::shared_ptr<Wheel> const wheel;
+    std::shared_ptr<Wheel::Entry> const entry;
+};
+
+mt::TimerWheelAlarmFactory::TimerWheelAlarmFactory(
+    std::shared_ptr<Clock> const& clock,
+    std::chrono::nanoseconds resolution)
+    : wheel{std::make_shared<Wheel>(clock, resolution)}
+{
+}
+
+mt::TimerWheelAlarmFactory::~TimerWheelAlarmFactory() = default;
+
+std::unique_ptr<mt::Alarm> mt::TimerWheelAlarmFactory::create_alarm(std::function<void()> const& callback)
+{
+    return create_alarm(std::make_unique<BasicCallback>(callback));
+}
+
+std::unique_ptr<mt::Alarm> mt::TimerWheelAlarmFactory::create_alarm(std::unique_ptr<LockableCallback> callback)
+{
+    return std::make_unique<AlarmImpl>(wheel, std::move(callback));
+}
+
+mir::Fd mt::TimerWheelAlarmFactory::watch_fd() const
+{
+    return wheel->timer_fd;
+}
+
+bool mt::TimerWheelAlarmFactory::dispatch(md::FdEvents events)
+{
+    if (events & md::FdEvent::error)
+        return false;
+
+    if (events & md::FdEvent::readable)
+    {
+        uint64_t expirations;
+        if (read(wheel->timer_fd, &expirations, sizeof expirations) < 0 && errno != EAGAIN)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to read timerfd"}));
+        }
+    }
+
+    wheel->fire_expired();
+    return true;
+}
+
+md::FdEvents mt::TimerWheelAlarmFactory::relevant_events() const
+{
+    return md::FdEvent::readable;
+}
+
+size_t mt::TimerWheelAlarmFactory::pending_alarms() const
+{
+    std::lock_guard<std::mutex> lock{wheel->mutex};
+    return wheel->pending;
+}
@@ -128,6 +128,7 @@ struct MockDisplayConfigurationReport : public mg::DisplayConfigurationObserver
 {
     MOCK_METHOD1(initial_configuration, void (std::shared_ptr<mg::DisplayConfiguration const> const& configuration));
     MOCK_METHOD1(configuration_applied, void (std::shared_ptr<mg::DisplayConfiguration const> const& configuration));
+    MOCK_METHOD2(configuration_timing, void (std::chrono::nanoseconds duration, bool incremental));
     MOCK_METHOD2(session_configuration_applied, void (std::shared_ptr<mf::Session> const& session, std::shared_ptr<mg::DisplayConfiguration> const& configuration));
     MOCK_METHOD1(session_configuration_removed, void (std::shared_ptr<mf::Session> const& session));
     MOCK_METHOD1(base_configuration_updated, void (std::shared_ptr<mg::DisplayConfiguration const> const& base_config));
@@ -140,6 +140,10 @@ struct DisplayConfigurationTest : mtf::ConnectedClientWithAWindow
             }
         }
 
+        void configuration_timing(std::chrono::nanoseconds, bool) override
+        {
+        }
+
         void base_configuration_updated(
             std::shared_ptr<mg::DisplayConfiguration const> const&) override
         {
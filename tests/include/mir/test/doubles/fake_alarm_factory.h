@@ -46,11 +46,14 @@ public:
     void advance_smoothly_by(time::Duration step);
     int wakeup_count() const;
 
+    /// The clock advanced by advance_by()
+    std::shared_ptr<time::Clock> clock() const;
+
 private:
     class FakeAlarm;
 
     std::vector<FakeAlarm*> alarms;
-    std::shared_ptr<AdvanceableClock> const clock;
+    std::shared_ptr<AdvanceableClock> const advanceable_clock;
 };
 
 }
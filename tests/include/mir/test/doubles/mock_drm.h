@@ -114,6 +114,14 @@ public:
     MOCK_METHOD1(drmModeFreePlane, void(drmModePlanePtr ptr));
     MOCK_METHOD1(drmModeFreeObjectProperties, void(drmModeObjectPropertiesPtr));
 
+    MOCK_METHOD0(drmModeAtomicAlloc, drmModeAtomicReqPtr());
+    MOCK_METHOD1(drmModeAtomicFree, void(drmModeAtomicReqPtr req));
+    MOCK_METHOD4(drmModeAtomicAddProperty, int(drmModeAtomicReqPtr req, uint32_t object_id,
+                                               uint32_t property_id, uint64_t value));
+    MOCK_METHOD4(drmModeAtomicCommit, int(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data));
+    MOCK_METHOD4(drmModeCreatePropertyBlob, int(int fd, void const* data, size_t size, uint32_t* id));
+    MOCK_METHOD2(drmModeDestroyPropertyBlob, int(int fd, uint32_t id));
+
     MOCK_METHOD8(drmModeAddFB, int(int fd, uint32_t width, uint32_t height,
                                    uint8_t depth, uint8_t bpp, uint32_t pitch,
                                    uint32_t bo_handle, uint32_t *buf_id));
@@ -132,6 +140,8 @@ public:
     MOCK_METHOD2(drmModeGetProperty, drmModePropertyPtr(int fd, uint32_t propertyId));
     MOCK_METHOD1(drmModeFreeProperty, void(drmModePropertyPtr));
     MOCK_METHOD4(drmModeConnectorSetProperty, int(int fd, uint32_t connector_id, uint32_t property_id, uint64_t value));
+    MOCK_METHOD5(drmModeObjectSetProperty, int(int fd, uint32_t object_id, uint32_t object_type,
+                                               uint32_t property_id, uint64_t value));
 
     MOCK_METHOD2(drmGetMagic, int(int fd, drm_magic_t *magic));
     MOCK_METHOD2(drmAuthMagic, int(int fd, drm_magic_t magic));
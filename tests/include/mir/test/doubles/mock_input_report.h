@@ -0,0 +1,43 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TEST_DOUBLES_MOCK_INPUT_REPORT_H_
+#define MIR_TEST_DOUBLES_MOCK_INPUT_REPORT_H_
+
+#include "mir/input/input_report.h"
+
+#include <gmock/gmock.h>
+
+namespace mir
+{
+namespace test
+{
+namespace doubles
+{
+struct MockInputReport : public mir::input::InputReport
+{
+    MOCK_METHOD4(received_event_from_kernel, void(int64_t, int, int, int));
+    MOCK_METHOD1(dispatched_event, void(int64_t));
+    MOCK_METHOD3(published_key_event, void(int, uint32_t, int64_t));
+    MOCK_METHOD3(published_motion_event, void(int, uint32_t, int64_t));
+    MOCK_METHOD2(opened_input_device, void(char const*, char const*));
+    MOCK_METHOD2(failed_to_open_input_device, void(char const*, char const*));
+};
+}
+}
+}
+
+#endif // MIR_TEST_DOUBLES_MOCK_INPUT_REPORT_H_
@@ -35,6 +35,13 @@ struct NullSnapshotStrategy : public scene::SnapshotStrategy
         scene::SnapshotCallback const&)
     {
     }
+
+    void take_thumbnail_of(
+        std::shared_ptr<compositor::BufferStream> const&,
+        geometry::Size const&,
+        scene::SnapshotCallback const&)
+    {
+    }
 };
 
 }
@@ -46,6 +46,9 @@ public:
     void unregister_compositor(compositor::CompositorID) override
     {
     }
+    void set_view_area(compositor::CompositorID, geometry::Rectangle const&) override
+    {
+    }
     void add_observer(std::shared_ptr<scene::Observer> const&) override
     {
     }
@@ -51,6 +51,7 @@ public:
 
     void set_streams(std::list<scene::StreamInfo> const&) override {}
     graphics::RenderableList generate_renderables(compositor::CompositorID) const override { return {}; }
+    bool could_appear_in(geometry::Rectangle const&) const override { return true; }
     int buffers_ready_for_compositor(void const*) const override { return 0; }
 
     MirWindowType type() const override { return mir_window_type_normal; }
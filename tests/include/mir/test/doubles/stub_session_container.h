@@ -20,6 +20,7 @@
 #define MIR_TEST_DOUBLES_STUB_SESSION_CONTAINER_H
 
 #include "mir/scene/session_container.h"
+#include "mir/scene/session.h"
 #include <memory>
 #include <vector>
 
@@ -53,6 +54,24 @@ public:
         return {};
     }
 
+    std::vector<std::shared_ptr<scene::Session>> sessions_of(pid_t pid) const
+    {
+        std::vector<std::shared_ptr<scene::Session>> result;
+        for (auto const& session : sessions)
+            if (session->process_id() == pid)
+                result.push_back(session);
+        return result;
+    }
+
+    std::vector<std::shared_ptr<scene::Session>> sessions_named(std::string const& name) const
+    {
+        std::vector<std::shared_ptr<scene::Session>> result;
+        for (auto const& session : sessions)
+            if (session->name() == name)
+                result.push_back(session);
+        return result;
+    }
+
 private:
     std::vector<std::shared_ptr<scene::Session>> sessions;
 };
@@ -373,14 +373,14 @@ struct DisplayServerMainLoopEvents : testing::Test
         EXPECT_CALL(*mock_connector, stop()).Times(1);
         EXPECT_CALL(*mock_input_dispatcher, stop()).Times(1);
         EXPECT_CALL(*mock_input_manager, stop()).Times(1);
-        EXPECT_CALL(*mock_compositor, stop()).Times(1);
+        EXPECT_CALL(*mock_compositor, pause()).Times(1);
         EXPECT_CALL(*mock_display, pause()).Times(1);
     }
 
     void expect_resume()
     {
         EXPECT_CALL(*mock_display, resume()).Times(1);
-        EXPECT_CALL(*mock_compositor, start()).Times(1);
+        EXPECT_CALL(*mock_compositor, resume()).Times(1);
         EXPECT_CALL(*mock_input_manager, start()).Times(1);
         EXPECT_CALL(*mock_input_dispatcher, start()).Times(1);
         EXPECT_CALL(*mock_connector, start()).Times(1);
@@ -507,12 +507,12 @@ TEST_F(DisplayServerMainLoopEvents, display_server_attempts_to_continue_on_pause
         EXPECT_CALL(*mock_connector, stop()).Times(1);
         EXPECT_CALL(*mock_input_dispatcher, stop()).Times(1);
         EXPECT_CALL(*mock_input_manager, stop()).Times(1);
-        EXPECT_CALL(*mock_compositor, stop()).Times(1);
+        EXPECT_CALL(*mock_compositor, pause()).Times(1);
         EXPECT_CALL(*mock_display, pause())
             .WillOnce(Throw(std::runtime_error("")));
 
         /* Attempt to continue */
-        EXPECT_CALL(*mock_compositor, start()).Times(1);
+        EXPECT_CALL(*mock_compositor, resume()).Times(1);
         EXPECT_CALL(*mock_input_manager, start()).Times(1);
         EXPECT_CALL(*mock_input_dispatcher, start()).Times(1);
         EXPECT_CALL(*mock_connector, start()).Times(1);
@@ -107,6 +107,16 @@ public:
         scene->remove_observer(observer);
     }
 
+    void pause()
+    {
+        stop();
+    }
+
+    void resume()
+    {
+        start();
+    }
+
 private:
     std::shared_ptr<mg::Display> const display;
     std::shared_ptr<mc::DisplayListener> const display_listener;
@@ -17,6 +17,7 @@
  */
 
 #include "mir/compositor/display_listener.h"
+#include "mir/graphics/display_configuration_observer.h"
 #include "mir/renderer/renderer_factory.h"
 #include "mir/scene/surface_creation_parameters.h"
 #include "src/server/report/null_report_factory.h"
@@ -34,6 +35,7 @@
 #include "mir/test/doubles/null_display_sync_group.h"
 #include "mir/test/doubles/mock_event_sink.h"
 #include "mir/test/doubles/stub_buffer_allocator.h"
+#include "mir/test/doubles/stub_observer_registrar.h"
 
 #include <condition_variable>
 #include <mutex>
@@ -169,6 +171,7 @@ TEST_F(SurfaceStackCompositor, composes_on_start_if_told_to_in_constructor)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>>(),
         null_comp_report, default_delay, true);
     mt_compositor.start();
 
@@ -183,6 +186,7 @@ TEST_F(SurfaceStackCompositor, does_not_composes_on_start_if_told_not_to_in_cons
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>>(),
         null_comp_report, default_delay, false);
     mt_compositor.start();
 
@@ -197,6 +201,7 @@ TEST_F(SurfaceStackCompositor, swapping_a_surface_that_has_been_added_triggers_a
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>>(),
         null_comp_report, default_delay, false);
     mt_compositor.start();
 
@@ -222,6 +227,7 @@ TEST_F(SurfaceStackCompositor, compositor_runs_until_all_surfaces_buffers_are_co
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>>(),
         null_comp_report, default_delay, false);
     mt_compositor.start();
 
@@ -251,6 +257,7 @@ TEST_F(SurfaceStackCompositor, bypassed_compositor_runs_until_all_surfaces_buffe
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>>(),
         null_comp_report, default_delay, false);
     mt_compositor.start();
 
@@ -269,6 +276,7 @@ TEST_F(SurfaceStackCompositor, an_empty_scene_retriggers)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>>(),
         null_comp_report, default_delay, false);
     mt_compositor.start();
 
@@ -294,6 +302,7 @@ TEST_F(SurfaceStackCompositor, moving_a_surface_triggers_composition)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>>(),
         null_comp_report, default_delay, false);
 
     mt_compositor.start();
@@ -313,6 +322,7 @@ TEST_F(SurfaceStackCompositor, removing_a_surface_triggers_composition)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>>(),
         null_comp_report, default_delay, false);
 
     mt_compositor.start();
@@ -332,6 +342,7 @@ TEST_F(SurfaceStackCompositor, buffer_updates_trigger_composition)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>>(),
         null_comp_report, default_delay, false);
 
     mt_compositor.start();
@@ -128,7 +128,7 @@ bool mtd::FakeAlarmFactory::FakeAlarm::reschedule_for(mir::time::Timestamp timeo
 }
 
 mtd::FakeAlarmFactory::FakeAlarmFactory()
-    : clock{std::make_shared<mtd::AdvanceableClock>()}
+    : advanceable_clock{std::make_shared<mtd::AdvanceableClock>()}
 {
 }
 
@@ -137,7 +137,7 @@ std::unique_ptr<mt::Alarm> mtd::FakeAlarmFactory::create_alarm(
 {
     std::unique_ptr<mt::Alarm> alarm = std::make_unique<FakeAlarm>(
         callback,
-        clock,
+        advanceable_clock,
         [this](FakeAlarm* destroying)
         {
             alarms.erase(std::remove(alarms.begin(), alarms.end(), destroying), alarms.end());
@@ -154,7 +154,7 @@ std::unique_ptr<mt::Alarm> mtd::FakeAlarmFactory::create_alarm(
 
 void mtd::FakeAlarmFactory::advance_by(mt::Duration step)
 {
-    clock->advance_by(step);
+    advanceable_clock->advance_by(step);
     for (unsigned i = 0u; i < alarms.size();)
     {
         auto const old_size = alarms.size();
@@ -187,3 +187,8 @@ int mtd::FakeAlarmFactory::wakeup_count() const
             return count + alarm->wakeup_count();
         });
 }
+
+std::shared_ptr<mt::Clock> mtd::FakeAlarmFactory::clock() const
+{
+    return advanceable_clock;
+}
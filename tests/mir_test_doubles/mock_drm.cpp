@@ -299,6 +299,27 @@ mtd::MockDRM::MockDRM()
     ON_CALL(*this, drmModeObjectGetProperties(_, _, _))
         .WillByDefault(Return(&empty_object_props));
 
+    /* Default to the legacy modesetting API; tests of atomic modesetting opt in */
+    ON_CALL(*this, drmSetClientCap(_, DRM_CLIENT_CAP_ATOMIC, _))
+        .WillByDefault(Return(-EINVAL));
+
+    ON_CALL(*this, drmModeAtomicAlloc())
+        .WillByDefault(Return(reinterpret_cast<drmModeAtomicReqPtr>(0xa70)));
+
+    ON_CALL(*this, drmModeAtomicAddProperty(_, _, _, _))
+        .WillByDefault(Return(1));
+
+    ON_CALL(*this, drmModeCreatePropertyBlob(_, _, _, _))
+        .WillByDefault(
+            WithArg<3>(
+                Invoke(
+                    [](uint32_t* id)
+                    {
+                        static uint32_t next_blob_id{1000};
+                        *id = next_blob_id++;
+                        return 0;
+                    })));
+
     ON_CALL(*this, drmSetInterfaceVersion(_, _))
     .WillByDefault(Return(0));
 
@@ -550,6 +571,12 @@ int drmModeConnectorSetProperty(int fd, uint32_t connector_id, uint32_t property
     return global_mock->drmModeConnectorSetProperty(fd, connector_id, property_id, value);
 }
 
+int drmModeObjectSetProperty(int fd, uint32_t object_id, uint32_t object_type,
+                             uint32_t property_id, uint64_t value)
+{
+    return global_mock->drmModeObjectSetProperty(fd, object_id, object_type, property_id, value);
+}
+
 void drmModeFreeConnector(drmModeConnectorPtr ptr)
 {
     global_mock->drmModeFreeConnector(ptr);
@@ -580,6 +607,36 @@ void drmModeFreeObjectProperties(drmModeObjectPropertiesPtr ptr)
     global_mock->drmModeFreeObjectProperties(ptr);
 }
 
+drmModeAtomicReqPtr drmModeAtomicAlloc()
+{
+    return global_mock->drmModeAtomicAlloc();
+}
+
+void drmModeAtomicFree(drmModeAtomicReqPtr req)
+{
+    global_mock->drmModeAtomicFree(req);
+}
+
+int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    return global_mock->drmModeAtomicAddProperty(req, object_id, property_id, value);
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
+int drmModeCreatePropertyBlob(int fd, void const* data, size_t size, uint32_t* id)
+{
+    return global_mock->drmModeCreatePropertyBlob(fd, data, size, id);
+}
+
+int drmModeDestroyPropertyBlob(int fd, uint32_t id)
+{
+    return global_mock->drmModeDestroyPropertyBlob(fd, id);
+}
+
 int drmModeAddFB(int fd, uint32_t width, uint32_t height,
                  uint8_t depth, uint8_t bpp, uint32_t pitch,
                  uint32_t bo_handle, uint32_t *buf_id)
@@ -311,6 +311,13 @@ void glGenTextures(GLsizei n, GLuint *textures)
     global_mock_gl->glGenTextures(n, textures);
 }
 
+void glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset,
+                         GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    CHECK_GLOBAL_VOID_MOCK();
+    global_mock_gl->glCopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height);
+}
+
 void glDeleteTextures(GLsizei n, const GLuint *textures)
 {
     CHECK_GLOBAL_VOID_MOCK();
@@ -447,12 +454,24 @@ void glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
     global_mock_gl->glViewport(x, y, width, height);
 }
 
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    CHECK_GLOBAL_VOID_MOCK();
+    global_mock_gl->glScissor(x, y, width, height);
+}
+
 void glFinish()
 {
     CHECK_GLOBAL_VOID_MOCK();
     global_mock_gl->glFinish();
 }
 
+void glFlush()
+{
+    CHECK_GLOBAL_VOID_MOCK();
+    global_mock_gl->glFlush();
+}
+
 void glGenerateMipmap(GLenum target)
 {
     CHECK_GLOBAL_VOID_MOCK();
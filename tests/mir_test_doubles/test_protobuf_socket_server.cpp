@@ -46,7 +46,8 @@ std::shared_ptr<mf::Connector> make_connector(
             factory,
             std::make_shared<mtd::StubSessionAuthorizer>(),
             std::make_shared<mtd::NullPlatformIpcOperations>(),
-            mr::null_message_processor_report()),
+            mr::null_message_processor_report(),
+            mr::null_input_report()),
         null_emergency_cleanup,
         report);
 }
@@ -47,6 +47,12 @@ void mtd::StubSession::take_snapshot(
 {
 }
 
+void mtd::StubSession::take_thumbnail(
+    mir::geometry::Size const& /*size*/,
+    mir::scene::SnapshotCallback const& /*thumbnail_taken*/)
+{
+}
+
 std::shared_ptr<mir::scene::Surface> mtd::StubSession::default_surface() const
 {
     return {};
@@ -106,6 +106,11 @@ mir::graphics::RenderableList mtd::StubSurface::generate_renderables(mir::compos
     return {};
 }
 
+bool mtd::StubSurface::could_appear_in(mir::geometry::Rectangle const& /*area*/) const
+{
+    return true;
+}
+
 int mtd::StubSurface::buffers_ready_for_compositor(void const* /*compositor_id*/) const
 {
     return 0;
@@ -0,0 +1,152 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_window_manager_tools.h"
+
+#include <mir/events/event_builders.h>
+
+#include <future>
+
+using namespace miral;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+Rectangle const display_area{{0, 0}, {1280, 720}};
+
+struct UnlockedQueries : TestWindowManagerTools
+{
+    void SetUp() override
+    {
+        basic_window_manager.add_display_for_testing(display_area);
+        basic_window_manager.add_session(session);
+
+        EXPECT_CALL(*window_manager_policy, advise_new_window(_))
+            .WillOnce(Invoke([this](WindowInfo const& window_info){ window = window_info.window(); }))
+            .WillOnce(Invoke([this](WindowInfo const& window_info){ another_window = window_info.window(); }));
+
+        mir::scene::SurfaceCreationParameters creation_parameters;
+        creation_parameters.size = Size{600, 400};
+        basic_window_manager.add_surface(session, creation_parameters, &create_surface);
+        basic_window_manager.add_surface(session, creation_parameters, &create_surface);
+
+        basic_window_manager.invoke_under_lock([this]{ window_manager_tools.select_active_window(window); });
+
+        Mock::VerifyAndClearExpectations(window_manager_policy);
+    }
+
+    template<typename Query>
+    auto from_another_thread(Query const& query) -> std::future<decltype(query())>
+    {
+        return std::async(std::launch::async, query);
+    }
+
+    auto pointer_motion_to(Point position) -> mir::EventUPtr
+    {
+        return mir::events::make_event(
+            MirInputDeviceId{0}, 0ns, std::vector<uint8_t>{}, mir_input_event_modifier_none,
+            mir_pointer_action_motion, 0,
+            position.x.as_int(), position.y.as_int(), 0, 0, 0, 0);
+    }
+
+    void handle(mir::EventUPtr const& event)
+    {
+        basic_window_manager.handle_pointer_event(
+            mir_input_event_get_pointer_event(mir_event_get_input_event(event.get())));
+    }
+
+    Window window;
+    Window another_window;
+};
+}
+
+TEST_F(UnlockedQueries, see_the_model_as_the_lock_was_released)
+{
+    EXPECT_THAT(from_another_thread([this]{ return window_manager_tools.active_window(); }).get(), Eq(window));
+    EXPECT_THAT(from_another_thread([this]{ return window_manager_tools.count_applications(); }).get(), Eq(1u));
+    EXPECT_THAT(from_another_thread([this]{ return window_manager_tools.active_output(); }).get(), Eq(display_area));
+}
+
+TEST_F(UnlockedQueries, do_not_wait_for_the_lock)
+{
+    basic_window_manager.invoke_under_lock([this]
+        {
+            auto active_window = from_another_thread([this]{ return window_manager_tools.active_window(); });
+
+            ASSERT_THAT(active_window.wait_for(5s), Eq(std::future_status::ready));
+            EXPECT_THAT(active_window.get(), Eq(window));
+        });
+}
+
+TEST_F(UnlockedQueries, under_the_lock_see_changes_immediately)
+{
+    basic_window_manager.invoke_under_lock([this]
+        {
+            window_manager_tools.select_active_window(another_window);
+
+            EXPECT_THAT(window_manager_tools.active_window(), Eq(another_window));
+            EXPECT_THAT(
+                from_another_thread([this]{ return window_manager_tools.active_window(); }).get(), Eq(window));
+        });
+
+    EXPECT_THAT(
+        from_another_thread([this]{ return window_manager_tools.active_window(); }).get(), Eq(another_window));
+}
+
+TEST_F(UnlockedQueries, info_snapshots_see_the_model_as_the_lock_was_released)
+{
+    // The first snapshot taken without the lock waits for it once
+    auto const original_name =
+        from_another_thread([this]{ return window_manager_tools.info_snapshot_for(window)->name(); }).get();
+
+    basic_window_manager.invoke_under_lock([&, this]
+        {
+            WindowSpecification modifications;
+            modifications.name() = original_name + " renamed";
+            window_manager_tools.modify_window(window, modifications);
+
+            EXPECT_THAT(window_manager_tools.info_snapshot_for(window)->name(), Eq(original_name + " renamed"));
+            EXPECT_THAT(
+                from_another_thread([this]{ return window_manager_tools.info_snapshot_for(window)->name(); }).get(),
+                Eq(original_name));
+            EXPECT_THAT(
+                from_another_thread([this]{ return window_manager_tools.info_snapshot_for(session)->windows().size(); }).get(),
+                Eq(2u));
+        });
+
+    EXPECT_THAT(
+        from_another_thread([this]{ return window_manager_tools.info_snapshot_for(window)->name(); }).get(),
+        Eq(original_name + " renamed"));
+}
+
+TEST_F(UnlockedQueries, pointer_motion_moves_the_active_output_without_copying_infos)
+{
+    Rectangle const another_display_area{{1280, 0}, {1280, 720}};
+    basic_window_manager.add_display_for_testing(another_display_area);
+
+    auto const before =
+        from_another_thread([this]{ return window_manager_tools.info_snapshot_for(window); }).get();
+
+    handle(pointer_motion_to({1500, 10}));
+
+    EXPECT_THAT(
+        from_another_thread([this]{ return window_manager_tools.active_output(); }).get(),
+        Eq(another_display_area));
+    EXPECT_THAT(
+        from_another_thread([this]{ return window_manager_tools.info_snapshot_for(window); }).get(),
+        Eq(before));
+}
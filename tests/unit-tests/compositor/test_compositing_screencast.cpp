@@ -17,6 +17,7 @@
  */
 
 #include "src/server/compositor/compositing_screencast.h"
+#include "src/server/compositor/mirrored_outputs.h"
 #include "mir/compositor/display_buffer_compositor_factory.h"
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/scene.h"
@@ -31,6 +32,7 @@
 #include "mir/test/doubles/stub_display_configuration.h"
 #include "mir/test/doubles/stub_gl_buffer_allocator.h"
 #include "mir/test/doubles/mock_buffer.h"
+#include "mir/test/doubles/mock_egl.h"
 #include "mir/test/doubles/mock_gl.h"
 #include "mir/test/doubles/stub_scene.h"
 #include "mir/test/doubles/stub_scene_element.h"
@@ -205,18 +207,21 @@ struct CompositingScreencastTest : testing::Test
         : screencast{mt::fake_shared(stub_scene),
                      mt::fake_shared(stub_display),
                      mt::fake_shared(stub_buffer_allocator),
-                     mt::fake_shared(stub_db_compositor_factory)},
+                     mt::fake_shared(stub_db_compositor_factory),
+                     mt::fake_shared(mirrored_outputs)},
           default_size{1, 1},
           default_region{{0, 0}, {1, 1}},
           default_pixel_format{mir_pixel_format_xbgr_8888}
     {
     }
 
+    testing::NiceMock<mtd::MockEGL> mock_egl;
     testing::NiceMock<mtd::MockGL> mock_gl;
     mtd::StubScene stub_scene;
     StubDisplay stub_display;
     mtd::StubGLBufferAllocator stub_buffer_allocator;
     StubDisplayBufferCompositorFactory stub_db_compositor_factory;
+    mc::MirroredOutputs mirrored_outputs;
     mc::CompositingScreencast screencast;
     geom::Size const default_size;
     geom::Rectangle const default_region;
@@ -289,7 +294,8 @@ TEST_F(CompositingScreencastTest, captures_by_compositing_with_provided_region)
         mt::fake_shared(mock_scene),
         mt::fake_shared(stub_display),
         mt::fake_shared(stub_buffer_allocator),
-        mt::fake_shared(mock_db_compositor_factory)};
+        mt::fake_shared(mock_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
 
     auto session_id = screencast_local.create_session(
         default_region, default_size, default_pixel_format,
@@ -320,7 +326,8 @@ TEST_F(CompositingScreencastTest, captures_to_buffer_by_compositing)
         mt::fake_shared(mock_scene),
         mt::fake_shared(stub_display),
         mt::fake_shared(stub_buffer_allocator),
-        mt::fake_shared(mock_db_compositor_factory)};
+        mt::fake_shared(mock_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
 
     auto session_id = screencast.create_session(
         default_region, default_size, default_pixel_format,
@@ -340,7 +347,8 @@ TEST_F(CompositingScreencastTest, captures_to_buffer_by_compositing_with_reserve
         mt::fake_shared(mock_scene),
         mt::fake_shared(stub_display),
         mt::fake_shared(stub_buffer_allocator),
-        mt::fake_shared(mock_db_compositor_factory)};
+        mt::fake_shared(mock_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
 
     auto session_id = screencast.create_session(
         default_region, default_size, default_pixel_format,
@@ -365,7 +373,8 @@ TEST_F(CompositingScreencastTest, allocates_and_uses_buffer_with_provided_size)
         mt::fake_shared(stub_scene),
         mt::fake_shared(stub_display),
         mt::fake_shared(mock_buffer_allocator),
-        mt::fake_shared(stub_db_compositor_factory)};
+        mt::fake_shared(stub_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
 
     auto session_id = screencast_local.create_session(
         default_region, default_size, default_pixel_format,
@@ -391,7 +400,8 @@ TEST_F(CompositingScreencastTest, allocates_different_buffers_per_session)
         mt::fake_shared(stub_scene),
         mt::fake_shared(stub_display),
         mt::fake_shared(mock_buffer_allocator),
-        mt::fake_shared(stub_db_compositor_factory)};
+        mt::fake_shared(stub_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
 
     auto session_id1 = screencast_local.create_session(
         default_region, default_size, default_pixel_format,
@@ -428,7 +438,8 @@ TEST_F(CompositingScreencastTest, registers_and_unregisters_from_scene)
         mt::fake_shared(mock_scene),
         mt::fake_shared(stub_display),
         mt::fake_shared(mock_buffer_allocator),
-        mt::fake_shared(stub_db_compositor_factory)};
+        mt::fake_shared(stub_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
 
     auto session_id = screencast_local.create_session(
         default_region, default_size, default_pixel_format,
@@ -446,7 +457,8 @@ TEST_F(CompositingScreencastTest, attempts_to_create_output_display_when_given_r
         mt::fake_shared(stub_scene),
         mt::fake_shared(stub_display),
         mt::fake_shared(stub_buffer_allocator),
-        mt::fake_shared(stub_db_compositor_factory)};
+        mt::fake_shared(stub_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
 
     auto session_id = screencast_local.create_session(
             region_outside_display, default_size, default_pixel_format,
@@ -467,7 +479,8 @@ TEST_F(CompositingScreencastTest, does_not_create_virtual_output_when_given_regi
         mt::fake_shared(stub_scene),
         mt::fake_shared(stub_display),
         mt::fake_shared(stub_buffer_allocator),
-        mt::fake_shared(stub_db_compositor_factory)};
+        mt::fake_shared(stub_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
 
     auto session_id = screencast_local.create_session(
             region_inside_display, default_size, default_pixel_format,
@@ -498,7 +511,8 @@ TEST_F(CompositingScreencastTest, uses_requested_number_of_buffers)
         mt::fake_shared(stub_scene),
         mt::fake_shared(stub_display),
         mt::fake_shared(mock_buffer_allocator),
-        mt::fake_shared(stub_db_compositor_factory)};
+        mt::fake_shared(stub_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
 
     auto session_id = screencast_local.create_session(
         default_region, default_size, default_pixel_format,
@@ -512,3 +526,66 @@ TEST_F(CompositingScreencastTest, uses_requested_number_of_buffers)
 }
 
 
+
+TEST_F(CompositingScreencastTest, captures_output_by_drawing_its_last_frame)
+{
+    using namespace testing;
+
+    geom::Rectangle const output_region{{0, 0}, {1920, 1080}};
+    GLint const viewport[4]{0, 0, 1920, 1080};
+    NiceMock<mtd::MockScene> mock_scene;
+    MockDisplayBufferCompositorFactory mock_db_compositor_factory;
+
+    ON_CALL(mock_gl, glGetIntegerv(GL_VIEWPORT, _))
+        .WillByDefault(SetArrayArgument<1>(viewport, viewport + 4));
+
+    mc::CompositingScreencast screencast_local{
+        mt::fake_shared(mock_scene),
+        mt::fake_shared(stub_display),
+        mt::fake_shared(stub_buffer_allocator),
+        mt::fake_shared(mock_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
+
+    auto session_id = screencast_local.create_session(
+        output_region, default_size, default_pixel_format,
+        default_num_buffers, default_mirror_mode);
+
+    mirrored_outputs.frame_rendered(output_region);
+
+    EXPECT_CALL(mock_scene, scene_elements_for(_)).Times(0);
+    EXPECT_CALL(mock_db_compositor_factory.mock_db_compositor, composite_(_)).Times(0);
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+
+    screencast_local.capture(session_id);
+}
+
+TEST_F(CompositingScreencastTest, captures_output_by_compositing_when_its_last_frame_was_not_rendered)
+{
+    using namespace testing;
+
+    geom::Rectangle const output_region{{0, 0}, {1920, 1080}};
+    GLint const viewport[4]{0, 0, 1920, 1080};
+    NiceMock<mtd::MockScene> mock_scene;
+    MockDisplayBufferCompositorFactory mock_db_compositor_factory;
+
+    ON_CALL(mock_gl, glGetIntegerv(GL_VIEWPORT, _))
+        .WillByDefault(SetArrayArgument<1>(viewport, viewport + 4));
+
+    mc::CompositingScreencast screencast_local{
+        mt::fake_shared(mock_scene),
+        mt::fake_shared(stub_display),
+        mt::fake_shared(stub_buffer_allocator),
+        mt::fake_shared(mock_db_compositor_factory),
+        mt::fake_shared(mirrored_outputs)};
+
+    auto session_id = screencast_local.create_session(
+        output_region, default_size, default_pixel_format,
+        default_num_buffers, default_mirror_mode);
+
+    mirrored_outputs.frame_rendered(output_region);
+    mirrored_outputs.frame_not_rendered(output_region);
+
+    EXPECT_CALL(mock_db_compositor_factory.mock_db_compositor, composite_(_));
+
+    screencast_local.capture(session_id);
+}
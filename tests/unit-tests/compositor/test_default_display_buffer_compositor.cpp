@@ -298,6 +298,26 @@ TEST_F(DefaultDisplayBufferCompositor, optimization_toggles_seamlessly)
     fullscreen->set_buffer({});  // Avoid GMock complaining about false leaks
 }
 
+TEST_F(DefaultDisplayBufferCompositor, renderables_overlaid_by_the_display_buffer_are_not_rendered)
+{
+    using namespace testing;
+    auto video = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{200,100},{640,480}});
+
+    EXPECT_CALL(display_buffer, overlay(_))
+        .WillOnce(Return(false));
+    EXPECT_CALL(display_buffer, overlay_topmost(ElementsAre(big, small, video)))
+        .WillOnce(Return(1));
+
+    mg::RenderableList const composited{big, small};
+    EXPECT_CALL(mock_renderer, render(ContainerEq(composited)));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({big, small, video}));
+}
+
 TEST_F(DefaultDisplayBufferCompositor, occluded_surfaces_are_not_rendered)
 {
     using namespace testing;
@@ -0,0 +1,221 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/mirroring_display_buffer_compositor_factory.h"
+#include "src/server/compositor/mirrored_outputs.h"
+#include "mir/compositor/display_buffer_compositor.h"
+
+#include "mir/test/doubles/mock_egl.h"
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_gl_display_buffer.h"
+#include "mir/test/as_render_target.h"
+#include "mir/test/fake_shared.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+/// Renders as DefaultDisplayBufferCompositor would, without drawing anything
+struct RenderingDisplayBufferCompositor : mc::DisplayBufferCompositor
+{
+    RenderingDisplayBufferCompositor(mg::DisplayBuffer& display_buffer) :
+        display_buffer(display_buffer)
+    {
+    }
+
+    void composite(mc::SceneElementSequence&&) override
+    {
+        if (display_buffer.overlay({}))
+            return;
+
+        display_buffer.overlay_topmost({});
+        auto const render_target = mt::as_render_target(display_buffer);
+        render_target->bind();
+        render_target->swap_buffers();
+    }
+
+    mg::DisplayBuffer& display_buffer;
+};
+
+struct RenderingDisplayBufferCompositorFactory : mc::DisplayBufferCompositorFactory
+{
+    std::unique_ptr<mc::DisplayBufferCompositor> create_compositor_for(mg::DisplayBuffer& db) override
+    {
+        return std::make_unique<RenderingDisplayBufferCompositor>(db);
+    }
+};
+
+struct MirroringDisplayBufferCompositorFactory : Test
+{
+    MirroringDisplayBufferCompositorFactory()
+    {
+        ON_CALL(output, view_area()).WillByDefault(Return(output_area));
+        ON_CALL(output, transformation()).WillByDefault(Return(glm::mat2(1)));
+        ON_CALL(mock_gl, glGetIntegerv(GL_VIEWPORT, _))
+            .WillByDefault(SetArrayArgument<1>(viewport, viewport + 4));
+        ON_CALL(mock_gl, glGenTextures(1, _))
+            .WillByDefault(SetArgPointee<1>(texture));
+    }
+
+    geom::Rectangle const output_area{{0, 0}, {1920, 1080}};
+    GLint const viewport[4]{0, 0, 1920, 1080};
+    GLuint const texture{7};
+
+    EGLSyncKHR const fake_sync{reinterpret_cast<EGLSyncKHR>(0x5f1c)};
+
+    NiceMock<mtd::MockEGL> mock_egl;
+    NiceMock<mtd::MockGL> mock_gl;
+    NiceMock<mtd::MockGLDisplayBuffer> output;
+    RenderingDisplayBufferCompositorFactory rendering_factory;
+    mc::MirroredOutputs mirrored_outputs;
+    mc::MirroringDisplayBufferCompositorFactory factory{
+        mt::fake_shared(rendering_factory),
+        mt::fake_shared(mirrored_outputs)};
+};
+}
+
+TEST_F(MirroringDisplayBufferCompositorFactory, copies_frame_of_mirrored_output_before_it_is_swapped)
+{
+    auto const compositor = factory.create_compositor_for(output);
+    auto const frame = mirrored_outputs.start_mirroring(output_area);
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, 1920, 1080));
+    EXPECT_CALL(output, swap_buffers());
+
+    compositor->composite({});
+
+    bool drawn = false;
+    EXPECT_TRUE(mirrored_outputs.draw_latest(*frame, [&](GLuint) { drawn = true; }));
+    EXPECT_TRUE(drawn);
+}
+
+TEST_F(MirroringDisplayBufferCompositorFactory, does_not_copy_frames_of_outputs_not_mirrored)
+{
+    auto const compositor = factory.create_compositor_for(output);
+    auto const frame = mirrored_outputs.start_mirroring({{1920, 0}, {640, 480}});
+
+    EXPECT_CALL(mock_gl, glCopyTexSubImage2D(_, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(output, swap_buffers());
+
+    compositor->composite({});
+
+    EXPECT_FALSE(mirrored_outputs.draw_latest(*frame, [](GLuint) {}));
+}
+
+TEST_F(MirroringDisplayBufferCompositorFactory, has_no_frame_while_output_is_overlaid)
+{
+    auto const compositor = factory.create_compositor_for(output);
+    auto const frame = mirrored_outputs.start_mirroring(output_area);
+
+    compositor->composite({});
+    ASSERT_TRUE(mirrored_outputs.draw_latest(*frame, [](GLuint) {}));
+
+    EXPECT_CALL(output, overlay(_)).WillOnce(Return(true));
+    compositor->composite({});
+
+    EXPECT_FALSE(mirrored_outputs.draw_latest(*frame, [](GLuint) {}));
+}
+
+TEST_F(MirroringDisplayBufferCompositorFactory, has_no_frame_while_output_has_overlay_planes)
+{
+    auto const compositor = factory.create_compositor_for(output);
+    auto const frame = mirrored_outputs.start_mirroring(output_area);
+
+    EXPECT_CALL(output, overlay_topmost(_)).WillOnce(Return(1));
+    compositor->composite({});
+
+    EXPECT_FALSE(mirrored_outputs.draw_latest(*frame, [](GLuint) {}));
+}
+
+TEST_F(MirroringDisplayBufferCompositorFactory, has_no_frame_while_output_is_rotated)
+{
+    auto const compositor = factory.create_compositor_for(output);
+    auto const frame = mirrored_outputs.start_mirroring(output_area);
+
+    ON_CALL(output, transformation()).WillByDefault(Return(glm::mat2{0, -1, 1, 0}));
+    compositor->composite({});
+
+    EXPECT_FALSE(mirrored_outputs.draw_latest(*frame, [](GLuint) {}));
+}
+
+TEST_F(MirroringDisplayBufferCompositorFactory, fences_the_copy_rather_than_finishing_it)
+{
+    auto const compositor = factory.create_compositor_for(output);
+    auto const frame = mirrored_outputs.start_mirroring(output_area);
+
+    EXPECT_CALL(mock_gl, glFinish()).Times(0);
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_gl, glCopyTexSubImage2D(_, _, _, _, _, _, _, _));
+        EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _)).WillOnce(Return(fake_sync));
+        EXPECT_CALL(mock_gl, glFlush());
+        EXPECT_CALL(output, swap_buffers());
+    }
+
+    compositor->composite({});
+    Mock::VerifyAndClearExpectations(&mock_egl);
+
+    bool drawn = false;
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, fake_sync, _, EGL_FOREVER_KHR))
+            .WillOnce(InvokeWithoutArgs([&] { EXPECT_FALSE(drawn); return EGL_CONDITION_SATISFIED_KHR; }));
+        EXPECT_CALL(mock_egl, eglDestroySyncKHR(_, fake_sync));
+    }
+
+    EXPECT_TRUE(mirrored_outputs.draw_latest(*frame, [&](GLuint) { drawn = true; }));
+    EXPECT_TRUE(drawn);
+}
+
+TEST_F(MirroringDisplayBufferCompositorFactory, finishes_the_copy_if_it_cannot_be_fenced)
+{
+    auto const compositor = factory.create_compositor_for(output);
+    auto const frame = mirrored_outputs.start_mirroring(output_area);
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glCopyTexSubImage2D(_, _, _, _, _, _, _, _));
+    EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, _, _)).WillOnce(Return(EGL_NO_SYNC_KHR));
+    EXPECT_CALL(mock_gl, glFinish());
+    EXPECT_CALL(output, swap_buffers());
+
+    compositor->composite({});
+
+    EXPECT_TRUE(mirrored_outputs.draw_latest(*frame, [](GLuint) {}));
+}
+
+TEST_F(MirroringDisplayBufferCompositorFactory, has_no_frame_once_the_output_is_reconfigured)
+{
+    auto compositor = factory.create_compositor_for(output);
+    auto const frame = mirrored_outputs.start_mirroring(output_area);
+
+    compositor->composite({});
+    ASSERT_TRUE(mirrored_outputs.draw_latest(*frame, [](GLuint) {}));
+
+    // Compositors are recreated for the new display configuration
+    compositor.reset();
+
+    EXPECT_FALSE(mirrored_outputs.draw_latest(*frame, [](GLuint) {}));
+}
@@ -23,6 +23,7 @@
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/scene.h"
 #include "mir/compositor/display_buffer_compositor_factory.h"
+#include "mir/graphics/display_configuration_observer.h"
 #include "mir/scene/observer.h"
 #include "mir/raii.h"
 
@@ -34,7 +35,12 @@
 #include "mir/test/doubles/mock_scene.h"
 #include "mir/test/doubles/stub_scene.h"
 #include "mir/test/doubles/stub_display.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/stub_renderable.h"
+#include "mir/test/doubles/stub_scene_element.h"
 #include "mir/test/doubles/null_display_buffer_compositor_factory.h"
+#include "mir/test/doubles/null_display_configuration.h"
+#include "mir/test/doubles/stub_observer_registrar.h"
 
 #include <boost/throw_exception.hpp>
 
@@ -154,6 +160,56 @@ private:
     bool throw_on_add_observer_;
 };
 
+class StubSceneWithOneRenderable : public StubScene
+{
+public:
+    mc::SceneElementSequence scene_elements_for(mc::CompositorID) override
+    {
+        return {std::make_shared<mtd::StubSceneElement>(renderable)};
+    }
+
+    void post_new_buffer()
+    {
+        renderable->set_buffer(std::make_shared<mtd::StubBuffer>());
+        emit_change_event();
+    }
+
+private:
+    std::shared_ptr<mtd::StubRenderable> const renderable{
+        std::make_shared<mtd::StubRenderable>(geom::Rectangle{{0,0},{1,1}})};
+};
+
+class BufferCountingRenderable : public mtd::StubRenderable
+{
+public:
+    using mtd::StubRenderable::StubRenderable;
+
+    std::shared_ptr<mg::Buffer> buffer() const override
+    {
+        ++buffers_taken;
+        return mtd::StubRenderable::buffer();
+    }
+
+    std::atomic<unsigned int> mutable buffers_taken{0};
+};
+
+class StubSceneWithOccludedRenderable : public StubScene
+{
+public:
+    mc::SceneElementSequence scene_elements_for(mc::CompositorID) override
+    {
+        return {std::make_shared<mtd::StubSceneElement>(occluded),
+                std::make_shared<mtd::StubSceneElement>(top)};
+    }
+
+    std::shared_ptr<BufferCountingRenderable> const occluded{
+        std::make_shared<BufferCountingRenderable>(geom::Rectangle{{0,0},{1,1}})};
+
+private:
+    std::shared_ptr<mtd::StubRenderable> const top{
+        std::make_shared<mtd::StubRenderable>(geom::Rectangle{{0,0},{1,1}})};
+};
+
 class RecordingDisplayBufferCompositor : public mc::DisplayBufferCompositor
 {
 public:
@@ -270,6 +326,18 @@ private:
     std::unordered_map<mg::DisplayBuffer*,Record> records;
 };
 
+class CountingDisplayBufferCompositorFactory : public RecordingDisplayBufferCompositorFactory
+{
+public:
+    std::unique_ptr<mc::DisplayBufferCompositor> create_compositor_for(mg::DisplayBuffer& display_buffer) override
+    {
+        ++created;
+        return RecordingDisplayBufferCompositorFactory::create_compositor_for(display_buffer);
+    }
+
+    std::atomic<unsigned int> created{0};
+};
+
 class SurfaceUpdatingDisplayBufferCompositor : public mc::DisplayBufferCompositor
 {
 public:
@@ -359,9 +427,32 @@ struct MockDisplayListener : mc::DisplayListener
     MOCK_METHOD1(remove_display, void(geom::Rectangle const& /*area*/));
 };
 
+struct DisplayConfigurationObservers : mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>
+{
+    void register_interest(std::weak_ptr<mg::DisplayConfigurationObserver> const& observer) override
+    {
+        this->observer = observer;
+    }
+
+    void register_interest(std::weak_ptr<mg::DisplayConfigurationObserver> const& observer, mir::Executor&) override
+    {
+        this->observer = observer;
+    }
+
+    void configuration_applied()
+    {
+        if (auto const o = observer.lock())
+            o->configuration_applied(std::make_shared<mtd::NullDisplayConfiguration>());
+    }
+
+    std::weak_ptr<mg::DisplayConfigurationObserver> observer;
+};
+
 auto const null_report = mr::null_compositor_report();
 unsigned int const composites_per_update{1};
 auto const null_display_listener = std::make_shared<StubDisplayListener>();
+auto const null_display_configuration_observers =
+    std::make_shared<mtd::StubObserverRegistrar<mg::DisplayConfigurationObserver>>();
 std::chrono::milliseconds const default_delay{-1};
 
 }
@@ -375,7 +466,7 @@ TEST(MultiThreadedCompositor, compositing_happens_in_different_threads)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_display_configuration_observers, null_report, default_delay, true};
 
     compositor.start();
 
@@ -415,6 +506,7 @@ TEST(MultiThreadedCompositor, does_not_deadlock_itself)
         scene,
         std::make_shared<mtd::NullDisplayBufferCompositorFactory>(),
         std::make_shared<ReentrantDisplayListener>(scene),
+        null_display_configuration_observers,
         null_report,
         default_delay,
         true
@@ -440,6 +532,7 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
     mc::MultiThreadedCompositor compositor{display, scene,
                                            db_compositor_factory,
                                            null_display_listener,
+                                           null_display_configuration_observers,
                                            mock_report,
                                            default_delay,
                                            true};
@@ -486,7 +579,7 @@ TEST(MultiThreadedCompositor, composites_only_on_demand)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_display_configuration_observers, null_report, default_delay, true};
 
     // Verify we're actually starting at zero frames
     EXPECT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -547,7 +640,7 @@ TEST(MultiThreadedCompositor, schedules_enough_frames)
     auto scene = std::make_shared<StubScene>();
     auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
     mc::MultiThreadedCompositor compositor{display, scene, factory,
-                                           null_display_listener, null_report, default_delay, true};
+                                           null_display_listener, null_display_configuration_observers, null_report, default_delay, true};
 
     EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
 
@@ -610,6 +703,284 @@ TEST(MultiThreadedCompositor, schedules_enough_frames)
     compositor.stop();
 }
 
+TEST(MultiThreadedCompositor, skips_frames_in_which_nothing_changed)
+{
+    using namespace testing;
+
+    unsigned int const nbuffers = 3;
+
+    auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
+    auto scene = std::make_shared<StubSceneWithOneRenderable>();
+    auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+    std::atomic<unsigned int> skipped{0};
+    ON_CALL(*mock_report, skipped_frame(_))
+        .WillByDefault(InvokeWithoutArgs([&] { ++skipped; }));
+
+    mc::MultiThreadedCompositor compositor{display, scene, factory,
+                                           null_display_listener, null_display_configuration_observers, mock_report, default_delay, true, true};
+
+    compositor.start();
+
+    int const max_retries = 100;
+    int retry = 0;
+    while (retry < max_retries &&
+           !factory->check_record_count_for_each_buffer(nbuffers, 1))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+
+    // A change notification that changes nothing we draw
+    scene->emit_change_event();
+
+    retry = 0;
+    while (retry < max_retries && skipped < nbuffers)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+    EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 1, 1));
+
+    // A new buffer is drawn
+    scene->post_new_buffer();
+
+    retry = 0;
+    while (retry < max_retries &&
+           !factory->check_record_count_for_each_buffer(nbuffers, 2))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, deciding_to_skip_a_frame_takes_no_buffer_from_an_occluded_stream)
+{
+    using namespace testing;
+
+    unsigned int const nbuffers = 1;
+
+    auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
+    auto scene = std::make_shared<StubSceneWithOccludedRenderable>();
+    auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+    std::atomic<unsigned int> skipped{0};
+    ON_CALL(*mock_report, skipped_frame(_))
+        .WillByDefault(InvokeWithoutArgs([&] { ++skipped; }));
+
+    mc::MultiThreadedCompositor compositor{display, scene, factory,
+                                           null_display_listener, null_display_configuration_observers, mock_report, default_delay, true, true};
+
+    compositor.start();
+
+    int const max_retries = 100;
+    int retry = 0;
+    while (retry < max_retries &&
+           !factory->check_record_count_for_each_buffer(nbuffers, 1))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+
+    // The occluded surface posts
+    scene->emit_change_event();
+
+    retry = 0;
+    while (retry < max_retries && skipped < nbuffers)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+
+    compositor.stop();
+
+    EXPECT_THAT(scene->occluded->buffers_taken.load(), Eq(0u));
+}
+
+TEST(MultiThreadedCompositor, redraws_unchanged_scene_when_display_configuration_is_applied)
+{
+    using namespace testing;
+
+    unsigned int const nbuffers = 3;
+
+    auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
+    auto scene = std::make_shared<StubSceneWithOneRenderable>();
+    auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto display_configuration_observers = std::make_shared<DisplayConfigurationObservers>();
+
+    mc::MultiThreadedCompositor compositor{display, scene, factory,
+                                           null_display_listener, display_configuration_observers,
+                                           null_report, default_delay, true, true};
+
+    compositor.start();
+
+    int const max_retries = 100;
+    int retry = 0;
+    while (retry < max_retries &&
+           !factory->check_record_count_for_each_buffer(nbuffers, 1))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+
+    // The display was reconfigured in place, so what we draw may look different
+    display_configuration_observers->configuration_applied();
+
+    retry = 0;
+    while (retry < max_retries &&
+           !factory->check_record_count_for_each_buffer(nbuffers, 2))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, follows_display_buffers_the_display_moved)
+{
+    using namespace testing;
+
+    geom::Rectangle const initial_area{{0, 0}, {640, 480}};
+    geom::Rectangle const moved_area{{1920, 0}, {640, 480}};
+
+    std::mutex area_mutex;
+    geom::Rectangle area{initial_area};
+
+    auto display = std::make_shared<StubDisplayWithMockBuffers>(1);
+    display->for_each_mock_buffer([&](mtd::MockDisplayBuffer& buffer)
+        {
+            ON_CALL(buffer, view_area())
+                .WillByDefault(Invoke([&]
+                    {
+                        std::lock_guard<std::mutex> lock{area_mutex};
+                        return area;
+                    }));
+        });
+
+    auto scene = std::make_shared<NiceMock<mtd::MockScene>>();
+    auto mock_display_listener = std::make_shared<NiceMock<MockDisplayListener>>();
+    auto display_configuration_observers = std::make_shared<DisplayConfigurationObservers>();
+
+    mc::MultiThreadedCompositor compositor{
+        display, scene, std::make_shared<mtd::NullDisplayBufferCompositorFactory>(),
+        mock_display_listener, display_configuration_observers, null_report, default_delay, true};
+
+    compositor.start();
+
+    std::atomic<bool> moved{false};
+    EXPECT_CALL(*scene, set_view_area(_, moved_area));
+    EXPECT_CALL(*mock_display_listener, remove_display(initial_area));
+    EXPECT_CALL(*mock_display_listener, add_display(moved_area))
+        .WillOnce(InvokeWithoutArgs([&] { moved = true; }));
+
+    {
+        std::lock_guard<std::mutex> lock{area_mutex};
+        area = moved_area;
+    }
+    display_configuration_observers->configuration_applied();
+
+    int const max_retries = 100;
+    int retry = 0;
+    while (retry < max_retries && !moved)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+
+    Mock::VerifyAndClearExpectations(mock_display_listener.get());
+
+    // The listener is told about the display where it is now
+    EXPECT_CALL(*mock_display_listener, remove_display(moved_area));
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, keeps_display_buffer_compositors_across_pause_and_resume)
+{
+    using namespace testing;
+
+    unsigned int const nbuffers = 3;
+
+    auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
+    auto scene = std::make_shared<StubScene>();
+    auto factory = std::make_shared<CountingDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+    std::atomic<unsigned int> resumed{0};
+    ON_CALL(*mock_report, resumed_frame(_, _))
+        .WillByDefault(InvokeWithoutArgs([&] { ++resumed; }));
+
+    mc::MultiThreadedCompositor compositor{display, scene, factory,
+                                           null_display_listener, null_display_configuration_observers,
+                                           mock_report, default_delay, true};
+
+    compositor.start();
+
+    int const max_retries = 100;
+    int retry = 0;
+    while (retry < max_retries &&
+           !factory->check_record_count_for_each_buffer(nbuffers, 1))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+
+    compositor.pause();
+
+    // Nothing is composited while paused
+    scene->emit_change_event();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 1, 1));
+
+    // Resuming redraws, with the compositors we already had
+    compositor.resume();
+
+    retry = 0;
+    while (retry < max_retries &&
+           (!factory->check_record_count_for_each_buffer(nbuffers, 2) || resumed < nbuffers))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+
+    EXPECT_THAT(factory->created.load(), Eq(nbuffers));
+    EXPECT_THAT(resumed.load(), Eq(nbuffers));
+
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, can_stop_while_paused)
+{
+    unsigned int const nbuffers = 3;
+
+    auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
+    auto scene = std::make_shared<StubScene>();
+    auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+
+    mc::MultiThreadedCompositor compositor{display, scene, factory,
+                                           null_display_listener, null_display_configuration_observers,
+                                           null_report, default_delay, true};
+
+    compositor.start();
+    compositor.pause();
+    compositor.stop();
+
+    // Restarting after a stop adds the scene observer afresh
+    compositor.start();
+    compositor.stop();
+}
+
 TEST(MultiThreadedCompositor, recommended_sleep_throttles_compositor_loop)
 {
     using namespace testing;
@@ -622,7 +993,7 @@ TEST(MultiThreadedCompositor, recommended_sleep_throttles_compositor_loop)
     auto scene = std::make_shared<StubScene>();
     auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
     mc::MultiThreadedCompositor compositor{display, scene, factory,
-                                           null_display_listener, null_report,
+                                           null_display_listener, null_display_configuration_observers, null_report,
                                            recommendation, false};
 
     EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -671,7 +1042,7 @@ TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_there_is_none)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_display_configuration_observers, null_report, default_delay, false};
 
     // Verify we're actually starting at zero frames
     ASSERT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -694,7 +1065,7 @@ TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_we_still_compo
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_display_configuration_observers, null_report, default_delay, false};
 
     compositor.start();
 
@@ -729,7 +1100,7 @@ TEST(MultiThreadedCompositor, surface_update_from_render_doesnt_deadlock)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<SurfaceUpdatingDisplayBufferCompositorFactory>(scene);
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_display_configuration_observers, null_report, default_delay, true};
 
     compositor.start();
 
@@ -761,7 +1132,7 @@ TEST(MultiThreadedCompositor, double_start_or_stop_ignored)
         .Times(AtLeast(0))
         .WillRepeatedly(Return(mc::SceneElementSequence{}));
 
-    mc::MultiThreadedCompositor compositor{display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, mock_scene, db_compositor_factory, null_display_listener, null_display_configuration_observers, mock_report, default_delay, true};
 
     compositor.start();
     compositor.start();
@@ -776,7 +1147,7 @@ TEST(MultiThreadedCompositor, cleans_up_after_throw_in_start)
     auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_display_configuration_observers, null_report, default_delay, true};
 
     scene->throw_on_add_observer(true);
 
@@ -826,7 +1197,7 @@ TEST(MultiThreadedCompositor, names_compositor_threads)
     auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<ThreadNameDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_display_configuration_observers, null_report, default_delay, true};
 
     compositor.start();
 
@@ -855,7 +1226,7 @@ TEST(MultiThreadedCompositor, registers_and_unregisters_with_scene)
     EXPECT_CALL(*mock_scene, register_compositor(_))
         .Times(nbuffers);
     mc::MultiThreadedCompositor compositor{
-        display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+        display, mock_scene, db_compositor_factory, null_display_listener, null_display_configuration_observers, mock_report, default_delay, true};
 
     compositor.start();
 
@@ -878,7 +1249,7 @@ TEST(MultiThreadedCompositor, notifies_about_display_additions_and_removals)
     auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, null_display_configuration_observers, mock_report, default_delay, true};
 
     EXPECT_CALL(*mock_display_listener, add_display(_)).Times(nbuffers);
 
@@ -900,7 +1271,7 @@ TEST(MultiThreadedCompositor, when_compositor_thread_fails_start_reports_error)
     auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, null_display_configuration_observers, mock_report, default_delay, true};
 
     EXPECT_CALL(*mock_display_listener, add_display(_))
         .WillRepeatedly(Throw(std::runtime_error("Failed to add display")));
@@ -923,7 +1294,7 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_adding_dis
         .WillByDefault(InvokeWithoutArgs([&]{ stub_scene->emit_change_event(); }));
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, null_display_configuration_observers, mock_report, default_delay, true};
     compositor.start();
 }
 
@@ -941,6 +1312,6 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_removing_d
         .WillByDefault(InvokeWithoutArgs([&]{ stub_scene->emit_change_event(); }));
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, null_display_configuration_observers, mock_report, default_delay, true};
     compositor.start();
 }
@@ -28,7 +28,9 @@
 #include <fcntl.h>
 
 #include <atomic>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -490,3 +492,93 @@ TEST(MultiplexingDispatchableTest, automatic_removals_are_threadsafe)
     
     dispatchee->trigger();
 }
+
+TEST(MultiplexingDispatchableTest, dispatches_every_ready_dispatchee_in_one_call)
+{
+    int const dispatchee_count{8};
+    int dispatched{0};
+
+    md::MultiplexingDispatchable dispatcher;
+    std::vector<std::shared_ptr<mt::TestDispatchable>> dispatchees;
+    for (int i = 0; i != dispatchee_count; ++i)
+    {
+        dispatchees.push_back(std::make_shared<mt::TestDispatchable>([&dispatched]() { ++dispatched; }));
+        dispatcher.add_watch(dispatchees.back());
+        dispatchees.back()->trigger();
+    }
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatched, testing::Eq(dispatchee_count));
+    EXPECT_FALSE(mt::fd_is_readable(dispatcher.watch_fd()));
+}
+
+TEST(MultiplexingDispatchableTest, dispatchee_removed_earlier_in_the_same_dispatch_is_not_dispatched)
+{
+    md::MultiplexingDispatchable dispatcher;
+    int dispatched{0};
+
+    std::shared_ptr<mt::TestDispatchable> first, second;
+    first = std::make_shared<mt::TestDispatchable>(
+        [&]() { ++dispatched; dispatcher.remove_watch(second); });
+    second = std::make_shared<mt::TestDispatchable>(
+        [&]() { ++dispatched; dispatcher.remove_watch(first); });
+
+    dispatcher.add_watch(first);
+    dispatcher.add_watch(second);
+    first->trigger();
+    second->trigger();
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatched, testing::Eq(1));
+    EXPECT_FALSE(mt::fd_is_readable(dispatcher.watch_fd()));
+}
+
+TEST(MultiplexingDispatchableTest, dispatchees_after_one_that_throws_are_dispatched_next_time)
+{
+    int dispatched{0};
+    auto const throw_first_time = [&dispatched]()
+        {
+            if (dispatched++ == 0)
+                throw std::runtime_error{"Boom"};
+        };
+
+    auto first = std::make_shared<mt::TestDispatchable>(throw_first_time);
+    auto second = std::make_shared<mt::TestDispatchable>(throw_first_time);
+    md::MultiplexingDispatchable dispatcher{first, second};
+
+    first->trigger();
+    second->trigger();
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    EXPECT_THROW(dispatcher.dispatch(md::FdEvent::readable), std::runtime_error);
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatched, testing::Eq(2));
+}
+
+TEST(MultiplexingDispatchableTest, records_queueing_delay_per_watch)
+{
+    auto first = std::make_shared<mt::TestDispatchable>([]() {});
+    auto second = std::make_shared<mt::TestDispatchable>([]() {});
+    md::MultiplexingDispatchable dispatcher{first, second};
+
+    first->trigger();
+    first->trigger();
+
+    while (mt::fd_is_readable(dispatcher.watch_fd()))
+    {
+        dispatcher.dispatch(md::FdEvent::readable);
+    }
+
+    EXPECT_THAT(dispatcher.queueing_delay(first->watch_fd()), testing::StartsWith("count=2 "));
+    EXPECT_THAT(dispatcher.queueing_delay(second->watch_fd()), testing::StartsWith("count=0 "));
+
+    dispatcher.remove_watch(first);
+    EXPECT_THAT(dispatcher.queueing_delay(first->watch_fd()), testing::Eq(""));
+}
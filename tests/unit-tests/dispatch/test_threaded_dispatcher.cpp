@@ -446,3 +446,129 @@ TEST_F(ThreadedDispatcherTest, executes_exception_handler_with_current_exception
     EXPECT_TRUE(dispatched->wait_for(10s));
     EXPECT_THAT(exception, Not(Eq(nullptr)));
 }
+
+TEST_F(ThreadedDispatcherTest, adaptive_dispatcher_adds_threads_while_all_are_busy)
+{
+    using namespace testing;
+
+    auto first_dispatched = std::make_shared<mt::Signal>();
+    auto second_dispatched = std::make_shared<mt::Signal>();
+
+    // Deadlocks unless a second thread is started
+    auto first_dispatchable = std::make_shared<mt::TestDispatchable>([first_dispatched, second_dispatched]()
+    {
+        first_dispatched->raise();
+        EXPECT_TRUE(second_dispatched->wait_for(std::chrono::seconds{60}));
+    });
+    auto second_dispatchable = std::make_shared<mt::TestDispatchable>([first_dispatched, second_dispatched]()
+    {
+        second_dispatched->raise();
+        EXPECT_TRUE(first_dispatched->wait_for(std::chrono::seconds{60}));
+    });
+
+    auto combined_dispatchable = std::make_shared<md::MultiplexingDispatchable>();
+    combined_dispatchable->add_watch(first_dispatchable);
+    combined_dispatchable->add_watch(second_dispatchable);
+    md::ThreadedDispatcher dispatcher{"Adaptive", combined_dispatchable};
+
+    dispatcher.set_thread_limits(1, 2);
+
+    first_dispatchable->trigger();
+    second_dispatchable->trigger();
+
+    EXPECT_TRUE(first_dispatched->wait_for(std::chrono::seconds{60}));
+    EXPECT_TRUE(second_dispatched->wait_for(std::chrono::seconds{60}));
+    EXPECT_THAT(dispatcher.thread_count(), Le(2u));
+}
+
+TEST_F(ThreadedDispatcherTest, adaptive_dispatcher_retires_idle_threads_down_to_minimum)
+{
+    using namespace testing;
+
+    auto dispatched = std::make_shared<mt::Signal>();
+    auto dispatchable = std::make_shared<mt::TestDispatchable>([dispatched]() { dispatched->raise(); });
+    md::ThreadedDispatcher dispatcher{"Retiring", dispatchable};
+
+    dispatcher.set_thread_limits(2, 4, std::chrono::milliseconds{10});
+
+    dispatcher.add_thread();
+    dispatcher.add_thread();
+    dispatcher.add_thread();
+
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (dispatcher.thread_count() > 2 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+
+    EXPECT_THAT(dispatcher.thread_count(), Eq(2u));
+
+    dispatchable->trigger();
+    EXPECT_TRUE(dispatched->wait_for(std::chrono::seconds{5}));
+}
+
+TEST_F(ThreadedDispatcherTest, adaptive_dispatcher_does_not_add_threads_for_wakeups_without_work)
+{
+    using namespace testing;
+
+    auto dispatched = std::make_shared<mt::Signal>();
+    auto dispatchable = std::make_shared<mt::TestDispatchable>([dispatched]() { dispatched->raise(); });
+
+    // Each event wakes every thread, but only one of them gets to dispatch it
+    auto combined_dispatchable = std::make_shared<md::MultiplexingDispatchable>();
+    combined_dispatchable->add_watch(dispatchable);
+    md::ThreadedDispatcher dispatcher{"Quiet", combined_dispatchable};
+
+    dispatcher.set_thread_limits(1, 4, std::chrono::seconds{60});
+
+    for (int i = 0; i != 20; ++i)
+    {
+        dispatchable->trigger();
+        ASSERT_TRUE(dispatched->wait_for(std::chrono::seconds{5}));
+        dispatched->reset();
+
+        // Let the dispatch return, so no two events are ever being worked on at once
+        std::this_thread::sleep_for(std::chrono::milliseconds{5});
+    }
+
+    // One thread busy in dispatch() leaves nobody to wait for work, so may add one more
+    EXPECT_THAT(dispatcher.thread_count(), Le(2u));
+}
+
+TEST_F(ThreadedDispatcherTest, adaptive_dispatcher_retires_threads_that_only_see_others_work)
+{
+    using namespace testing;
+
+    auto dispatched = std::make_shared<mt::Signal>();
+    auto dispatchable = std::make_shared<mt::TestDispatchable>([dispatched]() { dispatched->raise(); });
+    auto combined_dispatchable = std::make_shared<md::MultiplexingDispatchable>();
+    combined_dispatchable->add_watch(dispatchable);
+    md::ThreadedDispatcher dispatcher{"Steady", combined_dispatchable};
+
+    dispatcher.set_thread_limits(1, 4, std::chrono::milliseconds{200});
+
+    dispatcher.add_thread();
+    dispatcher.add_thread();
+    dispatcher.add_thread();
+
+    // Light, steady traffic wakes every thread more often than the idle timeout
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (dispatcher.thread_count() > 2 && std::chrono::steady_clock::now() < deadline)
+    {
+        dispatchable->trigger();
+        ASSERT_TRUE(dispatched->wait_for(std::chrono::seconds{5}));
+        dispatched->reset();
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    }
+
+    EXPECT_THAT(dispatcher.thread_count(), Le(2u));
+}
+
+TEST_F(ThreadedDispatcherTest, rejects_invalid_thread_limits)
+{
+    auto dispatchable = std::make_shared<mt::TestDispatchable>([](){});
+    md::ThreadedDispatcher dispatcher{"Limited", dispatchable};
+
+    EXPECT_THROW(dispatcher.set_thread_limits(0, 4), std::invalid_argument);
+    EXPECT_THROW(dispatcher.set_thread_limits(3, 2), std::invalid_argument);
+}
@@ -21,6 +21,7 @@
 
 #include "src/server/frontend/message_sender.h"
 #include "src/server/frontend/event_sender.h"
+#include "src/server/report/null_report_factory.h"
 
 #include "mir/events/event_builders.h"
 #include "mir/client_visible_error.h"
@@ -32,6 +33,7 @@
 #include "mir/test/doubles/stub_buffer.h"
 #include "mir/test/doubles/stub_input_device.h"
 #include "mir/test/doubles/mock_platform_ipc_operations.h"
+#include "mir/test/doubles/mock_input_report.h"
 #include "mir/input/device.h"
 #include "mir/input/device_capability.h"
 #include "mir/input/mir_input_config.h"
@@ -51,6 +53,7 @@ namespace mf = mir::frontend;
 namespace mfd = mf::detail;
 namespace mev = mir::events;
 namespace geom = mir::geometry;
+namespace mr = mir::report;
 
 namespace
 {
@@ -112,7 +115,7 @@ struct MockMsgSender : public mf::MessageSender
 struct EventSender : public testing::Test
 {
     EventSender()
-        : event_sender(mt::fake_shared(mock_msg_sender), mt::fake_shared(mock_buffer_packer))
+        : event_sender(mt::fake_shared(mock_msg_sender), mt::fake_shared(mock_buffer_packer), mr::null_input_report(), -1)
     {
     }
     MockMsgSender mock_msg_sender;
@@ -179,6 +182,27 @@ TEST_F(EventSender, sends_input_events)
     event_sender.handle_event(move(ev));
 }
 
+TEST_F(EventSender, reports_published_input_events)
+{
+    using namespace testing;
+
+    int const client_fd{42};
+    std::chrono::nanoseconds const event_time{12345};
+    auto const report = std::make_shared<NiceMock<mtd::MockInputReport>>();
+    mfd::EventSender reporting_sender{
+        mt::fake_shared(mock_msg_sender), mt::fake_shared(mock_buffer_packer), report, client_fd};
+
+    auto key_ev = mev::make_event(MirInputDeviceId(), event_time, std::vector<uint8_t>{}, MirKeyboardAction(),
+                                  0, 0, MirInputEventModifiers());
+    auto surface_ev = mev::make_event(mf::SurfaceId{1}, mir_window_attrib_focus, mir_window_focus_state_focused);
+
+    EXPECT_CALL(*report, published_key_event(client_fd, _, event_time.count()));
+    EXPECT_CALL(*report, published_motion_event(_, _, _)).Times(0);
+
+    reporting_sender.handle_event(move(key_ev));
+    reporting_sender.handle_event(move(surface_ev));
+}
+
 TEST_F(EventSender, packs_buffer_with_platform_packer)
 {
     using namespace testing;
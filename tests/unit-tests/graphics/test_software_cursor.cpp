@@ -49,11 +49,11 @@ struct MockInputScene : mtd::StubInputScene
 
 struct StubCursorImage : mg::CursorImage
 {
-    StubCursorImage(geom::Displacement const& hotspot)
+    StubCursorImage(geom::Displacement const& hotspot, unsigned char fill = 0x55)
         : hotspot_{hotspot},
           pixels(
             size().width.as_uint32_t() * size().height.as_uint32_t() * bytes_per_pixel,
-            0x55)
+            fill)
     {
     }
 
@@ -81,7 +81,7 @@ private:
 struct SoftwareCursor : testing::Test
 {
     StubCursorImage stub_cursor_image{{3,4}};
-    StubCursorImage another_stub_cursor_image{{10,9}};
+    StubCursorImage another_stub_cursor_image{{10,9}, 0xaa};
     mtd::StubBufferAllocator stub_buffer_allocator;
     testing::NiceMock<MockInputScene> mock_input_scene;
 
@@ -295,7 +295,7 @@ TEST_F(SoftwareCursor, places_new_cursor_renderable_at_correct_position)
 }
 
 //lp: #1413211
-TEST_F(SoftwareCursor, new_buffer_on_each_show)
+TEST_F(SoftwareCursor, new_buffer_for_each_new_image)
 {
     struct MockBufferAllocator : public mg::GraphicBufferAllocator
     {
@@ -306,8 +306,9 @@ TEST_F(SoftwareCursor, new_buffer_on_each_show)
     } mock_allocator;
 
     EXPECT_CALL(mock_allocator, alloc_buffer(testing::_))
-        .Times(3)
-        .WillRepeatedly(testing::Return(std::make_shared<mtd::StubBuffer>()));;
+        .Times(2)
+        .WillRepeatedly(testing::Invoke([](mg::BufferProperties const&)
+            { return std::make_shared<mtd::StubBuffer>(); }));
     mg::SoftwareCursor cursor{
         mt::fake_shared(mock_allocator),
         mt::fake_shared(mock_input_scene)};
@@ -316,6 +317,24 @@ TEST_F(SoftwareCursor, new_buffer_on_each_show)
     cursor.show(stub_cursor_image);
 }
 
+TEST_F(SoftwareCursor, reuses_buffer_of_previously_shown_image)
+{
+    using namespace testing;
+
+    std::vector<std::shared_ptr<mg::Renderable>> renderables;
+
+    EXPECT_CALL(mock_input_scene, add_input_visualization(_))
+        .WillRepeatedly(Invoke([&](std::shared_ptr<mg::Renderable> const& r) { renderables.push_back(r); }));
+
+    cursor.show(stub_cursor_image);
+    cursor.show(another_stub_cursor_image);
+    cursor.show(stub_cursor_image);
+
+    ASSERT_THAT(renderables.size(), Eq(3u));
+    EXPECT_THAT(renderables[2]->buffer(), Eq(renderables[0]->buffer()));
+    EXPECT_THAT(renderables[1]->buffer(), Ne(renderables[0]->buffer()));
+}
+
 //lp: 1483779
 TEST_F(SoftwareCursor, doesnt_try_to_remove_after_hiding)
 {
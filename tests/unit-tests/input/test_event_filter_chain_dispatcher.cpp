@@ -18,8 +18,10 @@
 
 #include "src/server/input/event_filter_chain_dispatcher.h"
 #include "src/server/input/null_input_dispatcher.h"
+#include "src/server/report/null_report_factory.h"
 #include "mir/test/doubles/mock_event_filter.h"
 #include "mir/test/doubles/mock_input_dispatcher.h"
+#include "mir/test/doubles/mock_input_report.h"
 #include "mir/events/event_builders.h"
 #include "mir/events/event_private.h"
 
@@ -28,6 +30,7 @@
 
 namespace mi = mir::input;
 namespace mtd = mir::test::doubles;
+namespace mr = mir::report;
 
 using namespace ::testing;
 
@@ -50,7 +53,7 @@ TEST_F(EventFilterChainDispatcher, offers_events_to_filters)
 {
     auto filter = mock_filter();
     mi::EventFilterChainDispatcher filter_chain({filter, filter},
-        std::make_shared<mi::NullInputDispatcher>());
+        std::make_shared<mi::NullInputDispatcher>(), mr::null_input_report());
     
     // Filter will pass the event on twice
     EXPECT_CALL(*filter, handle(_)).Times(2).WillRepeatedly(Return(false));
@@ -65,7 +68,7 @@ TEST_F(EventFilterChainDispatcher, prepends_appends_filters)
     auto filter3 = mock_filter();
 
     mi::EventFilterChainDispatcher filter_chain({filter2},
-        std::make_shared<mi::NullInputDispatcher>());
+        std::make_shared<mi::NullInputDispatcher>(), mr::null_input_report());
     
     filter_chain.append(filter3);
     filter_chain.prepend(filter1);
@@ -84,7 +87,8 @@ TEST_F(EventFilterChainDispatcher, accepting_event_halts_emission)
 {
     auto filter = mock_filter();
 
-    mi::EventFilterChainDispatcher filter_chain({filter, filter, filter}, std::make_shared<mi::NullInputDispatcher>());
+    mi::EventFilterChainDispatcher filter_chain({filter, filter, filter},
+        std::make_shared<mi::NullInputDispatcher>(), mr::null_input_report());
 
     // First filter will reject, second will accept, third one should not be asked.
     {
@@ -100,7 +104,8 @@ TEST_F(EventFilterChainDispatcher, does_not_own_event_filters)
 {
     auto filter = mock_filter();
 
-    mi::EventFilterChainDispatcher filter_chain({filter}, std::make_shared<mi::NullInputDispatcher>());
+    mi::EventFilterChainDispatcher filter_chain({filter},
+        std::make_shared<mi::NullInputDispatcher>(), mr::null_input_report());
     EXPECT_CALL(*filter, handle(_)).Times(1).WillOnce(Return(true));
     EXPECT_TRUE(filter_chain.handle(*event));
     filter.reset();
@@ -111,7 +116,7 @@ TEST_F(EventFilterChainDispatcher, does_not_own_event_filters)
 TEST_F(EventFilterChainDispatcher, forwards_start_and_stop)
 {
     auto mock_next_dispatcher = std::make_shared<mtd::MockInputDispatcher>();
-    mi::EventFilterChainDispatcher filter_chain({}, mock_next_dispatcher);
+    mi::EventFilterChainDispatcher filter_chain({}, mock_next_dispatcher, mr::null_input_report());
 
     InSequence seq;
     EXPECT_CALL(*mock_next_dispatcher, start()).Times(1);
@@ -120,3 +125,34 @@ TEST_F(EventFilterChainDispatcher, forwards_start_and_stop)
     filter_chain.start();
     filter_chain.stop();
 }
+
+TEST_F(EventFilterChainDispatcher, reports_dispatch_of_events_not_handled_by_filters)
+{
+    auto const filter = mock_filter();
+    auto const report = std::make_shared<NiceMock<mtd::MockInputReport>>();
+    std::chrono::nanoseconds const event_time{12345};
+    std::shared_ptr<MirEvent const> const unhandled = mir::events::make_event(MirInputDeviceId(),
+        event_time, std::vector<uint8_t>{}, MirKeyboardAction(), xkb_keysym_t(), 0, MirInputEventModifiers());
+
+    mi::EventFilterChainDispatcher filter_chain({filter}, std::make_shared<mi::NullInputDispatcher>(), report);
+
+    EXPECT_CALL(*filter, handle(_)).WillOnce(Return(false));
+    EXPECT_CALL(*report, dispatched_event(event_time.count()));
+
+    filter_chain.dispatch(unhandled);
+}
+
+TEST_F(EventFilterChainDispatcher, does_not_report_dispatch_of_filtered_events)
+{
+    auto const filter = mock_filter();
+    auto const report = std::make_shared<NiceMock<mtd::MockInputReport>>();
+    std::shared_ptr<MirEvent const> const handled = mir::events::make_event(MirInputDeviceId(),
+        std::chrono::nanoseconds(0), std::vector<uint8_t>{}, MirKeyboardAction(), xkb_keysym_t(), 0, MirInputEventModifiers());
+
+    mi::EventFilterChainDispatcher filter_chain({filter}, std::make_shared<mi::NullInputDispatcher>(), report);
+
+    EXPECT_CALL(*filter, handle(_)).WillOnce(Return(true));
+    EXPECT_CALL(*report, dispatched_event(_)).Times(0);
+
+    filter_chain.dispatch(handled);
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/logging/input_report.h"
+#include "mir/logging/logger.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+namespace mtd = mir::test::doubles;
+namespace mrl = mir::report::logging;
+namespace ml = mir::logging;
+
+using namespace std::chrono;
+using namespace testing;
+
+namespace
+{
+class Recorder : public ml::Logger
+{
+public:
+    void log(ml::Severity, std::string const& message, std::string const&) override
+    {
+        messages.push_back(message);
+    }
+
+    std::vector<std::string> summaries() const
+    {
+        std::vector<std::string> result;
+        for (auto const& message : messages)
+        {
+            if (message.find("Latency summary") != std::string::npos)
+                result.push_back(message);
+        }
+        return result;
+    }
+
+    std::vector<std::string> messages;
+};
+
+struct LoggingInputReport : Test
+{
+    std::shared_ptr<mtd::FakeAlarmFactory> const alarm_factory = std::make_shared<mtd::FakeAlarmFactory>();
+    std::shared_ptr<Recorder> const recorder = std::make_shared<Recorder>();
+    mrl::InputReport report{recorder, alarm_factory->clock(), alarm_factory};
+
+    int64_t event_time_ago(nanoseconds age) const
+    {
+        return (alarm_factory->clock()->now().time_since_epoch() - age).count();
+    }
+};
+}
+
+TEST_F(LoggingInputReport, does_not_log_summary_before_interval_elapses)
+{
+    report.dispatched_event(event_time_ago(milliseconds{1}));
+    alarm_factory->advance_by(seconds{1});
+    report.dispatched_event(event_time_ago(milliseconds{1}));
+    alarm_factory->advance_by(seconds{1});
+
+    EXPECT_THAT(recorder->summaries(), IsEmpty());
+}
+
+TEST_F(LoggingInputReport, logs_summary_per_stage_once_interval_elapses)
+{
+    report.received_event_from_kernel(event_time_ago(microseconds{100}), 0, 0, 0);
+    report.dispatched_event(event_time_ago(milliseconds{2}));
+    report.published_key_event(3, 0, event_time_ago(milliseconds{3}));
+    report.published_motion_event(3, 1, event_time_ago(milliseconds{3}));
+
+    // No further input arrives to trigger the summary
+    alarm_factory->advance_by(seconds{11});
+
+    auto const summaries = recorder->summaries();
+    ASSERT_THAT(summaries.size(), Eq(3u));
+    EXPECT_THAT(summaries[0], HasSubstr("stage=read count=1"));
+    EXPECT_THAT(summaries[1], HasSubstr("stage=dispatch count=1 p50=2.000ms"));
+    EXPECT_THAT(summaries[2], HasSubstr("stage=publish count=2 p50=3.000ms"));
+}
+
+TEST_F(LoggingInputReport, starts_a_fresh_histogram_after_each_summary)
+{
+    report.dispatched_event(event_time_ago(milliseconds{8}));
+    alarm_factory->advance_by(seconds{11});
+
+    report.dispatched_event(event_time_ago(milliseconds{1}));
+    alarm_factory->advance_by(seconds{11});
+
+    auto const summaries = recorder->summaries();
+    ASSERT_THAT(summaries.size(), Eq(2u));
+    EXPECT_THAT(summaries[1], HasSubstr("count=1 p50=1.000ms"));
+}
+
+TEST_F(LoggingInputReport, does_not_wake_without_input)
+{
+    report.dispatched_event(event_time_ago(milliseconds{1}));
+    alarm_factory->advance_by(seconds{11});
+    ASSERT_THAT(recorder->summaries().size(), Eq(1u));
+
+    alarm_factory->advance_by(seconds{60});
+
+    EXPECT_THAT(recorder->summaries().size(), Eq(1u));
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/latency_histogram.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+
+namespace ml = mir::logging;
+
+using namespace std::chrono;
+using namespace testing;
+
+TEST(LatencyHistogram, is_empty_when_constructed)
+{
+    ml::LatencyHistogram histogram;
+
+    EXPECT_THAT(histogram.count(), Eq(0u));
+    EXPECT_THAT(histogram.percentile(99), Eq(nanoseconds{0}));
+    EXPECT_THAT(histogram.max(), Eq(nanoseconds{0}));
+}
+
+TEST(LatencyHistogram, bucket_bounds_contain_their_values)
+{
+    for (unsigned int bucket = 0; bucket != ml::LatencyHistogram::bucket_count; ++bucket)
+    {
+        auto const upper = ml::LatencyHistogram::bucket_upper_bound(bucket);
+        EXPECT_THAT(ml::LatencyHistogram::bucket_for(upper - 1), Eq(bucket));
+        if (bucket + 1 != ml::LatencyHistogram::bucket_count)
+        {
+            EXPECT_THAT(ml::LatencyHistogram::bucket_for(upper), Eq(bucket + 1));
+        }
+    }
+}
+
+TEST(LatencyHistogram, clamps_huge_values_into_last_bucket)
+{
+    EXPECT_THAT(ml::LatencyHistogram::bucket_for(uint64_t{1} << 40), Eq(ml::LatencyHistogram::bucket_count - 1));
+}
+
+TEST(LatencyHistogram, percentiles_are_within_bucket_precision)
+{
+    ml::LatencyHistogram histogram;
+
+    for (int i = 1; i <= 1000; ++i)
+        histogram.record(microseconds{i});
+
+    EXPECT_THAT(histogram.count(), Eq(1000u));
+    EXPECT_THAT(histogram.max(), Eq(microseconds{1000}));
+
+    auto const p50 = duration_cast<microseconds>(histogram.percentile(50)).count();
+    auto const p99 = duration_cast<microseconds>(histogram.percentile(99)).count();
+
+    EXPECT_THAT(p50, AllOf(Ge(500), Le(625)));
+    EXPECT_THAT(p99, AllOf(Ge(990), Le(1000)));
+}
+
+TEST(LatencyHistogram, treats_negative_latency_as_zero)
+{
+    ml::LatencyHistogram histogram;
+
+    histogram.record(microseconds{-5});
+
+    EXPECT_THAT(histogram.count(), Eq(1u));
+    EXPECT_THAT(histogram.max(), Eq(nanoseconds{0}));
+}
+
+TEST(LatencyHistogram, reset_discards_samples)
+{
+    ml::LatencyHistogram histogram;
+
+    histogram.record(milliseconds{3});
+    histogram.reset();
+
+    EXPECT_THAT(histogram.count(), Eq(0u));
+    EXPECT_THAT(histogram.max(), Eq(nanoseconds{0}));
+}
+
+TEST(LatencyHistogram, summary_reports_percentiles)
+{
+    ml::LatencyHistogram histogram;
+
+    histogram.record(milliseconds{2});
+
+    EXPECT_THAT(histogram.summary(), StartsWith("count=1 p50=2.000ms p90=2.000ms p99=2.000ms max=2.000ms"));
+}
+
+TEST(LatencyHistogram, records_concurrently)
+{
+    ml::LatencyHistogram histogram;
+    int const threads = 4;
+    int const samples = 10000;
+
+    std::vector<std::thread> recorders;
+    for (int i = 0; i != threads; ++i)
+    {
+        recorders.emplace_back([&histogram]
+            {
+                for (int j = 0; j != samples; ++j)
+                    histogram.record(microseconds{j});
+            });
+    }
+
+    for (auto& t : recorders)
+        t.join();
+
+    EXPECT_THAT(histogram.count(), Eq(uint64_t{threads * samples}));
+    EXPECT_THAT(histogram.max(), Eq(microseconds{samples - 1}));
+}
@@ -50,10 +50,35 @@ struct MockKMSOutput : public graphics::mesa::KMSOutput
     }
 
     MOCK_METHOD1(set_crtc_thunk, bool(graphics::mesa::FBHandle const*));
+
+    bool add_crtc_to(graphics::mesa::AtomicKMSCommit& commit, graphics::mesa::FBHandle const& fb) override
+    {
+        return add_crtc_to_thunk(&commit, &fb);
+    }
+
+    MOCK_METHOD2(add_crtc_to_thunk, bool(graphics::mesa::AtomicKMSCommit*, graphics::mesa::FBHandle const*));
+    MOCK_METHOD0(overlay_planes, std::vector<uint32_t>());
+
+    bool add_frame_to(
+        graphics::mesa::AtomicKMSCommit& commit,
+        graphics::mesa::FBHandle const& fb,
+        std::vector<graphics::mesa::OverlayPlane> const& overlays) override
+    {
+        return add_frame_to_thunk(&commit, &fb, overlays);
+    }
+
+    MOCK_METHOD3(add_frame_to_thunk, bool(
+        graphics::mesa::AtomicKMSCommit*,
+        graphics::mesa::FBHandle const*,
+        std::vector<graphics::mesa::OverlayPlane> const&));
+    MOCK_METHOD0(crtc_is_unchanged, bool());
     MOCK_METHOD0(clear_crtc, void());
 
-    bool schedule_page_flip(graphics::mesa::FBHandle const& fb) override
+    bool schedule_page_flip(
+        graphics::mesa::FBHandle const& fb,
+        std::function<void()> const& on_flipped) override
     {
+        on_page_flipped = on_flipped;
         return schedule_page_flip_thunk(&fb);
     }
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::mesa::FBHandle const*));
@@ -68,6 +93,8 @@ struct MockKMSOutput : public graphics::mesa::KMSOutput
 
     MOCK_METHOD1(set_power_mode, void(MirPowerMode));
     MOCK_METHOD1(set_gamma, void(mir::graphics::GammaCurves const&));
+    MOCK_METHOD1(set_adaptive_sync, void(bool));
+    MOCK_CONST_METHOD0(adaptive_sync, bool());
 
     MOCK_METHOD0(refresh_hardware_state, void());
     MOCK_CONST_METHOD1(update_from_hardware_state, void(graphics::DisplayConfigurationOutput&));
@@ -75,6 +102,9 @@ struct MockKMSOutput : public graphics::mesa::KMSOutput
     MOCK_CONST_METHOD1(fb_for, graphics::mesa::FBHandle*(gbm_bo*));
     MOCK_CONST_METHOD1(buffer_requires_migration, bool(gbm_bo*));
     MOCK_CONST_METHOD0(drm_fd, int());
+
+    /// The completion callback of the last page flip scheduled
+    std::function<void()> on_page_flipped;
 };
 
 } // namespace test
@@ -268,3 +268,22 @@ TEST_F(BypassMatchTest, multimonitor_oversized_no_bypass)
     EXPECT_EQ(list.rend(), std::find_if(list.rbegin(), list.rend(), primary_matcher));
     EXPECT_EQ(list.rend(), std::find_if(list.rbegin(), list.rend(), secondary_matcher));
 }
+
+TEST_F(BypassMatchTest, opaque_window_on_the_monitor_can_be_overlaid)
+{
+    mgm::OverlayMatch matcher(primary_monitor);
+
+    EXPECT_TRUE(matcher(std::make_shared<mtd::FakeRenderable>(100, 100, 640, 480)));
+}
+
+TEST_F(BypassMatchTest, translucent_shaped_or_offscreen_windows_are_not_overlaid)
+{
+    mgm::OverlayMatch matcher(primary_monitor);
+
+    EXPECT_FALSE(matcher(
+        std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{100, 100}, {640, 480}}, 0.5f)));
+    EXPECT_FALSE(matcher(
+        std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{100, 100}, {640, 480}}, 1.0f, false)));
+    EXPECT_FALSE(matcher(std::make_shared<mtd::FakeRenderable>(1600, 100, 640, 480)));
+    EXPECT_FALSE(matcher(std::make_shared<mtd::FakeRenderable>(2000, 100, 640, 480)));
+}
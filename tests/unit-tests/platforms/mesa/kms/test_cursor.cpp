@@ -21,7 +21,7 @@
 #include "src/platforms/mesa/server/kms/kms_output_container.h"
 #include "src/platforms/mesa/server/kms/kms_display_configuration.h"
 
-#include "mir/graphics/cursor_image.h"
+#include "mir/graphics/animated_cursor_image.h"
 
 #include <xf86drm.h>
 
@@ -29,12 +29,14 @@
 #include "mir/test/doubles/mock_drm.h"
 #include "mir/test/doubles/stub_display_configuration.h"
 #include "mir/test/fake_shared.h"
+#include "mir/test/signal.h"
 #include "mir_test_framework/temporary_environment_value.h"
 #include "mock_kms_output.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <atomic>
 #include <unordered_map>
 #include <algorithm>
 
@@ -343,6 +345,40 @@ struct SinglePixelCursorImage : public StubCursorImage
     geom::Size const small_cursor_size{cursor_side, cursor_side};
 };
 
+struct TwoFrameCursorImage : public mg::AnimatedCursorImage
+{
+    void const* as_argb_8888() const override
+    {
+        return first.as_argb_8888();
+    }
+    geom::Size size() const override
+    {
+        return first.size();
+    }
+    geom::Displacement hotspot() const override
+    {
+        return first.hotspot();
+    }
+
+    size_t frame_count() const override
+    {
+        return 2;
+    }
+    mg::CursorImage const& frame(size_t index) const override
+    {
+        if (index == 0)
+            return first;
+        return second;
+    }
+    std::chrono::milliseconds frame_delay(size_t) const override
+    {
+        return std::chrono::milliseconds{1};
+    }
+
+    StubCursorImage first;
+    SinglePixelCursorImage second;
+};
+
 }
 
 TEST_F(MesaCursorTest, creates_cursor_bo_image)
@@ -806,3 +842,43 @@ TEST_F(MesaCursorTest, show_cursor_sets_cursor_with_hotspot)
     cursor.move_to(cursor_location_2);
 }
 
+
+TEST_F(MesaCursorTest, showing_a_previously_shown_image_does_not_rewrite_the_bo)
+{
+    using namespace testing;
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _)).Times(2);
+    EXPECT_CALL(*output_container.outputs[0], set_cursor(_)).Times(3);
+
+    cursor.show(stub_image);
+    cursor.show(SinglePixelCursorImage());
+    cursor.show(stub_image);
+}
+
+TEST_F(MesaCursorTest, animated_cursor_cycles_through_its_frames_without_rewriting_them)
+{
+    using namespace testing;
+    using namespace std::chrono_literals;
+
+    TwoFrameCursorImage animation;
+    std::atomic<int> frames_shown{0};
+    mt::Signal shown_both_frames_twice;
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _)).Times(2);
+    EXPECT_CALL(*output_container.outputs[0], set_cursor(_))
+        .Times(AtLeast(4))
+        .WillRepeatedly(InvokeWithoutArgs(
+            [&]
+            {
+                if (++frames_shown == 4)
+                    shown_both_frames_twice.raise();
+                return true;
+            }));
+
+    cursor.show(animation);
+
+    EXPECT_TRUE(shown_both_frames_twice.wait_for(10s));
+
+    // Stop animating before the expectations go out of scope
+    cursor.show(stub_image);
+}
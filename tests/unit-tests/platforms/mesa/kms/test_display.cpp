@@ -57,6 +57,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <fcntl.h>
+#include <cstring>
 
 namespace mg=mir::graphics;
 namespace mgm=mir::graphics::mesa;
@@ -168,6 +169,68 @@ public:
             .WillOnce(DoAll(SetArgPointee<7>(fake.fb_id2), Return(0)));
     }
 
+    /*
+     * Advertise atomic modesetting, with a primary plane usable on every CRTC
+     * and the properties an atomic modeset needs.
+     */
+    void enable_atomic_kms()
+    {
+        using namespace testing;
+
+        ON_CALL(mock_drm, drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1))
+            .WillByDefault(Return(0));
+
+        plane_resources.count_planes = 1;
+        plane_resources.planes = &primary_plane.plane_id;
+        primary_plane.plane_id = 40;
+        primary_plane.possible_crtcs = 0x3;
+
+        ON_CALL(mock_drm, drmModeGetPlaneResources(drm_fd))
+            .WillByDefault(Return(&plane_resources));
+        ON_CALL(mock_drm, drmModeGetPlane(drm_fd, primary_plane.plane_id))
+            .WillByDefault(Return(&primary_plane));
+
+        char const* const crtc_prop_names[] = {"MODE_ID", "ACTIVE"};
+        char const* const connector_prop_names[] = {"CRTC_ID"};
+        char const* const plane_prop_names[] = {
+            "type", "FB_ID", "CRTC_ID",
+            "SRC_X", "SRC_Y", "SRC_W", "SRC_H",
+            "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H"};
+
+        auto const add_props =
+            [this](AtomicObject& object, uint32_t type, auto const& names)
+            {
+                for (auto name : names)
+                {
+                    drmModePropertyRes prop = drmModePropertyRes();
+                    prop.prop_id = 100 + atomic_props.size();
+                    strncpy(prop.name, name, DRM_PROP_NAME_LEN - 1);
+                    atomic_props.push_back(prop);
+
+                    object.prop_ids.push_back(prop.prop_id);
+                    object.values.push_back(
+                        strcmp(name, "type") == 0 ? DRM_PLANE_TYPE_PRIMARY : 0);
+                }
+                object.props.count_props = object.prop_ids.size();
+                object.props.props = object.prop_ids.data();
+                object.props.prop_values = object.values.data();
+
+                ON_CALL(mock_drm, drmModeObjectGetProperties(drm_fd, _, type))
+                    .WillByDefault(Return(&object.props));
+            };
+
+        atomic_props.reserve(16);
+        add_props(atomic_crtc, DRM_MODE_OBJECT_CRTC, crtc_prop_names);
+        add_props(atomic_connector, DRM_MODE_OBJECT_CONNECTOR, connector_prop_names);
+        add_props(atomic_plane, DRM_MODE_OBJECT_PLANE, plane_prop_names);
+
+        for (auto& prop : atomic_props)
+        {
+            ON_CALL(mock_drm, drmModeGetProperty(drm_fd, prop.prop_id))
+                .WillByDefault(Return(&prop));
+        }
+    }
+
     uint32_t get_connected_connector_id()
     {
         mg::kms::DRMModeResources resources{drm_fd};
@@ -219,6 +282,20 @@ public:
         drmModeCrtc crtc;
     } fake;
 
+    struct AtomicObject
+    {
+        drmModeObjectProperties props = drmModeObjectProperties();
+        std::vector<uint32_t> prop_ids;
+        std::vector<uint64_t> values;
+    };
+
+    drmModePlaneRes plane_resources = drmModePlaneRes();
+    drmModePlane primary_plane = drmModePlane();
+    std::vector<drmModePropertyRes> atomic_props;
+    AtomicObject atomic_crtc;
+    AtomicObject atomic_connector;
+    AtomicObject atomic_plane;
+
     ::testing::NiceMock<mtd::MockEGL> mock_egl;
     ::testing::NiceMock<mtd::MockGL> mock_gl;
     ::testing::NiceMock<mtd::MockDRM> mock_drm;
@@ -294,6 +371,99 @@ TEST_F(MesaDisplayTest, create_display)
     auto display = create_display(create_platform());
 }
 
+TEST_F(MesaDisplayTest, create_display_with_atomic_kms_sets_crtcs_in_one_validated_commit)
+{
+    using namespace testing;
+
+    enable_atomic_kms();
+
+    auto const connector_id = get_connected_connector_id();
+    auto const crtc_id = get_connected_crtc_id();
+
+    ON_CALL(mock_gbm, gbm_surface_lock_front_buffer(mock_gbm.fake_gbm.surface))
+        .WillByDefault(Return(fake.bo1));
+    ON_CALL(mock_gbm, gbm_bo_get_handle(fake.bo1))
+        .WillByDefault(Return(fake.bo_handle1));
+    ON_CALL(mock_drm, drmModeAddFB2(drm_fd, _, _, _, _, _, _, _, _))
+        .WillByDefault(DoAll(SetArgPointee<7>(fake.fb_id1), Return(0)));
+
+    auto const fb_id_prop = atomic_plane.prop_ids[1];
+    auto const crtc_id_prop = atomic_connector.prop_ids[0];
+
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, _, _, _)).Times(AnyNumber());
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, connector_id, crtc_id_prop, crtc_id));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, primary_plane.plane_id, fb_id_prop, fake.fb_id1));
+
+    {
+        InSequence validate_then_commit;
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+            .WillOnce(Return(0));
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+            .WillOnce(Return(0));
+    }
+
+    /* The only legacy modesets are the cleanup on destruction */
+    EXPECT_CALL(mock_drm, drmModeSetCrtc(drm_fd, _, fake.fb_id1, _, _, _, _, _))
+        .Times(0);
+
+    auto display = create_display(create_platform());
+}
+
+TEST_F(MesaDisplayTest, configuration_rejected_by_atomic_test_commit_is_not_applied)
+{
+    using namespace testing;
+
+    enable_atomic_kms();
+
+    auto display = create_display(create_platform());
+    auto conf = display->configuration();
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+        .WillOnce(Return(-EINVAL));
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+        .Times(0);
+
+    conf->for_each_output(
+        [](mg::UserDisplayConfigurationOutput& output)
+        {
+            output.current_mode_index = (output.current_mode_index + 1) % output.modes.size();
+        });
+
+    EXPECT_THROW(display->configure(*conf), std::runtime_error);
+}
+
+TEST_F(MesaDisplayTest, configuration_that_fails_to_commit_restores_the_previous_one)
+{
+    using namespace testing;
+
+    enable_atomic_kms();
+
+    auto display = create_display(create_platform());
+    auto conf = display->configuration();
+
+    {
+        InSequence fail_then_restore;
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+            .WillOnce(Return(0));
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+            .WillOnce(Return(-EINVAL));
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+            .WillOnce(Return(0));
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+            .WillOnce(Return(0));
+    }
+
+    auto new_conf = display->configuration();
+    new_conf->for_each_output(
+        [](mg::UserDisplayConfigurationOutput& output)
+        {
+            output.current_mode_index = (output.current_mode_index + 1) % output.modes.size();
+        });
+
+    EXPECT_THROW(display->configure(*new_conf), std::runtime_error);
+    EXPECT_EQ(*conf, *display->configuration());
+}
+
 TEST_F(MesaDisplayTest, reset_crtc_on_destruction)
 {
     using namespace testing;
@@ -878,3 +1048,38 @@ TEST_F(MesaDisplayTest, can_change_configuration_metadata_without_invalidating_d
         EXPECT_THAT(display_buffer->transformation(), Eq(rotate_inverted));
     }
 }
+
+TEST_F(MesaDisplayTest, can_move_outputs_without_invalidating_display_buffers)
+{
+    using namespace testing;
+
+    auto display = create_display(create_platform());
+
+    auto config = display->configuration();
+
+    std::vector<std::pair<mg::DisplayBuffer*, mir::geometry::Rectangle>> initial_display_buffers;
+
+    display->for_each_display_sync_group(
+        [&initial_display_buffers](auto& group)
+        {
+            group.for_each_display_buffer(
+                [&initial_display_buffers](mg::DisplayBuffer& db)
+                {
+                    initial_display_buffers.emplace_back(&db, db.view_area());
+                });
+        });
+
+    mir::geometry::Displacement const move{100, 50};
+    config->for_each_output(
+        [move](mg::UserDisplayConfigurationOutput& output)
+        {
+            output.top_left = output.top_left + move;
+        });
+
+    EXPECT_TRUE(display->apply_if_configuration_preserves_display_buffers(*config));
+
+    for (auto const& display_buffer : initial_display_buffers)
+    {
+        EXPECT_THAT(display_buffer.first->view_area().top_left, Eq(display_buffer.second.top_left + move));
+    }
+}
@@ -33,6 +33,7 @@
 #include "mir/test/doubles/fake_renderable.h"
 #include "mir/graphics/transformation.h"
 #include "mock_kms_output.h"
+#include "src/platforms/mesa/server/kms/atomic_kms_commit.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -187,6 +188,84 @@ TEST_F(MesaDisplayBufferTest, bypass_buffer_is_held_for_full_frame)
     EXPECT_EQ(original_count, mock_bypassable_buffer.use_count());
 }
 
+TEST_F(MesaDisplayBufferTest, replaced_bypass_buffer_is_released_once_the_flip_completes)
+{
+    auto const next_bypassable_buffer = std::make_shared<NiceMock<MockBuffer>>();
+    ON_CALL(*next_bypassable_buffer, size())
+        .WillByDefault(Return(display_area.size));
+    ON_CALL(*next_bypassable_buffer, native_buffer_handle())
+        .WillByDefault(Return(stub_gbm_native_buffer));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    auto original_count = mock_bypassable_buffer.use_count();
+
+    ASSERT_TRUE(db.overlay(bypassable_list));
+    db.post();
+    mock_kms_output->on_page_flipped();
+
+    fake_bypassable_renderable->set_buffer(next_bypassable_buffer);
+    ASSERT_TRUE(db.overlay(bypassable_list));
+    db.post();
+
+    // Still on screen till the flip completes...
+    EXPECT_EQ(original_count+1, mock_bypassable_buffer.use_count());
+
+    // ...and released as it does, without waiting for another frame
+    mock_kms_output->on_page_flipped();
+    EXPECT_EQ(original_count, mock_bypassable_buffer.use_count());
+}
+
+TEST_F(MesaDisplayBufferTest, replaced_bypass_buffer_is_released_once_every_clone_has_flipped)
+{
+    auto const next_bypassable_buffer = std::make_shared<NiceMock<MockBuffer>>();
+    ON_CALL(*next_bypassable_buffer, size())
+        .WillByDefault(Return(display_area.size));
+    ON_CALL(*next_bypassable_buffer, native_buffer_handle())
+        .WillByDefault(Return(stub_gbm_native_buffer));
+
+    auto const clone_kms_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*clone_kms_output, schedule_page_flip_thunk(_))
+        .WillByDefault(Return(true));
+    ON_CALL(*clone_kms_output, max_refresh_rate())
+        .WillByDefault(Return(mock_refresh_rate));
+    ON_CALL(*clone_kms_output, fb_for(_))
+        .WillByDefault(Return(reinterpret_cast<FBHandle*>(0x12ad)));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, clone_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    auto original_count = mock_bypassable_buffer.use_count();
+
+    ASSERT_TRUE(db.overlay(bypassable_list));
+    db.post();
+    mock_kms_output->on_page_flipped();
+    clone_kms_output->on_page_flipped();
+
+    fake_bypassable_renderable->set_buffer(next_bypassable_buffer);
+    ASSERT_TRUE(db.overlay(bypassable_list));
+    db.post();
+
+    // The first output is showing the new frame, but the clone isn't yet...
+    mock_kms_output->on_page_flipped();
+    EXPECT_EQ(original_count+1, mock_bypassable_buffer.use_count());
+
+    // ...and once it is, nothing shows the old one
+    clone_kms_output->on_page_flipped();
+    EXPECT_EQ(original_count, mock_bypassable_buffer.use_count());
+}
+
 TEST_F(MesaDisplayBufferTest, predictive_bypass_is_throttled)
 {
     graphics::mesa::DisplayBuffer db(
@@ -209,6 +288,28 @@ TEST_F(MesaDisplayBufferTest, predictive_bypass_is_throttled)
     }
 }
 
+TEST_F(MesaDisplayBufferTest, bypass_on_an_adaptive_sync_output_is_not_throttled)
+{
+    ON_CALL(*mock_kms_output, adaptive_sync())
+        .WillByDefault(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    for (int frame = 0; frame < 5; ++frame)
+    {
+        ASSERT_TRUE(db.overlay(bypassable_list));
+        db.post();
+
+        ASSERT_EQ(0, db.recommended_sleep().count());
+    }
+}
+
 TEST_F(MesaDisplayBufferTest, frames_requiring_gl_are_not_throttled)
 {
     graphics::RenderableList non_bypassable_list{
@@ -396,14 +497,16 @@ TEST_F(MesaDisplayBufferTest, clone_mode_first_flip_flips_but_no_wait)
 
     db.swap_buffers();
     db.post();
+    Mock::VerifyAndClearExpectations(mock_kms_output.get());
 }
 
-TEST_F(MesaDisplayBufferTest, single_mode_first_post_flips_with_wait)
+TEST_F(MesaDisplayBufferTest, single_mode_first_post_flips_but_no_wait)
 {
+    // The flip completes in the background while the next frame is rendered
     EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
         .Times(1);
     EXPECT_CALL(*mock_kms_output, wait_for_page_flip())
-        .Times(1);
+        .Times(0);
 
     graphics::mesa::DisplayBuffer db(
         graphics::mesa::BypassOption::allowed,
@@ -415,6 +518,7 @@ TEST_F(MesaDisplayBufferTest, single_mode_first_post_flips_with_wait)
 
     db.swap_buffers();
     db.post();
+    Mock::VerifyAndClearExpectations(mock_kms_output.get());
 }
 
 TEST_F(MesaDisplayBufferTest, clone_mode_waits_for_page_flip_on_second_flip)
@@ -445,6 +549,24 @@ TEST_F(MesaDisplayBufferTest, clone_mode_waits_for_page_flip_on_second_flip)
 
     db.swap_buffers();
     db.post();
+    Mock::VerifyAndClearExpectations(mock_kms_output.get());
+}
+
+TEST_F(MesaDisplayBufferTest, destruction_waits_for_the_last_page_flip)
+{
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+
+    EXPECT_CALL(*mock_kms_output, wait_for_page_flip())
+        .Times(1);
 }
 
 TEST_F(MesaDisplayBufferTest, skips_bypass_because_of_incompatible_list)
@@ -505,3 +627,144 @@ TEST_F(MesaDisplayBufferTest, buffer_requiring_migration_is_ineligable_for_bypas
 
     EXPECT_FALSE(db.overlay(bypassable_list));
 }
+
+TEST_F(MesaDisplayBufferTest, resuming_on_an_unchanged_crtc_flips_without_a_modeset)
+{
+    ON_CALL(*mock_kms_output, crtc_is_unchanged())
+        .WillByDefault(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, set_crtc_thunk(_))
+        .Times(0);
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(1);
+
+    db.schedule_set_crtc_if_changed();
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, resuming_on_a_changed_crtc_sets_the_crtc)
+{
+    ON_CALL(*mock_kms_output, crtc_is_unchanged())
+        .WillByDefault(Return(false));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, set_crtc_thunk(_))
+        .Times(1);
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(0);
+
+    db.schedule_set_crtc_if_changed();
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, scanout_window_on_top_goes_on_an_overlay_plane)
+{
+    uint32_t const overlay_plane{50};
+    ON_CALL(*mock_kms_output, add_crtc_to_thunk(_, _))
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, add_frame_to_thunk(_, _, _))
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, overlay_planes())
+        .WillByDefault(Return(std::vector<uint32_t>{overlay_plane}));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+    AtomicKMSCommit modeset{drm->fd};
+    db.add_crtcs_to(modeset);
+
+    auto const video = std::make_shared<FakeRenderable>(
+        mir::geometry::Rectangle{display_area.top_left + mir::geometry::Displacement{4, 6}, {20, 10}});
+    video->set_buffer(mock_bypassable_buffer);
+    mir::graphics::RenderableList const list{fake_software_renderable, video};
+
+    EXPECT_CALL(*mock_kms_output, add_frame_to_thunk(_, _,
+        ElementsAre(AllOf(
+            Field(&OverlayPlane::plane_id, overlay_plane),
+            Field(&OverlayPlane::destination, mir::geometry::Rectangle{{4, 6}, {20, 10}})))))
+        .Times(AtLeast(1));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(0);
+
+    EXPECT_FALSE(db.overlay(list));
+    EXPECT_EQ(1u, db.overlay_topmost(list));
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, overlays_the_driver_rejects_are_left_to_be_composited)
+{
+    ON_CALL(*mock_kms_output, add_crtc_to_thunk(_, _))
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, add_frame_to_thunk(_, _, _))
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, overlay_planes())
+        .WillByDefault(Return(std::vector<uint32_t>{50}));
+    ON_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillByDefault(Return(-EINVAL));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+    AtomicKMSCommit modeset{drm->fd};
+    db.add_crtcs_to(modeset);
+
+    auto const video = std::make_shared<FakeRenderable>(
+        mir::geometry::Rectangle{display_area.top_left, {20, 10}});
+    video->set_buffer(mock_bypassable_buffer);
+    mir::graphics::RenderableList const list{fake_software_renderable, video};
+
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(1);
+
+    EXPECT_FALSE(db.overlay(list));
+    EXPECT_EQ(0u, db.overlay_topmost(list));
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, no_overlays_without_atomic_modesetting)
+{
+    ON_CALL(*mock_kms_output, overlay_planes())
+        .WillByDefault(Return(std::vector<uint32_t>{50}));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+    db.set_crtcs();
+
+    auto const video = std::make_shared<FakeRenderable>(
+        mir::geometry::Rectangle{display_area.top_left, {20, 10}});
+    video->set_buffer(mock_bypassable_buffer);
+
+    EXPECT_EQ(0u, db.overlay_topmost({fake_software_renderable, video}));
+}
@@ -968,3 +968,62 @@ TEST_F(MesaDisplayConfigurationTest, does_not_query_drm_unnecesarily)
     EXPECT_CALL(mock_drm, drmModeGetConnector(_,_)).Times(AtLeast(1));
     display->configuration();
 }
+
+TEST_F(MesaDisplayConfigurationTest, outputs_of_every_drm_device_are_reported_in_device_order)
+{
+    using namespace ::testing;
+
+    char const* const second_drm_device = "/dev/dri/card1";
+    uint32_t const crtc_id{10};
+    uint32_t const encoder_id{20};
+    uint32_t const connector_id{30};
+    uint32_t const invalid_id{0};
+    geom::Size const connector_physical_size_mm{480, 270};
+    std::vector<uint32_t> possible_encoder_ids_empty;
+    uint32_t const possible_crtcs_mask_empty{0};
+
+    mock_drm.reset(drm_device);
+    mock_drm.add_crtc(
+        drm_device,
+        crtc_id,
+        modes0[1]);
+    mock_drm.add_encoder(
+        drm_device,
+        encoder_id,
+        crtc_id,
+        possible_crtcs_mask_empty);
+    mock_drm.add_connector(
+        drm_device,
+        connector_id,
+        DRM_MODE_CONNECTOR_HDMIA,
+        DRM_MODE_CONNECTED,
+        encoder_id,
+        modes0,
+        possible_encoder_ids_empty,
+        connector_physical_size_mm);
+    mock_drm.prepare(drm_device);
+
+    mock_drm.add_connector(
+        second_drm_device,
+        connector_id,
+        DRM_MODE_CONNECTOR_DVID,
+        DRM_MODE_DISCONNECTED,
+        invalid_id,
+        modes_empty,
+        possible_encoder_ids_empty,
+        geom::Size{});
+    mock_drm.prepare(second_drm_device);
+
+    auto display = create_display(create_platform());
+
+    std::vector<mg::DisplayConfigurationOutputType> types;
+    display->configuration()->for_each_output(
+        [&types](mg::DisplayConfigurationOutput const& output)
+        {
+            types.push_back(output.type);
+        });
+
+    EXPECT_THAT(types, ElementsAre(
+        mg::DisplayConfigurationOutputType::hdmia,
+        mg::DisplayConfigurationOutputType::dvid));
+}
@@ -41,6 +41,7 @@
 #include <gmock/gmock.h>
 
 #include <unordered_set>
+#include <deque>
 #include <fcntl.h>
 
 namespace mg = mir::graphics;
@@ -336,12 +337,19 @@ TEST_F(MesaDisplayMultiMonitorTest, create_display_creates_shared_egl_contexts)
 namespace
 {
 
-ACTION_P(InvokePageFlipHandler, param)
+ACTION_P2(QueuePageFlipEvent, pending_flips, mock_drm)
+{
+    pending_flips->push_back(arg4);
+    mock_drm->generate_event_on("/dev/dri/card0");
+}
+
+ACTION_P(InvokePageFlipHandler, pending_flips)
 {
     int const dont_care{0};
     char dummy;
 
-    arg1->page_flip_handler(dont_care, dont_care, dont_care, dont_care, *param);
+    arg1->page_flip_handler(dont_care, dont_care, dont_care, dont_care, pending_flips->front());
+    pending_flips->pop_front();
     ASSERT_EQ(1, read(arg0, &dummy, 1));
 }
 
@@ -354,7 +362,8 @@ TEST_F(MesaDisplayMultiMonitorTest, flip_flips_all_connected_crtcs)
     int const num_connected_outputs{3};
     int const num_disconnected_outputs{2};
     uint32_t const fb_id{66};
-    std::vector<void*> user_data(num_connected_outputs, nullptr);
+    /* Only touched with the page flipper's lock held */
+    std::deque<void*> pending_flips;
 
     setup_outputs(num_connected_outputs, num_disconnected_outputs);
 
@@ -363,25 +372,20 @@ TEST_F(MesaDisplayMultiMonitorTest, flip_flips_all_connected_crtcs)
                                         _, _, _, _, _, _, _, _))
         .WillRepeatedly(DoAll(SetArgPointee<7>(fb_id), Return(0)));
 
-    /* All crtcs are flipped */
+    /* All crtcs are flipped, each emitting a fake DRM page-flip event */
     for (int i = 0; i < num_connected_outputs; i++)
     {
         EXPECT_CALL(mock_drm, drmModePageFlip(mtd::IsFdOfDevice(drm_device),
                                               crtc_ids[i], fb_id,
                                               _, _))
             .Times(2)
-            .WillRepeatedly(DoAll(SaveArg<4>(&user_data[i]), Return(0)));
-
-        /* Emit fake DRM page-flip events */
-        mock_drm.generate_event_on(drm_device);
+            .WillRepeatedly(DoAll(QueuePageFlipEvent(&pending_flips, &mock_drm), Return(0)));
     }
 
     /* Handle the events properly */
     EXPECT_CALL(mock_drm, drmHandleEvent(mtd::IsFdOfDevice(drm_device), _))
-        .Times(num_connected_outputs)
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[0]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[1]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[2]), Return(0)));
+        .Times(2 * num_connected_outputs)
+        .WillRepeatedly(DoAll(InvokePageFlipHandler(&pending_flips), Return(0)));
 
     auto display = create_display_cloned(create_platform());
 
@@ -392,7 +396,7 @@ TEST_F(MesaDisplayMultiMonitorTest, flip_flips_all_connected_crtcs)
     });
 
     /* Second frame: Previous page flips finish (drmHandleEvent) and new ones
-       are scheduled */
+       are scheduled; those finish before the display goes away */
     display->for_each_display_sync_group([](mg::DisplaySyncGroup& group)
     {
         group.post();
@@ -22,6 +22,7 @@
 #include "mir/test/doubles/mock_display_report.h"
 #include "src/server/report/null_report_factory.h"
 #include "mir/test/fake_shared.h"
+#include "mir/test/signal.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -69,6 +70,13 @@ ACTION_P(InvokePageFlipHandler, param)
     ASSERT_EQ(1, read(arg0, &dummy, 1));
 }
 
+ACTION(ConsumeEvent)
+{
+    char dummy;
+
+    ASSERT_EQ(1, read(arg0, &dummy, 1));
+}
+
 }
 
 TEST_F(KMSPageFlipperTest, schedule_flip_calls_drm_page_flip)
@@ -82,7 +90,7 @@ TEST_F(KMSPageFlipperTest, schedule_flip_calls_drm_page_flip)
     EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
         .Times(1);
 
-    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id, {});
 }
 
 TEST_F(KMSPageFlipperTest, double_schedule_flip_throws)
@@ -96,10 +104,10 @@ TEST_F(KMSPageFlipperTest, double_schedule_flip_throws)
     EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
         .Times(1);
 
-    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id, {});
 
     EXPECT_THROW({
-        page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+        page_flipper.schedule_flip(crtc_id, fb_id, connector_id, {});
     }, std::logic_error);
 }
 
@@ -120,7 +128,7 @@ TEST_F(KMSPageFlipperTest, wait_for_flip_handles_drm_event)
         .Times(1)
         .WillOnce(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
 
-    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id, {});
 
     /* Fake a DRM event */
     mock_drm.generate_event_on(drm_device);
@@ -144,7 +152,7 @@ TEST_F(KMSPageFlipperTest, wait_for_flip_reports_vsync)
     ASSERT_NE(crtc_id, connector_id);
     EXPECT_CALL(report, report_vsync(connector_id, _));
 
-    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id, {});
     mock_drm.generate_event_on(drm_device);
     page_flipper.wait_for_flip(crtc_id);
 }
@@ -171,19 +179,17 @@ TEST_F(KMSPageFlipperTest, failure_in_wait_for_flip_throws)
     uint32_t const crtc_id{10};
     uint32_t const fb_id{101};
     uint32_t const connector_id{345};
-    void* user_data{nullptr};
 
     EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
-        .Times(1)
-        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
+        .Times(1);
 
-    EXPECT_CALL(mock_drm, drmHandleEvent(_, _))
-        .Times(0);
+    /* Cause a failure in handling the DRM event */
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(ConsumeEvent(), SetErrnoAndReturn(EIO, -1)));
 
-    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id, {});
 
-    /* Cause a failure in wait_for_flip */
-    close(drm_fd);
+    mock_drm.generate_event_on(drm_device);
 
     EXPECT_THROW({
         page_flipper.wait_for_flip(crtc_id);
@@ -213,7 +219,7 @@ TEST_F(KMSPageFlipperTest, wait_for_flips_interleaved)
         .WillOnce(DoAll(InvokePageFlipHandler(&user_data[0]), Return(0)));
 
     for (int i = 0; i < flips; ++i)
-        page_flipper.schedule_flip(crtc_ids[i], fb_id, connector_ids[i]);
+        page_flipper.schedule_flip(crtc_ids[i], fb_id, connector_ids[i], {});
 
     /* Fake 3 DRM events */
     mock_drm.generate_event_on(drm_device);
@@ -241,7 +247,7 @@ public:
     {
         while (!done)
         {
-            page_flipper.schedule_flip(crtc_id, 0, 987);
+            page_flipper.schedule_flip(crtc_id, 0, 987, {});
             num_page_flips++;
             std::this_thread::sleep_for(std::chrono::milliseconds{1});
             page_flipper.wait_for_flip(crtc_id);
@@ -274,134 +280,101 @@ private:
 
 }
 
-TEST_F(KMSPageFlipperTest, threads_switch_worker)
+TEST_F(KMSPageFlipperTest, flip_completion_is_delivered_without_waiting_for_it)
 {
     using namespace testing;
 
-    size_t const worker_index{0};
-    size_t const other_index{1};
-    std::vector<uint32_t> const crtc_ids{10, 11};
-    std::vector<void*> user_data{nullptr, nullptr};
-    std::vector<std::unique_ptr<PageFlippingFunctor>> page_flipping_functors;
-    std::vector<std::thread> page_flipping_threads;
-    std::thread::id tid;
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+    void* user_data{nullptr};
+    mt::Signal flipped;
 
-    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, _, _, _, _))
-        .Times(2)
-        .WillOnce(DoAll(SaveArg<4>(&user_data[worker_index]), Return(0)))
-        .WillOnce(DoAll(SaveArg<4>(&user_data[other_index]), Return(0)));
-
-    /*
-     * The first event releases the original worker, hence we expect that
-     * then the other thread will become the worker.
-     */
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
+        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
     EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
-        .Times(2)
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[worker_index]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[other_index]), Return(0)));
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
 
-    /* Start the page-flipping threads */
-    for (auto crtc_id : crtc_ids)
-    {
-        auto pf = std::unique_ptr<PageFlippingFunctor>(new PageFlippingFunctor{page_flipper, crtc_id});
-        page_flipping_functors.push_back(std::move(pf));
-        page_flipping_threads.push_back(std::thread{std::ref(*page_flipping_functors.back())});
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id, [&] { flipped.raise(); });
 
-        /* Wait for page-flip request and tell flipper to stop after this iteration */
-        while (page_flipping_functors.back()->page_flip_count() == 0)
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-        page_flipping_functors.back()->stop();
+    mock_drm.generate_event_on(drm_device);
 
-        /* Wait until the (first) thread has become the worker */
-        while (tid == std::thread::id())
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-            tid = page_flipper.debug_get_worker_tid();
-        }
-    }
+    EXPECT_TRUE(flipped.wait_for(std::chrono::seconds{10}));
+}
 
-    EXPECT_EQ(page_flipping_threads[worker_index].get_id(), tid);
+TEST_F(KMSPageFlipperTest, flip_completion_is_delivered_before_wait_for_flip_returns)
+{
+    using namespace testing;
 
-    /* Fake a DRM event */
-    mock_drm.generate_event_on(drm_device);
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+    void* user_data{nullptr};
+    std::atomic<bool> flipped{false};
 
-    page_flipping_threads[worker_index].join();
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
+        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
 
-    /* Wait for the worker to switch */
-    while (tid != page_flipping_threads[other_index].get_id())
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds{1});
-        tid = page_flipper.debug_get_worker_tid();
-    }
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id, [&]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            flipped = true;
+        });
 
-    /* Fake another DRM event to unblock the remaining thread */
     mock_drm.generate_event_on(drm_device);
+    page_flipper.wait_for_flip(crtc_id);
 
-    page_flipping_threads[other_index].join();
+    EXPECT_TRUE(flipped);
 }
 
-TEST_F(KMSPageFlipperTest, threads_worker_notifies_non_worker)
+TEST_F(KMSPageFlipperTest, flip_completion_can_schedule_the_next_flip)
 {
     using namespace testing;
 
-    size_t const worker_index{0};
-    size_t const other_index{1};
-    std::vector<uint32_t> const crtc_ids{10, 11};
-    std::vector<void*> user_data{nullptr, nullptr};
-    std::vector<std::unique_ptr<PageFlippingFunctor>> page_flipping_functors;
-    std::vector<std::thread> page_flipping_threads;
-    std::thread::id tid;
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const next_fb_id{102};
+    uint32_t const connector_id{345};
+    void* user_data{nullptr};
+    mt::Signal next_scheduled;
 
-    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, _, _, _, _))
-        .Times(2)
-        .WillOnce(DoAll(SaveArg<4>(&user_data[worker_index]), Return(0)))
-        .WillOnce(DoAll(SaveArg<4>(&user_data[other_index]), Return(0)));
-
-    /*
-     * The first event releases the non-worker thread, hence we expect that
-     * original worker not change.
-     */
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
+        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, next_fb_id, _, _))
+        .WillOnce(Return(0));
     EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
-        .Times(2)
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[other_index]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[worker_index]), Return(0)));
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
 
-    /* Start the page-flipping threads */
-    for (auto crtc_id : crtc_ids)
-    {
-        auto pf = std::unique_ptr<PageFlippingFunctor>(new PageFlippingFunctor{page_flipper, crtc_id});
-        page_flipping_functors.push_back(std::move(pf));
-        page_flipping_threads.push_back(std::thread{std::ref(*page_flipping_functors.back())});
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id, [&]
+        {
+            page_flipper.schedule_flip(crtc_id, next_fb_id, connector_id, {});
+            next_scheduled.raise();
+        });
 
-        /* Wait for page-flip request and tell flipper to stop after this iteration */
-        while (page_flipping_functors.back()->page_flip_count() == 0)
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-        page_flipping_functors.back()->stop();
+    mock_drm.generate_event_on(drm_device);
 
-        /* Wait until the (first) thread has become the worker */
-        while (tid == std::thread::id())
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-            tid = page_flipper.debug_get_worker_tid();
-        }
-    }
+    EXPECT_TRUE(next_scheduled.wait_for(std::chrono::seconds{10}));
+}
 
-    EXPECT_EQ(page_flipping_threads[worker_index].get_id(), tid);
+TEST_F(KMSPageFlipperTest, flip_that_cannot_be_scheduled_is_never_completed)
+{
+    using namespace testing;
 
-    /* Fake a DRM event */
-    mock_drm.generate_event_on(drm_device);
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+    bool flipped{false};
 
-    /* Wait for the non-worker thread to exit */
-    page_flipping_threads[other_index].join();
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
+        .WillOnce(Return(-EINVAL));
 
-    /* Check that the worker hasn't changed */
-    EXPECT_EQ(page_flipping_threads[worker_index].get_id(),
-              page_flipper.debug_get_worker_tid());
+    EXPECT_FALSE(page_flipper.schedule_flip(crtc_id, fb_id, connector_id, [&] { flipped = true; }));
 
-    /* Fake another DRM event to unblock the remaining thread */
-    mock_drm.generate_event_on(drm_device);
+    page_flipper.wait_for_flip(crtc_id);
 
-    page_flipping_threads[worker_index].join();
+    EXPECT_FALSE(flipped);
 }
 
 namespace
@@ -29,6 +29,9 @@
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <unordered_map>
+#include <deque>
+#include <cstring>
 #include <fcntl.h>
 
 namespace mg = mir::graphics;
@@ -45,14 +48,14 @@ namespace
 class NullPageFlipper : public mgm::PageFlipper
 {
 public:
-    bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_flip(uint32_t,uint32_t,uint32_t,std::function<void()> const&) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
 };
 
 class MockPageFlipper : public mgm::PageFlipper
 {
 public:
-    MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD4(schedule_flip, bool(uint32_t,uint32_t,uint32_t,std::function<void()> const&));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
 };
 
@@ -157,6 +160,50 @@ public:
                     Return(0)));
     }
 
+    /* Give a DRM object the named properties, returning their ids */
+    std::vector<uint32_t> fake_properties(
+        uint32_t object_id,
+        uint32_t object_type,
+        std::vector<std::pair<char const*, uint64_t>> const& named_values)
+    {
+        auto& object = fake_objects[object_id];
+        std::vector<uint32_t> prop_ids;
+
+        for (auto const& named_value : named_values)
+        {
+            fake_props.push_back(drmModePropertyRes());
+            auto& prop = fake_props.back();
+            prop.prop_id = 100 + fake_props.size();
+            strncpy(prop.name, named_value.first, DRM_PROP_NAME_LEN - 1);
+
+            ON_CALL(mock_drm, drmModeGetProperty(drm_fd, prop.prop_id))
+                .WillByDefault(Return(&prop));
+
+            object.prop_ids.push_back(prop.prop_id);
+            object.values.push_back(named_value.second);
+            prop_ids.push_back(prop.prop_id);
+        }
+
+        object.props.count_props = object.prop_ids.size();
+        object.props.props = object.prop_ids.data();
+        object.props.prop_values = object.values.data();
+
+        ON_CALL(mock_drm, drmModeObjectGetProperties(drm_fd, object_id, object_type))
+            .WillByDefault(Return(&object.props));
+
+        return prop_ids;
+    }
+
+    struct FakeObject
+    {
+        drmModeObjectProperties props;
+        std::vector<uint32_t> prop_ids;
+        std::vector<uint64_t> values;
+    };
+
+    std::unordered_map<uint32_t, FakeObject> fake_objects;
+    std::deque<drmModePropertyRes> fake_props;
+
     testing::NiceMock<mtd::MockDRM> mock_drm;
     testing::NiceMock<mtd::MockGBM> mock_gbm;
     MockPageFlipper mock_page_flipper;
@@ -194,7 +241,7 @@ TEST_F(RealKMSOutputTest, operations_use_existing_crtc)
             .Times(1);
 
         EXPECT_CALL(mock_page_flipper, schedule_flip(crtc_ids[0], fb_id,
-                                                     connector_ids[0]))
+                                                     connector_ids[0], _))
             .Times(1)
             .WillOnce(Return(true));
 
@@ -214,7 +261,7 @@ TEST_F(RealKMSOutputTest, operations_use_existing_crtc)
     auto fb = output.fb_for(fake_bo);
 
     EXPECT_TRUE(output.set_crtc(*fb));
-    EXPECT_TRUE(output.schedule_page_flip(*fb));
+    EXPECT_TRUE(output.schedule_page_flip(*fb, {}));
     output.wait_for_page_flip();
 }
 
@@ -234,7 +281,7 @@ TEST_F(RealKMSOutputTest, operations_use_possible_crtc)
             .Times(1);
 
         EXPECT_CALL(mock_page_flipper, schedule_flip(crtc_ids[1], fb_id,
-                                                     connector_ids[0]))
+                                                     connector_ids[0], _))
             .Times(1)
             .WillOnce(Return(true));
 
@@ -256,7 +303,7 @@ TEST_F(RealKMSOutputTest, operations_use_possible_crtc)
     auto fb = output.fb_for(fake_bo);
 
     EXPECT_TRUE(output.set_crtc(*fb));
-    EXPECT_TRUE(output.schedule_page_flip(*fb));
+    EXPECT_TRUE(output.schedule_page_flip(*fb, {}));
     output.wait_for_page_flip();
 }
 
@@ -276,7 +323,7 @@ TEST_F(RealKMSOutputTest, set_crtc_failure_is_handled_gracefully)
             .Times(1)
             .WillOnce(Return(1));
 
-        EXPECT_CALL(mock_page_flipper, schedule_flip(_, _, _))
+        EXPECT_CALL(mock_page_flipper, schedule_flip(_, _, _, _))
             .Times(0);
 
         EXPECT_CALL(mock_page_flipper, wait_for_flip(_))
@@ -298,7 +345,7 @@ TEST_F(RealKMSOutputTest, set_crtc_failure_is_handled_gracefully)
     EXPECT_FALSE(output.set_crtc(*fb));
 
     EXPECT_NO_THROW({
-        EXPECT_FALSE(output.schedule_page_flip(*fb));
+        EXPECT_FALSE(output.schedule_page_flip(*fb, {}));
     });
     EXPECT_THROW({  // schedule failed. It's programmer error if you then wait.
         output.wait_for_page_flip();
@@ -522,3 +569,75 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
 
     EXPECT_NO_THROW(output.set_gamma(gamma););
 }
+
+TEST_F(RealKMSOutputTest, reports_adaptive_sync_support_of_vrr_capable_monitors)
+{
+    setup_outputs_connected_crtc();
+    fake_properties(connector_ids[0], DRM_MODE_OBJECT_CONNECTOR, {{"vrr_capable", 1}});
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper)};
+
+    mg::DisplayConfigurationOutput conf_output;
+    output.update_from_hardware_state(conf_output);
+
+    EXPECT_TRUE(conf_output.adaptive_sync_supported);
+}
+
+TEST_F(RealKMSOutputTest, adaptive_sync_enables_vrr_on_the_crtc)
+{
+    setup_outputs_connected_crtc();
+    fake_properties(connector_ids[0], DRM_MODE_OBJECT_CONNECTOR, {{"vrr_capable", 1}});
+    auto const vrr_enabled = fake_properties(crtc_ids[0], DRM_MODE_OBJECT_CRTC, {{"VRR_ENABLED", 0}});
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper)};
+
+    EXPECT_CALL(mock_drm, drmModeObjectSetProperty(
+        drm_fd, crtc_ids[0], DRM_MODE_OBJECT_CRTC, vrr_enabled[0], 1));
+
+    output.set_adaptive_sync(true);
+
+    EXPECT_TRUE(output.adaptive_sync());
+}
+
+TEST_F(RealKMSOutputTest, adaptive_sync_stays_off_if_the_monitor_cannot_do_it)
+{
+    setup_outputs_connected_crtc();
+    fake_properties(connector_ids[0], DRM_MODE_OBJECT_CONNECTOR, {{"vrr_capable", 0}});
+    fake_properties(crtc_ids[0], DRM_MODE_OBJECT_CRTC, {{"VRR_ENABLED", 0}});
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper)};
+
+    EXPECT_CALL(mock_drm, drmModeObjectSetProperty(_, _, _, _, _))
+        .Times(0);
+
+    output.set_adaptive_sync(true);
+
+    EXPECT_FALSE(output.adaptive_sync());
+}
+
+TEST_F(RealKMSOutputTest, adaptive_sync_stays_off_if_the_driver_cannot_do_it)
+{
+    setup_outputs_connected_crtc();
+    fake_properties(connector_ids[0], DRM_MODE_OBJECT_CONNECTOR, {{"vrr_capable", 1}});
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper)};
+
+    EXPECT_CALL(mock_drm, drmModeObjectSetProperty(_, _, _, _, _))
+        .Times(0);
+
+    output.set_adaptive_sync(true);
+
+    EXPECT_FALSE(output.adaptive_sync());
+}
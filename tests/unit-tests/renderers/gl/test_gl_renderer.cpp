@@ -36,6 +36,7 @@ using testing::SetArgPointee;
 using testing::InSequence;
 using testing::Return;
 using testing::ReturnRef;
+using testing::ReturnPointee;
 using testing::Pointee;
 using testing::AnyNumber;
 using testing::AtLeast;
@@ -466,3 +467,136 @@ TEST_F(GLRenderer, sets_viewport_downscaled_wide)
 
     mrg::Renderer renderer(mock_display_buffer);
 }
+
+TEST_F(GLRenderer, redraws_only_damaged_area_of_aged_buffer)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    mir::geometry::Rectangle position{{1,2}, {3,4}};
+
+    ON_CALL(mock_egl, eglQueryString(_,EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_image EGL_EXT_buffer_age"));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_WIDTH,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1920), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_HEIGHT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1080), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_BUFFER_AGE_EXT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1), Return(EGL_TRUE)));
+    ON_CALL(mock_display_buffer, view_area())
+        .WillByDefault(Return(view_area));
+    EXPECT_CALL(*renderable, screen_position())
+        .WillRepeatedly(ReturnPointee(&position));
+
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+    renderer.render(renderable_list);
+
+    position.top_left = {11,12};
+
+    // {1,2}x{3,4} and {11,12}x{3,4} apart, with GL's origin at the bottom
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
+    EXPECT_CALL(mock_gl, glScissor(1, 1080 - 6, 3, 4));
+    EXPECT_CALL(mock_gl, glClear(_));
+    EXPECT_CALL(mock_gl, glScissor(11, 1080 - 16, 3, 4));
+    EXPECT_CALL(mock_gl, glClear(_));
+    EXPECT_CALL(mock_gl, glDisable(GL_SCISSOR_TEST));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, redraws_overlapping_damage_as_one_area)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    mir::geometry::Rectangle position{{1,2}, {3,4}};
+
+    ON_CALL(mock_egl, eglQueryString(_,EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_image EGL_EXT_buffer_age"));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_WIDTH,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1920), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_HEIGHT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1080), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_BUFFER_AGE_EXT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1), Return(EGL_TRUE)));
+    ON_CALL(mock_display_buffer, view_area())
+        .WillByDefault(Return(view_area));
+    EXPECT_CALL(*renderable, screen_position())
+        .WillRepeatedly(ReturnPointee(&position));
+
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    position.top_left = {2,3};
+
+    // The union of {1,2}x{3,4} and {2,3}x{3,4}
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
+    EXPECT_CALL(mock_gl, glScissor(1, 1080 - 7, 4, 5));
+    EXPECT_CALL(mock_gl, glClear(_));
+    EXPECT_CALL(mock_gl, glDisable(GL_SCISSOR_TEST));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, tessellates_once_a_frame_when_redrawing_only_damaged_areas)
+{
+    struct CountingTessellateRenderer : public mrg::Renderer
+    {
+        using Renderer::Renderer;
+
+        void tessellate(std::vector<mgl::Primitive>& primitives,
+                        mg::Renderable const& renderable) const override
+        {
+            ++tessellations;
+            Renderer::tessellate(primitives, renderable);
+        }
+        mutable int tessellations = 0;
+    };
+
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+
+    ON_CALL(mock_egl, eglQueryString(_,EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_image EGL_EXT_buffer_age"));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_WIDTH,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1920), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_HEIGHT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1080), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_BUFFER_AGE_EXT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1), Return(EGL_TRUE)));
+    ON_CALL(mock_display_buffer, view_area())
+        .WillByDefault(Return(view_area));
+
+    CountingTessellateRenderer renderer(mock_display_buffer);
+
+    renderer.render(renderable_list);
+    EXPECT_THAT(renderer.tessellations, testing::Eq(1));
+
+    renderer.render(renderable_list);
+    EXPECT_THAT(renderer.tessellations, testing::Eq(2));
+}
+
+TEST_F(GLRenderer, redraws_everything_when_buffer_age_is_unknown)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    mir::geometry::Rectangle position{{1,2}, {3,4}};
+
+    ON_CALL(mock_egl, eglQueryString(_,EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_image EGL_EXT_buffer_age"));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_WIDTH,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1920), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_HEIGHT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(1080), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_BUFFER_AGE_EXT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(0), Return(EGL_TRUE)));
+    ON_CALL(mock_display_buffer, view_area())
+        .WillByDefault(Return(view_area));
+    EXPECT_CALL(*renderable, screen_position())
+        .WillRepeatedly(ReturnPointee(&position));
+
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    position.top_left = {11,12};
+
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST)).Times(0);
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+    renderer.render(renderable_list);
+}
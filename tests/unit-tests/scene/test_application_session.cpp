@@ -78,6 +78,10 @@ public:
     MOCK_METHOD2(take_snapshot_of,
                 void(std::shared_ptr<mc::BufferStream> const&,
                      ms::SnapshotCallback const&));
+    MOCK_METHOD3(take_thumbnail_of,
+                void(std::shared_ptr<mc::BufferStream> const&,
+                     geom::Size const&,
+                     ms::SnapshotCallback const&));
 };
 
 struct MockSnapshotCallback
@@ -506,6 +510,40 @@ TEST_F(ApplicationSession, takes_snapshot_of_default_surface)
     app_session.destroy_surface(surface);
 }
 
+TEST_F(ApplicationSession, takes_thumbnail_of_default_surface)
+{
+    using namespace ::testing;
+
+    auto mock_surface = make_mock_surface();
+    NiceMock<MockSurfaceFactory> surface_factory;
+    MockBufferStreamFactory mock_buffer_stream_factory;
+    std::shared_ptr<mc::BufferStream> const mock_stream = std::make_shared<mtd::MockBufferStream>();
+    ON_CALL(mock_buffer_stream_factory, create_buffer_stream(_,_)).WillByDefault(Return(mock_stream));
+    ON_CALL(surface_factory, create_surface(_,_)).WillByDefault(Return(mock_surface));
+    NiceMock<mtd::MockSurfaceStack> surface_stack;
+
+    auto const snapshot_strategy = std::make_shared<MockSnapshotStrategy>();
+    geom::Size const thumbnail_size{64, 48};
+
+    EXPECT_CALL(*snapshot_strategy, take_thumbnail_of(mock_stream, thumbnail_size, _));
+
+    ms::ApplicationSession app_session(
+        mt::fake_shared(surface_stack),
+        mt::fake_shared(surface_factory),
+        mt::fake_shared(mock_buffer_stream_factory),
+        pid, name,
+        snapshot_strategy,
+        std::make_shared<ms::NullSessionListener>(),
+        mtd::StubDisplayConfig{},
+        event_sink, allocator);
+
+    ms::SurfaceCreationParameters params = ms::a_surface()
+        .with_buffer_stream(app_session.create_buffer_stream(properties));
+    auto surface = app_session.create_surface(params, event_sink);
+    app_session.take_thumbnail(thumbnail_size, ms::SnapshotCallback());
+    app_session.destroy_surface(surface);
+}
+
 TEST_F(ApplicationSession, returns_null_snapshot_if_no_default_surface)
 {
     using namespace ::testing;
@@ -1031,6 +1031,25 @@ TEST_F(BasicSurfaceTest, buffer_streams_produce_correctly_sized_renderables)
     EXPECT_THAT(renderables[1], IsRenderableOfSize(size1));
 }
 
+TEST_F(BasicSurfaceTest, could_appear_in_any_area_one_of_its_streams_overlaps)
+{
+    using namespace testing;
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    geom::Size const size{10, 10};
+
+    std::list<ms::StreamInfo> streams = {
+        { mock_buffer_stream, {0,0}, size },
+        { buffer_stream, {100,0}, size },
+    };
+    surface.set_streams(streams);
+    surface.move_to({0, 0});
+
+    EXPECT_TRUE(surface.could_appear_in({{5, 5}, {10, 10}}));
+    EXPECT_TRUE(surface.could_appear_in({{105, 5}, {10, 10}}));
+    EXPECT_FALSE(surface.could_appear_in({{20, 0}, {50, 50}}));
+    EXPECT_FALSE(surface.could_appear_in({{0, 20}, {200, 50}}));
+}
+
 TEST_F(BasicSurfaceTest, renderables_of_transparent_buffer_streams_are_shaped)
 {
     using namespace testing;
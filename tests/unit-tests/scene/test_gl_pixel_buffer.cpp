@@ -21,6 +21,7 @@
 
 #include "mir/test/doubles/mock_gl_buffer.h"
 #include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -101,6 +102,20 @@ ACTION(FillPixelsRGBA)
     }
 }
 
+std::vector<uint32_t> mapped_pixels;
+
+void* fake_map_buffer_range(GLenum, GLintptr, GLsizeiptr length, GLbitfield)
+{
+    mapped_pixels.resize(length / 4);
+    for (uint32_t i = 0; i < mapped_pixels.size(); ++i)
+        mapped_pixels[i] = i;
+    return mapped_pixels.data();
+}
+
+GLboolean fake_unmap_buffer(GLenum)
+{
+    return GL_TRUE;
+}
 }
 
 TEST_F(GLPixelBufferTest, returns_empty_if_not_initialized)
@@ -225,3 +240,117 @@ TEST_F(GLPixelBufferTest, returns_data_from_rgba_buffer_texture)
     EXPECT_EQ(width - 1,
               static_cast<uint32_t const*>(data)[width * height - 1]);
 }
+
+TEST_F(GLPixelBufferTest, scales_buffer_on_gpu_when_filling_to_a_size)
+{
+    using namespace testing;
+    GLuint const tex{10};
+    GLuint const scaled_tex{11};
+    geom::Size const size{17, 13};
+    uint32_t const width{size.width.as_uint32_t()};
+    uint32_t const height{size.height.as_uint32_t()};
+
+    EXPECT_CALL(mock_context, make_current()).Times(AtLeast(1));
+    EXPECT_CALL(mock_gl, glGenTextures(_,_))
+        .WillOnce(SetArgPointee<1>(tex))
+        .WillOnce(SetArgPointee<1>(scaled_tex));
+
+    {
+        InSequence s;
+
+        /* The buffer texture is drawn into a texture of the requested size... */
+        EXPECT_CALL(mock_buffer, gl_bind_to_texture());
+        EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, _));
+        EXPECT_CALL(mock_gl, glFramebufferTexture2D(_,_,_,scaled_tex,0));
+        EXPECT_CALL(mock_gl, glViewport(0, 0, width, height));
+        EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+
+        /* ...which is what gets read back */
+        EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height,
+                                          GL_BGRA_EXT, GL_UNSIGNED_BYTE, _))
+            .WillOnce(FillPixels());
+    }
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    pixels.fill_from(mock_buffer, size);
+    auto data = pixels.as_argb_8888();
+
+    EXPECT_EQ(size, pixels.size());
+    EXPECT_EQ(geom::Stride{width * 4}, pixels.stride());
+    EXPECT_EQ(width * (height - 1),
+              static_cast<uint32_t const*>(data)[0]);
+}
+
+TEST_F(GLPixelBufferTest, cannot_begin_fill_without_pixel_buffer_objects)
+{
+    using namespace testing;
+
+    EXPECT_CALL(mock_context, make_current()).Times(AtLeast(1));
+    EXPECT_CALL(mock_gl, glReadPixels(_,_,_,_,_,_,_)).Times(0);
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    EXPECT_FALSE(pixels.begin_fill_from(mock_buffer, geom::Size{17, 13}));
+}
+
+TEST_F(GLPixelBufferTest, overlapping_fills_read_back_through_alternating_pixel_buffer_objects)
+{
+    using namespace testing;
+    GLuint const pbos[]{30, 31};
+    geom::Size const size{17, 13};
+    uint32_t const width{size.width.as_uint32_t()};
+    uint32_t const height{size.height.as_uint32_t()};
+    NiceMock<mtd::MockEGL> mock_egl;
+
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 3.0 Mesa")));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glMapBufferRange")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_map_buffer_range)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glUnmapBuffer")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_unmap_buffer)));
+
+    EXPECT_CALL(mock_context, make_current()).Times(AtLeast(1));
+    EXPECT_CALL(mock_gl, glGenBuffers(2, _))
+        .WillOnce(SetArrayArgument<1>(std::begin(pbos), std::end(pbos)));
+
+    {
+        InSequence s;
+
+        /* Both read backs go into pixel buffer objects, not client memory... */
+        for (auto const pbo : pbos)
+        {
+            EXPECT_CALL(mock_gl, glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, pbo));
+            EXPECT_CALL(mock_gl, glBufferData(GL_PIXEL_PACK_BUFFER_NV, width * height * 4, nullptr, _));
+            EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height, GL_BGRA_EXT, GL_UNSIGNED_BYTE, nullptr));
+            EXPECT_CALL(mock_gl, glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, 0));
+            EXPECT_CALL(mock_gl, glFlush());
+        }
+
+        /* ...and are only mapped as each fill is ended, oldest first */
+        for (auto const pbo : pbos)
+        {
+            EXPECT_CALL(mock_gl, glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, pbo));
+            EXPECT_CALL(mock_gl, glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, 0));
+        }
+    }
+
+    EXPECT_CALL(mock_gl, glDeleteBuffers(2, _));
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    ASSERT_TRUE(pixels.begin_fill_from(mock_buffer, size));
+    ASSERT_TRUE(pixels.begin_fill_from(mock_buffer, size));
+
+    for (int i = 0; i != 2; ++i)
+    {
+        pixels.end_fill();
+        auto data = pixels.as_argb_8888();
+
+        EXPECT_EQ(size, pixels.size());
+        EXPECT_EQ(width * (height - 1),
+                  static_cast<uint32_t const*>(data)[0]);
+        EXPECT_EQ(width - 1,
+                  static_cast<uint32_t const*>(data)[width * height - 1]);
+    }
+}
@@ -18,6 +18,7 @@
 
 #include "mir/scene/legacy_scene_change_notification.h"
 #include "mir/scene/surface_observer.h"
+#include "mir/geometry/rectangle.h"
 
 #include "mir/test/fake_shared.h"
 #include "mir/test/doubles/mock_surface.h"
@@ -39,6 +40,10 @@ struct MockBufferCallback
 {
     MOCK_METHOD1(invoke, void(int));
 };
+struct MockDamageCallback
+{
+    MOCK_METHOD2(invoke, void(int, mir::geometry::Rectangle const&));
+};
 
 struct LegacySceneChangeNotificationTest : public testing::Test
 {
@@ -48,8 +53,11 @@ struct LegacySceneChangeNotificationTest : public testing::Test
     }
     testing::NiceMock<MockSceneCallback> scene_callback;
     testing::NiceMock<MockBufferCallback> buffer_callback;
+    testing::NiceMock<MockDamageCallback> damage_callback;
     std::function<void(int)> buffer_change_callback{[this](int arg){buffer_callback.invoke(arg);}};
     std::function<void()> scene_change_callback{[this](){scene_callback.invoke();}};
+    std::function<void(int, mir::geometry::Rectangle const&)> damage_change_callback{
+        [this](int frames, mir::geometry::Rectangle const& damage){damage_callback.invoke(frames, damage);}};
     testing::NiceMock<mtd::MockSurface> surface;
 }; 
 }
@@ -114,6 +122,107 @@ TEST_F(LegacySceneChangeNotificationTest, redraws_on_rename)
     surface_observer->renamed(&surface, "Something New");
 }
 
+TEST_F(LegacySceneChangeNotificationTest, damages_old_and_new_bounds_when_surface_moves)
+{
+    using namespace ::testing;
+    mir::geometry::Size const size{10, 10};
+    mir::geometry::Point const new_top_left{100, 100};
+    ON_CALL(surface, size()).WillByDefault(Return(size));
+
+    std::shared_ptr<ms::SurfaceObserver> surface_observer;
+    EXPECT_CALL(surface, add_observer(_)).Times(1)
+        .WillOnce(SaveArg<0>(&surface_observer));
+
+    EXPECT_CALL(scene_callback, invoke()).Times(0);
+    EXPECT_CALL(damage_callback, invoke(1, mir::geometry::Rectangle{surface.top_left(), size}));
+    EXPECT_CALL(damage_callback, invoke(1, mir::geometry::Rectangle{new_top_left, size}));
+
+    ms::LegacySceneChangeNotification observer(scene_change_callback, damage_change_callback);
+    observer.surface_added(&surface);
+    surface.move_to(new_top_left);
+    surface_observer->moved_to(&surface, new_top_left);
+}
+
+TEST_F(LegacySceneChangeNotificationTest, damages_streams_displaced_beyond_the_surface_when_it_moves)
+{
+    using namespace ::testing;
+    mir::geometry::Size const size{10, 10};
+    mir::geometry::Point const old_top_left{0, 0};
+    mir::geometry::Point const new_top_left{100, 100};
+    ON_CALL(surface, size()).WillByDefault(Return(size));
+    surface.move_to(old_top_left);
+    surface.ms::BasicSurface::set_streams({
+        {std::make_shared<NiceMock<mtd::MockBufferStream>>(), {0, 0}, {}},
+        {std::make_shared<NiceMock<mtd::MockBufferStream>>(), {15, 5}, mir::geometry::Size{20, 20}}});
+
+    std::shared_ptr<ms::SurfaceObserver> surface_observer;
+    EXPECT_CALL(surface, add_observer(_)).Times(1)
+        .WillOnce(SaveArg<0>(&surface_observer));
+
+    mir::geometry::Size const extents{35, 25};
+    EXPECT_CALL(scene_callback, invoke()).Times(0);
+    EXPECT_CALL(damage_callback, invoke(1, mir::geometry::Rectangle{old_top_left, extents}));
+    EXPECT_CALL(damage_callback, invoke(1, mir::geometry::Rectangle{new_top_left, extents}));
+
+    ms::LegacySceneChangeNotification observer(scene_change_callback, damage_change_callback);
+    observer.surface_added(&surface);
+    surface.move_to(new_top_left);
+    surface_observer->moved_to(&surface, new_top_left);
+}
+
+TEST_F(LegacySceneChangeNotificationTest, frame_posted_damages_displaced_streams)
+{
+    using namespace ::testing;
+    mir::geometry::Size const size{10, 10};
+    ON_CALL(surface, size()).WillByDefault(Return(size));
+    surface.move_to({0, 0});
+    surface.ms::BasicSurface::set_streams({
+        {std::make_shared<NiceMock<mtd::MockBufferStream>>(), {0, 0}, {}},
+        {std::make_shared<NiceMock<mtd::MockBufferStream>>(), {-5, 0}, mir::geometry::Size{5, 5}}});
+
+    std::shared_ptr<ms::SurfaceObserver> surface_observer;
+    EXPECT_CALL(surface, add_observer(_)).Times(1)
+        .WillOnce(SaveArg<0>(&surface_observer));
+
+    EXPECT_CALL(damage_callback, invoke(1, mir::geometry::Rectangle{{-5, 0}, {15, 10}}));
+
+    ms::LegacySceneChangeNotification observer(scene_change_callback, damage_change_callback);
+    observer.surface_added(&surface);
+    surface_observer->frame_posted(&surface, 1, size);
+}
+
+TEST_F(LegacySceneChangeNotificationTest, damages_surface_bounds_when_visible_surface_is_removed)
+{
+    using namespace ::testing;
+    mir::geometry::Size const size{10, 10};
+    ON_CALL(surface, size()).WillByDefault(Return(size));
+
+    EXPECT_CALL(scene_callback, invoke()).Times(0);
+    EXPECT_CALL(damage_callback, invoke(1, mir::geometry::Rectangle{surface.top_left(), size}));
+
+    ms::LegacySceneChangeNotification observer(scene_change_callback, damage_change_callback);
+    observer.surface_added(&surface);
+    observer.surface_removed(&surface);
+}
+
+TEST_F(LegacySceneChangeNotificationTest, does_not_damage_for_changes_to_surface_that_was_never_visible)
+{
+    using namespace ::testing;
+    ON_CALL(surface, visible()).WillByDefault(Return(false));
+
+    std::shared_ptr<ms::SurfaceObserver> surface_observer;
+    EXPECT_CALL(surface, add_observer(_)).Times(1)
+        .WillOnce(SaveArg<0>(&surface_observer));
+
+    EXPECT_CALL(scene_callback, invoke()).Times(0);
+    EXPECT_CALL(damage_callback, invoke(_, _)).Times(0);
+
+    ms::LegacySceneChangeNotification observer(scene_change_callback, damage_change_callback);
+    observer.surface_added(&surface);
+    surface_observer->moved_to(&surface, {100, 100});
+    surface_observer->alpha_set_to(&surface, 0.5f);
+}
+
 TEST_F(LegacySceneChangeNotificationTest, destroying_observer_unregisters_surface_observers)
 {
     using namespace ::testing;
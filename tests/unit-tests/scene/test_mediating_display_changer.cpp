@@ -126,6 +126,7 @@ struct StubDisplayConfigurationObserver : mg::DisplayConfigurationObserver
 {
     void initial_configuration(std::shared_ptr<mg::DisplayConfiguration const> const&) override {}
     void configuration_applied(std::shared_ptr<mg::DisplayConfiguration const> const&) override {}
+    void configuration_timing(std::chrono::nanoseconds, bool) override {}
     void base_configuration_updated(std::shared_ptr<mg::DisplayConfiguration const> const&) override {}
     void session_configuration_applied(
         std::shared_ptr<mf::Session> const&,
@@ -894,6 +895,72 @@ TEST_F(MediatingDisplayChangerTest, notifies_observer_on_set_base_configuration)
     changer->set_base_configuration(mt::fake_shared(conf));
 }
 
+TEST_F(MediatingDisplayChangerTest, reports_incremental_timing_when_display_buffers_are_preserved)
+{
+    using namespace testing;
+
+    struct MockDisplayConfigurationObserver : StubDisplayConfigurationObserver
+    {
+        MOCK_METHOD2(configuration_timing, void (std::chrono::nanoseconds duration, bool incremental));
+    } display_configuration_observer;
+
+    changer = std::make_shared<ms::MediatingDisplayChanger>(
+        mt::fake_shared(mock_display),
+        mt::fake_shared(mock_compositor),
+        mt::fake_shared(mock_conf_policy),
+        mt::fake_shared(stub_session_container),
+        mt::fake_shared(session_event_sink),
+        mt::fake_shared(server_action_queue),
+        mt::fake_shared(display_configuration_observer),
+        mt::fake_shared(alarm_factory));
+
+    mtd::NullDisplayConfiguration conf;
+    auto session = std::make_shared<mtd::StubSession>();
+
+    ON_CALL(mock_display, apply_if_configuration_preserves_display_buffers(_))
+        .WillByDefault(Return(true));
+
+    EXPECT_CALL(display_configuration_observer, configuration_timing(_, true));
+
+    session_event_sink.handle_focus_change(session);
+    changer->configure(session, mt::fake_shared(conf));
+}
+
+TEST_F(MediatingDisplayChangerTest, reports_timing_of_restarting_the_compositor_when_display_buffers_are_invalidated)
+{
+    using namespace testing;
+
+    struct MockDisplayConfigurationObserver : StubDisplayConfigurationObserver
+    {
+        MOCK_METHOD2(configuration_timing, void (std::chrono::nanoseconds duration, bool incremental));
+    } display_configuration_observer;
+
+    changer = std::make_shared<ms::MediatingDisplayChanger>(
+        mt::fake_shared(mock_display),
+        mt::fake_shared(mock_compositor),
+        mt::fake_shared(mock_conf_policy),
+        mt::fake_shared(stub_session_container),
+        mt::fake_shared(session_event_sink),
+        mt::fake_shared(server_action_queue),
+        mt::fake_shared(display_configuration_observer),
+        mt::fake_shared(alarm_factory));
+
+    mtd::NullDisplayConfiguration conf;
+    auto session = std::make_shared<mtd::StubSession>();
+
+    ON_CALL(mock_display, apply_if_configuration_preserves_display_buffers(_))
+        .WillByDefault(Return(false));
+
+    InSequence s;
+    EXPECT_CALL(mock_compositor, stop());
+    EXPECT_CALL(mock_display, configure(Ref(conf)));
+    EXPECT_CALL(mock_compositor, start());
+    EXPECT_CALL(display_configuration_observer, configuration_timing(_, false));
+
+    session_event_sink.handle_focus_change(session);
+    changer->configure(session, mt::fake_shared(conf));
+}
+
 TEST_F(MediatingDisplayChangerTest, notifies_session_on_preview_base_configuration)
 {
     using namespace testing;
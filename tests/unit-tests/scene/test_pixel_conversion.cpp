@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/pixel_conversion.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace ms = mir::scene;
+
+namespace
+{
+struct PixelConversion : testing::TestWithParam<uint32_t>
+{
+    uint32_t const width{GetParam()};
+    uint32_t const height{7};
+
+    std::vector<uint32_t> source()
+    {
+        std::vector<uint32_t> pixels(width * height);
+        for (uint32_t i = 0; i < pixels.size(); ++i)
+            pixels[i] = 0x01020304u * (i + 1);
+        return pixels;
+    }
+
+    uint32_t at(std::vector<uint32_t> const& pixels, uint32_t x, uint32_t y)
+    {
+        return pixels[y * width + x];
+    }
+};
+
+uint32_t swap_red_and_blue(uint32_t p)
+{
+    return (p & 0xff00ff00) | ((p & 0xff) << 16) | ((p >> 16) & 0xff);
+}
+}
+
+TEST_P(PixelConversion, copy_flipped_reverses_rows)
+{
+    auto const src = source();
+    std::vector<uint32_t> dst(src.size());
+
+    ms::copy_flipped(src.data(), dst.data(), width, height);
+
+    for (uint32_t y = 0; y < height; ++y)
+        for (uint32_t x = 0; x < width; ++x)
+            ASSERT_EQ(at(src, x, height - y - 1), at(dst, x, y)) << "at " << x << "," << y;
+}
+
+TEST_P(PixelConversion, copy_flipped_abgr_to_argb_reverses_rows_and_swaps_red_and_blue)
+{
+    auto const src = source();
+    std::vector<uint32_t> dst(src.size());
+
+    ms::copy_flipped_abgr_to_argb(src.data(), dst.data(), width, height);
+
+    for (uint32_t y = 0; y < height; ++y)
+        for (uint32_t x = 0; x < width; ++x)
+            ASSERT_EQ(swap_red_and_blue(at(src, x, height - y - 1)), at(dst, x, y)) << "at " << x << "," << y;
+}
+
+TEST_P(PixelConversion, flip_reverses_rows_in_place)
+{
+    auto const src = source();
+    auto pixels = src;
+
+    ms::flip(pixels.data(), width, height);
+
+    for (uint32_t y = 0; y < height; ++y)
+        for (uint32_t x = 0; x < width; ++x)
+            ASSERT_EQ(at(src, x, height - y - 1), at(pixels, x, y)) << "at " << x << "," << y;
+}
+
+TEST_P(PixelConversion, flip_abgr_to_argb_reverses_rows_and_swaps_red_and_blue_in_place)
+{
+    auto const src = source();
+    auto pixels = src;
+
+    ms::flip_abgr_to_argb(pixels.data(), width, height);
+
+    for (uint32_t y = 0; y < height; ++y)
+        for (uint32_t x = 0; x < width; ++x)
+            ASSERT_EQ(swap_red_and_blue(at(src, x, height - y - 1)), at(pixels, x, y)) << "at " << x << "," << y;
+}
+
+// Widths either side of the vector lengths, so both the vector and scalar paths are exercised
+INSTANTIATE_TEST_CASE_P(Widths, PixelConversion, testing::Values(1, 3, 4, 5, 15, 16, 17, 33, 51));
@@ -59,6 +59,24 @@ struct StubSessionContainer : ms::SessionContainer
         return {};
     }
 
+    std::vector<std::shared_ptr<ms::Session>> sessions_of(pid_t pid) const
+    {
+        std::vector<std::shared_ptr<ms::Session>> result;
+        for (auto const& session : sessions)
+            if (session->process_id() == pid)
+                result.push_back(session);
+        return result;
+    }
+
+    std::vector<std::shared_ptr<ms::Session>> sessions_named(std::string const& name) const
+    {
+        std::vector<std::shared_ptr<ms::Session>> result;
+        for (auto const& session : sessions)
+            if (session->name() == name)
+                result.push_back(session);
+        return result;
+    }
+
     std::vector<std::shared_ptr<ms::Session>> sessions;
 };
 
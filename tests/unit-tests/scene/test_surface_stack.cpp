@@ -225,6 +225,46 @@ TEST_F(SurfaceStack, scene_snapshot_omits_invisible_surfaces)
             SceneElementForStream(stub_buffer_stream2)));
 }
 
+TEST_F(SurfaceStack, scene_snapshot_omits_surfaces_outside_the_view_area)
+{
+    using namespace testing;
+
+    geom::Size const size{100, 100};
+    stub_surface1->set_streams({{stub_buffer_stream1, {0, 0}, size}});
+    stub_surface2->set_streams({{stub_buffer_stream2, {0, 0}, size}});
+    stub_surface3->set_streams({{stub_buffer_stream3, {0, 0}, size}});
+    stub_surface2->move_to({1000, 0});
+    stub_surface3->move_to({600, 400});
+
+    stack.register_compositor(compositor_id);
+    stack.set_view_area(compositor_id, {{0, 0}, {640, 480}});
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+    stack.add_surface(stub_surface3, default_params.input_mode);
+
+    EXPECT_THAT(
+        stack.scene_elements_for(compositor_id),
+        ElementsAre(
+            SceneElementForStream(stub_buffer_stream1),
+            SceneElementForStream(stub_buffer_stream3)));
+}
+
+TEST_F(SurfaceStack, surface_outside_the_view_area_is_occluded)
+{
+    using namespace testing;
+
+    stub_surface1->set_streams({{stub_buffer_stream1, {0, 0}, geom::Size{100, 100}}});
+    stub_surface1->move_to({1000, 0});
+
+    stack.register_compositor(compositor_id);
+    stack.set_view_area(compositor_id, {{0, 0}, {640, 480}});
+    stack.add_surface(stub_surface1, default_params.input_mode);
+
+    stack.scene_elements_for(compositor_id);
+
+    EXPECT_THAT(stub_surface1->query(mir_window_attrib_visibility), Eq(mir_window_visibility_occluded));
+}
+
 TEST_F(SurfaceStack, scene_counts_pending_accurately)
 {
     using namespace testing;
@@ -940,6 +980,56 @@ TEST_F(SurfaceStack, for_each_enumerates_all_input_surfaces)
     EXPECT_THAT(num_exposed_surfaces, Eq(3));
 }
 
+TEST_F(SurfaceStack, for_each_enumerates_the_stack_as_it_was_when_called)
+{
+    using namespace ::testing;
+
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    std::vector<std::shared_ptr<mi::Surface>> enumerated;
+    stack.for_each([&](std::shared_ptr<mi::Surface> const& surface)
+        {
+            if (enumerated.empty())
+            {
+                stack.remove_surface(stub_surface2);
+                stack.add_surface(stub_surface3, default_params.input_mode);
+            }
+            enumerated.push_back(surface);
+        });
+
+    EXPECT_THAT(enumerated, ElementsAre(stub_surface1, stub_surface2));
+    EXPECT_THAT(
+        stack.scene_elements_for(compositor_id),
+        ElementsAre(
+            SceneElementForStream(stub_buffer_stream1),
+            SceneElementForStream(stub_buffer_stream3)));
+}
+
+TEST_F(SurfaceStack, scene_can_be_read_while_it_is_restacked)
+{
+    using namespace ::testing;
+
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+    stack.add_surface(stub_surface3, default_params.input_mode);
+
+    std::atomic<bool> done{false};
+    std::thread restacker{[&]
+        {
+            for (int i = 0; i != 1000; ++i)
+                stack.raise(i % 2 ? stub_surface1 : stub_surface2);
+            done = true;
+        }};
+
+    while (!done)
+    {
+        EXPECT_THAT(stack.scene_elements_for(compositor_id).size(), Eq(3u));
+    }
+
+    restacker.join();
+}
+
 using namespace ::testing;
 
 TEST_F(SurfaceStack, returns_top_surface_under_cursor)
@@ -85,3 +85,69 @@ TEST(DefaultSessionContainer, invalid_session_throw_behavior)
         container.remove_session(std::make_shared<mtd::StubSession>());
     }, std::logic_error);
 }
+
+TEST(DefaultSessionContainer, finds_sessions_by_pid_and_name)
+{
+    using namespace ::testing;
+    ms::DefaultSessionContainer container;
+
+    pid_t const pid{__LINE__};
+    pid_t const another_pid{__LINE__};
+    auto session1 = std::make_shared<mtd::StubSession>(pid);
+    auto session2 = std::make_shared<mtd::StubSession>(another_pid);
+    auto session3 = std::make_shared<mtd::StubSession>(pid);
+
+    container.insert_session(session1);
+    container.insert_session(session2);
+    container.insert_session(session3);
+
+    EXPECT_THAT(container.sessions_of(pid), ElementsAre(session1, session3));
+    EXPECT_THAT(container.sessions_of(another_pid), ElementsAre(session2));
+    EXPECT_THAT(container.sessions_named(session2->name()), ElementsAre(session1, session2, session3));
+
+    container.remove_session(session1);
+
+    EXPECT_THAT(container.sessions_of(pid), ElementsAre(session3));
+    EXPECT_THAT(container.sessions_of(__LINE__), IsEmpty());
+}
+
+TEST(DefaultSessionContainer, sessions_can_be_removed_during_for_each)
+{
+    using namespace ::testing;
+    ms::DefaultSessionContainer container;
+
+    auto session1 = std::make_shared<mtd::StubSession>();
+    auto session2 = std::make_shared<mtd::StubSession>();
+
+    container.insert_session(session1);
+    container.insert_session(session2);
+
+    std::vector<std::shared_ptr<ms::Session>> seen;
+    container.for_each([&](std::shared_ptr<ms::Session> const& session)
+        {
+            seen.push_back(session);
+            container.remove_session(session);
+        });
+
+    EXPECT_THAT(seen, ElementsAre(session1, session2));
+    EXPECT_THAT(container.successor_of({}), Eq(nullptr));
+}
+
+TEST(DefaultSessionContainer, successor_of_follows_removals)
+{
+    using namespace ::testing;
+    ms::DefaultSessionContainer container;
+
+    auto session1 = std::make_shared<mtd::StubSession>();
+    auto session2 = std::make_shared<mtd::StubSession>();
+    auto session3 = std::make_shared<mtd::StubSession>();
+
+    container.insert_session(session1);
+    container.insert_session(session2);
+    container.insert_session(session3);
+    container.remove_session(session2);
+
+    EXPECT_EQ(session3, container.successor_of(session1));
+    EXPECT_EQ(session1, container.successor_of(session3));
+    EXPECT_THROW(container.successor_of(session2), std::logic_error);
+}
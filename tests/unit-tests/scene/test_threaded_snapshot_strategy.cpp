@@ -49,6 +49,9 @@ public:
     ~MockPixelBuffer() noexcept {}
 
     MOCK_METHOD1(fill_from, void(mg::Buffer& buffer));
+    MOCK_METHOD2(fill_from, void(mg::Buffer& buffer, geom::Size const& size));
+    MOCK_METHOD2(begin_fill_from, bool(mg::Buffer& buffer, geom::Size const& size));
+    MOCK_METHOD0(end_fill, void());
     MOCK_METHOD0(as_argb_8888, void const*());
     MOCK_CONST_METHOD0(size, geom::Size());
     MOCK_CONST_METHOD0(stride, geom::Stride());
@@ -121,3 +124,127 @@ TEST_F(ThreadedSnapshotStrategyTest, names_snapshot_thread)
 
     EXPECT_THAT(buffer_access.thread_name, Eq("Mir/Snapshot"));
 }
+
+TEST_F(ThreadedSnapshotStrategyTest, takes_thumbnail_at_requested_size)
+{
+    using namespace testing;
+
+    geom::Size const size{4, 3};
+    geom::Stride const stride{16};
+    std::vector<uint32_t> const pixels(size.width.as_int() * size.height.as_int(), 0xff00ff00);
+
+    NiceMock<MockPixelBuffer> pixel_buffer;
+    ON_CALL(pixel_buffer, as_argb_8888()).WillByDefault(Return(pixels.data()));
+    ON_CALL(pixel_buffer, size()).WillByDefault(Return(size));
+    ON_CALL(pixel_buffer, stride()).WillByDefault(Return(stride));
+
+    EXPECT_CALL(pixel_buffer, fill_from(Ref(*buffer_access.stub_compositor_buffer), size));
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+
+    mt::Signal thumbnail_taken;
+    ms::Snapshot thumbnail;
+    std::vector<uint32_t> thumbnail_pixels;
+
+    strategy.take_thumbnail_of(
+        mt::fake_shared(buffer_access),
+        size,
+        [&](ms::Snapshot const& s)
+        {
+            thumbnail = s;
+            auto const data = static_cast<uint32_t const*>(s.pixels);
+            thumbnail_pixels.assign(data, data + pixels.size());
+            thumbnail_taken.raise();
+        });
+
+    ASSERT_TRUE(thumbnail_taken.wait_for(std::chrono::seconds{5}));
+
+    EXPECT_EQ(size, thumbnail.size);
+    EXPECT_EQ(stride, thumbnail.stride);
+    EXPECT_THAT(thumbnail_pixels, Eq(pixels));
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, reuses_thumbnail_until_stream_changes)
+{
+    using namespace testing;
+
+    geom::Size const size{4, 3};
+    geom::Size const other_size{2, 2};
+    std::vector<uint32_t> const pixels(size.width.as_int() * size.height.as_int(), 0);
+
+    NiceMock<MockPixelBuffer> pixel_buffer;
+    ON_CALL(pixel_buffer, as_argb_8888()).WillByDefault(Return(pixels.data()));
+    ON_CALL(pixel_buffer, size()).WillByDefault(Return(size));
+    ON_CALL(pixel_buffer, stride()).WillByDefault(Return(geom::Stride{16}));
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+    auto const stream = mt::fake_shared(buffer_access);
+
+    auto const take_thumbnail = [&](geom::Size const& size)
+        {
+            mt::Signal thumbnail_taken;
+            strategy.take_thumbnail_of(
+                stream,
+                size,
+                [&](ms::Snapshot const&) { thumbnail_taken.raise(); });
+            ASSERT_TRUE(thumbnail_taken.wait_for(std::chrono::seconds{5}));
+        };
+
+    EXPECT_CALL(pixel_buffer, fill_from(_, size)).Times(1);
+    take_thumbnail(size);
+    take_thumbnail(size);
+    Mock::VerifyAndClearExpectations(&pixel_buffer);
+
+    // A different size needs a new thumbnail
+    EXPECT_CALL(pixel_buffer, fill_from(_, other_size)).Times(1);
+    take_thumbnail(other_size);
+    Mock::VerifyAndClearExpectations(&pixel_buffer);
+
+    // As does a new frame, even in the same buffer
+    EXPECT_CALL(pixel_buffer, fill_from(_, other_size)).Times(1);
+    buffer_access.submit_buffer(buffer_access.stub_compositor_buffer);
+    take_thumbnail(other_size);
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, overlaps_thumbnail_read_backs_when_the_pixel_buffer_supports_it)
+{
+    using namespace testing;
+
+    geom::Size const size{4, 3};
+    std::vector<uint32_t> const pixels(size.width.as_int() * size.height.as_int(), 0);
+    mtd::StubBufferStream other_buffer_access;
+    mt::Signal second_requested;
+
+    NiceMock<MockPixelBuffer> pixel_buffer;
+    ON_CALL(pixel_buffer, as_argb_8888()).WillByDefault(Return(pixels.data()));
+    ON_CALL(pixel_buffer, size()).WillByDefault(Return(size));
+    ON_CALL(pixel_buffer, stride()).WillByDefault(Return(geom::Stride{16}));
+
+    {
+        InSequence seq;
+        EXPECT_CALL(pixel_buffer, begin_fill_from(Ref(*buffer_access.stub_compositor_buffer), size))
+            .WillOnce(InvokeWithoutArgs([&] { second_requested.wait_for(std::chrono::seconds{5}); return true; }));
+        EXPECT_CALL(pixel_buffer, begin_fill_from(Ref(*other_buffer_access.stub_compositor_buffer), size))
+            .WillOnce(Return(true));
+        EXPECT_CALL(pixel_buffer, end_fill()).Times(2);
+    }
+    EXPECT_CALL(pixel_buffer, fill_from(_, _)).Times(0);
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+
+    mt::Signal first_taken;
+    mt::Signal second_taken;
+
+    strategy.take_thumbnail_of(
+        mt::fake_shared(buffer_access),
+        size,
+        [&](ms::Snapshot const&) { first_taken.raise(); });
+    strategy.take_thumbnail_of(
+        mt::fake_shared(other_buffer_access),
+        size,
+        [&](ms::Snapshot const&) { second_taken.raise(); });
+    second_requested.raise();
+
+    EXPECT_TRUE(first_taken.wait_for(std::chrono::seconds{5}));
+    EXPECT_TRUE(second_taken.wait_for(std::chrono::seconds{5}));
+}
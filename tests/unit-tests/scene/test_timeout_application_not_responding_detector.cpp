@@ -45,7 +45,7 @@ TEST(TimeoutApplicationNotRespondingDetector, pings_registered_sessions_on_sched
     
     mtd::FakeAlarmFactory fake_alarms;
     
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
     
     bool first_session_pinged{false}, second_session_pinged{false};
     
@@ -72,7 +72,7 @@ TEST(TimeoutApplicationNotRespondingDetector, pings_repeatedly)
 
     mtd::FakeAlarmFactory fake_alarms;
 
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
 
     int first_session_pinged{0}, second_session_pinged{0};
 
@@ -101,7 +101,7 @@ TEST(TimeoutApplicationNotRespondingDetector, triggers_anr_signal_when_session_f
 
     mtd::FakeAlarmFactory fake_alarms;
 
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
 
     bool session_not_responding{false};
     auto observer = std::make_shared<NiceMock<MockObserver>>();
@@ -132,7 +132,7 @@ TEST(TimeoutApplicationNotRespondingDetector, does_not_trigger_anr_when_session_
 
     mtd::FakeAlarmFactory fake_alarms;
 
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
 
     bool session_not_responding{false};
     auto observer = std::make_shared<NiceMock<MockObserver>>();
@@ -165,7 +165,7 @@ TEST(TimeoutApplicationNotRespondingDetector, triggers_now_responsive_signal_whe
 
     mtd::FakeAlarmFactory fake_alarms;
 
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
 
     bool session_not_responding{false};
     auto observer = std::make_shared<NiceMock<MockObserver>>();
@@ -205,7 +205,7 @@ TEST(TimeoutApplicationNotRespondingDetector, fiddling_with_sessions_from_callba
 
     mtd::FakeAlarmFactory fake_alarms;
 
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
 
     NiceMock<mtd::MockSceneSession> session_one, session_two, session_three;
 
@@ -242,7 +242,7 @@ TEST(TimeoutApplicationNotRespondingDetector, does_not_generate_signals_after_un
 
     mtd::FakeAlarmFactory fake_alarms;
 
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
 
     bool session_not_responding{false};
     auto observer = std::make_shared<NiceMock<MockObserver>>();
@@ -285,7 +285,7 @@ TEST(TimeoutApplicationNotRespondingDetector, does_not_schedule_alarm_when_no_se
 
     mtd::FakeAlarmFactory fake_alarms;
 
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
 
     // Go through several ping cycles.
     fake_alarms.advance_smoothly_by(5000ms);
@@ -316,7 +316,7 @@ TEST(TimeoutApplicationNotRespondingDetector, does_not_schedule_alarm_when_all_s
 
     mtd::FakeAlarmFactory fake_alarms;
 
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
 
     NiceMock<mtd::MockSceneSession> session;
     bool session_unresponsive{false};
@@ -350,7 +350,7 @@ TEST(TimeoutApplicationNotRespondingDetector, session_switches_between_responsiv
 
     mtd::FakeAlarmFactory fake_alarms;
 
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
 
     NiceMock<mtd::MockSceneSession> session;
     bool session_unresponsive{false};
@@ -391,7 +391,7 @@ TEST(TimeoutApplicationNotRespondingDetector, sends_unresponsive_notification_on
 
     mtd::FakeAlarmFactory fake_alarms;
 
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, 1s};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
 
     NiceMock<mtd::MockSceneSession> session_one;
     NiceMock<mtd::MockSceneSession> session_two;
@@ -434,7 +434,7 @@ TEST(TimeoutApplicationNotRespondingDetector, sends_pings_on_schedule_as_session
     mtd::FakeAlarmFactory fake_alarms;
 
     auto const cycle_time = 1s;
-    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, cycle_time};
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), cycle_time};
 
     NiceMock<mtd::MockSceneSession> session;
     std::atomic<int> ping_count{0};
@@ -469,3 +469,131 @@ TEST(TimeoutApplicationNotRespondingDetector, sends_pings_on_schedule_as_session
 
     EXPECT_THAT(ping_count, Ge(duration / cycle_time));
 }
+
+TEST(TimeoutApplicationNotRespondingDetector, does_not_ping_sessions_sending_traffic)
+{
+    using namespace testing;
+    using namespace std::literals::chrono_literals;
+
+    mtd::FakeAlarmFactory fake_alarms;
+
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
+
+    auto observer = std::make_shared<NiceMock<MockObserver>>();
+    EXPECT_CALL(*observer, session_unresponsive(_)).Times(0);
+    detector.register_observer(observer);
+
+    NiceMock<mtd::MockSceneSession> session;
+    int ping_count{0};
+
+    detector.register_session(&session, [&ping_count]() { ++ping_count; });
+    auto const notify_activity = detector.activity_notifier(&session);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        fake_alarms.advance_by(500ms);
+        notify_activity();
+    }
+
+    EXPECT_THAT(ping_count, Eq(0));
+
+    // Once the traffic stops we go back to pinging
+    fake_alarms.advance_smoothly_by(2000ms);
+
+    EXPECT_THAT(ping_count, Gt(0));
+}
+
+TEST(TimeoutApplicationNotRespondingDetector, traffic_from_unresponsive_session_marks_it_responsive)
+{
+    using namespace testing;
+    using namespace std::literals::chrono_literals;
+
+    mtd::FakeAlarmFactory fake_alarms;
+
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
+
+    NiceMock<mtd::MockSceneSession> session;
+
+    auto observer = std::make_shared<NiceMock<MockObserver>>();
+    detector.register_observer(observer);
+    detector.register_session(&session, [](){});
+    auto const notify_activity = detector.activity_notifier(&session);
+
+    EXPECT_CALL(*observer, session_unresponsive(&session));
+    fake_alarms.advance_smoothly_by(3000ms);
+    Mock::VerifyAndClearExpectations(observer.get());
+
+    EXPECT_CALL(*observer, session_now_responsive(&session)).Times(1);
+    notify_activity();
+    notify_activity();
+}
+
+TEST(TimeoutApplicationNotRespondingDetector, session_that_was_unresponsive_is_pinged_again_once_traffic_stops)
+{
+    using namespace testing;
+    using namespace std::literals::chrono_literals;
+
+    mtd::FakeAlarmFactory fake_alarms;
+
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
+
+    NiceMock<mtd::MockSceneSession> session;
+    int ping_count{0};
+
+    detector.register_session(&session, [&ping_count]() { ++ping_count; });
+    auto const notify_activity = detector.activity_notifier(&session);
+
+    fake_alarms.advance_smoothly_by(3000ms);
+    notify_activity();
+    ping_count = 0;
+
+    fake_alarms.advance_smoothly_by(3000ms);
+
+    EXPECT_THAT(ping_count, Gt(0));
+}
+
+TEST(TimeoutApplicationNotRespondingDetector, ignores_traffic_from_unregistered_sessions)
+{
+    using namespace std::literals::chrono_literals;
+
+    mtd::FakeAlarmFactory fake_alarms;
+
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
+
+    testing::NiceMock<mtd::MockSceneSession> session;
+
+    EXPECT_NO_THROW(detector.activity_notifier(&session)());
+
+    detector.register_session(&session, [](){});
+    auto const notify_activity = detector.activity_notifier(&session);
+    detector.unregister_session(&session);
+
+    EXPECT_NO_THROW(notify_activity());
+}
+
+TEST(TimeoutApplicationNotRespondingDetector, pings_sessions_a_period_after_they_register)
+{
+    using namespace testing;
+    using namespace std::literals::chrono_literals;
+
+    mtd::FakeAlarmFactory fake_alarms;
+
+    ms::TimeoutApplicationNotRespondingDetector detector{fake_alarms, fake_alarms.clock(), 1s};
+
+    bool first_session_pinged{false}, second_session_pinged{false};
+
+    NiceMock<mtd::MockSceneSession> session_one, session_two;
+
+    detector.register_session(&session_one, [&first_session_pinged]() { first_session_pinged = true; });
+    fake_alarms.advance_by(500ms);
+    detector.register_session(&session_two, [&second_session_pinged]() { second_session_pinged = true; });
+
+    fake_alarms.advance_by(501ms);
+
+    EXPECT_TRUE(first_session_pinged);
+    EXPECT_FALSE(second_session_pinged);
+
+    fake_alarms.advance_by(500ms);
+
+    EXPECT_TRUE(second_session_pinged);
+}
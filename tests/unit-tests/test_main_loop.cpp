@@ -1,5 +1,5 @@
 /*
- * Copyright © 2014-2015 Canonical Ltd.
+ * Copyright © 2014-2018 Canonical Ltd.
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License version 2 or 3 as
@@ -18,6 +18,7 @@
  */
 
 #include "mir/glib_main_loop.h"
+#include "mir/epoll_main_loop.h"
 #include "mir/time/steady_clock.h"
 
 #include "mir/test/signal.h"
@@ -32,6 +33,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <array>
 #include <thread>
 
 namespace mt = mir::test;
@@ -80,15 +82,19 @@ void execute_in_forked_process(
     }
 }
 
-struct GLibMainLoopTest : ::testing::Test
+template<typename MainLoop>
+struct MainLoopTest : ::testing::Test
 {
-    mir::GLibMainLoop ml{std::make_shared<mir::time::SteadyClock>()};
-    std::function<void()> const destroy_glib_main_loop{[this]{ ml.~GLibMainLoop(); }};
+    MainLoop ml{std::make_shared<mir::time::SteadyClock>()};
+    std::function<void()> const destroy_main_loop{[this]{ ml.~MainLoop(); }};
 };
 
+using MainLoops = ::testing::Types<mir::GLibMainLoop, mir::EpollMainLoop>;
 }
 
-TEST_F(GLibMainLoopTest, stops_from_within_handler)
+TYPED_TEST_CASE(MainLoopTest, MainLoops);
+
+TYPED_TEST(MainLoopTest, stops_from_within_handler)
 {
     mt::Signal loop_finished;
 
@@ -96,15 +102,15 @@ TEST_F(GLibMainLoopTest, stops_from_within_handler)
         [&]
         {
             int const owner{0};
-            ml.enqueue(&owner, [&] { ml.stop(); });
-            ml.run();
+            this->ml.enqueue(&owner, [&] { this->ml.stop(); });
+            this->ml.run();
             loop_finished.raise();
         }};
 
     EXPECT_TRUE(loop_finished.wait_for(std::chrono::seconds{5}));
 }
 
-TEST_F(GLibMainLoopTest, stops_from_outside_handler)
+TYPED_TEST(MainLoopTest, stops_from_outside_handler)
 {
     mt::Signal loop_running;
     mt::Signal loop_finished;
@@ -113,19 +119,19 @@ TEST_F(GLibMainLoopTest, stops_from_outside_handler)
         [&]
         {
             int const owner{0};
-            ml.enqueue(&owner, [&] { loop_running.raise(); });
-            ml.run();
+            this->ml.enqueue(&owner, [&] { loop_running.raise(); });
+            this->ml.run();
             loop_finished.raise();
         }};
 
     ASSERT_TRUE(loop_running.wait_for(std::chrono::seconds{5}));
 
-    ml.stop();
+    this->ml.stop();
 
     EXPECT_TRUE(loop_finished.wait_for(std::chrono::seconds{30}));
 }
 
-TEST_F(GLibMainLoopTest, ignores_handler_added_after_stop)
+TYPED_TEST(MainLoopTest, ignores_handler_added_after_stop)
 {
     int const owner{0};
     bool handler_called{false};
@@ -135,47 +141,47 @@ TEST_F(GLibMainLoopTest, ignores_handler_added_after_stop)
         [&]
         {
             loop_running.wait();
-            ml.stop();
+            this->ml.stop();
             int const owner1{0};
-            ml.enqueue(&owner1, [&] { handler_called = true; });
+            this->ml.enqueue(&owner1, [&] { handler_called = true; });
         }};
 
-    ml.enqueue(&owner, [&] { loop_running.raise(); });
-    ml.run();
+    this->ml.enqueue(&owner, [&] { loop_running.raise(); });
+    this->ml.run();
 
     t.join();
 
     EXPECT_FALSE(handler_called);
 }
 
-TEST_F(GLibMainLoopTest, handles_signal)
+TYPED_TEST(MainLoopTest, handles_signal)
 {
     int const signum{SIGUSR1};
     int handled_signum{0};
 
-    ml.register_signal_handler(
+    this->ml.register_signal_handler(
         {signum},
         [&handled_signum, this](int sig)
         {
            handled_signum = sig;
-           ml.stop();
+           this->ml.stop();
         });
 
     kill(getpid(), signum);
 
-    ml.run();
+    this->ml.run();
 
     ASSERT_EQ(signum, handled_signum);
 }
 
-TEST_F(GLibMainLoopTest, handles_multiple_signals)
+TYPED_TEST(MainLoopTest, handles_multiple_signals)
 {
     std::vector<int> const signals{SIGUSR1, SIGUSR2};
     size_t const num_signals_to_send{10};
     std::vector<int> handled_signals;
     std::atomic<unsigned int> num_handled_signals{0};
 
-    ml.register_signal_handler(
+    this->ml.register_signal_handler(
         {signals[0], signals[1]},
         [&handled_signals, &num_handled_signals](int sig)
         {
@@ -192,10 +198,10 @@ TEST_F(GLibMainLoopTest, handles_multiple_signals)
                 kill(getpid(), signals[i % signals.size()]);
                 while (num_handled_signals <= i) std::this_thread::yield();
             }
-            ml.stop();
+            this->ml.stop();
         });
 
-    ml.run();
+    this->ml.run();
 
     signal_sending_thread.join();
 
@@ -205,14 +211,14 @@ TEST_F(GLibMainLoopTest, handles_multiple_signals)
         EXPECT_EQ(signals[i % signals.size()], handled_signals[i]) << " index " << i;
 }
 
-TEST_F(GLibMainLoopTest, invokes_all_registered_handlers_for_signal)
+TYPED_TEST(MainLoopTest, invokes_all_registered_handlers_for_signal)
 {
     using namespace testing;
 
     int const signum{SIGUSR1};
     std::vector<int> handled_signum{0,0,0};
 
-    ml.register_signal_handler(
+    this->ml.register_signal_handler(
         {signum},
         [&handled_signum, this](int sig)
         {
@@ -221,11 +227,11 @@ TEST_F(GLibMainLoopTest, invokes_all_registered_handlers_for_signal)
                 handled_signum[1] != 0 &&
                 handled_signum[2] != 0)
             {
-                ml.stop();
+                this->ml.stop();
             }
         });
 
-    ml.register_signal_handler(
+    this->ml.register_signal_handler(
         {signum},
         [&handled_signum, this](int sig)
         {
@@ -234,11 +240,11 @@ TEST_F(GLibMainLoopTest, invokes_all_registered_handlers_for_signal)
                 handled_signum[1] != 0 &&
                 handled_signum[2] != 0)
             {
-                ml.stop();
+                this->ml.stop();
             }
         });
 
-    ml.register_signal_handler(
+    this->ml.register_signal_handler(
         {signum},
         [&handled_signum, this](int sig)
         {
@@ -247,18 +253,18 @@ TEST_F(GLibMainLoopTest, invokes_all_registered_handlers_for_signal)
                 handled_signum[1] != 0 &&
                 handled_signum[2] != 0)
             {
-                ml.stop();
+                this->ml.stop();
             }
         });
 
     kill(getpid(), signum);
 
-    ml.run();
+    this->ml.run();
 
     ASSERT_THAT(handled_signum, Each(signum));
 }
 
-TEST_F(GLibMainLoopTest, propagates_exception_from_signal_handler)
+TYPED_TEST(MainLoopTest, propagates_exception_from_signal_handler)
 {
     // Execute in forked process to work around
     // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=61643
@@ -267,66 +273,66 @@ TEST_F(GLibMainLoopTest, propagates_exception_from_signal_handler)
         [&]
         {
             int const signum{SIGUSR1};
-            ml.register_signal_handler(
+            this->ml.register_signal_handler(
                 {signum},
                 [&] (int) { throw std::runtime_error("signal handler error"); });
 
             kill(getpid(), signum);
 
-            EXPECT_THROW({ ml.run(); }, std::runtime_error);
+            EXPECT_THROW({ this->ml.run(); }, std::runtime_error);
         },
         // Since we terminate the forked process with an exit() call, objects on
         // the stack are not destroyed. We need to manually destroy the
-        // GLibMainLoop object to avoid fd leaks.
-        destroy_glib_main_loop);
+        // main loop object to avoid fd leaks.
+        this->destroy_main_loop);
 }
 
-TEST_F(GLibMainLoopTest, handles_signal_with_unique_module_ptr_handler)
+TYPED_TEST(MainLoopTest, handles_signal_with_unique_module_ptr_handler)
 {
     int const signum{SIGUSR1};
     int handled_signum{0};
 
-    ml.register_signal_handler(
+    this->ml.register_signal_handler(
         {signum},
         mir::make_module_ptr<std::function<void(int)>>(
             [&handled_signum, this](int sig)
             {
                handled_signum = sig;
-               ml.stop();
+               this->ml.stop();
             }));
 
     kill(getpid(), signum);
 
-    ml.run();
+    this->ml.run();
 
     ASSERT_EQ(signum, handled_signum);
 }
 
-TEST_F(GLibMainLoopTest, handles_fd)
+TYPED_TEST(MainLoopTest, handles_fd)
 {
     mt::Pipe p;
     char const data_to_write{'a'};
     int handled_fd{0};
     char data_read{0};
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {p.read_fd()},
         this,
         [&handled_fd, &data_read, this](int fd)
         {
             handled_fd = fd;
             EXPECT_EQ(1, read(fd, &data_read, 1));
-            ml.stop();
+            this->ml.stop();
         });
 
     EXPECT_EQ(1, write(p.write_fd(), &data_to_write, 1));
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_EQ(data_to_write, data_read);
 }
 
-TEST_F(GLibMainLoopTest, multiple_fds_with_single_handler_handled)
+TYPED_TEST(MainLoopTest, multiple_fds_with_single_handler_handled)
 {
     using namespace testing;
 
@@ -336,7 +342,7 @@ TEST_F(GLibMainLoopTest, multiple_fds_with_single_handler_handled)
     std::vector<size_t> elems_read;
     std::atomic<unsigned int> num_handled_fds{0};
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {pipes[0].read_fd(), pipes[1].read_fd()},
         this,
         [&handled_fds, &elems_read, &num_handled_fds](int fd)
@@ -360,10 +366,10 @@ TEST_F(GLibMainLoopTest, multiple_fds_with_single_handler_handled)
                           write(pipes[i % pipes.size()].write_fd(), &i, sizeof(i)));
                 while (num_handled_fds <= i) std::this_thread::yield();
             }
-            ml.stop();
+            this->ml.stop();
         }};
 
-    ml.run();
+    this->ml.run();
 
     fd_writing_thread.join();
 
@@ -374,7 +380,7 @@ TEST_F(GLibMainLoopTest, multiple_fds_with_single_handler_handled)
     EXPECT_THAT(elems_read, ContainerEq(values_from_to<size_t>(0, num_elems_to_send - 1)));
 }
 
-TEST_F(GLibMainLoopTest, multiple_fd_handlers_are_called)
+TYPED_TEST(MainLoopTest, multiple_fd_handlers_are_called)
 {
     using namespace testing;
 
@@ -383,7 +389,7 @@ TEST_F(GLibMainLoopTest, multiple_fd_handlers_are_called)
     std::vector<int> handled_fds{0,0,0};
     std::vector<int> elems_read{0,0,0};
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {pipes[0].read_fd()},
         this,
         [&handled_fds, &elems_read, this](int fd)
@@ -395,11 +401,11 @@ TEST_F(GLibMainLoopTest, multiple_fd_handlers_are_called)
                 handled_fds[1] != 0 &&
                 handled_fds[2] != 0)
             {
-                ml.stop();
+                this->ml.stop();
             }
         });
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {pipes[1].read_fd()},
         this,
         [&handled_fds, &elems_read, this](int fd)
@@ -411,11 +417,11 @@ TEST_F(GLibMainLoopTest, multiple_fd_handlers_are_called)
                 handled_fds[1] != 0 &&
                 handled_fds[2] != 0)
             {
-                ml.stop();
+                this->ml.stop();
             }
         });
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {pipes[2].read_fd()},
         this,
         [&handled_fds, &elems_read, this](int fd)
@@ -427,7 +433,7 @@ TEST_F(GLibMainLoopTest, multiple_fd_handlers_are_called)
                 handled_fds[1] != 0 &&
                 handled_fds[2] != 0)
             {
-                ml.stop();
+                this->ml.stop();
             }
         });
 
@@ -438,7 +444,7 @@ TEST_F(GLibMainLoopTest, multiple_fd_handlers_are_called)
     EXPECT_EQ(static_cast<ssize_t>(sizeof(elems_to_send[2])),
               write(pipes[2].write_fd(), &elems_to_send[2], sizeof(elems_to_send[2])));
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_THAT(handled_fds,
                 ElementsAre(
@@ -449,7 +455,7 @@ TEST_F(GLibMainLoopTest, multiple_fd_handlers_are_called)
     EXPECT_THAT(elems_read, ContainerEq(elems_to_send));
 }
 
-TEST_F(GLibMainLoopTest,
+TYPED_TEST(MainLoopTest,
        unregister_prevents_callback_and_does_not_harm_other_callbacks)
 {
     mt::Pipe p1, p2;
@@ -457,70 +463,70 @@ TEST_F(GLibMainLoopTest,
     int p2_handler_executes{-1};
     char data_read{0};
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {p1.read_fd()},
         this,
         [this](int)
         {
             FAIL() << "unregistered handler called";
-            ml.stop();
+            this->ml.stop();
         });
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {p2.read_fd()},
         this+2,
         [&p2_handler_executes,&data_read,this](int fd)
         {
             p2_handler_executes = fd;
             EXPECT_EQ(1, read(fd, &data_read, 1));
-            ml.stop();
+            this->ml.stop();
         });
 
-    ml.unregister_fd_handler(this);
+    this->ml.unregister_fd_handler(this);
 
     EXPECT_EQ(1, write(p1.write_fd(), &data_to_write, 1));
     EXPECT_EQ(1, write(p2.write_fd(), &data_to_write, 1));
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_EQ(data_to_write, data_read);
     EXPECT_EQ(p2.read_fd(), p2_handler_executes);
 }
 
-TEST_F(GLibMainLoopTest, unregister_does_not_close_fds)
+TYPED_TEST(MainLoopTest, unregister_does_not_close_fds)
 {
     mt::Pipe p1, p2;
     char const data_to_write{'b'};
     char data_read{0};
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {p1.read_fd()},
         this,
         [this](int)
         {
             FAIL() << "unregistered handler called";
-            ml.stop();
+            this->ml.stop();
         });
 
-    ml.unregister_fd_handler(this);
+    this->ml.unregister_fd_handler(this);
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {p1.read_fd()},
         this,
         [this,&data_read](int fd)
         {
             EXPECT_EQ(1, read(fd, &data_read, 1));
-            ml.stop();
+            this->ml.stop();
         });
 
     EXPECT_EQ(1, write(p1.write_fd(), &data_to_write, 1));
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_EQ(data_to_write, data_read);
 }
 
-TEST_F(GLibMainLoopTest, propagates_exception_from_fd_handler)
+TYPED_TEST(MainLoopTest, propagates_exception_from_fd_handler)
 {
     // Execute in forked process to work around
     // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=61643
@@ -531,47 +537,47 @@ TEST_F(GLibMainLoopTest, propagates_exception_from_fd_handler)
             mt::Pipe p;
             char const data_to_write{'a'};
 
-            ml.register_fd_handler(
+            this->ml.register_fd_handler(
                 {p.read_fd()},
                 this,
                 [] (int) { throw std::runtime_error("fd handler error"); });
 
             EXPECT_EQ(1, write(p.write_fd(), &data_to_write, 1));
 
-            EXPECT_THROW({ ml.run(); }, std::runtime_error);
+            EXPECT_THROW({ this->ml.run(); }, std::runtime_error);
         },
         // Since we terminate the forked process with an exit() call, objects on
         // the stack are not destroyed. We need to manually destroy the
-        // GLibMainLoop object to avoid fd leaks.
-        destroy_glib_main_loop);
+        // main loop object to avoid fd leaks.
+        this->destroy_main_loop);
 }
 
-TEST_F(GLibMainLoopTest, can_unregister_fd_from_within_fd_handler)
+TYPED_TEST(MainLoopTest, can_unregister_fd_from_within_fd_handler)
 {
     mt::Pipe p1;
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {p1.read_fd()},
         this,
         [this](int)
         {
-            ml.unregister_fd_handler(this);
-            ml.stop();
+            this->ml.unregister_fd_handler(this);
+            this->ml.stop();
         });
 
     EXPECT_EQ(1, write(p1.write_fd(), "a", 1));
 
-    ml.run();
+    this->ml.run();
 }
 
-TEST_F(GLibMainLoopTest, handles_fd_with_unique_module_ptr_handler)
+TYPED_TEST(MainLoopTest, handles_fd_with_unique_module_ptr_handler)
 {
     mt::Pipe p;
     char const data_to_write{'a'};
     int handled_fd{0};
     char data_read{0};
 
-    ml.register_fd_handler(
+    this->ml.register_fd_handler(
         {p.read_fd()},
         this,
         mir::make_module_ptr<std::function<void(int)>>(
@@ -579,37 +585,37 @@ TEST_F(GLibMainLoopTest, handles_fd_with_unique_module_ptr_handler)
             {
                 handled_fd = fd;
                 EXPECT_EQ(1, read(fd, &data_read, 1));
-                ml.stop();
+                this->ml.stop();
             }));
 
     EXPECT_EQ(1, write(p.write_fd(), &data_to_write, 1));
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_EQ(data_to_write, data_read);
 }
 
-TEST_F(GLibMainLoopTest, dispatches_action)
+TYPED_TEST(MainLoopTest, dispatches_action)
 {
     using namespace testing;
 
     int num_actions{0};
     int const owner{0};
 
-    ml.enqueue(
+    this->ml.enqueue(
         &owner,
         [&]
         {
             ++num_actions;
-            ml.stop();
+            this->ml.stop();
         });
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_THAT(num_actions, Eq(1));
 }
 
-TEST_F(GLibMainLoopTest, dispatches_multiple_actions_in_order)
+TYPED_TEST(MainLoopTest, dispatches_multiple_actions_in_order)
 {
     using namespace testing;
 
@@ -619,22 +625,22 @@ TEST_F(GLibMainLoopTest, dispatches_multiple_actions_in_order)
 
     for (int i = 0; i < num_actions; ++i)
     {
-        ml.enqueue(
+        this->ml.enqueue(
             &owner,
             [&,i]
             {
                 actions.push_back(i);
                 if (i == num_actions - 1)
-                    ml.stop();
+                    this->ml.stop();
             });
     }
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_THAT(actions, ContainerEq(values_from_to(0, num_actions - 1)));
 }
 
-TEST_F(GLibMainLoopTest, does_not_dispatch_paused_actions)
+TYPED_TEST(MainLoopTest, does_not_dispatch_paused_actions)
 {
     using namespace testing;
 
@@ -642,7 +648,7 @@ TEST_F(GLibMainLoopTest, does_not_dispatch_paused_actions)
     int const owner1{0};
     int const owner2{0};
 
-    ml.enqueue(
+    this->ml.enqueue(
         &owner1,
         [&]
         {
@@ -650,7 +656,7 @@ TEST_F(GLibMainLoopTest, does_not_dispatch_paused_actions)
             actions.push_back(id);
         });
 
-    ml.enqueue(
+    this->ml.enqueue(
         &owner2,
         [&]
         {
@@ -658,7 +664,7 @@ TEST_F(GLibMainLoopTest, does_not_dispatch_paused_actions)
             actions.push_back(id);
         });
 
-    ml.enqueue(
+    this->ml.enqueue(
         &owner1,
         [&]
         {
@@ -666,23 +672,23 @@ TEST_F(GLibMainLoopTest, does_not_dispatch_paused_actions)
             actions.push_back(id);
         });
 
-    ml.enqueue(
+    this->ml.enqueue(
         &owner2,
         [&]
         {
             int const id = 3;
             actions.push_back(id);
-            ml.stop();
+            this->ml.stop();
         });
 
-    ml.pause_processing_for(&owner1);
+    this->ml.pause_processing_for(&owner1);
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_THAT(actions, ElementsAre(1, 3));
 }
 
-TEST_F(GLibMainLoopTest, dispatches_actions_resumed_from_within_another_action)
+TYPED_TEST(MainLoopTest, dispatches_actions_resumed_from_within_another_action)
 {
     using namespace testing;
 
@@ -690,32 +696,32 @@ TEST_F(GLibMainLoopTest, dispatches_actions_resumed_from_within_another_action)
     void const* const owner1_ptr{&actions};
     int const owner2{0};
 
-    ml.enqueue(
+    this->ml.enqueue(
         owner1_ptr,
         [&]
         {
             int const id = 0;
             actions.push_back(id);
-            ml.stop();
+            this->ml.stop();
         });
 
-    ml.enqueue(
+    this->ml.enqueue(
         &owner2,
         [&]
         {
             int const id = 1;
             actions.push_back(id);
-            ml.resume_processing_for(owner1_ptr);
+            this->ml.resume_processing_for(owner1_ptr);
         });
 
-    ml.pause_processing_for(owner1_ptr);
+    this->ml.pause_processing_for(owner1_ptr);
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_THAT(actions, ElementsAre(1, 0));
 }
 
-TEST_F(GLibMainLoopTest, handles_enqueue_from_within_action)
+TYPED_TEST(MainLoopTest, handles_enqueue_from_within_action)
 {
     using namespace testing;
 
@@ -723,7 +729,7 @@ TEST_F(GLibMainLoopTest, handles_enqueue_from_within_action)
     int const num_actions{10};
     void const* const owner{&num_actions};
 
-    ml.enqueue(
+    this->ml.enqueue(
         owner,
         [&]
         {
@@ -732,23 +738,23 @@ TEST_F(GLibMainLoopTest, handles_enqueue_from_within_action)
 
             for (int i = 1; i < num_actions; ++i)
             {
-                ml.enqueue(
+                this->ml.enqueue(
                     owner,
                     [&,i]
                     {
                         actions.push_back(i);
                         if (i == num_actions - 1)
-                            ml.stop();
+                            this->ml.stop();
                     });
             }
         });
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_THAT(actions, ContainerEq(values_from_to(0, num_actions - 1)));
 }
 
-TEST_F(GLibMainLoopTest, dispatches_actions_resumed_externally)
+TYPED_TEST(MainLoopTest, dispatches_actions_resumed_externally)
 {
     using namespace testing;
 
@@ -757,16 +763,16 @@ TEST_F(GLibMainLoopTest, dispatches_actions_resumed_externally)
     int const owner2{0};
     mt::Signal action_with_id_1_done;
 
-    ml.enqueue(
+    this->ml.enqueue(
         owner1_ptr,
         [&]
         {
             int const id = 0;
             actions.push_back(id);
-            ml.stop();
+            this->ml.stop();
         });
 
-    ml.enqueue(
+    this->ml.enqueue(
         &owner2,
         [&]
         {
@@ -775,16 +781,16 @@ TEST_F(GLibMainLoopTest, dispatches_actions_resumed_externally)
             action_with_id_1_done.raise();
         });
 
-    ml.pause_processing_for(owner1_ptr);
+    this->ml.pause_processing_for(owner1_ptr);
 
     std::thread t{
         [&]
         {
             action_with_id_1_done.wait_for(std::chrono::seconds{5});
-            ml.resume_processing_for(owner1_ptr);
+            this->ml.resume_processing_for(owner1_ptr);
         }};
 
-    ml.run();
+    this->ml.run();
 
     t.join();
 
@@ -792,7 +798,7 @@ TEST_F(GLibMainLoopTest, dispatches_actions_resumed_externally)
     EXPECT_THAT(actions, ElementsAre(1, 0));
 }
 
-TEST_F(GLibMainLoopTest, propagates_exception_from_server_action)
+TYPED_TEST(MainLoopTest, propagates_exception_from_server_action)
 {
     // Execute in forked process to work around
     // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=61643
@@ -800,17 +806,17 @@ TEST_F(GLibMainLoopTest, propagates_exception_from_server_action)
     execute_in_forked_process(this,
         [&]
         {
-            ml.enqueue(this, [] { throw std::runtime_error("server action error"); });
+            this->ml.enqueue(this, [] { throw std::runtime_error("server action error"); });
 
-            EXPECT_THROW({ ml.run(); }, std::runtime_error);
+            EXPECT_THROW({ this->ml.run(); }, std::runtime_error);
         },
         // Since we terminate the forked process with an exit() call, objects on
         // the stack are not destroyed. We need to manually destroy the
-        // GLibMainLoop object to avoid fd leaks.
-        destroy_glib_main_loop);
+        // main loop object to avoid fd leaks.
+        this->destroy_main_loop);
 }
 
-TEST_F(GLibMainLoopTest, can_be_rerun_after_exception)
+TYPED_TEST(MainLoopTest, can_be_rerun_after_exception)
 {
     // Execute in forked process to work around
     // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=61643
@@ -818,28 +824,28 @@ TEST_F(GLibMainLoopTest, can_be_rerun_after_exception)
     execute_in_forked_process(this,
         [&]
         {
-            ml.enqueue(this, [] { throw std::runtime_error("server action exception"); });
+            this->ml.enqueue(this, [] { throw std::runtime_error("server action exception"); });
 
             EXPECT_THROW({
-                ml.run();
+                this->ml.run();
             }, std::runtime_error);
 
-            ml.enqueue(this, [&] { ml.stop(); });
-            ml.run();
+            this->ml.enqueue(this, [&] { this->ml.stop(); });
+            this->ml.run();
         },
         // Since we terminate the forked process with an exit() call, objects on
         // the stack are not destroyed. We need to manually destroy the
-        // GLibMainLoop object to avoid fd leaks.
-        destroy_glib_main_loop);
+        // main loop object to avoid fd leaks.
+        this->destroy_main_loop);
 }
 
-TEST_F(GLibMainLoopTest, enqueue_with_guaranteed_execution_executes_before_run)
+TYPED_TEST(MainLoopTest, enqueue_with_guaranteed_execution_executes_before_run)
 {
     using namespace testing;
 
     int num_actions{0};
 
-    ml.enqueue_with_guaranteed_execution(
+    this->ml.enqueue_with_guaranteed_execution(
         [&num_actions]
         {
             ++num_actions;
@@ -848,22 +854,22 @@ TEST_F(GLibMainLoopTest, enqueue_with_guaranteed_execution_executes_before_run)
     EXPECT_THAT(num_actions, Eq(1));
 }
 
-TEST_F(GLibMainLoopTest, enqueue_with_guaranteed_execution_executes_after_stop)
+TYPED_TEST(MainLoopTest, enqueue_with_guaranteed_execution_executes_after_stop)
 {
     using namespace testing;
 
     int num_actions{0};
 
-    ml.enqueue(
+    this->ml.enqueue(
         nullptr,
         [this]()
         {
-            ml.stop();
+            this->ml.stop();
         });
 
-    ml.run();
+    this->ml.run();
 
-    ml.enqueue_with_guaranteed_execution(
+    this->ml.enqueue_with_guaranteed_execution(
         [&num_actions]
         {
             ++num_actions;
@@ -872,33 +878,33 @@ TEST_F(GLibMainLoopTest, enqueue_with_guaranteed_execution_executes_after_stop)
     EXPECT_THAT(num_actions, Eq(1));
 }
 
-TEST_F(GLibMainLoopTest, enqueue_with_guaranteed_execution_executes_on_mainloop)
+TYPED_TEST(MainLoopTest, enqueue_with_guaranteed_execution_executes_on_mainloop)
 {
     using namespace testing;
 
     mt::Signal loop_running;
     mt::Signal loop_finished;
 
-    ml.enqueue(
+    this->ml.enqueue(
         nullptr,
         [&loop_running]() { loop_running.raise(); });
 
     mt::AutoJoinThread t{
         [&]
         {
-            ml.run();
+            this->ml.run();
             loop_finished.raise();
         }};
 
     ASSERT_TRUE(loop_running.wait_for(std::chrono::seconds{5}));
 
-    ml.enqueue_with_guaranteed_execution(
+    this->ml.enqueue_with_guaranteed_execution(
         [main_thread = std::this_thread::get_id()]()
         {
             EXPECT_THAT(std::this_thread::get_id(), Ne(main_thread));
         });
 
-    ml.stop();
+    this->ml.stop();
 
     EXPECT_TRUE(loop_finished.wait_for(std::chrono::seconds{30}));
 }
@@ -908,7 +914,8 @@ namespace
 
 struct AdvanceableClock : mtd::AdvanceableClock
 {
-    void advance_by(std::chrono::milliseconds const step, mir::GLibMainLoop& ml)
+    template<typename MainLoop>
+    void advance_by(std::chrono::milliseconds const step, MainLoop& ml)
     {
         mtd::AdvanceableClock::advance_by(step);
         ml.reprocess_all_sources();
@@ -945,51 +952,53 @@ private:
 
 struct UnblockMainLoop : mt::AutoUnblockThread
 {
-    UnblockMainLoop(mir::GLibMainLoop& loop)
+    UnblockMainLoop(mir::MainLoop& loop)
         : mt::AutoUnblockThread([&loop]() {loop.stop();},
                                 [&loop]() {loop.run();})
     {}
 };
 
-struct GLibMainLoopAlarmTest : ::testing::Test
+template<typename MainLoop>
+struct MainLoopAlarmTest : ::testing::Test
 {
     std::shared_ptr<AdvanceableClock> clock = std::make_shared<AdvanceableClock>();
-    mir::GLibMainLoop ml{clock};
+    MainLoop ml{clock};
     std::chrono::milliseconds delay{50};
-    std::function<void()> const destroy_glib_main_loop{[this]{ ml.~GLibMainLoop(); }};
+    std::function<void()> const destroy_main_loop{[this]{ ml.~MainLoop(); }};
 };
-
 }
 
-TEST_F(GLibMainLoopAlarmTest, main_loop_runs_until_stop_called)
+TYPED_TEST_CASE(MainLoopAlarmTest, MainLoops);
+
+TYPED_TEST(MainLoopAlarmTest, main_loop_runs_until_stop_called)
 {
     auto mainloop_started = std::make_shared<mt::Signal>();
 
-    auto fire_on_mainloop_start = ml.create_alarm([mainloop_started]()
+    auto fire_on_mainloop_start = this->ml.create_alarm([mainloop_started]()
     {
         mainloop_started->raise();
     });
     fire_on_mainloop_start->reschedule_in(std::chrono::milliseconds{0});
 
-    UnblockMainLoop unblocker(ml);
+    UnblockMainLoop unblocker(this->ml);
 
     ASSERT_TRUE(mainloop_started->wait_for(std::chrono::milliseconds{100}));
 
     auto timer_fired = std::make_shared<mt::Signal>();
-    auto alarm = ml.create_alarm([timer_fired]
+    auto alarm = this->ml.create_alarm([timer_fired]
     {
         timer_fired->raise();
     });
     alarm->reschedule_in(std::chrono::milliseconds{10});
 
-    clock->advance_by(std::chrono::milliseconds{10}, ml);
+    this->clock->advance_by(std::chrono::milliseconds{10}, this->ml);
     EXPECT_TRUE(timer_fired->wait_for(std::chrono::milliseconds{500}));
 
-    ml.stop();
+    this->ml.stop();
 
     // Main loop should be stopped now
     timer_fired = std::make_shared<mt::Signal>();
-    auto should_not_fire = ml.create_alarm([timer_fired]()
+    auto should_not_fire = this->ml.create_alarm([timer_fired]()
     {
         timer_fired->raise();
     });
@@ -998,30 +1007,30 @@ TEST_F(GLibMainLoopAlarmTest, main_loop_runs_until_stop_called)
     EXPECT_FALSE(timer_fired->wait_for(std::chrono::milliseconds{10}));
 }
 
-TEST_F(GLibMainLoopAlarmTest, alarm_starts_in_pending_state)
+TYPED_TEST(MainLoopAlarmTest, alarm_starts_in_pending_state)
 {
-    auto alarm = ml.create_alarm([]{});
+    auto alarm = this->ml.create_alarm([]{});
 
-    UnblockMainLoop unblocker(ml);
+    UnblockMainLoop unblocker(this->ml);
 
     EXPECT_EQ(mir::time::Alarm::cancelled, alarm->state());
 }
 
-TEST_F(GLibMainLoopAlarmTest, alarm_fires_with_correct_delay)
+TYPED_TEST(MainLoopAlarmTest, alarm_fires_with_correct_delay)
 {
-    UnblockMainLoop unblocker(ml);
+    UnblockMainLoop unblocker(this->ml);
 
-    auto alarm = ml.create_alarm([]{});
-    alarm->reschedule_in(delay);
+    auto alarm = this->ml.create_alarm([]{});
+    alarm->reschedule_in(this->delay);
 
-    clock->advance_by(delay - std::chrono::milliseconds{1}, ml);
+    this->clock->advance_by(this->delay - std::chrono::milliseconds{1}, this->ml);
     EXPECT_EQ(mir::time::Alarm::pending, alarm->state());
 
-    clock->advance_by(delay, ml);
+    this->clock->advance_by(this->delay, this->ml);
     EXPECT_EQ(mir::time::Alarm::triggered, alarm->state());
 }
 
-TEST_F(GLibMainLoopAlarmTest, multiple_alarms_fire)
+TYPED_TEST(MainLoopAlarmTest, multiple_alarms_fire)
 {
     using namespace testing;
 
@@ -1031,111 +1040,111 @@ TEST_F(GLibMainLoopAlarmTest, multiple_alarms_fire)
 
     for (auto& alarm : alarms)
     {
-        alarm = ml.create_alarm([&call_count]{ ++call_count;});
-        alarm->reschedule_in(delay);
+        alarm = this->ml.create_alarm([&call_count]{ ++call_count;});
+        alarm->reschedule_in(this->delay);
     }
 
-    UnblockMainLoop unblocker(ml);
-    clock->advance_by(delay, ml);
+    UnblockMainLoop unblocker(this->ml);
+    this->clock->advance_by(this->delay, this->ml);
 
-    call_count.wait_for(delay, alarm_count);
+    call_count.wait_for(this->delay, alarm_count);
     EXPECT_THAT(call_count, Eq(alarm_count));
 
     for (auto const& alarm : alarms)
         EXPECT_EQ(mir::time::Alarm::triggered, alarm->state());
 }
 
-TEST_F(GLibMainLoopAlarmTest, alarm_changes_to_triggered_state)
+TYPED_TEST(MainLoopAlarmTest, alarm_changes_to_triggered_state)
 {
     auto alarm_fired = std::make_shared<mt::Signal>();
-    auto alarm = ml.create_alarm([alarm_fired]()
+    auto alarm = this->ml.create_alarm([alarm_fired]()
     {
         alarm_fired->raise();
     });
     alarm->reschedule_in(std::chrono::milliseconds{5});
 
-    UnblockMainLoop unblocker(ml);
+    UnblockMainLoop unblocker(this->ml);
 
-    clock->advance_by(delay, ml);
+    this->clock->advance_by(this->delay, this->ml);
     ASSERT_TRUE(alarm_fired->wait_for(std::chrono::milliseconds{100}));
 
     EXPECT_EQ(mir::time::Alarm::triggered, alarm->state());
 }
 
-TEST_F(GLibMainLoopAlarmTest, cancelled_alarm_doesnt_fire)
+TYPED_TEST(MainLoopAlarmTest, cancelled_alarm_doesnt_fire)
 {
-    UnblockMainLoop unblocker(ml);
-    auto alarm = ml.create_alarm([]{ FAIL() << "Alarm handler of canceld alarm called"; });
+    UnblockMainLoop unblocker(this->ml);
+    auto alarm = this->ml.create_alarm([]{ FAIL() << "Alarm handler of canceld alarm called"; });
     alarm->reschedule_in(std::chrono::milliseconds{100});
 
     EXPECT_TRUE(alarm->cancel());
 
     EXPECT_EQ(mir::time::Alarm::cancelled, alarm->state());
 
-    clock->advance_by(std::chrono::milliseconds{100}, ml);
+    this->clock->advance_by(std::chrono::milliseconds{100}, this->ml);
 
     EXPECT_EQ(mir::time::Alarm::cancelled, alarm->state());
 }
 
-TEST_F(GLibMainLoopAlarmTest, destroyed_alarm_doesnt_fire)
+TYPED_TEST(MainLoopAlarmTest, destroyed_alarm_doesnt_fire)
 {
-    auto alarm = ml.create_alarm([]{ FAIL() << "Alarm handler of destroyed alarm called"; });
+    auto alarm = this->ml.create_alarm([]{ FAIL() << "Alarm handler of destroyed alarm called"; });
     alarm->reschedule_in(std::chrono::milliseconds{200});
 
-    UnblockMainLoop unblocker(ml);
+    UnblockMainLoop unblocker(this->ml);
 
     alarm.reset(nullptr);
-    clock->advance_by(std::chrono::milliseconds{200}, ml);
+    this->clock->advance_by(std::chrono::milliseconds{200}, this->ml);
 }
 
-TEST_F(GLibMainLoopAlarmTest, rescheduled_alarm_fires_again)
+TYPED_TEST(MainLoopAlarmTest, rescheduled_alarm_fires_again)
 {
     std::atomic<int> call_count{0};
 
-    auto alarm = ml.create_alarm([&call_count]()
+    auto alarm = this->ml.create_alarm([&call_count]()
     {
         if (call_count++ > 1)
             FAIL() << "Alarm called too many times";
     });
     alarm->reschedule_in(std::chrono::milliseconds{0});
 
-    UnblockMainLoop unblocker(ml);
+    UnblockMainLoop unblocker(this->ml);
 
-    clock->advance_by(std::chrono::milliseconds{0}, ml);
+    this->clock->advance_by(std::chrono::milliseconds{0}, this->ml);
     ASSERT_EQ(mir::time::Alarm::triggered, alarm->state());
 
     alarm->reschedule_in(std::chrono::milliseconds{100});
     EXPECT_EQ(mir::time::Alarm::pending, alarm->state());
 
-    clock->advance_by(std::chrono::milliseconds{100}, ml);
+    this->clock->advance_by(std::chrono::milliseconds{100}, this->ml);
     EXPECT_EQ(mir::time::Alarm::triggered, alarm->state());
 }
 
-TEST_F(GLibMainLoopAlarmTest, rescheduled_alarm_cancels_previous_scheduling)
+TYPED_TEST(MainLoopAlarmTest, rescheduled_alarm_cancels_previous_scheduling)
 {
     std::atomic<int> call_count{0};
 
-    auto alarm = ml.create_alarm([&call_count]()
+    auto alarm = this->ml.create_alarm([&call_count]()
     {
         call_count++;
     });
     alarm->reschedule_in(std::chrono::milliseconds{100});
 
-    UnblockMainLoop unblocker(ml);
-    clock->advance_by(std::chrono::milliseconds{90}, ml);
+    UnblockMainLoop unblocker(this->ml);
+    this->clock->advance_by(std::chrono::milliseconds{90}, this->ml);
 
     EXPECT_EQ(mir::time::Alarm::pending, alarm->state());
     EXPECT_EQ(0, call_count);
     EXPECT_TRUE(alarm->reschedule_in(std::chrono::milliseconds{100}));
     EXPECT_EQ(mir::time::Alarm::pending, alarm->state());
 
-    clock->advance_by(std::chrono::milliseconds{110}, ml);
+    this->clock->advance_by(std::chrono::milliseconds{110}, this->ml);
 
     EXPECT_EQ(mir::time::Alarm::triggered, alarm->state());
     EXPECT_EQ(1, call_count);
 }
 
-TEST_F(GLibMainLoopAlarmTest, alarm_callback_preserves_lock_ordering)
+TYPED_TEST(MainLoopAlarmTest, alarm_callback_preserves_lock_ordering)
 {
     using namespace testing;
 
@@ -1147,30 +1156,30 @@ TEST_F(GLibMainLoopAlarmTest, alarm_callback_preserves_lock_ordering)
         EXPECT_CALL(*handler, unlock());
     }
 
-    auto alarm = ml.create_alarm(std::move(handler));
+    auto alarm = this->ml.create_alarm(std::move(handler));
 
-    UnblockMainLoop unblocker(ml);
+    UnblockMainLoop unblocker(this->ml);
     alarm->reschedule_in(std::chrono::milliseconds{10});
-    clock->advance_by(std::chrono::milliseconds{11}, ml);
+    this->clock->advance_by(std::chrono::milliseconds{11}, this->ml);
 }
 
-TEST_F(GLibMainLoopAlarmTest, alarm_fires_at_correct_time_point)
+TYPED_TEST(MainLoopAlarmTest, alarm_fires_at_correct_time_point)
 {
-    mir::time::Timestamp real_soon = clock->now() + std::chrono::milliseconds{120};
+    mir::time::Timestamp real_soon = this->clock->now() + std::chrono::milliseconds{120};
 
-    auto alarm = ml.create_alarm([]{});
+    auto alarm = this->ml.create_alarm([]{});
     alarm->reschedule_for(real_soon);
 
-    UnblockMainLoop unblocker(ml);
+    UnblockMainLoop unblocker(this->ml);
 
-    clock->advance_by(std::chrono::milliseconds{119}, ml);
+    this->clock->advance_by(std::chrono::milliseconds{119}, this->ml);
     EXPECT_EQ(mir::time::Alarm::pending, alarm->state());
 
-    clock->advance_by(std::chrono::milliseconds{1}, ml);
+    this->clock->advance_by(std::chrono::milliseconds{1}, this->ml);
     EXPECT_EQ(mir::time::Alarm::triggered, alarm->state());
 }
 
-TEST_F(GLibMainLoopAlarmTest, propagates_exception_from_alarm)
+TYPED_TEST(MainLoopAlarmTest, propagates_exception_from_alarm)
 {
     // Execute in forked process to work around
     // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=61643
@@ -1178,41 +1187,41 @@ TEST_F(GLibMainLoopAlarmTest, propagates_exception_from_alarm)
     execute_in_forked_process(this,
         [&]
         {
-            auto alarm = ml.create_alarm([] { throw std::runtime_error("alarm error"); });
+            auto alarm = this->ml.create_alarm([] { throw std::runtime_error("alarm error"); });
             alarm->reschedule_in(std::chrono::milliseconds{0});
 
-            EXPECT_THROW({ ml.run(); }, std::runtime_error);
+            EXPECT_THROW({ this->ml.run(); }, std::runtime_error);
         },
         // Since we terminate the forked process with an exit() call, objects on
         // the stack are not destroyed. We need to manually destroy the
-        // GLibMainLoop object to avoid fd leaks.
-        destroy_glib_main_loop);
+        // main loop object to avoid fd leaks.
+        this->destroy_main_loop);
 }
 
-TEST_F(GLibMainLoopAlarmTest, can_reschedule_alarm_from_within_alarm_callback)
+TYPED_TEST(MainLoopAlarmTest, can_reschedule_alarm_from_within_alarm_callback)
 {
     using namespace testing;
 
     int num_triggers = 0;
     int const expected_triggers = 3;
 
-    std::shared_ptr<mir::time::Alarm> alarm = ml.create_alarm(
+    std::shared_ptr<mir::time::Alarm> alarm = this->ml.create_alarm(
         [&]
         {
             if (++num_triggers == expected_triggers)
-                ml.stop();
+                this->ml.stop();
             else
                 alarm->reschedule_in(std::chrono::milliseconds{0});
         });
 
     alarm->reschedule_in(std::chrono::milliseconds{0});
 
-    ml.run();
+    this->ml.run();
 
     EXPECT_THAT(num_triggers, Eq(expected_triggers));
 }
 
-TEST_F(GLibMainLoopAlarmTest, rescheduling_alarm_from_within_alarm_callback_doesnt_deadlock_with_external_reschedule)
+TYPED_TEST(MainLoopAlarmTest, rescheduling_alarm_from_within_alarm_callback_doesnt_deadlock_with_external_reschedule)
 {
     using namespace testing;
     using namespace std::literals::chrono_literals;
@@ -1220,7 +1229,7 @@ TEST_F(GLibMainLoopAlarmTest, rescheduling_alarm_from_within_alarm_callback_does
     mt::Signal in_alarm;
     mt::Signal alarm_rescheduled;
 
-    std::shared_ptr<mir::time::Alarm> alarm = ml.create_alarm(
+    std::shared_ptr<mir::time::Alarm> alarm = this->ml.create_alarm(
         [&]
         {
             // Ensure that the external thread reschedules us while we're
@@ -1230,7 +1239,7 @@ TEST_F(GLibMainLoopAlarmTest, rescheduling_alarm_from_within_alarm_callback_does
 
             alarm->reschedule_in(0ms);
 
-            ml.stop();
+            this->ml.stop();
         });
 
     alarm->reschedule_in(0ms);
@@ -1243,10 +1252,10 @@ TEST_F(GLibMainLoopAlarmTest, rescheduling_alarm_from_within_alarm_callback_does
             alarm_rescheduled.raise();
         }};
 
-    ml.run();
+    this->ml.run();
 }
 
-TEST_F(GLibMainLoopAlarmTest, cancel_blocks_until_definitely_cancelled)
+TYPED_TEST(MainLoopAlarmTest, cancel_blocks_until_definitely_cancelled)
 {
     using namespace testing;
     using namespace std::literals::chrono_literals;
@@ -1254,7 +1263,7 @@ TEST_F(GLibMainLoopAlarmTest, cancel_blocks_until_definitely_cancelled)
     auto waiting_in_lock = std::make_shared<mt::Barrier>(2);
     auto has_been_called = std::make_shared<mt::Signal>();
 
-    std::shared_ptr<mir::time::Alarm> alarm = ml.create_alarm(
+    std::shared_ptr<mir::time::Alarm> alarm = this->ml.create_alarm(
         [waiting_in_lock, has_been_called]()
         {
             waiting_in_lock->ready();
@@ -1270,21 +1279,21 @@ TEST_F(GLibMainLoopAlarmTest, cancel_blocks_until_definitely_cancelled)
             waiting_in_lock->ready();
             alarm->cancel();
             EXPECT_TRUE(has_been_called->raised());
-            ml.stop();
+            this->ml.stop();
         }
     };
 
-    ml.run();
+    this->ml.run();
 }
 
-TEST_F(GLibMainLoopAlarmTest, can_cancel_from_callback)
+TYPED_TEST(MainLoopAlarmTest, can_cancel_from_callback)
 {
     using namespace testing;
     using namespace std::literals::chrono_literals;
 
     mir::time::Alarm* raw_alarm;
     auto cancel_didnt_deadlock = std::make_shared<mt::Signal>();
-    auto alarm = ml.create_alarm(
+    auto alarm = this->ml.create_alarm(
         [&raw_alarm, cancel_didnt_deadlock]()
         {
             raw_alarm->cancel();
@@ -1293,7 +1302,7 @@ TEST_F(GLibMainLoopAlarmTest, can_cancel_from_callback)
 
     raw_alarm = alarm.get();
 
-    UnblockMainLoop unblocker{ml};
+    UnblockMainLoop unblocker{this->ml};
 
     alarm->reschedule_in(0ms);
 
@@ -1306,14 +1315,14 @@ TEST_F(GLibMainLoopAlarmTest, can_cancel_from_callback)
     }
 }
 
-TEST_F(GLibMainLoopAlarmTest, can_destroy_alarm_from_callback)
+TYPED_TEST(MainLoopAlarmTest, can_destroy_alarm_from_callback)
 {
     using namespace testing;
     using namespace std::literals::chrono_literals;
 
     mir::time::Alarm* raw_alarm;
     auto cancel_didnt_deadlock = std::make_shared<mt::Signal>();
-    auto alarm = ml.create_alarm(
+    auto alarm = this->ml.create_alarm(
         [&raw_alarm, cancel_didnt_deadlock]()
         {
             delete raw_alarm;
@@ -1323,7 +1332,7 @@ TEST_F(GLibMainLoopAlarmTest, can_destroy_alarm_from_callback)
     alarm->reschedule_in(0ms);
     raw_alarm = alarm.release();
 
-    UnblockMainLoop unblocker{ml};
+    UnblockMainLoop unblocker{this->ml};
 
 
     EXPECT_TRUE(cancel_didnt_deadlock->wait_for(10s));
@@ -1335,15 +1344,15 @@ TEST_F(GLibMainLoopAlarmTest, can_destroy_alarm_from_callback)
     }
 }
 
-TEST_F(GLibMainLoopAlarmTest, cancelling_a_triggered_alarm_has_no_effect)
+TYPED_TEST(MainLoopAlarmTest, cancelling_a_triggered_alarm_has_no_effect)
 {
     using namespace testing;
     using namespace std::literals::chrono_literals;
 
-    UnblockMainLoop unblocker{ml};
+    UnblockMainLoop unblocker{this->ml};
 
     auto alarm_triggered = std::make_shared<mt::Signal>();
-    auto alarm = ml.create_alarm(
+    auto alarm = this->ml.create_alarm(
         [alarm_triggered]()
         {
             alarm_triggered->raise();
@@ -1358,15 +1367,15 @@ TEST_F(GLibMainLoopAlarmTest, cancelling_a_triggered_alarm_has_no_effect)
     EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::State::triggered));
 }
 
-TEST_F(GLibMainLoopAlarmTest, reschedule_returns_true_when_it_resets_a_previous_schedule)
+TYPED_TEST(MainLoopAlarmTest, reschedule_returns_true_when_it_resets_a_previous_schedule)
 {
     using namespace testing;
     using namespace std::literals::chrono_literals;
 
-    UnblockMainLoop unblocker{ml};
+    UnblockMainLoop unblocker{this->ml};
 
     auto alarm_triggered = std::make_shared<mt::Signal>();
-    auto alarm = ml.create_alarm([](){});
+    auto alarm = this->ml.create_alarm([](){});
 
     ASSERT_FALSE(alarm_triggered->raised());
     alarm->reschedule_in(10min);
@@ -1374,15 +1383,15 @@ TEST_F(GLibMainLoopAlarmTest, reschedule_returns_true_when_it_resets_a_previous_
     EXPECT_TRUE(alarm->reschedule_in(5s));
 }
 
-TEST_F(GLibMainLoopAlarmTest, reschedule_returns_false_when_it_didnt_reset_a_previous_schedule)
+TYPED_TEST(MainLoopAlarmTest, reschedule_returns_false_when_it_didnt_reset_a_previous_schedule)
 {
     using namespace testing;
     using namespace std::literals::chrono_literals;
 
-    UnblockMainLoop unblocker{ml};
+    UnblockMainLoop unblocker{this->ml};
 
     auto alarm_triggered = std::make_shared<mt::Signal>();
-    auto alarm = ml.create_alarm(
+    auto alarm = this->ml.create_alarm(
         [alarm_triggered]()
         {
             alarm_triggered->raise();
@@ -1396,15 +1405,15 @@ TEST_F(GLibMainLoopAlarmTest, reschedule_returns_false_when_it_didnt_reset_a_pre
 }
 
 // More targeted regression test for LP: #1381925
-TEST_F(GLibMainLoopTest, stress_emits_alarm_notification_with_zero_timeout)
+TYPED_TEST(MainLoopTest, stress_emits_alarm_notification_with_zero_timeout)
 {
-    UnblockMainLoop unblocker{ml};
+    UnblockMainLoop unblocker{this->ml};
 
     for (int i = 0; i < 1000; ++i)
     {
         mt::Signal notification_called;
 
-        auto alarm = ml.create_alarm([&]{ notification_called.raise(); });
+        auto alarm = this->ml.create_alarm([&]{ notification_called.raise(); });
         alarm->reschedule_in(std::chrono::milliseconds{0});
 
         EXPECT_TRUE(notification_called.wait_for(std::chrono::seconds{15}));
@@ -1412,18 +1421,29 @@ TEST_F(GLibMainLoopTest, stress_emits_alarm_notification_with_zero_timeout)
 }
 
 // This test recreates a scenario we get in our integration and acceptance test
-// runs, and which creates problems for the default glib signal source. The
+// runs, and which creates problems for the default glib signal source (and
+// for any signal handling that isn't per-loop). The
 // scenario involves creating, running (with signal handling) and destroying
 // the main loop in the main process and then trying to do the same in a forked
 // process. This happens, for example, when we run some tests with an in-process
 // server setup followed by a test using an out-of-process server setup.
-TEST(GLibMainLoopForkTest, handles_signals_when_created_in_forked_process)
+namespace
+{
+template<typename MainLoop>
+struct MainLoopForkTest : ::testing::Test
+{
+};
+}
+
+TYPED_TEST_CASE(MainLoopForkTest, MainLoops);
+
+TYPED_TEST(MainLoopForkTest, handles_signals_when_created_in_forked_process)
 {
     auto const check_mainloop_signal_handling =
         []
         {
             int const signum = SIGUSR1;
-            mir::GLibMainLoop ml{std::make_shared<mir::time::SteadyClock>()};
+            TypeParam ml{std::make_shared<mir::time::SteadyClock>()};
             ml.register_signal_handler(
                 {signum},
                 [&](int)
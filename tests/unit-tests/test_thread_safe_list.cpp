@@ -22,6 +22,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <atomic>
+#include <thread>
+
 namespace
 {
 
@@ -157,3 +160,115 @@ TEST_F(ThreadSafeListTest, clears_all_elements)
 
     EXPECT_THAT(elements_seen, Eq(0));
 }
+
+TEST_F(ThreadSafeListTest, removing_element_waits_for_it_to_finish_being_used_in_different_thread)
+{
+    using namespace testing;
+
+    list.add(element1);
+
+    mir::test::Signal element_in_use;
+    std::atomic<bool> finished_using{false};
+
+    std::thread t{
+        [&]
+        {
+            list.for_each(
+                [&] (Element const&)
+                {
+                    element_in_use.raise();
+                    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+                    finished_using = true;
+                });
+        }};
+
+    element_in_use.wait_for(std::chrono::seconds{3});
+    list.remove(element1);
+
+    EXPECT_TRUE(finished_using);
+
+    t.join();
+}
+
+TEST_F(ThreadSafeListTest, all_removals_waiting_for_a_reader_resume_when_it_finishes)
+{
+    using namespace testing;
+
+    list.add(element1);
+    list.add(element2);
+
+    mir::test::Signal elements_in_use;
+    std::atomic<bool> finished_using{false};
+
+    std::thread reader{
+        [&]
+        {
+            list.for_each(
+                [&] (Element const& outer)
+                {
+                    if (outer != element1) return;
+
+                    list.for_each(
+                        [&] (Element const& inner)
+                        {
+                            if (inner != element2) return;
+
+                            elements_in_use.raise();
+                            std::this_thread::sleep_for(std::chrono::milliseconds{50});
+                            finished_using = true;
+                        });
+                });
+        }};
+
+    elements_in_use.wait_for(std::chrono::seconds{3});
+
+    std::atomic<bool> finished_first_before_removal{false};
+    std::atomic<bool> finished_second_before_removal{false};
+    std::thread remover1{[&] { list.remove(element1); finished_first_before_removal = finished_using.load(); }};
+    std::thread remover2{[&] { list.remove(element2); finished_second_before_removal = finished_using.load(); }};
+
+    remover1.join();
+    remover2.join();
+    reader.join();
+
+    EXPECT_TRUE(finished_first_before_removal);
+    EXPECT_TRUE(finished_second_before_removal);
+}
+
+TEST_F(ThreadSafeListTest, element_removed_while_in_use_by_same_thread_remains_valid)
+{
+    using namespace testing;
+
+    list.add(element1);
+    auto const uses_before = element1.use_count();
+
+    list.for_each(
+        [&] (Element const& element)
+        {
+            list.remove(element);
+            EXPECT_THAT(element, Eq(element1));
+            EXPECT_THAT(element1.use_count(), Eq(uses_before));
+        });
+
+    EXPECT_THAT(element1.use_count(), Eq(uses_before - 1));
+}
+
+TEST_F(ThreadSafeListTest, removed_slot_is_reused)
+{
+    using namespace testing;
+
+    std::vector<Element> elements_seen;
+
+    list.add(element1);
+    list.add(element2);
+    list.remove(element1);
+    list.add(element1);
+
+    list.for_each(
+        [&] (Element const& element)
+        {
+            elements_seen.push_back(element);
+        });
+
+    EXPECT_THAT(elements_seen, ElementsAre(element1, element2));
+}
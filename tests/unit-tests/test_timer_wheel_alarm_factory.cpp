@@ -0,0 +1,364 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/time/timer_wheel_alarm_factory.h"
+#include "mir/time/steady_clock.h"
+
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/mock_lockable_callback.h"
+#include "mir/test/fd_utils.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+namespace md = mir::dispatch;
+using namespace std::literals::chrono_literals;
+using namespace testing;
+
+namespace
+{
+struct TimerWheelAlarmFactory : Test
+{
+    std::shared_ptr<mtd::AdvanceableClock> const clock = std::make_shared<mtd::AdvanceableClock>();
+    mir::time::TimerWheelAlarmFactory factory{clock};
+
+    void advance_by(mir::time::Duration step)
+    {
+        clock->advance_by(step);
+        factory.dispatch(md::FdEvent::readable);
+    }
+};
+}
+
+TEST_F(TimerWheelAlarmFactory, alarm_starts_in_cancelled_state)
+{
+    auto const alarm = factory.create_alarm([]{});
+
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::cancelled));
+    EXPECT_THAT(factory.pending_alarms(), Eq(0u));
+}
+
+TEST_F(TimerWheelAlarmFactory, alarm_fires_after_delay)
+{
+    int calls{0};
+    auto const alarm = factory.create_alarm([&calls]{ ++calls; });
+
+    alarm->reschedule_in(50ms);
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::pending));
+
+    advance_by(49ms);
+    EXPECT_THAT(calls, Eq(0));
+
+    advance_by(1ms);
+    EXPECT_THAT(calls, Eq(1));
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::triggered));
+    EXPECT_THAT(factory.pending_alarms(), Eq(0u));
+}
+
+TEST_F(TimerWheelAlarmFactory, alarm_fires_at_time_point)
+{
+    int calls{0};
+    auto const alarm = factory.create_alarm([&calls]{ ++calls; });
+
+    alarm->reschedule_for(clock->now() + 20ms);
+
+    advance_by(19ms);
+    EXPECT_THAT(calls, Eq(0));
+
+    advance_by(1ms);
+    EXPECT_THAT(calls, Eq(1));
+}
+
+TEST_F(TimerWheelAlarmFactory, alarm_in_the_past_fires_on_next_dispatch)
+{
+    int calls{0};
+    auto const alarm = factory.create_alarm([&calls]{ ++calls; });
+
+    alarm->reschedule_for(clock->now() - 1s);
+
+    factory.dispatch(md::FdEvent::readable);
+    EXPECT_THAT(calls, Eq(1));
+}
+
+TEST_F(TimerWheelAlarmFactory, past_due_alarm_fires_on_next_dispatch_after_wheel_has_advanced)
+{
+    int calls{0};
+    auto const alarm = factory.create_alarm([&calls]{ ++calls; });
+
+    // Processes the ticks up to now, so "now" is no longer in the future of the wheel
+    advance_by(10ms);
+
+    alarm->reschedule_for(clock->now() - 5ms);
+
+    EXPECT_TRUE(mt::fd_becomes_readable(factory.watch_fd(), 10s));
+    factory.dispatch(md::FdEvent::readable);
+    EXPECT_THAT(calls, Eq(1));
+    EXPECT_THAT(factory.pending_alarms(), Eq(0u));
+}
+
+TEST_F(TimerWheelAlarmFactory, watch_fd_becomes_readable_when_alarm_is_due)
+{
+    auto const alarm = factory.create_alarm([]{});
+
+    EXPECT_FALSE(mt::fd_is_readable(factory.watch_fd()));
+
+    alarm->reschedule_in(0ms);
+
+    // The AdvanceableClock never asks us to wait
+    EXPECT_TRUE(mt::fd_becomes_readable(factory.watch_fd(), 10s));
+}
+
+TEST_F(TimerWheelAlarmFactory, cancelled_alarm_doesnt_fire)
+{
+    int calls{0};
+    auto const alarm = factory.create_alarm([&calls]{ ++calls; });
+
+    alarm->reschedule_in(10ms);
+    EXPECT_TRUE(alarm->cancel());
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::cancelled));
+
+    advance_by(20ms);
+    EXPECT_THAT(calls, Eq(0));
+}
+
+TEST_F(TimerWheelAlarmFactory, destroyed_alarm_doesnt_fire)
+{
+    int calls{0};
+    auto alarm = factory.create_alarm([&calls]{ ++calls; });
+
+    alarm->reschedule_in(10ms);
+    alarm.reset();
+
+    EXPECT_THAT(factory.pending_alarms(), Eq(0u));
+
+    advance_by(20ms);
+    EXPECT_THAT(calls, Eq(0));
+}
+
+TEST_F(TimerWheelAlarmFactory, rescheduled_alarm_fires_again)
+{
+    int calls{0};
+    auto const alarm = factory.create_alarm([&calls]{ ++calls; });
+
+    alarm->reschedule_in(10ms);
+    advance_by(10ms);
+    EXPECT_THAT(calls, Eq(1));
+
+    alarm->reschedule_in(10ms);
+    advance_by(10ms);
+    EXPECT_THAT(calls, Eq(2));
+}
+
+TEST_F(TimerWheelAlarmFactory, rescheduled_alarm_cancels_previous_scheduling)
+{
+    int calls{0};
+    auto const alarm = factory.create_alarm([&calls]{ ++calls; });
+
+    alarm->reschedule_in(10ms);
+    EXPECT_TRUE(alarm->reschedule_in(100ms));
+
+    advance_by(50ms);
+    EXPECT_THAT(calls, Eq(0));
+
+    advance_by(50ms);
+    EXPECT_THAT(calls, Eq(1));
+}
+
+TEST_F(TimerWheelAlarmFactory, reschedule_returns_false_when_it_didnt_reset_a_previous_schedule)
+{
+    auto const alarm = factory.create_alarm([]{});
+
+    EXPECT_FALSE(alarm->reschedule_in(10ms));
+
+    advance_by(10ms);
+    EXPECT_FALSE(alarm->reschedule_in(10ms));
+}
+
+TEST_F(TimerWheelAlarmFactory, cancelling_a_triggered_alarm_has_no_effect)
+{
+    auto const alarm = factory.create_alarm([]{});
+
+    alarm->reschedule_in(0ms);
+    advance_by(1ms);
+
+    EXPECT_FALSE(alarm->cancel());
+    EXPECT_THAT(alarm->state(), Eq(mir::time::Alarm::triggered));
+}
+
+TEST_F(TimerWheelAlarmFactory, can_reschedule_alarm_from_within_alarm_callback)
+{
+    int calls{0};
+    mir::time::Alarm* raw_alarm{nullptr};
+    auto const alarm = factory.create_alarm(
+        [&]
+        {
+            if (++calls < 3)
+                raw_alarm->reschedule_in(10ms);
+        });
+    raw_alarm = alarm.get();
+
+    alarm->reschedule_in(10ms);
+    for (int i = 0; i != 5; ++i)
+        advance_by(10ms);
+
+    EXPECT_THAT(calls, Eq(3));
+}
+
+TEST_F(TimerWheelAlarmFactory, can_destroy_alarm_from_callback)
+{
+    bool called{false};
+    mir::time::Alarm* raw_alarm{nullptr};
+    auto alarm = factory.create_alarm(
+        [&]
+        {
+            called = true;
+            delete raw_alarm;
+        });
+
+    alarm->reschedule_in(0ms);
+    raw_alarm = alarm.release();
+
+    advance_by(1ms);
+    EXPECT_TRUE(called);
+}
+
+TEST_F(TimerWheelAlarmFactory, alarm_callback_preserves_lock_ordering)
+{
+    auto handler = std::make_unique<mtd::MockLockableCallback>();
+    {
+        InSequence s;
+        EXPECT_CALL(*handler, lock());
+        EXPECT_CALL(*handler, functor());
+        EXPECT_CALL(*handler, unlock());
+    }
+
+    auto const alarm = factory.create_alarm(std::move(handler));
+
+    alarm->reschedule_in(5ms);
+    advance_by(5ms);
+}
+
+TEST_F(TimerWheelAlarmFactory, alarms_fire_in_order_across_wheel_levels)
+{
+    std::vector<int> fired;
+    std::vector<std::unique_ptr<mir::time::Alarm>> alarms;
+
+    // Spread across the first three levels of the wheel
+    std::vector<std::chrono::milliseconds> const delays{70000ms, 3ms, 300ms, 255ms, 256ms, 65536ms, 1ms};
+
+    for (auto i = 0u; i != delays.size(); ++i)
+    {
+        alarms.push_back(factory.create_alarm([&fired, i]{ fired.push_back(i); }));
+        alarms.back()->reschedule_in(delays[i]);
+    }
+
+    EXPECT_THAT(factory.pending_alarms(), Eq(delays.size()));
+
+    for (auto elapsed = 0ms; elapsed <= 70000ms; elapsed += 1ms)
+        advance_by(1ms);
+
+    EXPECT_THAT(fired, ElementsAre(6, 1, 3, 4, 2, 5, 0));
+    EXPECT_THAT(factory.pending_alarms(), Eq(0u));
+}
+
+TEST_F(TimerWheelAlarmFactory, alarms_fire_after_large_jump_in_time)
+{
+    int calls{0};
+    std::vector<std::unique_ptr<mir::time::Alarm>> alarms;
+
+    for (auto delay : {1ms, 1000ms, 100000ms, 10000000ms})
+    {
+        alarms.push_back(factory.create_alarm([&calls]{ ++calls; }));
+        alarms.back()->reschedule_in(delay);
+    }
+
+    advance_by(10000000ms);
+    EXPECT_THAT(calls, Eq(4));
+}
+
+TEST_F(TimerWheelAlarmFactory, alarm_beyond_wheel_range_still_fires)
+{
+    int calls{0};
+    auto const alarm = factory.create_alarm([&calls]{ ++calls; });
+
+    // Over 2^32 ticks at the default 1ms resolution
+    std::chrono::hours const delay{24 * 60};
+    alarm->reschedule_in(delay);
+
+    advance_by(delay - 1ms);
+    EXPECT_THAT(calls, Eq(0));
+
+    advance_by(1ms);
+    EXPECT_THAT(calls, Eq(1));
+}
+
+TEST_F(TimerWheelAlarmFactory, handles_many_alarms)
+{
+    int const alarm_count{10000};
+    int calls{0};
+    std::vector<std::unique_ptr<mir::time::Alarm>> alarms;
+
+    for (int i = 0; i != alarm_count; ++i)
+    {
+        alarms.push_back(factory.create_alarm([&calls]{ ++calls; }));
+        alarms.back()->reschedule_in(std::chrono::milliseconds{i});
+    }
+
+    // Cancel every other one
+    for (int i = 0; i < alarm_count; i += 2)
+        alarms[i]->cancel();
+
+    EXPECT_THAT(factory.pending_alarms(), Eq(alarm_count / 2u));
+
+    advance_by(std::chrono::milliseconds{alarm_count});
+    EXPECT_THAT(calls, Eq(alarm_count / 2));
+}
+
+TEST_F(TimerWheelAlarmFactory, propagates_exception_from_alarm_after_running_others)
+{
+    bool other_called{false};
+    auto const throwing = factory.create_alarm([]{ throw std::runtime_error{"Boom"}; });
+    auto const other = factory.create_alarm([&other_called]{ other_called = true; });
+
+    throwing->reschedule_in(1ms);
+    other->reschedule_in(1ms);
+
+    clock->advance_by(1ms);
+    EXPECT_THROW(factory.dispatch(md::FdEvent::readable), std::runtime_error);
+    EXPECT_TRUE(other_called);
+}
+
+TEST(TimerWheelAlarmFactoryRealClock, alarm_fires_from_watch_fd)
+{
+    mir::time::TimerWheelAlarmFactory factory{std::make_shared<mir::time::SteadyClock>()};
+
+    bool called{false};
+    auto const alarm = factory.create_alarm([&called]{ called = true; });
+    alarm->reschedule_in(5ms);
+
+    auto const deadline = std::chrono::steady_clock::now() + 10s;
+    while (!called && std::chrono::steady_clock::now() < deadline)
+    {
+        if (mt::fd_becomes_readable(factory.watch_fd(), 1s))
+            factory.dispatch(md::FdEvent::readable);
+    }
+
+    EXPECT_TRUE(called);
+}